@@ -0,0 +1,246 @@
+/*--------------------------------------------------------------------*/
+/* bdtFixed.c                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "bdt.h"
+#include "fixednode.h"
+
+/* A node of a Binary Directory Tree: at most 2 children, inline */
+DEFINE_FIXEDNODE(Node, 2);
+
+/* A Binary Directory Tree is an AO with 3 state variables: */
+/* a flag for if it is in an initialized state (TRUE) or not (FALSE) */
+static boolean isInitialized;
+/* a pointer to the root node in the hierarchy */
+static Node_T root;
+/* a counter of the number of nodes in the hierarchy */
+static size_t count;
+
+/*
+   Traverses the tree starting at the root as far down the hierarchy
+   as possible while still matching the path parameter.
+
+   Returns a pointer to the farthest matching node down that path,
+   or NULL if there is no node in the tree that matches a prefix of
+   the path
+*/
+static Node_T BDT_traversePath(char* path) {
+   Node_T curr;
+   Node_T next;
+
+   assert(path != NULL);
+
+   if(root == NULL || !Node_isPrefix(root, path))
+      return NULL;
+
+   curr = root;
+   while((next = Node_findChild(curr, path)) != NULL)
+      curr = next;
+   return curr;
+}
+
+/*
+   Inserts a new path into the tree rooted at parent, or, if
+   parent is NULL, as the root of the data structure.
+
+   If a node representing path already exists, returns ALREADY_IN_TREE
+
+   If parent already has 2 children, returns PARENT_CHILD_ERROR,
+   before creating any node
+
+   If there is an allocation error in creating any of the new nodes,
+   returns MEMORY_ERROR
+
+   Otherwise, returns SUCCESS
+*/
+static int BDT_insertRestOfPath(char* path, Node_T parent) {
+   Node_T curr = parent;
+   Node_T firstNew = NULL;
+   Node_T new;
+   const char* restPath = path;
+   size_t length;
+   size_t newCount = 0;
+
+   assert(path != NULL);
+
+   if(curr == NULL) {
+      if(root != NULL)
+         return CONFLICTING_PATH;
+   }
+   else {
+      if(path[Node_getPathLength(curr)] == '\0')
+         return ALREADY_IN_TREE;
+      if(Node_getNumChildren(curr) == 2)
+         return PARENT_CHILD_ERROR;
+
+      restPath += Node_getPathLength(curr) + 1;
+   }
+
+   /* empty components are skipped, as strtok skips them */
+   while(*restPath != '\0') {
+      length = strcspn(restPath, "/");
+      if(length != 0) {
+         new = Node_create(restPath, length, curr);
+         if(new == NULL) {
+            if(firstNew != NULL)
+               (void) Node_destroy(firstNew);
+            return MEMORY_ERROR;
+         }
+         newCount++;
+
+         /* a new node has no children yet, so linking cannot fail */
+         if(firstNew == NULL)
+            firstNew = new;
+         else
+            (void) Node_linkChild(curr, new);
+         curr = new;
+      }
+
+      restPath += length;
+      if(*restPath == '/')
+         restPath++;
+   }
+
+   if(firstNew == NULL)
+      return parent == NULL ? CONFLICTING_PATH : ALREADY_IN_TREE;
+
+   if(parent == NULL)
+      root = firstNew;
+   else
+      (void) Node_linkChild(parent, firstNew);
+   count += newCount;
+   return SUCCESS;
+}
+
+/* see bdt.h for specification */
+int BDT_insertPath(char* path) {
+   assert(path != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   return BDT_insertRestOfPath(path, BDT_traversePath(path));
+}
+
+/* see bdt.h for specification */
+boolean BDT_containsPath(char* path) {
+   Node_T curr;
+
+   assert(path != NULL);
+
+   if(!isInitialized)
+      return FALSE;
+
+   curr = BDT_traversePath(path);
+   return (boolean) (curr != NULL &&
+                     path[Node_getPathLength(curr)] == '\0');
+}
+
+/* see bdt.h for specification */
+int BDT_rmPath(char* path) {
+   Node_T curr;
+   Node_T parent;
+
+   assert(path != NULL);
+
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   curr = BDT_traversePath(path);
+   if(curr == NULL || path[Node_getPathLength(curr)] != '\0')
+      return NO_SUCH_PATH;
+
+   parent = Node_getParent(curr);
+   if(parent == NULL)
+      root = NULL;
+   else
+      Node_unlinkChild(parent, curr);
+
+   count -= Node_destroy(curr);
+   return SUCCESS;
+}
+
+/* see bdt.h for specification */
+int BDT_init(void) {
+   if(isInitialized)
+      return INITIALIZATION_ERROR;
+   isInitialized = TRUE;
+   root = NULL;
+   count = 0;
+   return SUCCESS;
+}
+
+/* see bdt.h for specification */
+int BDT_destroy(void) {
+   if(!isInitialized)
+      return INITIALIZATION_ERROR;
+   if(root != NULL)
+      count -= Node_destroy(root);
+   assert(count == 0);
+   root = NULL;
+   isInitialized = FALSE;
+   return SUCCESS;
+}
+
+/*
+   Returns the length of the paths of the nodes of the hierarchy
+   rooted at n, each with a newline after it.
+*/
+static size_t BDT_strlenFrom(Node_T n) {
+   size_t length;
+   size_t c;
+
+   assert(n != NULL);
+
+   length = Node_getPathLength(n) + 1;
+   for(c = 0; c < Node_getNumChildren(n); c++)
+      length += BDT_strlenFrom(Node_getChild(n, c));
+   return length;
+}
+
+/*
+   Copies the paths of the nodes of the hierarchy rooted at n, in
+   pre-order, each with a newline after it, to acc.
+   Returns the end of what was copied.
+*/
+static char* BDT_copyFrom(Node_T n, char* acc) {
+   size_t c;
+
+   assert(n != NULL);
+   assert(acc != NULL);
+
+   memcpy(acc, Node_getPath(n), Node_getPathLength(n));
+   acc += Node_getPathLength(n);
+   *acc++ = '\n';
+   for(c = 0; c < Node_getNumChildren(n); c++)
+      acc = BDT_copyFrom(Node_getChild(n, c), acc);
+   return acc;
+}
+
+/* see bdt.h for specification */
+char* BDT_toString(void) {
+   size_t totalStrlen = 1;
+   char* result;
+   char* end;
+
+   if(!isInitialized)
+      return NULL;
+
+   if(root != NULL)
+      totalStrlen += BDT_strlenFrom(root);
+
+   result = malloc(totalStrlen);
+   if(result == NULL)
+      return NULL;
+
+   end = result;
+   if(root != NULL)
+      end = BDT_copyFrom(root, end);
+   *end = '\0';
+   return result;
+}
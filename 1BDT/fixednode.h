@@ -0,0 +1,212 @@
+/*--------------------------------------------------------------------*/
+/* fixednode.h                                                        */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef FIXEDNODE_INCLUDED
+#define FIXEDNODE_INCLUDED
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+   DEFINE_FIXEDNODE(Name, K) defines Name_T, a node of a directory
+   tree with at most K children, for a fan-out bounded at compile
+   time. Unlike a node whose children are in a DynArray, it keeps its
+   children inline, in the order they were linked, and its path in
+   the same allocation as itself, so that creating a node is a single
+   allocation and visiting its children reads no other memory. Its
+   functions are static and inlinable, as those of a typed array are.
+
+   Use DEFINE_FIXEDNODE at file scope, at most once per Name in each
+   module.
+
+   Name_T Name_create(const char *pcDir, size_t uLength, Name_T oParent)
+      Return a new node whose path is oParent's path, if oParent is
+      not NULL, then a '/', then the uLength bytes at pcDir, and whose
+      parent is oParent, which is not changed to link to it, or NULL
+      if insufficient memory is available.
+   size_t Name_destroy(Name_T oNode)
+      Destroy the hierarchy rooted at oNode, oNode included, which
+      must have been unlinked from its parent. Return the number of
+      nodes destroyed.
+   const char *Name_getPath(Name_T oNode)
+      Return the path of oNode.
+   size_t Name_getPathLength(Name_T oNode)
+      Return the length of the path of oNode.
+   Name_T Name_getParent(Name_T oNode)
+      Return the parent of oNode, or NULL if it is a root.
+   size_t Name_getNumChildren(Name_T oNode)
+      Return the number of children of oNode.
+   Name_T Name_getChild(Name_T oNode, size_t uIndex)
+      Return the uIndex'th child of oNode.
+   int Name_isPrefix(Name_T oNode, const char *pcPath)
+      Return 1 (TRUE) if the path of oNode is pcPath, or a prefix of
+      it followed by a '/', or 0 (FALSE) otherwise.
+   Name_T Name_findChild(Name_T oNode, const char *pcPath)
+      Return the child of oNode whose path is a prefix of pcPath, as
+      Name_isPrefix tells, or NULL if there is none.
+   int Name_linkChild(Name_T oNode, Name_T oChild)
+      Make oChild the last child of oNode. Return 1 (TRUE) if
+      successful, or 0 (FALSE) if oNode already has K children.
+   void Name_unlinkChild(Name_T oNode, Name_T oChild)
+      Remove oChild from the children of oNode, moving those linked
+      after it up by one.
+*/
+
+/* The storage class of the generated functions. -ansi has no inline
+   keyword, but GCC accepts __inline__ in every mode. */
+#if defined(__GNUC__)
+#define FIXEDNODE_FUNCTION static __inline__
+#else
+#define FIXEDNODE_FUNCTION static
+#endif
+
+#define DEFINE_FIXEDNODE(Name, K)                                      \
+                                                                       \
+struct Name {                                                          \
+   /* the parent, NULL for a root */                                   \
+   struct Name *oParent;                                               \
+   /* the number of children, and the children, in the order they      \
+      were linked */                                                   \
+   size_t uNumChildren;                                                \
+   struct Name *aoChildren[K];                                         \
+   /* the path, stored right after the node, and its length */         \
+   char *pcPath;                                                       \
+   size_t uPathLength;                                                 \
+};                                                                     \
+                                                                       \
+typedef struct Name *Name##_T;                                         \
+                                                                       \
+FIXEDNODE_FUNCTION Name##_T Name##_create(const char *pcDir,           \
+                                          size_t uLength,              \
+                                          Name##_T oParent) {          \
+   Name##_T oNode;                                                     \
+   size_t uParentLength = 0;                                           \
+                                                                       \
+   assert(pcDir != NULL);                                              \
+                                                                       \
+   if (oParent != NULL)                                                \
+      uParentLength = oParent->uPathLength + 1;                        \
+                                                                       \
+   oNode = (Name##_T)malloc(sizeof(struct Name) + uParentLength +      \
+                            uLength + 1);                              \
+   if (oNode == NULL)                                                  \
+      return NULL;                                                     \
+                                                                       \
+   oNode->pcPath = (char *)(oNode + 1);                                \
+   if (oParent != NULL) {                                              \
+      memcpy(oNode->pcPath, oParent->pcPath, oParent->uPathLength);    \
+      oNode->pcPath[uParentLength - 1] = '/';                          \
+   }                                                                   \
+   memcpy(oNode->pcPath + uParentLength, pcDir, uLength);              \
+   oNode->pcPath[uParentLength + uLength] = '\0';                      \
+   oNode->uPathLength = uParentLength + uLength;                       \
+                                                                       \
+   oNode->oParent = oParent;                                           \
+   oNode->uNumChildren = 0;                                            \
+   return oNode;                                                       \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION size_t Name##_destroy(Name##_T oNode) {             \
+   size_t uCount = 1;                                                  \
+   size_t u;                                                           \
+                                                                       \
+   assert(oNode != NULL);                                              \
+                                                                       \
+   for (u = 0; u < oNode->uNumChildren; u++)                           \
+      uCount += Name##_destroy(oNode->aoChildren[u]);                  \
+   free(oNode);                                                        \
+   return uCount;                                                      \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION const char *Name##_getPath(Name##_T oNode) {        \
+   assert(oNode != NULL);                                              \
+                                                                       \
+   return oNode->pcPath;                                               \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION size_t Name##_getPathLength(Name##_T oNode) {       \
+   assert(oNode != NULL);                                              \
+                                                                       \
+   return oNode->uPathLength;                                          \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION Name##_T Name##_getParent(Name##_T oNode) {         \
+   assert(oNode != NULL);                                              \
+                                                                       \
+   return oNode->oParent;                                              \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION size_t Name##_getNumChildren(Name##_T oNode) {      \
+   assert(oNode != NULL);                                              \
+                                                                       \
+   return oNode->uNumChildren;                                         \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION Name##_T Name##_getChild(Name##_T oNode,            \
+                                            size_t uIndex) {           \
+   assert(oNode != NULL);                                              \
+   assert(uIndex < oNode->uNumChildren);                               \
+                                                                       \
+   return oNode->aoChildren[uIndex];                                   \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION int Name##_isPrefix(Name##_T oNode,                 \
+                                       const char *pcPath) {           \
+   assert(oNode != NULL);                                              \
+   assert(pcPath != NULL);                                             \
+                                                                       \
+   return strncmp(pcPath, oNode->pcPath, oNode->uPathLength) == 0 &&   \
+      (pcPath[oNode->uPathLength] == '\0' ||                           \
+       pcPath[oNode->uPathLength] == '/');                             \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION Name##_T Name##_findChild(Name##_T oNode,           \
+                                             const char *pcPath) {     \
+   size_t u;                                                           \
+                                                                       \
+   assert(oNode != NULL);                                              \
+   assert(pcPath != NULL);                                             \
+                                                                       \
+   for (u = 0; u < oNode->uNumChildren; u++) {                         \
+      if (Name##_isPrefix(oNode->aoChildren[u], pcPath))               \
+         return oNode->aoChildren[u];                                  \
+   }                                                                   \
+   return NULL;                                                        \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION int Name##_linkChild(Name##_T oNode,                \
+                                        Name##_T oChild) {             \
+   assert(oNode != NULL);                                              \
+   assert(oChild != NULL);                                             \
+                                                                       \
+   if (oNode->uNumChildren == (K))                                     \
+      return 0;                                                        \
+                                                                       \
+   oNode->aoChildren[oNode->uNumChildren++] = oChild;                  \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+FIXEDNODE_FUNCTION void Name##_unlinkChild(Name##_T oNode,             \
+                                           Name##_T oChild) {          \
+   size_t u;                                                           \
+                                                                       \
+   assert(oNode != NULL);                                              \
+   assert(oChild != NULL);                                             \
+                                                                       \
+   for (u = 0; u < oNode->uNumChildren &&                              \
+           oNode->aoChildren[u] != oChild; u++)                        \
+      ;                                                                \
+   assert(u < oNode->uNumChildren);                                    \
+                                                                       \
+   for (u++; u < oNode->uNumChildren; u++)                             \
+      oNode->aoChildren[u - 1] = oNode->aoChildren[u];                 \
+   oNode->uNumChildren--;                                              \
+}                                                                      \
+                                                                       \
+typedef int Name##_defined
+
+#endif
@@ -8,7 +8,7 @@
 #include <assert.h>
 #include <stdio.h>
 
-#include "dynarray.h"
+#include "typedarray.h"
 #include "node.h"
 #include "checkerDT.h"
 
@@ -25,9 +25,16 @@ struct node {
 
    /* the subdirectories of this directory
       stored in sorted order by pathname */
-   DynArray_T children;
+   struct NodeArray* children;
 };
 
+/* compares nodes by path, as Node_compare does, but inline */
+#define Node_comparePaths(node1, node2) \
+   strcmp((node1)->path, (node2)->path)
+
+/* the array of children, specialized for nodes */
+DEFINE_DYNARRAY(NodeArray, Node_T, Node_comparePaths);
+
 
 /*
   returns a path with contents
@@ -82,7 +89,7 @@ Node_T Node_create(const char* dir, Node_T parent){
    }
 
    new->parent = parent;
-   new->children = DynArray_new(0);
+   new->children = NodeArray_new(0);
    if(new->children == NULL) {
       free(new->path);
       free(new);
@@ -103,12 +110,12 @@ size_t Node_destroy(Node_T n) {
 
    assert(n != NULL);
 
-   for(i = 0; i < DynArray_getLength(n->children); i++)
+   for(i = 0; i < NodeArray_getLength(n->children); i++)
    {
-      c = DynArray_get(n->children, i);
+      c = NodeArray_get(n->children, i);
       count += Node_destroy(c);
    }
-   DynArray_free(n->children);
+   NodeArray_free(n->children);
 
    free(n->path);
    free(n);
@@ -148,7 +155,7 @@ int Node_compare(Node_T node1, Node_T node2) {
 size_t Node_getNumChildren(Node_T n) {
    assert(n != NULL);
 
-   return DynArray_getLength(n->children);
+   return NodeArray_getLength(n->children);
 }
 
 /* see node.h for specification */
@@ -164,8 +171,7 @@ int Node_hasChild(Node_T n, const char* path, size_t* childID) {
    if(checker == NULL) {
       return -1;
    }
-   result = DynArray_bsearch(n->children, checker, &index,
-                    (int (*)(const void*, const void*)) Node_compare);
+   result = NodeArray_bsearch(n->children, checker, &index);
    (void) Node_destroy(checker);
 
    if(childID != NULL)
@@ -178,8 +184,8 @@ int Node_hasChild(Node_T n, const char* path, size_t* childID) {
 Node_T Node_getChild(Node_T n, size_t childID) {
    assert(n != NULL);
 
-   if(DynArray_getLength(n->children) > childID) {
-      return DynArray_get(n->children, childID);
+   if(NodeArray_getLength(n->children) > childID) {
+      return NodeArray_get(n->children, childID);
    }
    else {
       return NULL;
@@ -228,14 +234,13 @@ int Node_linkChild(Node_T parent, Node_T child) {
    }
    child->parent = parent;
 
-   if(DynArray_bsearch(parent->children, child, &i,
-         (int (*)(const void*, const void*)) Node_compare) == 1) {
+   if(NodeArray_bsearch(parent->children, child, &i) == 1) {
       assert(CheckerDT_Node_isValid(parent));
       assert(CheckerDT_Node_isValid(child));
       return ALREADY_IN_TREE;
    }
 
-   if(DynArray_addAt(parent->children, i, child) == TRUE) {
+   if(NodeArray_addAt(parent->children, i, child) == TRUE) {
       assert(CheckerDT_Node_isValid(parent));
       assert(CheckerDT_Node_isValid(child));
       return SUCCESS;
@@ -256,14 +261,13 @@ int  Node_unlinkChild(Node_T parent, Node_T child) {
    assert(CheckerDT_Node_isValid(parent));
    assert(CheckerDT_Node_isValid(child));
 
-   if(DynArray_bsearch(parent->children, child, &i,
-         (int (*)(const void*, const void*)) Node_compare) == 0) {
+   if(NodeArray_bsearch(parent->children, child, &i) == 0) {
       assert(CheckerDT_Node_isValid(parent));
       assert(CheckerDT_Node_isValid(child));
       return PARENT_CHILD_ERROR;
    }
 
-   (void) DynArray_removeAt(parent->children, i);
+   (void) NodeArray_removeAt(parent->children, i);
 
    assert(CheckerDT_Node_isValid(parent));
    assert(CheckerDT_Node_isValid(child));
@@ -0,0 +1,805 @@
+/*--------------------------------------------------------------------*/
+/* chunkseq.c                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "a4def.h"
+#include "chunkseq.h"
+
+/*
+   The elements are kept in leaves (chunks) of up to LEAF_SIZE
+   elements. Each inner node holds up to INNER_SIZE children, along
+   with the number of elements below each child and each child's
+   first element, so that descents by index or by value look at one
+   node per level. All leaves are at the same depth.
+*/
+
+/* The capacities of leaves and inner nodes */
+enum {LEAF_SIZE = 64, INNER_SIZE = 32};
+/* A child with fewer entries than its size over UNDERFULL is merged
+   with a neighbor, if both fit in MERGE_QUARTERS quarters of a node */
+enum {UNDERFULL = 4, MERGE_QUARTERS = 3};
+/* The greatest depth of a tree: every split node is half full, so
+   a tree deeper than this would hold more than SIZE_MAX elements */
+enum {MAX_DEPTH = 24};
+
+/* The header shared by leaves and inner nodes */
+struct node {
+   /* the number of elements of a leaf or children of an inner node */
+   size_t num;
+};
+
+/* A leaf: a chunk of consecutive elements */
+struct leaf {
+   struct node header;
+   const void *elements[LEAF_SIZE];
+};
+
+/* An inner node */
+struct inner {
+   struct node header;
+   /* the children, in order */
+   struct node *children[INNER_SIZE];
+   /* the number of elements below each child */
+   size_t counts[INNER_SIZE];
+   /* the first element below each child */
+   const void *firsts[INNER_SIZE];
+};
+
+/* How a copy replaced a sequence (see ChunkSeq_addAtCopy) */
+enum {NOT_REPLACED, REPLACED_BY_ADD, REPLACED_BY_REMOVE};
+
+struct ChunkSeq {
+   /* the root, a leaf if depth is 0 */
+   struct node *root;
+   /* the number of inner levels above the leaves */
+   size_t depth;
+   /* the number of elements */
+   size_t length;
+   /* the number of bytes allocated for seq and its nodes, or, once a
+      copy replaced seq, for seq and the nodes the copy does not share */
+   size_t bytes;
+   /* how a copy replaced seq, and the index of the element that the
+      copy added or removed, which determine the nodes it does not
+      share */
+   int replaced;
+   size_t replacedIndex;
+};
+
+
+/* Returns the first element below node, which is a leaf if isLeaf is
+   TRUE and holds at least one entry */
+static const void *ChunkSeq_firstOf(struct node *node, boolean isLeaf) {
+   if (isLeaf)
+      return ((struct leaf *)node)->elements[0];
+   return ((struct inner *)node)->firsts[0];
+}
+
+/* Returns the number of elements below node, which is a leaf if
+   isLeaf is TRUE */
+static size_t ChunkSeq_countOf(struct node *node, boolean isLeaf) {
+   struct inner *inner = (struct inner *)node;
+   size_t count = 0;
+   size_t i;
+
+   if (isLeaf)
+      return node->num;
+
+   for (i = 0; i < inner->header.num; i++)
+      count += inner->counts[i];
+   return count;
+}
+
+/* Stores child, with count elements below it starting with first,
+   as entry i of inner, which must not be full */
+static void ChunkSeq_putEntry(struct inner *inner, size_t i,
+                              struct node *child, size_t count,
+                              const void *first) {
+   size_t j;
+
+   assert(inner->header.num < INNER_SIZE);
+
+   for (j = inner->header.num; j > i; j--) {
+      inner->children[j] = inner->children[j - 1];
+      inner->counts[j] = inner->counts[j - 1];
+      inner->firsts[j] = inner->firsts[j - 1];
+   }
+   inner->children[i] = child;
+   inner->counts[i] = count;
+   inner->firsts[i] = first;
+   inner->header.num++;
+}
+
+/* Removes entry i of inner */
+static void ChunkSeq_dropEntry(struct inner *inner, size_t i) {
+   size_t j;
+
+   for (j = i + 1; j < inner->header.num; j++) {
+      inner->children[j - 1] = inner->children[j];
+      inner->counts[j - 1] = inner->counts[j];
+      inner->firsts[j - 1] = inner->firsts[j];
+   }
+   inner->header.num--;
+}
+
+/* Descends seq towards the element at *pIndex (or the place for a
+   new element there), storing each inner node visited in path and
+   the index of the child taken in slots. Returns the leaf reached and
+   stores the position in it in *pIndex. */
+static struct leaf *ChunkSeq_descend(ChunkSeq_T seq, size_t *pIndex,
+                                     struct inner **path,
+                                     size_t *slots) {
+   struct node *node = seq->root;
+   struct inner *inner;
+   size_t index = *pIndex;
+   size_t d;
+   size_t i;
+
+   for (d = 0; d < seq->depth; d++) {
+      inner = (struct inner *)node;
+      i = 0;
+      while (i + 1 < inner->header.num && index >= inner->counts[i]) {
+         index -= inner->counts[i];
+         i++;
+      }
+      path[d] = inner;
+      slots[d] = i;
+      node = inner->children[i];
+   }
+
+   *pIndex = index;
+   return (struct leaf *)node;
+}
+
+/* see chunkseq.h for specification */
+ChunkSeq_T ChunkSeq_new(void) {
+   ChunkSeq_T seq;
+
+   seq = (ChunkSeq_T)malloc(sizeof(struct ChunkSeq));
+   if (seq == NULL)
+      return NULL;
+
+   seq->root = (struct node *)malloc(sizeof(struct leaf));
+   if (seq->root == NULL) {
+      free(seq);
+      return NULL;
+   }
+
+   seq->root->num = 0;
+   seq->depth = 0;
+   seq->length = 0;
+   seq->bytes = sizeof(struct ChunkSeq) + sizeof(struct leaf);
+   seq->replaced = NOT_REPLACED;
+   return seq;
+}
+
+/* Frees node, at depth levels above the leaves, and all below it */
+static void ChunkSeq_freeNode(struct node *node, size_t depth) {
+   struct inner *inner = (struct inner *)node;
+   size_t i;
+
+   if (depth > 0)
+      for (i = 0; i < inner->header.num; i++)
+         ChunkSeq_freeNode(inner->children[i], depth - 1);
+
+   free(node);
+}
+
+/* see chunkseq.h for specification */
+void ChunkSeq_free(ChunkSeq_T seq) {
+   assert(seq != NULL);
+   assert(seq->replaced == NOT_REPLACED);
+
+   ChunkSeq_freeNode(seq->root, seq->depth);
+   free(seq);
+}
+
+/* see chunkseq.h for specification */
+size_t ChunkSeq_getLength(ChunkSeq_T seq) {
+   assert(seq != NULL);
+
+   return seq->length;
+}
+
+/* see chunkseq.h for specification */
+size_t ChunkSeq_getBytes(ChunkSeq_T seq) {
+   assert(seq != NULL);
+
+   return seq->bytes;
+}
+
+/* see chunkseq.h for specification */
+void *ChunkSeq_get(ChunkSeq_T seq, size_t index) {
+   struct inner *path[MAX_DEPTH];
+   size_t slots[MAX_DEPTH];
+   struct leaf *leaf;
+
+   assert(seq != NULL);
+   assert(index < seq->length);
+
+   leaf = ChunkSeq_descend(seq, &index, path, slots);
+   return (void *)leaf->elements[index];
+}
+
+/* see chunkseq.h for specification */
+void *ChunkSeq_set(ChunkSeq_T seq, size_t index, const void *element) {
+   struct inner *path[MAX_DEPTH];
+   size_t slots[MAX_DEPTH];
+   struct leaf *leaf;
+   const void *old;
+   size_t d;
+
+   assert(seq != NULL);
+   assert(index < seq->length);
+
+   leaf = ChunkSeq_descend(seq, &index, path, slots);
+   old = leaf->elements[index];
+   leaf->elements[index] = element;
+
+   /* the inner nodes above whose first element it was keep it */
+   if (index == 0) {
+      for (d = seq->depth; d > 0; d--) {
+         path[d - 1]->firsts[slots[d - 1]] = element;
+         if (slots[d - 1] != 0)
+            break;
+      }
+   }
+
+   return (void *)old;
+}
+
+/* see chunkseq.h for specification */
+int ChunkSeq_addAt(ChunkSeq_T seq, size_t index, const void *element) {
+   struct inner *path[MAX_DEPTH];
+   size_t slots[MAX_DEPTH];
+   struct node *spares[MAX_DEPTH + 1];
+   size_t numSpares = 0;
+   size_t used = 0;
+   struct leaf *leaf;
+   struct leaf *rightLeaf;
+   struct inner *inner;
+   struct inner *rightInner;
+   struct node *child;
+   struct node *split = NULL;
+   size_t need = 0;
+   size_t half;
+   size_t d;
+   size_t i;
+
+   assert(seq != NULL);
+   assert(index <= seq->length);
+
+   leaf = ChunkSeq_descend(seq, &index, path, slots);
+
+   /* a full leaf splits, and so does each full node above a split;
+      a split root needs a new root */
+   if (leaf->header.num == LEAF_SIZE) {
+      need = 1;
+      d = seq->depth;
+      while (d > 0 && path[d - 1]->header.num == INNER_SIZE) {
+         need++;
+         d--;
+      }
+      if (d == 0)
+         need++;
+   }
+
+   /* allocates every new node first, so that failing changes nothing */
+   assert(need <= MAX_DEPTH + 1);
+   while (numSpares < need) {
+      if (numSpares == 0)
+         spares[numSpares] = (struct node *)malloc(sizeof(struct leaf));
+      else
+         spares[numSpares] =
+            (struct node *)malloc(sizeof(struct inner));
+
+      if (spares[numSpares] == NULL) {
+         while (numSpares > 0)
+            free(spares[--numSpares]);
+         return FALSE;
+      }
+      numSpares++;
+   }
+
+   if (need > 0)
+      seq->bytes += sizeof(struct leaf) +
+         (need - 1) * sizeof(struct inner);
+
+   /* inserts element in the leaf, moving its upper half to a new
+      leaf first if it is full */
+   if (leaf->header.num == LEAF_SIZE) {
+      rightLeaf = (struct leaf *)spares[used++];
+      half = LEAF_SIZE / 2;
+      memcpy(rightLeaf->elements, leaf->elements + half,
+             (LEAF_SIZE - half) * sizeof(const void *));
+      rightLeaf->header.num = LEAF_SIZE - half;
+      leaf->header.num = half;
+      split = (struct node *)rightLeaf;
+
+      if (index > half) {
+         index -= half;
+         leaf = rightLeaf;
+      }
+   }
+
+   memmove(leaf->elements + index + 1, leaf->elements + index,
+           (leaf->header.num - index) * sizeof(const void *));
+   leaf->elements[index] = element;
+   leaf->header.num++;
+
+   /* updates the entries of each ancestor, adding the new node of a
+      split below as the entry after the split one */
+   child = seq->depth > 0 ?
+      path[seq->depth - 1]->children[slots[seq->depth - 1]] :
+      seq->root;
+
+   for (d = seq->depth; d > 0; d--) {
+      inner = path[d - 1];
+      i = slots[d - 1];
+
+      inner->counts[i] = ChunkSeq_countOf(child, d == seq->depth);
+      inner->firsts[i] = ChunkSeq_firstOf(child, d == seq->depth);
+
+      if (split != NULL) {
+         rightInner = NULL;
+
+         if (inner->header.num == INNER_SIZE) {
+            rightInner = (struct inner *)spares[used++];
+            half = INNER_SIZE / 2;
+            memcpy(rightInner->children, inner->children + half,
+                   (INNER_SIZE - half) * sizeof(struct node *));
+            memcpy(rightInner->counts, inner->counts + half,
+                   (INNER_SIZE - half) * sizeof(size_t));
+            memcpy(rightInner->firsts, inner->firsts + half,
+                   (INNER_SIZE - half) * sizeof(const void *));
+            rightInner->header.num = INNER_SIZE - half;
+            inner->header.num = half;
+         }
+
+         if (rightInner != NULL && i + 1 > half)
+            ChunkSeq_putEntry(rightInner, i + 1 - half, split,
+                              ChunkSeq_countOf(split, d == seq->depth),
+                              ChunkSeq_firstOf(split, d == seq->depth));
+         else
+            ChunkSeq_putEntry(inner, i + 1, split,
+                              ChunkSeq_countOf(split, d == seq->depth),
+                              ChunkSeq_firstOf(split, d == seq->depth));
+
+         split = (struct node *)rightInner;
+      }
+
+      child = (struct node *)inner;
+   }
+
+   /* a split root gets a new root above it and its new sibling */
+   if (split != NULL) {
+      inner = (struct inner *)spares[used++];
+      inner->header.num = 0;
+      ChunkSeq_putEntry(inner, 0, seq->root,
+                        ChunkSeq_countOf(seq->root, seq->depth == 0),
+                        ChunkSeq_firstOf(seq->root, seq->depth == 0));
+      ChunkSeq_putEntry(inner, 1, split,
+                        ChunkSeq_countOf(split, seq->depth == 0),
+                        ChunkSeq_firstOf(split, seq->depth == 0));
+      seq->root = (struct node *)inner;
+      seq->depth++;
+   }
+
+   assert(used == numSpares);
+   seq->length++;
+   return TRUE;
+}
+
+/* Merges entry i + 1 of inner, whose children are at depth levels
+   above the leaves, into entry i, if either is underfull and both fit
+   in one node. Returns the number of bytes freed. */
+static size_t ChunkSeq_merge(struct inner *inner, size_t i,
+                             size_t depth) {
+   struct node *left = inner->children[i];
+   struct node *right = inner->children[i + 1];
+   struct inner *leftInner = (struct inner *)left;
+   struct inner *rightInner = (struct inner *)right;
+   size_t size = depth == 0 ? LEAF_SIZE : INNER_SIZE;
+   size_t j;
+
+   if (left->num >= size / UNDERFULL && right->num >= size / UNDERFULL)
+      return 0;
+   if (left->num + right->num > size / 4 * MERGE_QUARTERS)
+      return 0;
+
+   if (depth == 0)
+      memcpy(((struct leaf *)left)->elements + left->num,
+             ((struct leaf *)right)->elements,
+             right->num * sizeof(const void *));
+   else
+      for (j = 0; j < right->num; j++) {
+         leftInner->children[left->num + j] = rightInner->children[j];
+         leftInner->counts[left->num + j] = rightInner->counts[j];
+         leftInner->firsts[left->num + j] = rightInner->firsts[j];
+      }
+
+   left->num += right->num;
+   inner->counts[i] += inner->counts[i + 1];
+   ChunkSeq_dropEntry(inner, i + 1);
+   free(right);
+
+   return depth == 0 ? sizeof(struct leaf) : sizeof(struct inner);
+}
+
+/* Returns TRUE if node is one of the numCopies nodes at copies, or
+   if copies is NULL */
+static boolean ChunkSeq_isCopy(struct node *node, struct node **copies,
+                               size_t numCopies) {
+   size_t i;
+
+   if (copies == NULL)
+      return TRUE;
+
+   for (i = 0; i < numCopies; i++)
+      if (copies[i] == node)
+         return TRUE;
+   return FALSE;
+}
+
+/* Removes and returns the index'th element of seq, like
+   ChunkSeq_removeAt. If copies is not NULL, seq shares its nodes
+   with another sequence but the numCopies at copies, and the root
+   gives way to a single child only while it is one of them. */
+static void *ChunkSeq_removeFrom(ChunkSeq_T seq, size_t index,
+                                 struct node **copies,
+                                 size_t numCopies) {
+   struct inner *path[MAX_DEPTH];
+   size_t slots[MAX_DEPTH];
+   struct leaf *leaf;
+   struct inner *inner;
+   struct node *child;
+   const void *element;
+   size_t d;
+   size_t i;
+
+   assert(seq != NULL);
+   assert(index < seq->length);
+
+   leaf = ChunkSeq_descend(seq, &index, path, slots);
+
+   element = leaf->elements[index];
+   memmove(leaf->elements + index, leaf->elements + index + 1,
+           (leaf->header.num - index - 1) * sizeof(const void *));
+   leaf->header.num--;
+
+   /* updates the entries of each ancestor, dropping emptied children
+      and merging underfull ones into a neighbor. The nodes above the
+      last element stay, for the root to give way to them below. */
+   child = (struct node *)leaf;
+   for (d = seq->depth; d > 0; d--) {
+      inner = path[d - 1];
+      i = slots[d - 1];
+
+      if (child->num == 0 && seq->length > 1) {
+         ChunkSeq_dropEntry(inner, i);
+         free(child);
+         seq->bytes -= d == seq->depth ?
+            sizeof(struct leaf) : sizeof(struct inner);
+      }
+      else {
+         inner->counts[i]--;
+         if (child->num > 0)
+            inner->firsts[i] =
+               ChunkSeq_firstOf(child, d == seq->depth);
+
+         if (inner->header.num > 1) {
+            if (i + 1 == inner->header.num)
+               i--;
+            seq->bytes -= ChunkSeq_merge(inner, i, seq->depth - d);
+         }
+      }
+
+      child = (struct node *)inner;
+   }
+
+   /* a root with a single child gives way to it; a shared one is
+      left for the next copy, which has its own root, to drop */
+   while (seq->depth > 0 && seq->root->num == 1 &&
+          ChunkSeq_isCopy(seq->root, copies, numCopies)) {
+      child = ((struct inner *)seq->root)->children[0];
+      free(seq->root);
+      seq->bytes -= sizeof(struct inner);
+      seq->root = child;
+      seq->depth--;
+   }
+
+   seq->length--;
+   return (void *)element;
+}
+
+/* see chunkseq.h for specification */
+void *ChunkSeq_removeAt(ChunkSeq_T seq, size_t index) {
+   assert(seq != NULL);
+   assert(index < seq->length);
+
+   return ChunkSeq_removeFrom(seq, index, NULL, 0);
+}
+
+/* Returns the number of bytes of a node, which is a leaf if isLeaf
+   is TRUE */
+static size_t ChunkSeq_sizeOf(boolean isLeaf) {
+   return isLeaf ? sizeof(struct leaf) : sizeof(struct inner);
+}
+
+/* Frees seq and the nodes of seq that a change of the element at
+   index changes: those on the path to it and, if the change removes
+   it, the neighbor of each with which it may be merged. Returns the
+   number of bytes freed. */
+static size_t ChunkSeq_freePath(ChunkSeq_T seq, size_t index,
+                                boolean removing) {
+   struct inner *path[MAX_DEPTH];
+   size_t slots[MAX_DEPTH];
+   struct leaf *leaf;
+   struct inner *inner;
+   size_t bytes = sizeof(struct ChunkSeq);
+   size_t d;
+   size_t i;
+
+   leaf = ChunkSeq_descend(seq, &index, path, slots);
+
+   for (d = 0; d < seq->depth; d++) {
+      inner = path[d];
+      i = slots[d];
+
+      if (removing && inner->header.num > 1) {
+         i = i + 1 == inner->header.num ? i - 1 : i + 1;
+         free(inner->children[i]);
+         bytes += ChunkSeq_sizeOf(d + 1 == seq->depth);
+      }
+
+      free(inner);
+      bytes += sizeof(struct inner);
+   }
+
+   free(leaf);
+   bytes += sizeof(struct leaf);
+   free(seq);
+
+   return bytes;
+}
+
+/* Returns a copy of the node of seq at depth levels below its root,
+   or NULL if unable to allocate it */
+static struct node *ChunkSeq_copyNode(ChunkSeq_T seq, struct node *node,
+                                      size_t depth) {
+   struct node *copy;
+   size_t size = ChunkSeq_sizeOf(depth == seq->depth);
+
+   copy = (struct node *)malloc(size);
+   if (copy != NULL)
+      memcpy(copy, node, size);
+
+   return copy;
+}
+
+/* Returns a new ChunkSeq_T that shares the nodes of seq but those
+   that changing the element at index changes (see ChunkSeq_freePath),
+   of which it has copies, or NULL if unable to allocate them.
+   Stores the copies at copies, which has room for 2 * MAX_DEPTH + 1,
+   their number in *pNumCopies, and their bytes and those of the
+   header in *pBytes. */
+static ChunkSeq_T ChunkSeq_copyPath(ChunkSeq_T seq, size_t index,
+                                    boolean removing,
+                                    struct node **copies,
+                                    size_t *pNumCopies,
+                                    size_t *pBytes) {
+   struct inner *path[MAX_DEPTH];
+   size_t slots[MAX_DEPTH];
+   ChunkSeq_T copy;
+   struct inner *inner;
+   struct node *child;
+   size_t d;
+   size_t i;
+
+   (void) ChunkSeq_descend(seq, &index, path, slots);
+
+   copy = (ChunkSeq_T)malloc(sizeof(struct ChunkSeq));
+   if (copy == NULL)
+      return NULL;
+
+   *copy = *seq;
+   copy->root = ChunkSeq_copyNode(seq, seq->root, 0);
+   if (copy->root == NULL) {
+      free(copy);
+      return NULL;
+   }
+   copies[0] = copy->root;
+   *pNumCopies = 1;
+   *pBytes = sizeof(struct ChunkSeq) +
+      ChunkSeq_sizeOf(seq->depth == 0);
+
+   /* copies each node on the path below the root, and its neighbor,
+      linking them into the copies above them */
+   for (d = 0; d < seq->depth; d++) {
+      inner = d == 0 ? (struct inner *)copy->root :
+         (struct inner *)inner->children[slots[d - 1]];
+      i = slots[d];
+
+      if (removing && inner->header.num > 1) {
+         i = i + 1 == inner->header.num ? i - 1 : i + 1;
+         child = ChunkSeq_copyNode(seq, inner->children[i], d + 1);
+         if (child == NULL)
+            break;
+         inner->children[i] = child;
+         copies[(*pNumCopies)++] = child;
+         *pBytes += ChunkSeq_sizeOf(d + 1 == seq->depth);
+      }
+
+      child = ChunkSeq_copyNode(seq, inner->children[slots[d]], d + 1);
+      if (child == NULL) {
+         if (removing && inner->header.num > 1)
+            free(inner->children[i]);
+         break;
+      }
+      inner->children[slots[d]] = child;
+      copies[(*pNumCopies)++] = child;
+      *pBytes += ChunkSeq_sizeOf(d + 1 == seq->depth);
+   }
+
+   /* frees the copies made, which are exactly those on the path so
+      far */
+   if (d < seq->depth) {
+      copy->depth = d;
+      (void) ChunkSeq_freePath(copy, index, removing);
+      return NULL;
+   }
+
+   return copy;
+}
+
+/* see chunkseq.h for specification */
+ChunkSeq_T ChunkSeq_addAtCopy(ChunkSeq_T seq, size_t index,
+                              const void *element) {
+   struct node *copies[2 * MAX_DEPTH + 1];
+   size_t numCopies;
+   ChunkSeq_T copy;
+   size_t bytes;
+
+   assert(seq != NULL);
+   assert(seq->replaced == NOT_REPLACED);
+   assert(index <= seq->length);
+
+   copy = ChunkSeq_copyPath(seq, index, FALSE, copies, &numCopies,
+                            &bytes);
+   if (copy == NULL)
+      return NULL;
+
+   /* the copy has its own path, so adding to it leaves seq as is */
+   if (!ChunkSeq_addAt(copy, index, element)) {
+      (void) ChunkSeq_freePath(copy, index, FALSE);
+      return NULL;
+   }
+
+   seq->bytes = bytes;
+   seq->replaced = REPLACED_BY_ADD;
+   seq->replacedIndex = index;
+   return copy;
+}
+
+/* see chunkseq.h for specification */
+ChunkSeq_T ChunkSeq_removeAtCopy(ChunkSeq_T seq, size_t index) {
+   struct node *copies[2 * MAX_DEPTH + 1];
+   size_t numCopies;
+   ChunkSeq_T copy;
+   size_t bytes;
+
+   assert(seq != NULL);
+   assert(seq->replaced == NOT_REPLACED);
+   assert(index < seq->length);
+
+   copy = ChunkSeq_copyPath(seq, index, TRUE, copies, &numCopies,
+                            &bytes);
+   if (copy == NULL)
+      return NULL;
+
+   (void) ChunkSeq_removeFrom(copy, index, copies, numCopies);
+
+   seq->bytes = bytes;
+   seq->replaced = REPLACED_BY_REMOVE;
+   seq->replacedIndex = index;
+   return copy;
+}
+
+/* see chunkseq.h for specification */
+void ChunkSeq_release(ChunkSeq_T seq) {
+   assert(seq != NULL);
+   assert(seq->replaced != NOT_REPLACED);
+
+   (void) ChunkSeq_freePath(seq, seq->replacedIndex,
+                            seq->replaced == REPLACED_BY_REMOVE);
+}
+
+/* Applies apply to each element below node, at depth levels above
+   the leaves, in order */
+static void ChunkSeq_mapNode(struct node *node, size_t depth,
+                             void (*apply)(void *element, void *extra),
+                             void *extra) {
+   struct leaf *leaf = (struct leaf *)node;
+   struct inner *inner = (struct inner *)node;
+   size_t i;
+
+   if (depth == 0)
+      for (i = 0; i < leaf->header.num; i++)
+         (*apply)((void *)leaf->elements[i], extra);
+   else
+      for (i = 0; i < inner->header.num; i++)
+         ChunkSeq_mapNode(inner->children[i], depth - 1, apply, extra);
+}
+
+/* see chunkseq.h for specification */
+void ChunkSeq_map(ChunkSeq_T seq,
+                  void (*apply)(void *element, void *extra),
+                  void *extra) {
+   assert(seq != NULL);
+   assert(apply != NULL);
+
+   ChunkSeq_mapNode(seq->root, seq->depth, apply, extra);
+}
+
+/* see chunkseq.h for specification */
+int ChunkSeq_bsearch(ChunkSeq_T seq, const void *sought, size_t *pIndex,
+                     int (*compare)(const void *sought,
+                                    const void *element)) {
+   struct node *node;
+   struct inner *inner;
+   struct leaf *leaf;
+   size_t base = 0;
+   size_t lo;
+   size_t hi;
+   size_t mid;
+   size_t d;
+   size_t i;
+   int cmp;
+
+   assert(seq != NULL);
+   assert(pIndex != NULL);
+   assert(compare != NULL);
+
+   node = seq->root;
+
+   /* takes the last child whose first element is not greater than
+      sought (or the first child, if there is none) */
+   for (d = 0; d < seq->depth; d++) {
+      inner = (struct inner *)node;
+      lo = 0;
+      hi = inner->header.num;
+      while (lo < hi) {
+         mid = lo + (hi - lo) / 2;
+         if ((*compare)(sought, inner->firsts[mid]) < 0)
+            hi = mid;
+         else
+            lo = mid + 1;
+      }
+      if (lo > 0)
+         lo--;
+
+      for (i = 0; i < lo; i++)
+         base += inner->counts[i];
+      node = inner->children[lo];
+   }
+
+   leaf = (struct leaf *)node;
+   lo = 0;
+   hi = leaf->header.num;
+   while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      cmp = (*compare)(sought, leaf->elements[mid]);
+      if (cmp == EQUAL) {
+         *pIndex = base + mid;
+         return 1;
+      }
+      if (cmp < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+
+   *pIndex = base + lo;
+   return 0;
+}
@@ -0,0 +1,110 @@
+/*--------------------------------------------------------------------*/
+/* chunkseq.h                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef CHUNKSEQ_INCLUDED
+#define CHUNKSEQ_INCLUDED
+
+#include <stddef.h>
+
+/*
+   A ChunkSeq_T is a sequence of elements, like a DynArray_T, stored
+   as a B+ tree of fixed-size chunks whose inner nodes count the
+   elements below them. Getting, adding or removing the element at
+   any index takes O(log n) time and moves at most a chunk of
+   elements, however long the sequence is.
+*/
+typedef struct ChunkSeq *ChunkSeq_T;
+
+/*
+   Returns a new empty ChunkSeq_T, or NULL if unable to allocate
+   sufficient memory.
+*/
+ChunkSeq_T ChunkSeq_new(void);
+
+/*
+   Frees seq. The elements in it are unchanged.
+*/
+void ChunkSeq_free(ChunkSeq_T seq);
+
+/*
+   Returns the number of elements of seq.
+*/
+size_t ChunkSeq_getLength(ChunkSeq_T seq);
+
+/*
+   Returns the number of bytes allocated for seq, including its chunks
+   and inner nodes.
+*/
+size_t ChunkSeq_getBytes(ChunkSeq_T seq);
+
+/*
+   Returns the index'th element of seq, which must exist.
+*/
+void *ChunkSeq_get(ChunkSeq_T seq, size_t index);
+
+/*
+   Replaces the index'th element of seq, which must exist, with
+   element, and returns the old one.
+*/
+void *ChunkSeq_set(ChunkSeq_T seq, size_t index, const void *element);
+
+/*
+   Adds element to seq such that it is the index'th element, where
+   index is at most the length of seq.
+   Returns 1 (TRUE) if successful, or 0 (FALSE), leaving seq unchanged,
+   if unable to allocate sufficient memory.
+*/
+int ChunkSeq_addAt(ChunkSeq_T seq, size_t index, const void *element);
+
+/*
+   Removes and returns the index'th element of seq, which must exist.
+*/
+void *ChunkSeq_removeAt(ChunkSeq_T seq, size_t index);
+
+/*
+   Returns a new ChunkSeq_T holding the elements of seq with element
+   added as the index'th one, or NULL if unable to allocate
+   sufficient memory. The new sequence shares all but O(log n) of the
+   nodes of seq, which is left unchanged, so that it can still be read
+   while the new one replaces it. Unless NULL is returned, seq must
+   then be released with ChunkSeq_release rather than freed or
+   changed, and ChunkSeq_getBytes(seq) becomes the number of bytes
+   that releasing it frees.
+*/
+ChunkSeq_T ChunkSeq_addAtCopy(ChunkSeq_T seq, size_t index,
+                              const void *element);
+
+/*
+   Works like ChunkSeq_addAtCopy, but removing the index'th element of
+   seq, which must exist, from the new sequence.
+*/
+ChunkSeq_T ChunkSeq_removeAtCopy(ChunkSeq_T seq, size_t index);
+
+/*
+   Frees seq, which a ChunkSeq_addAtCopy or ChunkSeq_removeAtCopy
+   replaced, and its nodes that the replacement does not share.
+*/
+void ChunkSeq_release(ChunkSeq_T seq);
+
+/*
+   Calls (*apply)(element, extra) for each element of seq, in order.
+*/
+void ChunkSeq_map(ChunkSeq_T seq,
+                  void (*apply)(void *element, void *extra),
+                  void *extra);
+
+/*
+   Binary searches seq, which must be sorted as determined by
+   *compare, for sought. *compare must return <0, 0, or >0 if sought
+   is less than, equal to, or greater than element.
+   If such an element is found, stores its index in *pIndex and
+   returns 1. Otherwise, stores the index where it would belong in
+   *pIndex and returns 0.
+*/
+int ChunkSeq_bsearch(ChunkSeq_T seq, const void *sought, size_t *pIndex,
+                     int (*compare)(const void *sought,
+                                    const void *element));
+
+#endif
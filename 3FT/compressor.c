@@ -0,0 +1,477 @@
+/*--------------------------------------------------------------------*/
+/* compressor.c                                                       */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "compressor.h"
+
+/*
+   Packed contents are a sequence of LZ77 sequences, each one being
+   a token byte, optional literal length bytes, literals, a 2-byte
+   little-endian match offset and optional match length bytes.
+   The token's high nibble is the number of literals and its low
+   nibble the match length minus MIN_MATCH, each continued by
+   bytes of 255 (and a final smaller byte) when it is 15.
+   The last sequence has literals only.
+*/
+
+/* The length of the shortest match worth encoding */
+enum {MIN_MATCH = 4};
+/* The farthest back a match may start */
+enum {MAX_OFFSET = 65535};
+/* The number of entries (a power of 2) in the match-finder table */
+enum {HASH_BITS = 12, HASH_SIZE = 1 << HASH_BITS};
+/* The largest value a token nibble holds directly */
+enum {NIBBLE_MAX = 15};
+/* The number of unpacked contents kept in the cache */
+enum {CACHE_SLOTS = 8};
+
+/* An entry of the cache of unpacked contents */
+struct slot {
+   /* the owner whose contents are held, NULL if the slot is empty */
+   const void *owner;
+
+   /* the unpacked contents, of size bytes */
+   void *buffer;
+   size_t size;
+
+   /* the clock value of the last read of this slot */
+   size_t lastUse;
+};
+
+/* The Compressor is an AO with the following state variables: */
+
+/* contents of at least this many bytes are packed, 0 for none */
+static size_t threshold;
+/* the cache of unpacked contents */
+static struct slot cache[CACHE_SLOTS];
+/* a clock ticking once per read, to find the least recent slot */
+static size_t tick;
+/* a buffer returned by Compressor_forget or Compressor_drop, freed
+   on the next call, and its size */
+static void *retired;
+static size_t retiredSize;
+/* the bytes of the buffers of the cache and of the retired buffer */
+static size_t cacheBytes;
+/* the number of packed contents and their packed and unpacked bytes */
+static size_t numPacked;
+static size_t packedBytes;
+static size_t logicalBytes;
+/* the number of reads served from and not from the cache */
+static size_t numHits;
+static size_t numMisses;
+/* the bytes of the copies of contents that are not packed */
+static size_t copiedBytes;
+
+
+/* Returns the match-finder table index for the 4 bytes at p */
+static size_t Compressor_hash(const unsigned char *p) {
+   unsigned long v;
+
+   v = (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+      ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+
+   return (size_t)(((v * 2654435761UL) & 0xFFFFFFFFUL)
+                   >> (32 - HASH_BITS));
+}
+
+/* Writes a token nibble's continuation for value v (at least
+   NIBBLE_MAX) at dst, returning the position after it */
+static unsigned char *Compressor_putLength(unsigned char *dst,
+                                           size_t v) {
+   v -= NIBBLE_MAX;
+   while (v >= 255) {
+      *dst++ = 255;
+      v -= 255;
+   }
+   *dst++ = (unsigned char)v;
+   return dst;
+}
+
+/* Writes one sequence with the numLit literals at lit, followed (if
+   matchLen is not 0) by a match of matchLen bytes at offset back,
+   at dst. Returns the position after it. */
+static unsigned char *Compressor_putSequence(unsigned char *dst,
+                                             const unsigned char *lit,
+                                             size_t numLit,
+                                             size_t offset,
+                                             size_t matchLen) {
+   unsigned char *token = dst++;
+   size_t m = 0;
+
+   if (matchLen != 0)
+      m = matchLen - MIN_MATCH;
+
+   *token = (unsigned char)
+      (((numLit < NIBBLE_MAX ? numLit : NIBBLE_MAX) << 4) |
+       (m < NIBBLE_MAX ? m : NIBBLE_MAX));
+
+   if (numLit >= NIBBLE_MAX)
+      dst = Compressor_putLength(dst, numLit);
+
+   memcpy(dst, lit, numLit);
+   dst += numLit;
+
+   if (matchLen != 0) {
+      *dst++ = (unsigned char)(offset & 0xFF);
+      *dst++ = (unsigned char)(offset >> 8);
+      if (m >= NIBBLE_MAX)
+         dst = Compressor_putLength(dst, m);
+   }
+
+   return dst;
+}
+
+/* Packs the n bytes at src into dst, which must hold at least
+   n + n / 255 + 16 bytes. Returns the number of packed bytes. */
+static size_t Compressor_encode(const unsigned char *src, size_t n,
+                                unsigned char *dst) {
+   size_t table[HASH_SIZE];
+   unsigned char *out = dst;
+   size_t anchor = 0;
+   size_t i = 0;
+   size_t h;
+   size_t cand;
+   size_t len;
+
+   /* table entries hold a position plus 1, so 0 means empty */
+   memset(table, 0, sizeof(table));
+
+   while (i + MIN_MATCH <= n) {
+      h = Compressor_hash(src + i);
+      cand = table[h];
+      table[h] = i + 1;
+
+      if (cand != 0 && i - (cand - 1) <= MAX_OFFSET &&
+          memcmp(src + cand - 1, src + i, MIN_MATCH) == EQUAL) {
+
+         cand--;
+         len = MIN_MATCH;
+         while (i + len < n && src[cand + len] == src[i + len])
+            len++;
+
+         out = Compressor_putSequence(out, src + anchor, i - anchor,
+                                      i - cand, len);
+         i += len;
+         anchor = i;
+      }
+      else
+         i++;
+   }
+
+   out = Compressor_putSequence(out, src + anchor, n - anchor, 0, 0);
+   return (size_t)(out - dst);
+}
+
+/* Reads a token nibble's continuation at *pSrc (before end) onto
+   *pV, advancing *pSrc. Returns FALSE if the input ends early. */
+static boolean Compressor_getLength(const unsigned char **pSrc,
+                                    const unsigned char *end,
+                                    size_t *pV) {
+   unsigned char b;
+
+   do {
+      if (*pSrc == end)
+         return FALSE;
+      b = *(*pSrc)++;
+      *pV += b;
+   } while (b == 255);
+
+   return TRUE;
+}
+
+/* Unpacks the n packed bytes at src into the length bytes at dst.
+   Returns FALSE if the packed bytes are corrupt. */
+static boolean Compressor_decode(const unsigned char *src, size_t n,
+                                 unsigned char *dst, size_t length) {
+   const unsigned char *end = src + n;
+   size_t o = 0;
+   size_t numLit;
+   size_t matchLen;
+   size_t offset;
+
+   while (src < end) {
+      numLit = *src >> 4;
+      matchLen = (*src & NIBBLE_MAX) + MIN_MATCH;
+      src++;
+
+      if (numLit == NIBBLE_MAX &&
+          !Compressor_getLength(&src, end, &numLit))
+         return FALSE;
+
+      if (numLit > (size_t)(end - src) || numLit > length - o)
+         return FALSE;
+
+      memcpy(dst + o, src, numLit);
+      src += numLit;
+      o += numLit;
+
+      /* the last sequence has literals only */
+      if (src == end)
+         break;
+
+      if (end - src < 2)
+         return FALSE;
+      offset = (size_t)src[0] | ((size_t)src[1] << 8);
+      src += 2;
+
+      if (matchLen == NIBBLE_MAX + MIN_MATCH &&
+          !Compressor_getLength(&src, end, &matchLen))
+         return FALSE;
+
+      if (offset == 0 || offset > o || matchLen > length - o)
+         return FALSE;
+
+      /* copies byte by byte, since the match may overlap itself */
+      while (matchLen > 0) {
+         dst[o] = dst[o - offset];
+         o++;
+         matchLen--;
+      }
+   }
+
+   return (boolean)(o == length);
+}
+
+/* Frees the buffer returned by the last Compressor_forget, if any */
+static void Compressor_freeRetired(void) {
+   free(retired);
+   retired = NULL;
+   cacheBytes -= retiredSize;
+   retiredSize = 0;
+}
+
+/* see compressor.h for specification */
+void Compressor_init(size_t newThreshold) {
+   size_t i;
+
+   threshold = newThreshold;
+   for (i = 0; i < CACHE_SLOTS; i++) {
+      cache[i].owner = NULL;
+      cache[i].buffer = NULL;
+      cache[i].size = 0;
+      cache[i].lastUse = 0;
+   }
+   tick = 0;
+   retired = NULL;
+   retiredSize = 0;
+   cacheBytes = 0;
+   numPacked = 0;
+   packedBytes = 0;
+   logicalBytes = 0;
+   numHits = 0;
+   numMisses = 0;
+   copiedBytes = 0;
+}
+
+/* see compressor.h for specification */
+void Compressor_destroy(void) {
+   size_t i;
+
+   for (i = 0; i < CACHE_SLOTS; i++)
+      free(cache[i].buffer);
+
+   Compressor_freeRetired();
+   Compressor_init(0);
+}
+
+/* see compressor.h for specification */
+void *Compressor_pack(const void *contents, size_t length,
+                      size_t *pPackedLength) {
+   unsigned char *packed;
+   unsigned char *shrunk;
+   size_t n;
+
+   assert(pPackedLength != NULL);
+
+   if (threshold == 0 || contents == NULL || length < threshold)
+      return NULL;
+
+   packed = (unsigned char *)malloc(length + length / 255 + 16);
+   if (packed == NULL)
+      return NULL;
+
+   n = Compressor_encode((const unsigned char *)contents, length,
+                         packed);
+
+   /* keeps contents as they are if packing does not pay off */
+   if (n >= length) {
+      free(packed);
+      return NULL;
+   }
+
+   shrunk = (unsigned char *)realloc(packed, n);
+   if (shrunk != NULL)
+      packed = shrunk;
+
+   numPacked++;
+   packedBytes += n;
+   logicalBytes += length;
+
+   *pPackedLength = n;
+   return packed;
+}
+
+/* see compressor.h for specification */
+void *Compressor_unpack(const void *owner, const void *packed,
+                        size_t packedLength, size_t length) {
+   struct slot *victim = &cache[0];
+   void *buffer;
+   size_t i;
+
+   assert(owner != NULL);
+   assert(packed != NULL);
+
+   tick++;
+
+   for (i = 0; i < CACHE_SLOTS; i++) {
+      if (cache[i].owner == owner) {
+         cache[i].lastUse = tick;
+         numHits++;
+         return cache[i].buffer;
+      }
+
+      /* prefers an empty slot, then the least recently read one */
+      if (victim->owner != NULL &&
+          (cache[i].owner == NULL ||
+           cache[i].lastUse < victim->lastUse))
+         victim = &cache[i];
+   }
+
+   numMisses++;
+
+   /* one extra byte, so that empty contents still get a buffer */
+   buffer = malloc(length + 1);
+   if (buffer == NULL)
+      return NULL;
+
+   if (!Compressor_decode((const unsigned char *)packed, packedLength,
+                          (unsigned char *)buffer, length)) {
+      free(buffer);
+      return NULL;
+   }
+
+   free(victim->buffer);
+   cacheBytes += (length + 1) - victim->size;
+   victim->owner = owner;
+   victim->buffer = buffer;
+   victim->size = length + 1;
+   victim->lastUse = tick;
+
+   return buffer;
+}
+
+/* see compressor.h for specification */
+void *Compressor_forget(const void *owner, const void *packed,
+                        size_t packedLength, size_t length,
+                        boolean retire) {
+   void *buffer = NULL;
+   size_t i;
+
+   Compressor_freeRetired();
+
+   for (i = 0; i < CACHE_SLOTS; i++) {
+      if (cache[i].owner == owner && owner != NULL) {
+         buffer = cache[i].buffer;
+         cacheBytes -= cache[i].size;
+         cache[i].owner = NULL;
+         cache[i].buffer = NULL;
+         cache[i].size = 0;
+      }
+   }
+
+   if (retire && buffer == NULL) {
+      buffer = malloc(length + 1);
+      if (buffer != NULL &&
+          !Compressor_decode((const unsigned char *)packed,
+                             packedLength, (unsigned char *)buffer,
+                             length)) {
+         free(buffer);
+         buffer = NULL;
+      }
+   }
+
+   numPacked--;
+   packedBytes -= packedLength;
+   logicalBytes -= length;
+
+   if (!retire) {
+      free(buffer);
+      return NULL;
+   }
+
+   retired = buffer;
+   if (buffer != NULL) {
+      retiredSize = length + 1;
+      cacheBytes += retiredSize;
+   }
+   return buffer;
+}
+
+/* see compressor.h for specification */
+boolean Compressor_isActive(void) {
+   return (boolean)(threshold != 0);
+}
+
+/* see compressor.h for specification */
+void *Compressor_copy(const void *contents, size_t length) {
+   void *copy;
+
+   assert(contents != NULL);
+
+   /* one extra byte, so that empty contents still get a buffer */
+   copy = malloc(length + 1);
+   if (copy == NULL)
+      return NULL;
+
+   memcpy(copy, contents, length);
+   copiedBytes += length + 1;
+   return copy;
+}
+
+/* see compressor.h for specification */
+void *Compressor_drop(void *copy, size_t length, boolean retire) {
+
+   assert(copy != NULL);
+
+   Compressor_freeRetired();
+   copiedBytes -= length + 1;
+
+   if (!retire) {
+      free(copy);
+      return NULL;
+   }
+
+   retired = copy;
+   retiredSize = length + 1;
+   cacheBytes += retiredSize;
+   return copy;
+}
+
+/* see compressor.h for specification */
+void Compressor_getStats(size_t *pNumPacked, size_t *pPackedBytes,
+                         size_t *pLogicalBytes, size_t *pNumHits,
+                         size_t *pNumMisses) {
+   assert(pNumPacked != NULL);
+   assert(pPackedBytes != NULL);
+   assert(pLogicalBytes != NULL);
+   assert(pNumHits != NULL);
+   assert(pNumMisses != NULL);
+
+   *pNumPacked = numPacked;
+   *pPackedBytes = packedBytes;
+   *pLogicalBytes = logicalBytes;
+   *pNumHits = numHits;
+   *pNumMisses = numMisses;
+}
+
+/* see compressor.h for specification */
+size_t Compressor_getCacheBytes(void) {
+   return cacheBytes;
+}
+
+/* see compressor.h for specification */
+size_t Compressor_getCopiedBytes(void) {
+   return copiedBytes;
+}
@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------*/
+/* compressor.h                                                       */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef COMPRESSOR_INCLUDED
+#define COMPRESSOR_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+   The Compressor is an AO that packs large file contents with a small
+   LZ77-family block codec and unpacks them on demand into a cache of
+   the few most recently read contents. Each cached buffer is keyed by
+   the owner (a file) whose packed contents it holds.
+*/
+
+/*
+   Sets the compressor to initialized status. Contents of at least
+   threshold bytes will be packed; a threshold of 0 disables packing.
+*/
+void Compressor_init(size_t threshold);
+
+/*
+   Frees every cached buffer and returns the compressor to
+   uninitialized (disabled) status.
+*/
+void Compressor_destroy(void);
+
+/*
+   If contents is not NULL, length is at least the threshold, and
+   packing saves space, returns a newly allocated packed copy of the
+   length bytes at contents and stores its length in *pPackedLength.
+
+   Otherwise, or if unable to allocate sufficient memory, returns NULL.
+   The packed copy is then owned by the caller!
+*/
+void *Compressor_pack(const void *contents, size_t length,
+                      size_t *pPackedLength);
+
+/*
+   Returns the length unpacked bytes of owner's packedLength packed
+   bytes at packed, from the cache if present. The returned buffer is
+   owned by the compressor and stays valid until owner's entry is
+   evicted by reads of other owners or until Compressor_forget is
+   called for owner.
+
+   Returns NULL if unable to allocate sufficient memory.
+*/
+void *Compressor_unpack(const void *owner, const void *packed,
+                        size_t packedLength, size_t length);
+
+/*
+   Drops owner's cached buffer (if any) and stops accounting for
+   its packedLength packed bytes of length unpacked bytes.
+
+   If retire is TRUE, returns owner's unpacked bytes in a buffer that
+   stays valid until the next call to Compressor_forget or
+   Compressor_destroy (NULL if unable to allocate it).
+   Otherwise, returns NULL.
+*/
+void *Compressor_forget(const void *owner, const void *packed,
+                        size_t packedLength, size_t length,
+                        boolean retire);
+
+/*
+   Returns TRUE if the compressor packs contents, that is if it was
+   initialized with a threshold other than 0, and FALSE otherwise.
+*/
+boolean Compressor_isActive(void);
+
+/*
+   Returns a newly allocated copy of the length bytes at contents, for
+   contents that Compressor_pack does not pack but that must not stay
+   the client's, and accounts for it until Compressor_drop. Returns
+   NULL if unable to allocate sufficient memory.
+   The copy is then owned by the caller!
+*/
+void *Compressor_copy(const void *contents, size_t length);
+
+/*
+   Stops accounting for copy, of length bytes, returned by
+   Compressor_copy. If retire is TRUE, returns copy, which stays valid
+   until the next call to Compressor_forget, Compressor_drop or
+   Compressor_destroy. Otherwise, frees copy and returns NULL.
+*/
+void *Compressor_drop(void *copy, size_t length, boolean retire);
+
+/*
+   Stores in *pNumPacked the number of packed contents, in
+   *pPackedBytes and *pLogicalBytes their packed and unpacked bytes,
+   and in *pNumHits and *pNumMisses the number of reads served from
+   and not from the cache.
+*/
+void Compressor_getStats(size_t *pNumPacked, size_t *pPackedBytes,
+                         size_t *pLogicalBytes, size_t *pNumHits,
+                         size_t *pNumMisses);
+
+/*
+   Returns the bytes held by the cache of unpacked contents, and by
+   the buffer returned by the last Compressor_forget or
+   Compressor_drop.
+*/
+size_t Compressor_getCacheBytes(void);
+
+/*
+   Returns the bytes of the copies returned by Compressor_copy and not
+   yet dropped.
+*/
+size_t Compressor_getCopiedBytes(void);
+
+#endif
@@ -0,0 +1,255 @@
+/*--------------------------------------------------------------------*/
+/* contentstore.c                                                     */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "contentstore.h"
+#include "namekey.h"
+
+/*
+   A blob is a reference-counted copy of some contents. Its bytes are
+   allocated right after the struct, so a blob's address can be
+   recovered from the address of its bytes.
+*/
+struct blob {
+   /* the hash of this blob's bytes */
+   unsigned long hash;
+
+   /* the number of bytes in this blob */
+   size_t length;
+
+   /* the number of files referencing this blob */
+   size_t refCount;
+
+   /* the next blob in the same bucket */
+   struct blob *next;
+};
+
+/* The minimum (and initial) number of buckets in the table */
+static const size_t MIN_BUCKETS = 64;
+
+/* The ContentStore is an AO with the following state variables: */
+
+/* a flag for if the store is active (TRUE) or not (FALSE) */
+static boolean isActive;
+/* the hash table of blobs, chained by bucket */
+static struct blob **buckets;
+/* the number of buckets in the table */
+static size_t numBuckets;
+/* the number of blobs in the table */
+static size_t numBlobs;
+/* the number of references to all blobs */
+static size_t numRefs;
+/* the bytes held by all blobs */
+static size_t storedBytes;
+/* the bytes all references would hold without sharing */
+static size_t logicalBytes;
+/* a blob whose release was deferred by ContentStore_releaseLater */
+static void *pendingBlob;
+
+
+/* Returns the bytes of blob */
+static void *ContentStore_bytesOf(struct blob *blob) {
+   assert(blob != NULL);
+   return (void *)(blob + 1);
+}
+
+/* Returns the blob whose bytes are at bytes */
+static struct blob *ContentStore_blobOf(void *bytes) {
+   assert(bytes != NULL);
+   return ((struct blob *)bytes) - 1;
+}
+
+/* Doubles the number of buckets, rehashing every blob. If unable to
+   allocate sufficient memory, leaves the table unchanged. */
+static void ContentStore_grow(void) {
+   struct blob **newBuckets;
+   struct blob *blob;
+   struct blob *next;
+   size_t newNum = 2 * numBuckets;
+   size_t i;
+   size_t b;
+
+   newBuckets = (struct blob **)calloc(newNum, sizeof(struct blob *));
+   if (newBuckets == NULL)
+      return;
+
+   for (i = 0; i < numBuckets; i++) {
+      for (blob = buckets[i]; blob != NULL; blob = next) {
+         next = blob->next;
+         b = blob->hash % newNum;
+         blob->next = newBuckets[b];
+         newBuckets[b] = blob;
+      }
+   }
+
+   free(buckets);
+   buckets = newBuckets;
+   numBuckets = newNum;
+}
+
+/* Drops one reference to blob, unlinking and freeing it if that was
+   its last reference */
+static void ContentStore_drop(struct blob *blob) {
+   struct blob **link;
+
+   assert(blob != NULL);
+   assert(blob->refCount > 0);
+
+   blob->refCount--;
+   numRefs--;
+   logicalBytes -= blob->length;
+
+   if (blob->refCount > 0)
+      return;
+
+   link = &buckets[blob->hash % numBuckets];
+   while (*link != blob)
+      link = &(*link)->next;
+   *link = blob->next;
+
+   numBlobs--;
+   storedBytes -= blob->length;
+   free(blob);
+}
+
+/* Drops the reference deferred by ContentStore_releaseLater, if any */
+static void ContentStore_flushPending(void) {
+   if (pendingBlob != NULL) {
+      ContentStore_drop(ContentStore_blobOf(pendingBlob));
+      pendingBlob = NULL;
+   }
+}
+
+/* see contentstore.h for specification */
+void ContentStore_init(boolean enabled) {
+   isActive = FALSE;
+   buckets = NULL;
+   numBuckets = 0;
+   numBlobs = 0;
+   numRefs = 0;
+   storedBytes = 0;
+   logicalBytes = 0;
+   pendingBlob = NULL;
+
+   if (!enabled)
+      return;
+
+   buckets = (struct blob **)calloc(MIN_BUCKETS, sizeof(struct blob *));
+
+   /* without a table, the store simply stays inactive */
+   if (buckets == NULL)
+      return;
+
+   numBuckets = MIN_BUCKETS;
+   isActive = TRUE;
+}
+
+/* see contentstore.h for specification */
+void ContentStore_destroy(void) {
+   struct blob *blob;
+   struct blob *next;
+   size_t i;
+
+   for (i = 0; i < numBuckets; i++) {
+      for (blob = buckets[i]; blob != NULL; blob = next) {
+         next = blob->next;
+         free(blob);
+      }
+   }
+
+   free(buckets);
+   ContentStore_init(FALSE);
+}
+
+/* see contentstore.h for specification */
+boolean ContentStore_isActive(void) {
+   return isActive;
+}
+
+/* see contentstore.h for specification */
+void *ContentStore_acquire(void *contents, size_t length) {
+   struct blob *blob;
+   unsigned long hash;
+   size_t b;
+
+   if (!isActive || contents == NULL)
+      return contents;
+
+   ContentStore_flushPending();
+
+   hash = NameKey_hash(NAMEKEY_HASH_BASIS, contents, length);
+   b = hash % numBuckets;
+
+   /* Shares an existing blob with identical bytes, if any */
+   for (blob = buckets[b]; blob != NULL; blob = blob->next) {
+      if (blob->hash == hash && blob->length == length &&
+          memcmp(ContentStore_bytesOf(blob), contents, length) == EQUAL)
+         break;
+   }
+
+   if (blob == NULL) {
+      blob = (struct blob *)malloc(sizeof(struct blob) + length);
+      if (blob == NULL)
+         return NULL;
+
+      blob->hash = hash;
+      blob->length = length;
+      blob->refCount = 0;
+      memcpy(ContentStore_bytesOf(blob), contents, length);
+
+      blob->next = buckets[b];
+      buckets[b] = blob;
+      numBlobs++;
+      storedBytes += length;
+
+      if (numBlobs > numBuckets)
+         ContentStore_grow();
+   }
+
+   blob->refCount++;
+   numRefs++;
+   logicalBytes += length;
+
+   return ContentStore_bytesOf(blob);
+}
+
+/* see contentstore.h for specification */
+void ContentStore_release(void *blob) {
+   if (!isActive || blob == NULL)
+      return;
+
+   ContentStore_flushPending();
+   ContentStore_drop(ContentStore_blobOf(blob));
+}
+
+/* see contentstore.h for specification */
+void ContentStore_releaseLater(void *blob) {
+   if (!isActive || blob == NULL)
+      return;
+
+   ContentStore_flushPending();
+   pendingBlob = blob;
+}
+
+/* see contentstore.h for specification */
+void ContentStore_getStats(size_t *pNumBlobs, size_t *pNumRefs,
+                           size_t *pStoredBytes,
+                           size_t *pLogicalBytes) {
+   assert(pNumBlobs != NULL);
+   assert(pNumRefs != NULL);
+   assert(pStoredBytes != NULL);
+   assert(pLogicalBytes != NULL);
+
+   *pNumBlobs = numBlobs;
+   *pNumRefs = numRefs;
+   *pStoredBytes = storedBytes;
+   *pLogicalBytes = logicalBytes;
+}
+
+/* see contentstore.h for specification */
+size_t ContentStore_getTableBytes(void) {
+   return numBuckets * sizeof(struct blob *) +
+      numBlobs * sizeof(struct blob);
+}
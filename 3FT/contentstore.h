@@ -0,0 +1,78 @@
+/*--------------------------------------------------------------------*/
+/* contentstore.h                                                     */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef CONTENTSTORE_INCLUDED
+#define CONTENTSTORE_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+   The ContentStore is an AO that keeps a single reference-counted copy
+   (a blob) of each distinct file contents, so that files with
+   identical contents share the same bytes. Blobs are looked up by a
+   hash of their bytes and freed when their last reference goes.
+*/
+
+/*
+   Sets the store to initialized status, active if enabled is TRUE.
+   While the store is not active, ContentStore_acquire returns its
+   contents parameter unchanged and ContentStore_release does nothing.
+*/
+void ContentStore_init(boolean enabled);
+
+/*
+   Frees every blob still in the store and returns it to uninitialized
+   (inactive) status.
+*/
+void ContentStore_destroy(void);
+
+/*
+   Returns TRUE if the store is active and FALSE otherwise.
+*/
+boolean ContentStore_isActive(void);
+
+/*
+   If the store is active and contents is not NULL, returns the blob
+   holding a copy of the length bytes at contents, creating it if no
+   blob with identical bytes exists yet, and adds one reference to it.
+   Returns NULL if unable to allocate sufficient memory.
+
+   Otherwise, returns contents.
+*/
+void *ContentStore_acquire(void *contents, size_t length);
+
+/*
+   If the store is active and blob is not NULL, drops one reference
+   to blob (a value returned by ContentStore_acquire), freeing it if
+   that was its last reference.
+*/
+void ContentStore_release(void *blob);
+
+/*
+   Works as ContentStore_release, but the reference is only dropped
+   during the next call to ContentStore_acquire, ContentStore_release,
+   ContentStore_releaseLater or ContentStore_destroy, so that the
+   bytes at blob stay valid until then.
+*/
+void ContentStore_releaseLater(void *blob);
+
+/*
+   Stores in *pNumBlobs the number of distinct blobs, in *pNumRefs the
+   number of references to them, in *pStoredBytes the bytes held by
+   the blobs, and in *pLogicalBytes the bytes the references would
+   hold if each had its own copy.
+*/
+void ContentStore_getStats(size_t *pNumBlobs, size_t *pNumRefs,
+                           size_t *pStoredBytes,
+                           size_t *pLogicalBytes);
+
+/*
+   Returns the bytes held by the table of blobs beyond their contents:
+   its buckets and the headers of its blobs.
+*/
+size_t ContentStore_getTableBytes(void);
+
+#endif
@@ -0,0 +1,116 @@
+/*--------------------------------------------------------------------*/
+/* delta.c                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "delta.h"
+
+/* The bits of a number each byte of a stream holds, and the bit set
+   in every byte of a number but the last */
+enum {NUMBER_BITS = 7, MORE_BIT = 0x80};
+
+/* see delta.h for specification */
+boolean Delta_putNumber(FILE *stream, unsigned long number) {
+   unsigned char bytes[sizeof(unsigned long) * 8 / NUMBER_BITS + 1];
+   size_t length = 0;
+
+   assert(stream != NULL);
+
+   do {
+      bytes[length] = (unsigned char)(number & (MORE_BIT - 1));
+      number >>= NUMBER_BITS;
+      if (number != 0)
+         bytes[length] |= MORE_BIT;
+      length++;
+   } while (number != 0);
+
+   return Delta_putBytes(stream, bytes, length);
+}
+
+/* see delta.h for specification */
+boolean Delta_putBytes(FILE *stream, const void *bytes, size_t length) {
+   assert(stream != NULL);
+   assert(bytes != NULL || length == 0);
+
+   if (length == 0)
+      return TRUE;
+
+   return (boolean)(fwrite(bytes, 1, length, stream) == length);
+}
+
+/* see delta.h for specification */
+boolean Delta_putString(FILE *stream, const char *string) {
+   size_t length;
+
+   assert(string != NULL);
+
+   length = strlen(string);
+
+   return (boolean)(Delta_putNumber(stream, (unsigned long)length) &&
+                    Delta_putBytes(stream, string, length));
+}
+
+/* see delta.h for specification */
+boolean Delta_getNumber(FILE *stream, unsigned long *number) {
+   unsigned long value = 0;
+   unsigned long part;
+   size_t shift = 0;
+   int byte;
+
+   assert(stream != NULL);
+   assert(number != NULL);
+
+   do {
+      byte = getc(stream);
+      if (byte == EOF || shift >= sizeof(unsigned long) * 8)
+         return FALSE;
+
+      /* the bits must not overflow an unsigned long */
+      part = (unsigned long)(byte & (MORE_BIT - 1));
+      if (shift > 0 && (part >> (sizeof(unsigned long) * 8 - shift)) != 0)
+         return FALSE;
+
+      value |= part << shift;
+      shift += NUMBER_BITS;
+   } while ((byte & MORE_BIT) != 0);
+
+   *number = value;
+   return TRUE;
+}
+
+/* see delta.h for specification */
+int Delta_getBytes(FILE *stream, size_t length, char **pBytes) {
+   char *bytes;
+
+   assert(stream != NULL);
+   assert(pBytes != NULL);
+
+   if (length == (size_t)-1)
+      return CONFLICTING_PATH;
+
+   bytes = (char *)malloc(length + 1);
+   if (bytes == NULL)
+      return MEMORY_ERROR;
+
+   if (fread(bytes, 1, length, stream) != length) {
+      free(bytes);
+      return CONFLICTING_PATH;
+   }
+
+   bytes[length] = '\0';
+   *pBytes = bytes;
+   return SUCCESS;
+}
+
+/* see delta.h for specification */
+int Delta_getString(FILE *stream, char **pString) {
+   unsigned long length;
+
+   assert(pString != NULL);
+
+   if (!Delta_getNumber(stream, &length) || length > (size_t)-1)
+      return CONFLICTING_PATH;
+
+   return Delta_getBytes(stream, (size_t)length, pString);
+}
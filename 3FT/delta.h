@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------*/
+/* delta.h                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef DELTA_INCLUDED
+#define DELTA_INCLUDED
+
+#include <stdio.h>
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+   The Delta module reads and writes the binary streams in which
+   FT_exportDelta and FT_applyDelta carry the changes made to a tree.
+   A stream is a sequence of numbers and of byte strings: a number is
+   written in as few bytes as it needs, 7 bits to a byte, least
+   significant first, with the high bit of each byte but the last set;
+   a string is its length, as a number, followed by its bytes.
+
+   A delta starts with DELTA_MAGIC and is followed by records, each a
+   number telling its kind (see below) and its fields, the last of
+   which is a DELTA_END record.
+*/
+
+/* The number that starts a delta, "FTD1" in ASCII */
+#define DELTA_MAGIC 0x31445446UL
+
+/* The kinds of records of a delta */
+enum {
+   /* the path of the root, the empty string if there is none */
+   DELTA_ROOT,
+   /* the path of a directory, then the number and names of its files,
+      and the number and names of its directories, in order by name */
+   DELTA_DIR,
+   /* the path of a file, the length of its contents, 1 if they are
+      not NULL and 0 otherwise, and then, if 1, the contents */
+   DELTA_FILE,
+   /* the end of the delta */
+   DELTA_END
+};
+
+/*
+   Writes number to stream.
+   Returns FALSE if unable to write it, and TRUE otherwise.
+*/
+boolean Delta_putNumber(FILE *stream, unsigned long number);
+
+/*
+   Writes the length bytes at bytes to stream, without their length.
+   Returns FALSE if unable to write them, and TRUE otherwise.
+*/
+boolean Delta_putBytes(FILE *stream, const void *bytes, size_t length);
+
+/*
+   Writes the string string, with its length, to stream.
+   Returns FALSE if unable to write it, and TRUE otherwise.
+*/
+boolean Delta_putString(FILE *stream, const char *string);
+
+/*
+   Reads a number from stream into *number.
+   Returns FALSE, leaving *number unchanged, if stream ends first or
+   the number does not fit an unsigned long, and TRUE otherwise.
+*/
+boolean Delta_getNumber(FILE *stream, unsigned long *number);
+
+/*
+   Reads length bytes from stream into a new buffer, followed by a
+   '\0' byte, and stores it in *pBytes.
+   Returns CONFLICTING_PATH if stream ends first, MEMORY_ERROR if
+   unable to allocate the buffer, leaving *pBytes unchanged in both
+   cases, and SUCCESS otherwise.
+
+   Allocates memory for the buffer, which is then owned by client!
+*/
+int Delta_getBytes(FILE *stream, size_t length, char **pBytes);
+
+/*
+   Reads a string, with its length, from stream, as Delta_getBytes
+   does.
+*/
+int Delta_getString(FILE *stream, char **pString);
+
+#endif
@@ -3,10 +3,50 @@
 /* Authors: Julio Lins and Rishabh Rout                               */
 /*--------------------------------------------------------------------*/
 
-#include "dynarray.h"
 #include "checkerFT.h"
 #include "defs.h"
 #include "a4def.h"
+#include "intern.h"
+#include "namekey.h"
+#include "chunkseq.h"
+#include "metrics.h"
+#include "epoch.h"
+#include "lock.h"
+
+/* The Directory module accounts for the memory of all directories in
+   the following state variables, which writers holding the locks of
+   different directories update with Lock_add: */
+
+/* the number of directories */
+static size_t numDirs;
+/* the bytes of their structures and of their paths */
+static size_t nodeBytes;
+static size_t pathBytes;
+/* the bytes allocated for their arrays and sequences of children,
+   and the bytes of those holding children */
+static size_t arrayBytes;
+static size_t arrayUsedBytes;
+
+/* the latest version stamped on a directory or file (see
+   Dir_stampTree), which only grows, across FT_init and FT_destroy */
+static unsigned long latestVersion;
+
+/* the typed arrays report their memory to the state variables */
+#define TYPEDARRAY_ACCOUNT(allocated, freed, used, unused)             \
+   (Lock_add(arrayBytes, (size_t)(allocated) - (freed)),              \
+    Lock_add(arrayUsedBytes, (size_t)(used) - (unused)),               \
+    (allocated) != 0 ? Metrics_count(METRICS_ALLOCATIONS) : (void)0)
+
+#include "typedarray.h"
+
+/* The number of children of a type past which a directory keeps them
+   in a ChunkSeq_T, where adding or removing one in the middle does not
+   move all those after it */
+enum {SEQ_THRESHOLD = 1024};
+
+/* The arrays of children, specialized for their element types */
+DEFINE_DYNARRAY(DirArray, Dir_T, Dir_compare);
+DEFINE_DYNARRAY(FileArray, File_T, File_compare);
 
 /*
    A directory structure represents a directory in the file tree
@@ -16,54 +56,387 @@ struct directory {
    /* the full path of this directory */
    char* path;
 
-   /* the parent directory of this directory
-      NULL for the root of the directory tree */
+   /* the last component of path, interned */
+   const char* name;
+
+   /* the key of name, to compare names without reading them */
+   struct NameKey key;
+
+   /* the parent directory of this directory, in the live tree if
+      this directory is in it,
+      NULL for the root of the directory tree, and once only
+      snapshots hold this directory and its parent may be gone */
    Dir_T parent;
 
    /* the files of this directory
-      stored in sorted order by pathname */
-   DynArray_T fileC;
+      stored in sorted order by pathname,
+      NULL once they are kept in fileSeq.
+      While Epoch is active, these four fields are changed only by
+      publishing new versions (see epoch.h) */
+   FileArray_T fileC;
 
    /* the subdirectories of this directory
-      stored in sorted order by pathname */
-   DynArray_T dirC;
+      stored in sorted order by pathname,
+      NULL once they are kept in dirSeq */
+   DirArray_T dirC;
+
+   /* the files and subdirectories of this directory, in the same
+      order, once there have been more than SEQ_THRESHOLD of them;
+      NULL until then */
+   ChunkSeq_T fileSeq;
+   ChunkSeq_T dirSeq;
+
+   /* the lock a writer holds while it changes the children of this
+      directory, or looks for one to lock next (see Dir_lock) */
+   struct Lock lock;
+
+   /* the number of directories whose children include this one, in
+      the live tree and in snapshots of it, plus the number of trees,
+      live or snapshots, whose root it is (see Dir_copy) */
+   size_t refCount;
+
+   /* the Merkle hash of the hierarchy below this directory, valid
+      unless dirty is TRUE, which it then also is for every directory
+      above this one (see Dir_getHash) */
+   unsigned long hash;
+   boolean dirty;
+
+   /* the version at which this directory was created or last lost a
+      child, and the latest version stamped on it or on anything below
+      it (see Dir_getVersion) */
+   unsigned long version;
+   unsigned long treeVersion;
+};
+
+/* A name sought among the children of a directory */
+struct probe {
+   const struct NameKey* key;
+   const char* name;
 };
 
 
-/* returns a path with contents parent->path / dir
-   or NULL if there is an allocation error.
+/* returns a path with contents parent->path / the length bytes at
+   dir, or NULL if there is an allocation error.
 
    Allocates memory for the returned string,
    which is then owned by the called! */
 
-static char* Dir_buildPath(Dir_T parent, const char* dir) {
+static char* Dir_buildPath(Dir_T parent, const char* dir,
+                           size_t length) {
 
    char* path;
+   size_t parentLength = 0;
 
    assert(dir != NULL);
 
-   if (parent == NULL)
-      path = (char*)malloc(strlen(dir) + 1);  
-   else
-      path = (char*)malloc(strlen(parent->path) + 1 + strlen(dir) + 1);
+   if (parent != NULL)
+      parentLength = strlen(parent->path) + 1;
+
+   path = (char*)malloc(parentLength + length + 1);
    
    if (path == NULL)
       return NULL;
 
-   *path = '\0';
+   Metrics_count(METRICS_ALLOCATIONS);
 
    if (parent != NULL) {
-      strcpy(path, parent->path);
-      strcat(path, "/");
+      memcpy(path, parent->path, parentLength - 1);
+      path[parentLength - 1] = '/';
    }
 
-   strcat(path, dir);
+   memcpy(path + parentLength, dir, length);
+   path[parentLength + length] = '\0';
 
    return path;
 }
 
+/* Returns the number of children of the given type of parent */
+static size_t Dir_childCount(Dir_T parent, int type) {
+
+   if (type == DIR)
+      return parent->dirSeq != NULL ?
+         ChunkSeq_getLength(parent->dirSeq) :
+         DirArray_getLength(parent->dirC);
+
+   return parent->fileSeq != NULL ?
+      ChunkSeq_getLength(parent->fileSeq) :
+      FileArray_getLength(parent->fileC);
+}
+
+/* Returns the child of the given type of parent at index */
+static void* Dir_childAt(Dir_T parent, int type, size_t index) {
+
+   if (type == DIR)
+      return parent->dirSeq != NULL ?
+         ChunkSeq_get(parent->dirSeq, index) :
+         DirArray_get(parent->dirC, index);
+
+   return parent->fileSeq != NULL ?
+      ChunkSeq_get(parent->fileSeq, index) :
+      FileArray_get(parent->fileC, index);
+}
+
+/* Frees dirs, a DirArray_T of children, for Epoch_retire */
+static void Dir_releaseDirArray(void* dirs) {
+   DirArray_free((DirArray_T)dirs);
+}
+
+/* Frees files, a FileArray_T of children, for Epoch_retire */
+static void Dir_releaseFileArray(void* files) {
+   FileArray_free((FileArray_T)files);
+}
+
+/* Releases seq, a sequence of children that a copy replaced, after
+   accounting for it, for Epoch_retire */
+static void Dir_releaseSeq(void* seq) {
+   Lock_sub(arrayBytes, ChunkSeq_getBytes((ChunkSeq_T)seq));
+   ChunkSeq_release((ChunkSeq_T)seq);
+}
+
+/* Moves the children of the given type of parent from their array to
+   a new ChunkSeq_T. Returns FALSE, leaving them in the array, if
+   unable to allocate sufficient memory. */
+static boolean Dir_moveToSeq(Dir_T parent, int type) {
+
+   ChunkSeq_T seq;
+   DirArray_T dirs;
+   FileArray_T files;
+   size_t length;
+   size_t i;
+
+   seq = ChunkSeq_new();
+   if (seq == NULL)
+      return FALSE;
+
+   length = Dir_childCount(parent, type);
+   for (i = 0; i < length; i++) {
+      if (!ChunkSeq_addAt(seq, i, Dir_childAt(parent, type, i))) {
+         ChunkSeq_free(seq);
+         return FALSE;
+      }
+   }
+
+   Lock_add(arrayBytes, ChunkSeq_getBytes(seq));
+   Lock_add(arrayUsedBytes, length * sizeof(void*));
+
+   /* readers that find no array look for the sequence, so it is
+      published first */
+   if (type == DIR) {
+      dirs = parent->dirC;
+      Epoch_publish(parent->dirSeq, seq);
+      Epoch_publish(parent->dirC, NULL);
+      Epoch_retire(dirs, Dir_releaseDirArray);
+   }
+   else {
+      files = parent->fileC;
+      Epoch_publish(parent->fileSeq, seq);
+      Epoch_publish(parent->fileC, NULL);
+      Epoch_retire(files, Dir_releaseFileArray);
+   }
+
+   return TRUE;
+}
+
+/* Adds child as the child of the given type of parent at index, or
+   removes the child there if child is NULL, by publishing a copy of
+   those children with the change, for readers that may be reading
+   them (see epoch.h). Returns TRUE if successful, or FALSE, leaving
+   parent unchanged, if unable to allocate sufficient memory. */
+static boolean Dir_publishChange(Dir_T parent, int type, size_t index,
+                                 void* child) {
+
+   ChunkSeq_T seq;
+   ChunkSeq_T copy;
+   DirArray_T dirs;
+   FileArray_T files;
+   void* old;
+   size_t before;
+
+   seq = type == DIR ? parent->dirSeq : parent->fileSeq;
+
+   if (seq == NULL && type == DIR) {
+      dirs = child != NULL ?
+         DirArray_addAtCopy(parent->dirC, index, (Dir_T)child) :
+         DirArray_removeAtCopy(parent->dirC, index);
+      if (dirs == NULL)
+         return FALSE;
+
+      old = parent->dirC;
+      Epoch_publish(parent->dirC, dirs);
+      Epoch_retire(old, Dir_releaseDirArray);
+      return TRUE;
+   }
+
+   if (seq == NULL) {
+      files = child != NULL ?
+         FileArray_addAtCopy(parent->fileC, index, (File_T)child) :
+         FileArray_removeAtCopy(parent->fileC, index);
+      if (files == NULL)
+         return FALSE;
+
+      old = parent->fileC;
+      Epoch_publish(parent->fileC, files);
+      Epoch_retire(old, Dir_releaseFileArray);
+      return TRUE;
+   }
+
+   /* the copy shares all but a path of nodes with seq */
+   before = ChunkSeq_getBytes(seq);
+   copy = child != NULL ? ChunkSeq_addAtCopy(seq, index, child) :
+      ChunkSeq_removeAtCopy(seq, index);
+   if (copy == NULL)
+      return FALSE;
+
+   Metrics_count(METRICS_ALLOCATIONS);
+   Lock_add(arrayBytes, ChunkSeq_getBytes(copy) +
+            ChunkSeq_getBytes(seq) - before);
+   if (child != NULL)
+      Lock_add(arrayUsedBytes, sizeof(void*));
+   else
+      Lock_sub(arrayUsedBytes, sizeof(void*));
+
+   if (type == DIR)
+      Epoch_publish(parent->dirSeq, copy);
+   else
+      Epoch_publish(parent->fileSeq, copy);
+   Epoch_retire(seq, Dir_releaseSeq);
+   return TRUE;
+}
+
+/* Adds child as the child of the given type of parent at index,
+   first moving those children to a ChunkSeq_T if there are too many
+   for an array. Returns TRUE if successful, or FALSE if unable to
+   allocate sufficient memory. */
+static boolean Dir_addChildAt(Dir_T parent, int type, size_t index,
+                              void* child) {
+
+   ChunkSeq_T seq;
+   size_t before;
+   boolean added;
+
+   /* stays with the array if the sequence cannot be allocated */
+   if (Dir_childCount(parent, type) == SEQ_THRESHOLD &&
+       ((type == DIR && parent->dirSeq == NULL) ||
+        (type == FILES && parent->fileSeq == NULL)))
+      (void) Dir_moveToSeq(parent, type);
+
+   if (Epoch_isActive())
+      return Dir_publishChange(parent, type, index, child);
+
+   seq = type == DIR ? parent->dirSeq : parent->fileSeq;
+
+   if (seq == NULL) {
+      if (type == DIR)
+         return (boolean)DirArray_addAt(parent->dirC, index,
+                                        (Dir_T)child);
+      return (boolean)FileArray_addAt(parent->fileC, index,
+                                      (File_T)child);
+   }
+
+   before = ChunkSeq_getBytes(seq);
+   added = (boolean)ChunkSeq_addAt(seq, index, child);
+   if (ChunkSeq_getBytes(seq) != before)
+      Metrics_count(METRICS_ALLOCATIONS);
+   Lock_add(arrayBytes, ChunkSeq_getBytes(seq) - before);
+   if (added)
+      Lock_add(arrayUsedBytes, sizeof(void*));
+
+   return added;
+}
+
+/* Removes the child of the given type of parent at index. Returns
+   TRUE if successful, or FALSE, leaving parent unchanged, if Epoch is
+   active and there is not enough memory for a copy of the children. */
+static boolean Dir_removeChildAt(Dir_T parent, int type, size_t index) {
+
+   ChunkSeq_T seq;
+   size_t before;
+
+   if (Epoch_isActive())
+      return Dir_publishChange(parent, type, index, NULL);
+
+   seq = type == DIR ? parent->dirSeq : parent->fileSeq;
+
+   if (seq == NULL) {
+      if (type == DIR)
+         (void) DirArray_removeAt(parent->dirC, index);
+      else
+         (void) FileArray_removeAt(parent->fileC, index);
+      return TRUE;
+   }
+
+   before = ChunkSeq_getBytes(seq);
+   (void) ChunkSeq_removeAt(seq, index);
+   Lock_sub(arrayBytes, before - ChunkSeq_getBytes(seq));
+   Lock_sub(arrayUsedBytes, sizeof(void*));
+   return TRUE;
+}
+
+/* Frees seq, a sequence of children, after accounting for it */
+static void Dir_freeSeq(ChunkSeq_T seq) {
+
+   Lock_sub(arrayBytes, ChunkSeq_getBytes(seq));
+   Lock_sub(arrayUsedBytes, ChunkSeq_getLength(seq) * sizeof(void*));
+   ChunkSeq_free(seq);
+}
+
+/* Compares the name sought (a struct probe) with the name of
+   element, a Dir_T, for ChunkSeq_bsearch */
+static int Dir_compareProbe(const void* sought, const void* element) {
+
+   const struct probe* probe = (const struct probe*)sought;
+   const struct directory* dir = (const struct directory*)element;
+
+   Metrics_count(METRICS_COMPARISONS);
+   return NameKey_compare(probe->key, probe->name, &dir->key,
+                          dir->name);
+}
+
+/* Compares the name sought (a struct probe) with the name of
+   element, a File_T, for ChunkSeq_bsearch */
+static int Dir_compareFileProbe(const void* sought,
+                                const void* element) {
+
+   const struct probe* probe = (const struct probe*)sought;
+   File_T file = (File_T)element;
+
+   Metrics_count(METRICS_COMPARISONS);
+   return NameKey_compare(probe->key, probe->name, File_getKey(file),
+                          File_getName(file));
+}
+
+/* A directory dropping its references to its children, and the
+   number of directories and files destroyed meanwhile */
+struct drop {
+   Dir_T holder;
+   size_t count;
+};
+
+static size_t Dir_release(Dir_T dir);
+
+/* Drops the reference of drop->holder to child, a Dir_T, adding the
+   number of directories and files destroyed to drop->count, for
+   ChunkSeq_map. A snapshot that still holds child must not reach
+   drop->holder, which is being destroyed, through child's parent. */
+static void Dir_destroyDir(void* child, void* drop) {
+   struct drop* d = (struct drop*)drop;
+
+   if (((Dir_T)child)->refCount > 1 &&
+       ((Dir_T)child)->parent == d->holder)
+      ((Dir_T)child)->parent = NULL;
+   d->count += Dir_release((Dir_T)child);
+}
+
+/* Drops the reference of drop->holder to child, a File_T, adding 1
+   to drop->count if it is destroyed, for ChunkSeq_map */
+static void Dir_destroyFile(void* child, void* drop) {
+   if (!File_isShared((File_T)child))
+      ((struct drop*)drop)->count++;
+   File_destroy((File_T)child);
+}
+
 /* see directory.h for specification */
-Dir_T Dir_create(Dir_T parent, const char* dir) {
+Dir_T Dir_create(Dir_T parent, const char* dir, size_t length) {
 
    Dir_T new_dir;
 
@@ -77,7 +450,9 @@ Dir_T Dir_create(Dir_T parent, const char* dir) {
       return NULL;
    }
 
-   new_dir->path = Dir_buildPath(parent, dir);
+   Metrics_count(METRICS_ALLOCATIONS);
+
+   new_dir->path = Dir_buildPath(parent, dir, length);
 
    if (new_dir->path == NULL) {
       free(new_dir);
@@ -85,11 +460,24 @@ Dir_T Dir_create(Dir_T parent, const char* dir) {
       return NULL;
    }
 
+   NameKey_init(&new_dir->key, dir, length);
+   new_dir->name = Intern_acquire(dir, length, new_dir->key.hash);
+
+   if (new_dir->name == NULL) {
+      free(new_dir->path);
+      free(new_dir);
+      assert(parent == NULL || CheckerFT_Dir_isValid(parent));
+      return NULL;
+   }
+
    new_dir->parent = parent;
-   new_dir->fileC = DynArray_new(0);
+   new_dir->fileSeq = NULL;
+   new_dir->dirSeq = NULL;
+   new_dir->fileC = FileArray_new(0);
    
    if (new_dir->fileC == NULL) {
       
+      Intern_release(new_dir->name);
       free(new_dir->path);
       free(new_dir);
       
@@ -97,11 +485,12 @@ Dir_T Dir_create(Dir_T parent, const char* dir) {
       return NULL;
    }
 
-   new_dir->dirC = DynArray_new(0);
+   new_dir->dirC = DirArray_new(0);
 
    if (new_dir->dirC == NULL) {
       
-      free(new_dir->fileC);
+      FileArray_free(new_dir->fileC);
+      Intern_release(new_dir->name);
       free(new_dir->path);
       free(new_dir);
 
@@ -109,52 +498,252 @@ Dir_T Dir_create(Dir_T parent, const char* dir) {
       return NULL;
    }
 
+   Lock_clear(&new_dir->lock);
+   new_dir->refCount = 1;
+   new_dir->hash = 0;
+   new_dir->dirty = TRUE;
+   new_dir->version = Epoch_isActive() ? 0 : ++latestVersion;
+   new_dir->treeVersion = new_dir->version;
+
+   Lock_add(numDirs, 1);
+   Lock_add(nodeBytes, sizeof(struct directory));
+   Lock_add(pathBytes, strlen(new_dir->path) + 1);
+
    assert(parent == NULL || CheckerFT_Dir_isValid(parent));
    assert(CheckerFT_Dir_isValid(new_dir));
    return new_dir;
 
 }
 
-/* see directory.h for specification */
-size_t Dir_destroy(Dir_T dir) {
-   
+/* Drops a reference to dir, destroying it and dropping its
+   references to its children if that was the last one, as Dir_destroy
+   does, but leaving dir's parent link alone. Returns the number of
+   directories and files destroyed. */
+static size_t Dir_release(Dir_T dir) {
+
+   struct drop drop;
    size_t i;
-   size_t count = 0;
-   
-   Dir_T dirChild;
-   size_t uDirLen;
-   
-   File_T fileChild;
-   size_t uFileLen;
 
-   
    assert(dir != NULL);
+   assert(dir->refCount > 0);
 
-   uDirLen = DynArray_getLength(dir->dirC);
-   uFileLen = DynArray_getLength(dir->fileC);
+   if (--dir->refCount > 0)
+      return 0;
 
+   drop.holder = dir;
+   drop.count = 0;
 
-   for (i = 0; i < uDirLen; i++) {
+   if (dir->dirSeq != NULL) {
+      ChunkSeq_map(dir->dirSeq, Dir_destroyDir, &drop);
+      Dir_freeSeq(dir->dirSeq);
+   }
+   else {
+      for (i = 0; i < DirArray_getLength(dir->dirC); i++)
+         Dir_destroyDir(DirArray_get(dir->dirC, i), &drop);
 
-      dirChild = DynArray_get(dir->dirC, i);
-      count += Dir_destroy(dirChild);
+      DirArray_free(dir->dirC);
    }
 
-   for (i = 0; i < uFileLen; i++) {
+   if (dir->fileSeq != NULL) {
+      ChunkSeq_map(dir->fileSeq, Dir_destroyFile, &drop);
+      Dir_freeSeq(dir->fileSeq);
+   }
+   else {
+      for (i = 0; i < FileArray_getLength(dir->fileC); i++)
+         Dir_destroyFile(FileArray_get(dir->fileC, i), &drop);
 
-      fileChild = DynArray_get(dir->fileC, i);
-      File_destroy(fileChild);
-      count++;
+      FileArray_free(dir->fileC);
    }
 
-   DynArray_free(dir->dirC);
-   DynArray_free(dir->fileC);
+   Lock_sub(numDirs, 1);
+   Lock_sub(nodeBytes, sizeof(struct directory));
+   Lock_sub(pathBytes, strlen(dir->path) + 1);
 
+   Intern_release(dir->name);
    free(dir->path);
    free(dir);
-   count++;
 
-   return count;
+   return drop.count + 1;
+}
+
+/* see directory.h for specification */
+size_t Dir_destroy(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   /* the snapshots still holding dir do not hold its parent */
+   if (dir->refCount > 1)
+      dir->parent = NULL;
+
+   return Dir_release(dir);
+}
+
+/* Gives copy, a new copy of dir, the children of the given type of
+   dir, in an array or a sequence as dir keeps them, without adding
+   references to them. Returns FALSE, leaving copy without them, if
+   unable to allocate sufficient memory. */
+static boolean Dir_copyChildren(Dir_T copy, Dir_T dir, int type) {
+
+   ChunkSeq_T seq;
+   DirArray_T dirs;
+   FileArray_T files;
+   size_t length;
+   size_t i;
+
+   length = Dir_childCount(dir, type);
+
+   if ((type == DIR ? dir->dirSeq : dir->fileSeq) != NULL) {
+      seq = ChunkSeq_new();
+      if (seq == NULL)
+         return FALSE;
+
+      for (i = 0; i < length; i++) {
+         if (!ChunkSeq_addAt(seq, i, Dir_childAt(dir, type, i))) {
+            ChunkSeq_free(seq);
+            return FALSE;
+         }
+      }
+
+      Lock_add(arrayBytes, ChunkSeq_getBytes(seq));
+      Lock_add(arrayUsedBytes, length * sizeof(void*));
+
+      if (type == DIR)
+         copy->dirSeq = seq;
+      else
+         copy->fileSeq = seq;
+      return TRUE;
+   }
+
+   if (type == DIR) {
+      dirs = DirArray_new(length);
+      if (dirs == NULL)
+         return FALSE;
+
+      for (i = 0; i < length; i++)
+         (void) DirArray_set(dirs, i, DirArray_get(dir->dirC, i));
+      copy->dirC = dirs;
+   }
+   else {
+      files = FileArray_new(length);
+      if (files == NULL)
+         return FALSE;
+
+      for (i = 0; i < length; i++)
+         (void) FileArray_set(files, i, FileArray_get(dir->fileC, i));
+      copy->fileC = files;
+   }
+
+   return TRUE;
+}
+
+/* see directory.h for specification */
+Dir_T Dir_copy(Dir_T dir, Dir_T parent) {
+
+   Dir_T copy;
+   Dir_T child;
+   size_t i;
+
+   assert(dir != NULL);
+   assert(!Epoch_isActive());
+
+   copy = (Dir_T)malloc(sizeof(struct directory));
+   if (copy == NULL)
+      return NULL;
+
+   Metrics_count(METRICS_ALLOCATIONS);
+
+   copy->path = (char*)malloc(strlen(dir->path) + 1);
+   if (copy->path == NULL) {
+      free(copy);
+      return NULL;
+   }
+
+   Metrics_count(METRICS_ALLOCATIONS);
+   strcpy(copy->path, dir->path);
+
+   copy->key = dir->key;
+   copy->name = Intern_acquire(dir->name, dir->key.length,
+                               dir->key.hash);
+   if (copy->name == NULL) {
+      free(copy->path);
+      free(copy);
+      return NULL;
+   }
+
+   copy->parent = parent;
+   copy->fileC = NULL;
+   copy->dirC = NULL;
+   copy->fileSeq = NULL;
+   copy->dirSeq = NULL;
+
+   if (!Dir_copyChildren(copy, dir, DIR) ||
+       !Dir_copyChildren(copy, dir, FILES)) {
+      if (copy->dirC != NULL)
+         DirArray_free(copy->dirC);
+      if (copy->dirSeq != NULL)
+         Dir_freeSeq(copy->dirSeq);
+      Intern_release(copy->name);
+      free(copy->path);
+      free(copy);
+      return NULL;
+   }
+
+   /* the children are now shared, and belong to the copy */
+   for (i = 0; i < Dir_childCount(copy, DIR); i++) {
+      child = Dir_childAt(copy, DIR, i);
+      child->refCount++;
+      child->parent = copy;
+   }
+
+   for (i = 0; i < Dir_childCount(copy, FILES); i++)
+      File_share(Dir_childAt(copy, FILES, i), copy);
+
+   Lock_clear(&copy->lock);
+   copy->refCount = 1;
+   copy->hash = dir->hash;
+   copy->dirty = dir->dirty;
+   copy->version = dir->version;
+   copy->treeVersion = dir->treeVersion;
+
+   Lock_add(numDirs, 1);
+   Lock_add(nodeBytes, sizeof(struct directory));
+   Lock_add(pathBytes, strlen(copy->path) + 1);
+
+   return copy;
+}
+
+/* see directory.h for specification */
+boolean Dir_isShared(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   return (boolean)(dir->refCount > 1);
+}
+
+/* see directory.h for specification */
+void Dir_adopt(Dir_T dir) {
+
+   Dir_T child;
+   size_t i;
+
+   assert(dir != NULL);
+
+   for (i = 0; i < Dir_childCount(dir, DIR); i++) {
+      child = Dir_childAt(dir, DIR, i);
+      child->parent = dir;
+   }
+
+   for (i = 0; i < Dir_childCount(dir, FILES); i++)
+      File_setParent(Dir_childAt(dir, FILES, i), dir);
+}
+
+/* see directory.h for specification */
+Dir_T Dir_share(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   dir->refCount++;
+   return dir;
 }
 
 /* see directory.h for specification */
@@ -163,6 +752,15 @@ int Dir_compare(Dir_T dir1, Dir_T dir2) {
    assert(dir1 != NULL);
    assert(dir2 != NULL);
 
+   /* siblings are ordered by name, and interned names are equal
+      exactly when they are the same pointer */
+   if (dir1->parent == dir2->parent && dir1->parent != NULL) {
+      if (dir1->name == dir2->name)
+         return 0;
+      return NameKey_compare(&dir1->key, dir1->name,
+                             &dir2->key, dir2->name);
+   }
+
    return strcmp(dir1->path, dir2->path);
 }
 
@@ -174,6 +772,14 @@ const char* Dir_getPath(Dir_T dir) {
    return dir->path;
 }
 
+/* see directory.h for specification */
+const char* Dir_getName(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   return dir->name;
+}
+
 /* see directory.h for specification */
 size_t Dir_getNumChildren(Dir_T dir, int type) {
 
@@ -181,16 +787,144 @@ size_t Dir_getNumChildren(Dir_T dir, int type) {
 
    assert(dir != NULL);
 
+   if (type == DIR || type == FILES)
+      return Dir_childCount(dir, type);
+
+   both = Dir_childCount(dir, DIR);
+   both += Dir_childCount(dir, FILES);
+
+   return both;
+}
+
+/* Searches the children of the given type of parent for the one
+   whose name is the name whose key is *key. Returns 1 and
+   stores its index in *pIndex if there is one, and the child itself
+   in *pChild if pChild is not NULL. Otherwise, returns 0
+   and stores in *pIndex the index such a child would have.
+
+   The children are searched as published (see epoch.h), so that
+   readers may search them while the writer changes them.
+*/
+static int Dir_searchNames(Dir_T parent, int type,
+                           const struct NameKey* key, const char* name,
+                           size_t* pIndex, void** pChild) {
+
+   const struct NameKey* childKey;
+   const char* childName;
+   Dir_T childDir = NULL;
+   File_T childFile = NULL;
+   DirArray_T dirs = NULL;
+   FileArray_T files = NULL;
+   ChunkSeq_T seq = NULL;
+   struct probe probe;
+   size_t lo = 0;
+   size_t hi;
+   size_t mid;
+   int cmp;
+   int found;
+
+   assert(parent != NULL);
+   assert(key != NULL);
+   assert(name != NULL);
+   assert(pIndex != NULL);
+
+   /* the array is dropped only after the sequence is published */
+   if (type == DIR) {
+      dirs = Epoch_load(parent->dirC);
+      if (dirs == NULL)
+         seq = Epoch_load(parent->dirSeq);
+   }
+   else {
+      files = Epoch_load(parent->fileC);
+      if (files == NULL)
+         seq = Epoch_load(parent->fileSeq);
+   }
+
+   /* a sequence searches its own chunks */
+   probe.key = key;
+   probe.name = name;
+
+   if (seq != NULL) {
+      found = ChunkSeq_bsearch(seq, &probe, pIndex,
+                               type == DIR ? Dir_compareProbe :
+                               Dir_compareFileProbe);
+      if (found && pChild != NULL)
+         *pChild = ChunkSeq_get(seq, *pIndex);
+      return found;
+   }
+
    if (type == DIR)
-      return DynArray_getLength(dir->dirC);
+      hi = DirArray_getLength(dirs);
+   else
+      hi = FileArray_getLength(files);
+
+   /* siblings are sorted by path, which is the order of their names */
+   while (lo < hi) {
+      mid = lo + (hi - lo) / 2;
+
+      if (type == DIR) {
+         childDir = DirArray_get(dirs, mid);
+         childKey = &childDir->key;
+         childName = childDir->name;
+      }
+      else {
+         childFile = FileArray_get(files, mid);
+         childKey = File_getKey(childFile);
+         childName = File_getName(childFile);
+      }
+
+      Metrics_count(METRICS_COMPARISONS);
+      cmp = NameKey_compare(key, name, childKey, childName);
+      if (cmp == EQUAL) {
+         *pIndex = mid;
+         if (pChild != NULL)
+            *pChild = type == DIR ? (void*)childDir : (void*)childFile;
+         return 1;
+      }
+
+      if (cmp < 0)
+         hi = mid;
+      else
+         lo = mid + 1;
+   }
+
+   *pIndex = lo;
+   return 0;
+}
 
-   if (type == FILES)
-      return DynArray_getLength(dir->fileC);
+/* Searches the children of the given type of parent for the one
+   with the given full path, as Dir_searchNames does. */
+static int Dir_searchChildren(Dir_T parent, int type, const char* path,
+                              size_t* pIndex) {
 
-   both = DynArray_getLength(dir->dirC);
-   both += DynArray_getLength(dir->fileC);
+   struct NameKey key;
+   size_t parentLength;
+   int cmp;
 
-   return both;
+   assert(parent != NULL);
+   assert(path != NULL);
+   assert(pIndex != NULL);
+
+   parentLength = strlen(parent->path);
+
+   /* the children's paths are parent's path, a '/' and their names,
+      so only the rest of path is compared with each of them */
+   cmp = strncmp(path, parent->path, parentLength);
+   if (cmp == EQUAL)
+      cmp = (int)(unsigned char)path[parentLength] - '/';
+
+   if (cmp == EQUAL) {
+      path += parentLength + 1;
+      NameKey_init(&key, path, strlen(path));
+      return Dir_searchNames(parent, type, &key, path, pIndex, NULL);
+   }
+
+   /* otherwise, path sorts before or after all of them */
+   if (cmp < 0)
+      *pIndex = 0;
+   else
+      *pIndex = Dir_getNumChildren(parent, type);
+   return 0;
 }
 
 /* see directory.h for specification */
@@ -199,37 +933,21 @@ int Dir_hasChild(Dir_T parent, const char* path, size_t* childID,
    
    size_t indexDir = 0;
    size_t indexFile = 0;
-   int resultDir;
-   int resultFile;
-   Dir_T checkerDir;
-   File_T checkerFile;
+   int resultDir = 0;
+   int resultFile = 0;
 
    assert(parent != NULL);
    assert(path != NULL);
 
-   /* Creates checkers for both directories and files */
-   checkerDir = Dir_create(NULL, path);
-   if (checkerDir == NULL)
-      return -1;
-
-   checkerFile = File_create(checkerDir, path, NULL, 0);
-   if (checkerFile == NULL) {
-      free(checkerDir);
-      return -1;
-   }
-
-   resultDir = DynArray_bsearch(parent->dirC, checkerDir, &indexDir,
-                                (int (*)(const void*, const void*))
-                                Dir_compare);
-
-   resultFile = DynArray_bsearch(parent->fileC, checkerFile, &indexFile,
-                                 (int (*)(const void*, const void*))
-                                 File_compare);
+   /* Searches the children by path, without building checkers */
+   if (type != FILES)
+      resultDir = Dir_searchChildren(parent, DIR, path,
+                                     &indexDir);
 
-   (void) Dir_destroy(checkerDir);
-   File_destroy(checkerFile);
+   if (type != DIR)
+      resultFile = Dir_searchChildren(parent, FILES, path,
+                                      &indexFile);
 
-   
    /* 
       if type was defined, return respective result.
       If childID is not NULL, assigns respective childID
@@ -264,15 +982,61 @@ int Dir_hasChild(Dir_T parent, const char* path, size_t* childID,
 }
 
 /* see directory.h for specification */
-void* Dir_getChild(Dir_T parent, size_t childID, int type) {
+size_t Dir_getChildAfter(Dir_T parent, const char* name, int type) {
+
+   struct NameKey key;
+   size_t index;
+
    assert(parent != NULL);
    assert(type == DIR || type == FILES);
 
-   if (type == DIR && DynArray_getLength(parent->dirC) > childID)
-      return DynArray_get(parent->dirC, childID);
+   if (name == NULL)
+      return 0;
 
-   if (type == FILES && DynArray_getLength(parent->fileC) > childID)
-      return DynArray_get(parent->fileC, childID);
+   /* the first child greater than name follows name's own place */
+   NameKey_init(&key, name, strlen(name));
+   if (Dir_searchNames(parent, type, &key, name, &index, NULL) == 1)
+      index++;
+
+   return index;
+}
+
+/* see directory.h for specification */
+boolean Dir_hasChildName(Dir_T parent, const char* name, size_t length,
+                         int type) {
+
+   assert(parent != NULL);
+   assert(name != NULL);
+   assert(type == DIR || type == FILES);
+
+   return (boolean)(Dir_findChild(parent, name, length, type) != NULL);
+}
+
+/* see directory.h for specification */
+void* Dir_findChild(Dir_T parent, const char* name, size_t length,
+                    int type) {
+
+   struct NameKey key;
+   size_t index;
+   void* child = NULL;
+
+   assert(parent != NULL);
+   assert(name != NULL);
+   assert(type == DIR || type == FILES);
+
+   NameKey_init(&key, name, length);
+   (void) Dir_searchNames(parent, type, &key, name, &index, &child);
+   return child;
+}
+
+/* see directory.h for specification */
+void* Dir_getChild(Dir_T parent, size_t childID, int type) {
+   assert(parent != NULL);
+   assert(type == DIR || type == FILES);
+
+   if ((type == DIR || type == FILES) &&
+       Dir_childCount(parent, type) > childID)
+      return Dir_childAt(parent, type, childID);
 
    return NULL;
 }
@@ -289,7 +1053,8 @@ int Dir_linkChild(Dir_T parent, void* child, int type) {
    size_t i;
    const char* rest;
    const char* childPath;
-   DynArray_T children;
+   const char* childName;
+   const struct NameKey* childKey;
 
    assert(type == DIR || type == FILES);
    assert(parent != NULL);
@@ -298,12 +1063,14 @@ int Dir_linkChild(Dir_T parent, void* child, int type) {
 
    if (type == DIR) {
       childPath = Dir_getPath((Dir_T)child);
-      children = parent->dirC;
+      childName = ((Dir_T)child)->name;
+      childKey = &((Dir_T)child)->key;
    }
 
    else {
       childPath = File_getPath((File_T)child);
-      children = parent->fileC;
+      childName = File_getName((File_T)child);
+      childKey = File_getKey((File_T)child);
    }
 
    /* If parent's path is not a prefix of child's path */
@@ -322,13 +1089,15 @@ int Dir_linkChild(Dir_T parent, void* child, int type) {
    if (strstr(rest, "/") != NULL)
       return PARENT_CHILD_ERROR;
 
- if (DynArray_bsearch(children, child, &i,
-                        (int (*)(const void*, const void*))
-                        File_compare) == 1) {
+   /* child's name is the rest of its path, so its key finds it */
+   if (Dir_searchNames(parent, type, childKey, childName, &i,
+                       NULL) == 1)
       return ALREADY_IN_TREE;
-   }
 
-   if (DynArray_addAt(children, i, child) == TRUE) {
+   if (Dir_addChildAt(parent, type, i, child) == TRUE) {
+
+      Dir_markDirty(parent);
+      (void) Dir_stampTree(parent);
 
       if (type == DIR)
          assert(CheckerFT_Dir_isValid((Dir_T)child));
@@ -342,39 +1111,316 @@ int Dir_linkChild(Dir_T parent, void* child, int type) {
    return PARENT_CHILD_ERROR;
 }
 
+/* see directory.h for specification */
+boolean Dir_setChildren(Dir_T parent, DynArray_T children, size_t first,
+                        int type) {
+
+   ChunkSeq_T seq;
+   DirArray_T dirs;
+   FileArray_T files;
+   size_t length;
+   size_t i;
+
+   assert(parent != NULL);
+   assert(children != NULL);
+   assert(first <= DynArray_getLength(children));
+   assert(type == DIR || type == FILES);
+   assert(Dir_childCount(parent, type) == 0);
+   assert(!Epoch_isActive());
+
+   length = DynArray_getLength(children) - first;
+   if (length == 0)
+      return TRUE;
+
+   /* as many as Dir_addChildAt would have moved to a sequence, each
+      added at its end, where no other is moved */
+   if (length > SEQ_THRESHOLD) {
+      seq = ChunkSeq_new();
+      if (seq == NULL)
+         return FALSE;
+
+      for (i = 0; i < length; i++) {
+         if (!ChunkSeq_addAt(seq, i, DynArray_get(children, first + i))) {
+            ChunkSeq_free(seq);
+            return FALSE;
+         }
+      }
+
+      Metrics_count(METRICS_ALLOCATIONS);
+      Lock_add(arrayBytes, ChunkSeq_getBytes(seq));
+      Lock_add(arrayUsedBytes, length * sizeof(void*));
+
+      if (type == DIR) {
+         DirArray_free(parent->dirC);
+         parent->dirC = NULL;
+         parent->dirSeq = seq;
+      }
+      else {
+         FileArray_free(parent->fileC);
+         parent->fileC = NULL;
+         parent->fileSeq = seq;
+      }
+   }
+
+   else if (type == DIR) {
+      dirs = DirArray_new(length);
+      if (dirs == NULL)
+         return FALSE;
+
+      for (i = 0; i < length; i++)
+         (void) DirArray_set(dirs, i,
+                             (Dir_T)DynArray_get(children, first + i));
+      DirArray_free(parent->dirC);
+      parent->dirC = dirs;
+   }
+
+   else {
+      files = FileArray_new(length);
+      if (files == NULL)
+         return FALSE;
+
+      for (i = 0; i < length; i++)
+         (void) FileArray_set(files, i,
+                              (File_T)DynArray_get(children, first + i));
+      FileArray_free(parent->fileC);
+      parent->fileC = files;
+   }
+
+   Dir_markDirty(parent);
+   (void) Dir_stampTree(parent);
+   return TRUE;
+}
+
 /* see directory.h for specification */
 int Dir_unlinkChild(Dir_T parent, void* child, int type) {
 
-   DynArray_T children;
+   const char* childPath;
    size_t childID = 0;
 
    assert(child != NULL);
 
    if (type != DIR && type != FILES)
       return PARENT_CHILD_ERROR;
-   
-   if (type == DIR)
-      children = parent->dirC;
-
-   else 
-      children = parent->fileC;
-   
 
    /* Finds child and stores its childID */
-   if(DynArray_bsearch(children, child, &childID,
-                       (int (*)(const void*, const void*))
-                       Dir_compare) == 0) {
+   if (type == DIR)
+      childPath = ((Dir_T)child)->path;
+   else
+      childPath = File_getPath((File_T)child);
+
+   if (Dir_searchChildren(parent, type, childPath, &childID) == 0) {
 
       assert(CheckerFT_Dir_isValid(parent));
       return PARENT_CHILD_ERROR;
    }
 
-   (void) DynArray_removeAt(children, childID);
+   if (!Dir_removeChildAt(parent, type, childID))
+      return MEMORY_ERROR;
+
+   Dir_markDirty(parent);
+   parent->version = Dir_stampTree(parent);
 
    assert(CheckerFT_Dir_isValid(parent));
    return SUCCESS;
 }
          
+/* see directory.h for specification */
+void Dir_replaceChild(Dir_T parent, void* old, void* new, int type) {
+
+   const struct NameKey* key;
+   const char* name;
+   size_t index = 0;
+
+   assert(parent != NULL);
+   assert(old != NULL);
+   assert(new != NULL);
+   assert(type == DIR || type == FILES);
+   assert(!Epoch_isActive());
+
+   if (type == DIR) {
+      key = &((Dir_T)old)->key;
+      name = ((Dir_T)old)->name;
+   }
+   else {
+      key = File_getKey((File_T)old);
+      name = File_getName((File_T)old);
+   }
+
+   (void) Dir_searchNames(parent, type, key, name, &index, NULL);
+   assert(Dir_childAt(parent, type, index) == old);
+
+   /* new has old's name, so the children stay sorted */
+   if (type == DIR && parent->dirSeq != NULL)
+      (void) ChunkSeq_set(parent->dirSeq, index, new);
+   else if (type == DIR)
+      (void) DirArray_set(parent->dirC, index, (Dir_T)new);
+   else if (parent->fileSeq != NULL)
+      (void) ChunkSeq_set(parent->fileSeq, index, new);
+   else
+      (void) FileArray_set(parent->fileC, index, (File_T)new);
+
+   /* a file is replaced when its contents change, and a directory
+      only by a copy of it */
+   if (type == DIR)
+      (void) Dir_destroy((Dir_T)old);
+   else {
+      File_destroy((File_T)old);
+      Dir_markDirty(parent);
+   }
+}
+
+/* see directory.h for specification */
+void Dir_markDirty(Dir_T dir) {
+
+   /* hashes are not kept while Epoch is active, and the directories
+      above a dirty one are already dirty */
+   if (Epoch_isActive())
+      return;
+
+   while (dir != NULL && !dir->dirty) {
+      dir->dirty = TRUE;
+      dir = dir->parent;
+   }
+}
+
+/* see directory.h for specification */
+unsigned long Dir_stampTree(Dir_T dir) {
+
+   /* versions are not kept while Epoch is active */
+   if (Epoch_isActive())
+      return 0;
+
+   latestVersion++;
+
+   while (dir != NULL) {
+      dir->treeVersion = latestVersion;
+      dir = dir->parent;
+   }
+
+   return latestVersion;
+}
+
+/* see directory.h for specification */
+unsigned long Dir_getVersion(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   return dir->version;
+}
+
+/* see directory.h for specification */
+unsigned long Dir_getTreeVersion(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   return dir->treeVersion;
+}
+
+/* see directory.h for specification */
+unsigned long Dir_getLatestVersion(void) {
+   return latestVersion;
+}
+
+/* Returns hash, the hash of some bytes, continued with the bytes of
+   value, least significant first */
+static unsigned long Dir_hashMore(unsigned long hash,
+                                  unsigned long value) {
+   unsigned char bytes[sizeof(unsigned long)];
+   size_t i;
+
+   for (i = 0; i < sizeof(value); i++)
+      bytes[i] = (unsigned char)((value >> (8 * i)) & 0xFF);
+
+   return NameKey_hash(hash, bytes, sizeof(bytes));
+}
+
+/* see directory.h for specification */
+boolean Dir_getHash(Dir_T dir, unsigned long *hash) {
+
+   unsigned long childHash;
+   unsigned long sum = NAMEKEY_HASH_BASIS;
+   File_T file;
+   Dir_T child;
+   size_t i;
+
+   assert(dir != NULL);
+   assert(hash != NULL);
+   assert(!Epoch_isActive());
+
+   if (dir->dirty) {
+
+      /* the children in order, each a name, a type and a hash */
+      for (i = 0; i < Dir_childCount(dir, FILES); i++) {
+         file = Dir_childAt(dir, FILES, i);
+         if (!File_getHash(file, &childHash))
+            return FALSE;
+
+         sum = Dir_hashMore(sum, File_getKey(file)->hash);
+         sum = Dir_hashMore(sum, FILES);
+         sum = Dir_hashMore(sum, childHash);
+      }
+
+      for (i = 0; i < Dir_childCount(dir, DIR); i++) {
+         child = Dir_childAt(dir, DIR, i);
+         if (!Dir_getHash(child, &childHash))
+            return FALSE;
+
+         sum = Dir_hashMore(sum, child->key.hash);
+         sum = Dir_hashMore(sum, DIR);
+         sum = Dir_hashMore(sum, childHash);
+      }
+
+      dir->hash = sum;
+      dir->dirty = FALSE;
+   }
+
+   *hash = dir->hash;
+   return TRUE;
+}
+
+/* see directory.h for specification */
+void Dir_lock(Dir_T dir) {
+   assert(dir != NULL);
+
+   Lock_acquire(&dir->lock);
+}
+
+/* see directory.h for specification */
+boolean Dir_tryLock(Dir_T dir) {
+   assert(dir != NULL);
+
+   return Lock_tryAcquire(&dir->lock);
+}
+
+/* see directory.h for specification */
+void Dir_unlock(Dir_T dir) {
+   assert(dir != NULL);
+
+   Lock_release(&dir->lock);
+}
+
+/* see directory.h for specification */
+size_t Dir_getTreeSize(Dir_T dir) {
+
+   Dir_T child;
+   size_t size;
+   size_t numDirC;
+   size_t i;
+
+   assert(dir != NULL);
+
+   size = 1 + Dir_childCount(dir, FILES);
+   numDirC = Dir_childCount(dir, DIR);
+   for (i = 0; i < numDirC; i++) {
+      child = Dir_childAt(dir, DIR, i);
+      Dir_lock(child);
+      size += Dir_getTreeSize(child);
+      Dir_unlock(child);
+   }
+
+   return size;
+}
+
 /* see directory.h for specification */
 char* Dir_toString(Dir_T dir) {
    
@@ -390,3 +1436,21 @@ char* Dir_toString(Dir_T dir) {
 
    return strcpy(copyPath, dir->path);
 }
+
+/* see directory.h for specification */
+void Dir_getMemoryStats(size_t* pNumDirs, size_t* pNodeBytes,
+                        size_t* pPathBytes, size_t* pArrayBytes,
+                        size_t* pArrayUsedBytes) {
+
+   assert(pNumDirs != NULL);
+   assert(pNodeBytes != NULL);
+   assert(pPathBytes != NULL);
+   assert(pArrayBytes != NULL);
+   assert(pArrayUsedBytes != NULL);
+
+   *pNumDirs = numDirs;
+   *pNodeBytes = nodeBytes;
+   *pPathBytes = pathBytes;
+   *pArrayBytes = arrayBytes;
+   *pArrayUsedBytes = arrayUsedBytes;
+}
@@ -8,6 +8,7 @@
 
 #include <stddef.h>
 #include "a4def.h"
+#include "dynarray.h"
 
 /*
    a Dir_T is an object that contains a path payload and references to
@@ -18,28 +19,62 @@ typedef struct directory* Dir_T;
 
 
 /*
-   Given a parent directory and a string dir, returns a new Dir_T or 
+   Given a parent directory and the length bytes at dir (which need
+   not be '\0'-terminated), returns a new Dir_T or 
    NULL if any allocation error occurs in creating the directory or its
    fields.
 
    The new structure is initialized to have its path as the parent's
-   path (if it exists) prefixed to the dir string parameter, separated
+   path (if it exists) prefixed to those bytes, separated
    by a slash. It is also initialized with its parent link as the 
    parent parameter value, but the parent itself is not changed
    to link to the new directory. The children links are initialized but
    do not point to any children.
 */
 
-Dir_T Dir_create(Dir_T parent, const char* dir);
+Dir_T Dir_create(Dir_T parent, const char* dir, size_t length);
 
 /*
-  Destroys the entire hierarchy of directories and files rooted at dir,
-  including dir itself.
+  Drops a reference to dir, which Dir_create returns with one. If that
+  was the last one, destroys the entire hierarchy of directories and
+  files rooted at dir, including dir itself, dropping a reference to
+  each child rather than destroying those that are shared. Otherwise,
+  clears dir's parent link, as the snapshots still holding dir do not
+  hold its parent.
 
   Returns the number of directories and files destroyed.
 */
 size_t Dir_destroy(Dir_T dir);
 
+/*
+  Returns a new copy of dir with parent as its parent, or NULL if
+  unable to allocate sufficient memory. The copy has the same path
+  and children as dir, in new arrays, and adds a reference to each of
+  them, which become the children of the copy as far as their parent
+  links go. The copy and dir then change independently.
+  Epoch must not be active.
+*/
+Dir_T Dir_copy(Dir_T dir, Dir_T parent);
+
+/*
+  Returns TRUE if dir has more than one reference, so that it must be
+  replaced by a copy (see Dir_copy) rather than changed, and FALSE
+  otherwise.
+*/
+boolean Dir_isShared(Dir_T dir);
+
+/*
+  Makes dir the parent of each of its children again, as it was before
+  a copy of dir replaced it (see Dir_copy).
+*/
+void Dir_adopt(Dir_T dir);
+
+/*
+  Adds a reference to dir, for a snapshot that holds it as its root,
+  and returns dir. Dir_destroy drops it.
+*/
+Dir_T Dir_share(Dir_T dir);
+
 
 /*
   Compares dir1 and dir2 based on their paths.
@@ -53,6 +88,13 @@ int Dir_compare(Dir_T dir1, Dir_T dir2);
 */
 const char* Dir_getPath(Dir_T dir);
 
+/*
+   Returns dir's name, the last component of its path. Names are
+   interned: two directories or files have equal names if and only if
+   they return the same pointer.
+*/
+const char* Dir_getName(Dir_T dir);
+
 /*
   Returns the number of children of  parent dir if
   type is neither 0 (DIR) nor 1 (FILES).
@@ -64,8 +106,7 @@ size_t Dir_getNumChildren(Dir_T dir, int type);
 
 
 /* If type is 0 (DIR), returns 1 if parent has a child directory
-   whose full path is path, 0 if it does not have such a child,
-   and -1 if there is an allocation error during search.
+   whose full path is path, and 0 if it does not have such a child.
 
    If type is 1 (FILES), it works analogously for a child file
 
@@ -82,6 +123,40 @@ int Dir_hasChild(Dir_T parent, const char* path, size_t* childID,
                  int type);
 
 
+/*
+  If type is 0 (DIR), returns TRUE if parent has a child directory
+  whose name (the last component of its path) is the length bytes at
+  name, which need not be '\0'-terminated. Returns FALSE otherwise.
+  If type is 1 (FILES), it works analogously for child files.
+*/
+boolean Dir_hasChildName(Dir_T parent, const char* name, size_t length,
+                         int type);
+
+/*
+  If type is 0 (DIR), returns the child directory of parent whose
+  name is the length bytes at name, which need not be '\0'-terminated,
+  or NULL if there is none. If type is 1 (FILES), it works
+  analogously for child files, returning a File_T.
+
+  Unlike Dir_hasChild and Dir_getChild, which identify children by
+  an index that a change to parent may shift, Dir_findChild may be
+  called by readers while Epoch is active (see epoch.h).
+*/
+void* Dir_findChild(Dir_T parent, const char* name, size_t length,
+                    int type);
+
+/*
+  If type is 0 (DIR), returns the identifier of the first child
+  directory of parent whose name (the last component of its path)
+  is lexicographically greater than name.
+  If type is 1 (FILES), it works analogously for child files.
+
+  If name is NULL, returns 0 (the identifier of the first child).
+  If there is no such child, returns the number of children of the
+  given type.
+*/
+size_t Dir_getChildAfter(Dir_T parent, const char* name, int type);
+
 /*
   If type is 0 (DIR), returns the Dir_T child directory of parent
   with identifier childID, if it exists.
@@ -112,16 +187,116 @@ Dir_T Dir_getParent(Dir_T dir);
 */
 int Dir_linkChild(Dir_T parent, void* child, int type);
 
+/*
+  Makes the elements of children from index first on, which must have
+  parent as their parent, distinct names, and be in order by name,
+  the children of the given type of parent, which must have none of
+  that type, in an array or a sequence allocated at its final size.
+  Epoch must not be active.
+
+  Returns FALSE, leaving parent unchanged, if unable to allocate
+  sufficient memory, and TRUE otherwise.
+*/
+boolean Dir_setChildren(Dir_T parent, DynArray_T children, size_t first,
+                        int type);
+
 /*
   If type is 0 (DIR), unlinks parent from its child directory
   If type is 1 (FILES), unlinks parent from its child file
   In both cases, child is unchanged.
 
-  Returns PARENT_CHILD_ERROR if child is not a child of parent
+  Returns PARENT_CHILD_ERROR if child is not a child of parent,
+  MEMORY_ERROR, leaving parent unchanged, if Epoch is active and
+  there is not enough memory for a new version of parent's children,
   and SUCCESS otherwise.
  */
 int Dir_unlinkChild(Dir_T parent, void* child, int type);
 
+/*
+  Replaces old, a child of parent of the given type (0 (DIR) or 1
+  (FILES)), with new, which has the same name, and drops parent's
+  reference to old. Cannot fail. Epoch must not be active.
+*/
+void Dir_replaceChild(Dir_T parent, void* old, void* new, int type);
+
+/*
+  Marks the hash of dir, and those of the directories above it, as
+  out of date, as it is once the children of dir or the contents of
+  its files change, so that Dir_getHash computes them again. Does
+  nothing while Epoch is active, when hashes are not kept.
+*/
+void Dir_markDirty(Dir_T dir);
+
+/*
+  Stores in *hash the Merkle hash of the hierarchy below dir, which
+  combines the names, types and hashes of its children, directories
+  and files (see File_getHash), but not dir's own name. It is
+  computed, for dir and each directory below it whose hash is out of
+  date, the first time it is asked for after a change. Returns FALSE,
+  leaving *hash unchanged, if unable to allocate sufficient memory to
+  unpack the contents of a file, and TRUE otherwise. Epoch must not
+  be active.
+*/
+boolean Dir_getHash(Dir_T dir, unsigned long *hash);
+
+/*
+  Stamps a new version, greater than every one stamped before, on dir
+  and each directory above it as the latest version of a change below
+  them (see Dir_getTreeVersion), as a change to the children of dir or
+  the contents of one of its files does, and returns it. Does nothing
+  and returns 0 while Epoch is active, when versions are not kept.
+*/
+unsigned long Dir_stampTree(Dir_T dir);
+
+/*
+  Returns the version at which dir was created or last lost a child,
+  so that a tree that copied the hierarchy below dir before then may
+  hold directories and files that dir no longer does.
+*/
+unsigned long Dir_getVersion(Dir_T dir);
+
+/*
+  Returns the latest version stamped on dir or on any directory or
+  file below it, so that nothing below dir changed after then.
+*/
+unsigned long Dir_getTreeVersion(Dir_T dir);
+
+/*
+  Returns the latest version stamped on any directory or file.
+*/
+unsigned long Dir_getLatestVersion(void);
+
+/*
+  Waits until no other writer holds dir, then holds it until
+  Dir_unlock(dir). While Lock is active (see lock.h), a writer may
+  change the children of a directory only while holding it, and
+  locks directories hand over hand: it holds the root before any
+  other, and a directory's parent while it finds and locks the
+  directory. Writers therefore never deadlock, and never overtake
+  one another on a path, so that one that holds a directory it
+  unlinked is the last to reach the hierarchy below it.
+*/
+void Dir_lock(Dir_T dir);
+
+/*
+  Holds dir, as Dir_lock does, if no other writer holds it, and
+  returns TRUE, or returns FALSE at once otherwise.
+*/
+boolean Dir_tryLock(Dir_T dir);
+
+/*
+  Lets other writers hold dir, which the calling writer holds.
+*/
+void Dir_unlock(Dir_T dir);
+
+/*
+  Returns the number of directories and files in the hierarchy rooted
+  at dir, including dir itself. The calling writer must hold dir, or
+  be the only one that can reach it: each directory below it is held
+  while it is counted, waiting for the writers still changing it.
+*/
+size_t Dir_getTreeSize(Dir_T dir);
+
 /*
   Returns a string representation for dir, 
   or NULL if there is an allocation error.
@@ -131,4 +306,15 @@ int Dir_unlinkChild(Dir_T parent, void* child, int type);
 */
 char* Dir_toString(Dir_T dir);
 
+/*
+  Stores in *pNumDirs the number of existing directories, in
+  *pNodeBytes and *pPathBytes the bytes of their structures and
+  paths, and in *pArrayBytes the bytes allocated for their lists of
+  children, of which *pArrayUsedBytes hold children.
+  The counts are kept up to date as directories change.
+*/
+void Dir_getMemoryStats(size_t* pNumDirs, size_t* pNodeBytes,
+                        size_t* pPathBytes, size_t* pArrayBytes,
+                        size_t* pArrayUsedBytes);
+
 #endif
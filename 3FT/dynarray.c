@@ -4,6 +4,7 @@
 /*--------------------------------------------------------------------*/
 
 #include "dynarray.h"
+#include "metrics.h"
 #include <assert.h>
 #include <stdlib.h>
 
@@ -34,6 +35,14 @@ struct DynArray
 
 /*--------------------------------------------------------------------*/
 
+/* The number of bytes allocated for all DynArray objects and their
+   arrays, and the number of bytes of those arrays holding elements. */
+
+static size_t uAllocatedBytes = 0;
+static size_t uUsedBytes = 0;
+
+/*--------------------------------------------------------------------*/
+
 #ifndef NDEBUG
 
 /* Check the invariants of oDynArray.  Return 1 (TRUE) iff oDynArray
@@ -70,6 +79,9 @@ static int DynArray_grow(DynArray_T oDynArray)
    if (ppvNewArray == NULL)
       return 0;
 
+   Metrics_count(METRICS_ALLOCATIONS);
+   uAllocatedBytes +=
+      sizeof(void*) * (uNewLength - oDynArray->uPhysLength);
    oDynArray->uPhysLength = uNewLength;
    oDynArray->ppvArray = ppvNewArray;
    return 1;
@@ -99,6 +111,13 @@ DynArray_T DynArray_new(size_t uLength)
       return NULL;
    }
 
+   /* one allocation for oDynArray, another for its array */
+   Metrics_count(METRICS_ALLOCATIONS);
+   Metrics_count(METRICS_ALLOCATIONS);
+   uAllocatedBytes += sizeof(struct DynArray) +
+      sizeof(void*) * oDynArray->uPhysLength;
+   uUsedBytes += sizeof(void*) * uLength;
+
    return oDynArray;
 }
 
@@ -109,6 +128,10 @@ void DynArray_free(DynArray_T oDynArray)
    assert(oDynArray != NULL);
    assert(DynArray_isValid(oDynArray));
 
+   uAllocatedBytes -= sizeof(struct DynArray) +
+      sizeof(void*) * oDynArray->uPhysLength;
+   uUsedBytes -= sizeof(void*) * oDynArray->uLength;
+
    free(oDynArray->ppvArray);
    free(oDynArray);
 }
@@ -166,6 +189,7 @@ int DynArray_add(DynArray_T oDynArray, const void *pvElement)
 
    oDynArray->ppvArray[oDynArray->uLength] = pvElement;
    oDynArray->uLength++;
+   uUsedBytes += sizeof(void*);
 
    assert(DynArray_isValid(oDynArray));
 
@@ -192,6 +216,7 @@ int DynArray_addAt(DynArray_T oDynArray, size_t uIndex,
 
    oDynArray->ppvArray[uIndex] = pvElement;
    oDynArray->uLength++;
+   uUsedBytes += sizeof(void*);
 
    assert(DynArray_isValid(oDynArray));
 
@@ -212,6 +237,7 @@ void *DynArray_removeAt(DynArray_T oDynArray, size_t uIndex)
    pvOldElement = oDynArray->ppvArray[uIndex];
 
    oDynArray->uLength--;
+   uUsedBytes -= sizeof(void*);
 
    for (u = uIndex; u < oDynArray->uLength; u++)
       oDynArray->ppvArray[u] = oDynArray->ppvArray[u+1];
@@ -384,6 +410,7 @@ static const void **DynArray_bsearchHelp(
    while (ppvLo <= ppvHi)
    {
       ppvMid = ppvLo + ((ppvHi - ppvLo) / 2);
+      Metrics_count(METRICS_COMPARISONS);
       iCompare = (*pfCompare)(pvSoughtElement, *ppvMid);
       if (iCompare < 0)
          ppvHi = ppvMid - 1;
@@ -432,3 +459,15 @@ int DynArray_bsearch(DynArray_T oDynArray,
    *puIndex = (size_t)(ppvElement - &oDynArray->ppvArray[0]);
    return 1;
 }
+
+/*--------------------------------------------------------------------*/
+
+void DynArray_getMemoryUsage(size_t *puAllocatedBytes,
+                             size_t *puUsedBytes)
+{
+   assert(puAllocatedBytes != NULL);
+   assert(puUsedBytes != NULL);
+
+   *puAllocatedBytes = uAllocatedBytes;
+   *puUsedBytes = uUsedBytes;
+}
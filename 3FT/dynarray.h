@@ -129,4 +129,14 @@ int DynArray_bsearch(DynArray_T oDynArray,
                      int (*pfCompare)(const void *pvElement1,
                                       const void *pvElement2));
 
+/*--------------------------------------------------------------------*/
+
+/* Assign to *puAllocatedBytes the number of bytes allocated for all
+   existing DynArray objects (including their underlying arrays), and
+   to *puUsedBytes the number of bytes of the underlying arrays that
+   hold elements. */
+
+void DynArray_getMemoryUsage(size_t *puAllocatedBytes,
+                             size_t *puUsedBytes);
+
 #endif
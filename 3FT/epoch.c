@@ -0,0 +1,299 @@
+/*--------------------------------------------------------------------*/
+/* epoch.c                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "epoch.h"
+#include "lock.h"
+
+#if defined(__GNUC__)
+
+#include <pthread.h>
+
+/*
+   Every reader announces the global epoch it entered in. Writers
+   advance the global epoch only once every reader inside has
+   announced the current one, so memory retired in epoch e can no
+   longer be reached once the global epoch is e + 2: each reader that
+   entered before it was unlinked has exited by then. Retired memory
+   waits in one of NUM_LISTS lists, by epoch modulo NUM_LISTS.
+*/
+
+/* The number of lists of retired memory */
+enum {NUM_LISTS = 3};
+/* The epoch announced by a reader that is not reading */
+enum {QUIESCENT = 0};
+/* The size of a cache line, to which readers' records are padded so
+   that announcing an epoch does not slow down other readers */
+enum {CACHE_LINE = 64};
+
+/* A reader's record */
+struct reader {
+   /* the epoch the reader entered in, or QUIESCENT */
+   unsigned long epoch;
+   /* 1 if a thread holds this record, 0 otherwise */
+   int claimed;
+   /* the reads of the thread not yet ended */
+   size_t depth;
+};
+
+/* A record alone in its cache line */
+union slot {
+   struct reader reader;
+   char line[CACHE_LINE];
+};
+
+/* A piece of memory waiting to be released */
+struct retired {
+   void *object;
+   void (*release)(void *object);
+   struct retired *next;
+};
+
+/* The Epoch AO has 7 state variables: */
+
+/* whether Epoch is active */
+static boolean isActive;
+/* the global epoch, which starts past QUIESCENT */
+static unsigned long globalEpoch = QUIESCENT + 1;
+/* the records of the readers, of which the first numSlots have been
+   claimed at some point */
+static union slot slots[EPOCH_MAX_READERS]
+   __attribute__((aligned(CACHE_LINE)));
+static size_t numSlots;
+/* the memory retired in each epoch modulo NUM_LISTS */
+static struct retired *lists[NUM_LISTS];
+/* the calling thread's record, NULL until it first reads */
+static __thread struct reader *self;
+/* the lock of lists and of advancing the global epoch, which writers
+   changing different directories share (see lock.h) */
+static struct Lock retireLock;
+
+/* the key whose destructor frees the record of an exiting thread */
+static pthread_key_t exitKey;
+static pthread_once_t exitKeyOnce = PTHREAD_ONCE_INIT;
+static boolean hasExitKey;
+
+
+/* Frees the record reader of an exiting thread */
+static void Epoch_freeRecord(void *reader) {
+   __atomic_store_n(&((struct reader *)reader)->claimed, 0,
+                    __ATOMIC_RELEASE);
+}
+
+/* Creates exitKey */
+static void Epoch_createExitKey(void) {
+   hasExitKey = pthread_key_create(&exitKey, Epoch_freeRecord) == 0;
+}
+
+/* Returns a record claimed for the calling thread, waiting for one if
+   every record is claimed */
+static struct reader *Epoch_claimRecord(void) {
+   struct reader *reader;
+   int unclaimed;
+   size_t used;
+   size_t i;
+
+   for (;;) {
+      for (i = 0; i < EPOCH_MAX_READERS; i++) {
+         reader = &slots[i].reader;
+         unclaimed = 0;
+         if (__atomic_load_n(&reader->claimed, __ATOMIC_RELAXED) == 0 &&
+             __atomic_compare_exchange_n(&reader->claimed, &unclaimed,
+                                         1, FALSE, __ATOMIC_ACQUIRE,
+                                         __ATOMIC_RELAXED))
+            break;
+      }
+
+      if (i < EPOCH_MAX_READERS)
+         break;
+   }
+
+   /* lets the writer scan only the records claimed so far */
+   used = __atomic_load_n(&numSlots, __ATOMIC_RELAXED);
+   while (used <= i &&
+          !__atomic_compare_exchange_n(&numSlots, &used, i + 1, FALSE,
+                                       __ATOMIC_SEQ_CST,
+                                       __ATOMIC_RELAXED))
+      ;
+
+   if (hasExitKey)
+      (void) pthread_setspecific(exitKey, reader);
+
+   return reader;
+}
+
+/* Releases the memory in list */
+static void Epoch_releaseList(struct retired *list) {
+   struct retired *next;
+
+   while (list != NULL) {
+      next = list->next;
+      (*list->release)(list->object);
+      free(list);
+      list = next;
+   }
+}
+
+/* Advances the global epoch and releases the memory that can no
+   longer be reached, if every reader inside has announced the current
+   epoch. Returns TRUE if it advanced, and FALSE otherwise. */
+static boolean Epoch_tryAdvance(void) {
+   unsigned long epoch;
+   unsigned long announced;
+   struct retired *list;
+   size_t used;
+   size_t i;
+
+   epoch = __atomic_load_n(&globalEpoch, __ATOMIC_RELAXED);
+   used = __atomic_load_n(&numSlots, __ATOMIC_SEQ_CST);
+
+   for (i = 0; i < used; i++) {
+      announced = __atomic_load_n(&slots[i].reader.epoch,
+                                  __ATOMIC_SEQ_CST);
+      if (announced != QUIESCENT && announced != epoch)
+         return FALSE;
+   }
+
+   __atomic_store_n(&globalEpoch, epoch + 1, __ATOMIC_SEQ_CST);
+
+   /* the list of epoch + 1 holds what was retired in epoch - 2 and
+      was released when the epoch became epoch; the list of epoch - 1
+      can now be released */
+   list = lists[(epoch - 1) % NUM_LISTS];
+   lists[(epoch - 1) % NUM_LISTS] = NULL;
+   Epoch_releaseList(list);
+
+   return TRUE;
+}
+
+/* see epoch.h for specification */
+void Epoch_init(boolean enabled) {
+   if (enabled)
+      (void) pthread_once(&exitKeyOnce, Epoch_createExitKey);
+
+   isActive = enabled;
+}
+
+/* see epoch.h for specification */
+void Epoch_destroy(void) {
+   size_t i;
+
+   for (i = 0; i < NUM_LISTS; i++) {
+      Epoch_releaseList(lists[i]);
+      lists[i] = NULL;
+   }
+
+   isActive = FALSE;
+}
+
+/* see epoch.h for specification */
+boolean Epoch_isActive(void) {
+   return isActive;
+}
+
+/* see epoch.h for specification */
+void Epoch_enter(void) {
+   struct reader *reader;
+   unsigned long epoch;
+
+   if (!isActive)
+      return;
+
+   if (self == NULL)
+      self = Epoch_claimRecord();
+   reader = self;
+
+   if (reader->depth++ > 0)
+      return;
+
+   /* announces the epoch, then checks that the writer did not advance
+      past it before it could see the announcement */
+   do {
+      epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+      __atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+   } while (__atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST) != epoch);
+}
+
+/* see epoch.h for specification */
+void Epoch_exit(void) {
+   if (!isActive)
+      return;
+
+   assert(self != NULL && self->depth > 0);
+
+   if (--self->depth == 0)
+      __atomic_store_n(&self->epoch, QUIESCENT, __ATOMIC_RELEASE);
+}
+
+/* see epoch.h for specification */
+void Epoch_retire(void *object, void (*release)(void *object)) {
+   struct retired *retired;
+   unsigned long epoch;
+
+   assert(release != NULL);
+
+   if (!isActive) {
+      (*release)(object);
+      return;
+   }
+
+   retired = (struct retired *)malloc(sizeof(struct retired));
+   Lock_acquire(&retireLock);
+
+   /* two advances outlast every reader inside now */
+   if (retired == NULL) {
+      while (!Epoch_tryAdvance())
+         ;
+      while (!Epoch_tryAdvance())
+         ;
+      Lock_release(&retireLock);
+      (*release)(object);
+      return;
+   }
+
+   epoch = __atomic_load_n(&globalEpoch, __ATOMIC_RELAXED);
+   retired->object = object;
+   retired->release = release;
+   retired->next = lists[epoch % NUM_LISTS];
+   lists[epoch % NUM_LISTS] = retired;
+
+   (void) Epoch_tryAdvance();
+   Lock_release(&retireLock);
+}
+
+#else
+
+/* Without atomic builtins, Epoch is never active */
+
+/* see epoch.h for specification */
+void Epoch_init(boolean enabled) {
+   (void) enabled;
+}
+
+/* see epoch.h for specification */
+void Epoch_destroy(void) {
+}
+
+/* see epoch.h for specification */
+boolean Epoch_isActive(void) {
+   return FALSE;
+}
+
+/* see epoch.h for specification */
+void Epoch_enter(void) {
+}
+
+/* see epoch.h for specification */
+void Epoch_exit(void) {
+}
+
+/* see epoch.h for specification */
+void Epoch_retire(void *object, void (*release)(void *object)) {
+   assert(release != NULL);
+
+   (*release)(object);
+}
+
+#endif
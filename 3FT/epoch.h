@@ -0,0 +1,80 @@
+/*--------------------------------------------------------------------*/
+/* epoch.h                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef EPOCH_INCLUDED
+#define EPOCH_INCLUDED
+
+#include "a4def.h"
+
+/*
+   Epoch is an AO that lets any number of threads read shared
+   structures without locks while writers change them, one at a time
+   or, with Lock active (see lock.h), holding locks that keep them
+   from changing the same pointers.
+   Readers bracket their reads with Epoch_enter and Epoch_exit, and
+   load the pointers writers may change with Epoch_load. A writer
+   changes those pointers only with Epoch_publish, to a new version
+   that it built without changing the old one, and passes the memory
+   it unlinks to Epoch_retire instead of freeing it. Retired memory is
+   released once every reader that might have reached it has exited.
+
+   While Epoch is not active, Epoch_enter and Epoch_exit do nothing
+   and Epoch_retire releases memory at once.
+*/
+
+/*
+   Epoch_load(lvalue) returns the value of the pointer or size lvalue
+   as published by Epoch_publish(lvalue, value), along with everything
+   its writer did before publishing it.
+*/
+#if defined(__GNUC__)
+#define Epoch_load(lvalue) __atomic_load_n(&(lvalue), __ATOMIC_ACQUIRE)
+#define Epoch_publish(lvalue, value)                                   \
+   __atomic_store_n(&(lvalue), (value), __ATOMIC_RELEASE)
+#else
+#define Epoch_load(lvalue) (lvalue)
+#define Epoch_publish(lvalue, value) ((void)((lvalue) = (value)))
+#endif
+
+/*
+   Makes Epoch active if enabled is TRUE and the compiler provides
+   GCC's atomic builtins, and inactive otherwise.
+*/
+void Epoch_init(boolean enabled);
+
+/*
+   Releases everything retired and makes Epoch inactive. No reader may
+   be between Epoch_enter and Epoch_exit.
+*/
+void Epoch_destroy(void);
+
+/*
+   Returns TRUE if Epoch is active, and FALSE otherwise.
+*/
+boolean Epoch_isActive(void);
+
+/*
+   Starts a read: until the matching Epoch_exit, nothing the calling
+   thread can reach is released. Reads may nest. At most
+   EPOCH_MAX_READERS threads may read at once; further ones wait for
+   one of them to exit.
+*/
+void Epoch_enter(void);
+enum {EPOCH_MAX_READERS = 128};
+
+/*
+   Ends the read started by the matching Epoch_enter.
+*/
+void Epoch_exit(void);
+
+/*
+   Calls (*release)(object) once no reader can be reading object,
+   which the calling writer has made unreachable. If unable
+   to allocate memory to remember object, waits for the readers
+   instead.
+*/
+void Epoch_retire(void *object, void (*release)(void *object));
+
+#endif
@@ -5,6 +5,25 @@
 
 #include "defs.h"
 #include "checkerFT.h"
+#include "contentstore.h"
+#include "compressor.h"
+#include "intern.h"
+#include "namekey.h"
+#include "metrics.h"
+#include "epoch.h"
+#include "lock.h"
+
+/* The File module accounts for the memory of all files in the
+   following state variables, which writers holding the locks of
+   different directories update with Lock_add: */
+
+/* the number of files */
+static size_t numFiles;
+/* the bytes of their structures and of their paths */
+static size_t nodeBytes;
+static size_t pathBytes;
+/* the sum of the lengths of their contents, as their clients see them */
+static size_t contentBytes;
 
 /*
    A file structure represents a file in the file tree
@@ -14,14 +33,41 @@ struct file {
    /* the full path of this file */
    char* path;
 
-   /* the parent directory of this file */
+   /* the last component of path, interned */
+   const char* name;
+
+   /* the key of name, to compare names without reading them */
+   struct NameKey key;
+
+   /* the parent directory of this file, in the live tree if file is
+      in it */
    Dir_T parent;
 
-   /* the contents of this file */
+   /* the number of directories whose children include this file, in
+      the live tree and in snapshots of it (see Dir_copy) */
+   size_t refCount;
+
+   /* the contents of this file, which are packed if packedLength
+      is not 0, and a shared blob if the ContentStore is active.
+      Published with Epoch_publish, as are length and packedLength,
+      for readers */
    void* contents;
 
    /* the length of the file in bytes */
    size_t length;
+
+   /* the length of the packed contents in bytes,
+      0 if the contents are not packed */
+   size_t packedLength;
+
+   /* the hash of the contents, valid if hashed is TRUE (see
+      File_getHash) */
+   unsigned long hash;
+   boolean hashed;
+
+   /* the version at which the contents were last stored (see
+      Dir_stampTree) */
+   unsigned long version;
 };
 
 /* Returns a defensive copy of path or NULL
@@ -43,11 +89,100 @@ static char *File_copyPath(const char *path) {
 }
 
 
+/* Returns TRUE if the contents of files that are not packed are
+   copies owned by the Compressor, that is if compression is on and
+   the ContentStore, which copies them itself, is not active */
+static boolean File_copiesContents(void) {
+   return (boolean)(Compressor_isActive() && !ContentStore_isActive());
+}
+
+/* Stores contents of length bytes in file, packed if the Compressor
+   packs them and shared if the ContentStore is active. While
+   compression is on, file holds a copy of contents in any case.
+   Returns FALSE, leaving file unchanged, if unable to allocate
+   sufficient memory.
+*/
+static boolean File_storeContents(File_T file, void *contents,
+                                  size_t length) {
+
+   void *packed;
+   void *stored;
+   size_t packedLength = 0;
+
+   assert(file != NULL);
+
+   packed = Compressor_pack(contents, length, &packedLength);
+
+   if (packed == NULL && contents != NULL && File_copiesContents())
+      stored = Compressor_copy(contents, length);
+
+   else if (packed == NULL)
+      stored = ContentStore_acquire(contents, length);
+
+   else {
+      stored = ContentStore_acquire(packed, packedLength);
+
+      /* the store keeps its own copy of the packed bytes */
+      if (stored != packed)
+         free(packed);
+
+      if (stored == NULL)
+         (void) Compressor_forget(NULL, NULL, packedLength, length,
+                                  FALSE);
+   }
+
+   if (stored == NULL && contents != NULL)
+      return FALSE;
+
+   Epoch_publish(file->contents, stored);
+   Epoch_publish(file->length, length);
+   Epoch_publish(file->packedLength, packedLength);
+   file->hashed = FALSE;
+
+   return TRUE;
+}
+
+/* Releases contents of length bytes, packed in packedLength bytes,
+   that owner stored. If retire is TRUE, returns the contents as
+   owner's client saw them, valid until the next change to any file.
+   Otherwise, returns NULL.
+*/
+static void *File_releaseContents(File_T owner, void *contents,
+                                  size_t length, size_t packedLength,
+                                  boolean retire) {
+
+   void *seen = contents;
+
+   if (packedLength == 0 && contents != NULL && File_copiesContents())
+      return Compressor_drop(contents, length, retire);
+
+   if (packedLength == 0) {
+      if (retire)
+         ContentStore_releaseLater(contents);
+      else
+         ContentStore_release(contents);
+
+      return retire ? seen : NULL;
+   }
+
+   seen = Compressor_forget(owner, contents, packedLength, length,
+                            retire);
+
+   /* packed bytes are owned by the store if it is active */
+   if (ContentStore_isActive())
+      ContentStore_release(contents);
+   else
+      free(contents);
+
+   return seen;
+}
+
 /* see file.h for specification */
 File_T File_create(Dir_T parent, const char *path, void *contents,
                    size_t length) {
 
    File_T new_file;
+   const char* name;
    
    assert(CheckerFT_Dir_isValid(parent));
    assert(path != NULL);
@@ -58,15 +193,51 @@ File_T File_create(Dir_T parent, const char *path, void *contents,
       return NULL;
    }
 
+   Metrics_count(METRICS_ALLOCATIONS);
+
    /* Assigns defensive copy of path to new_file->path */
    new_file->path = File_copyPath(path);
    
-   if (new_file->path == NULL)
+   if (new_file->path == NULL) {
+      free(new_file);
+      return NULL;
+   }
+
+   Metrics_count(METRICS_ALLOCATIONS);
+
+   /* the name follows the last '/' of path, if any */
+   name = strrchr(path, '/');
+   if (name == NULL)
+      name = path;
+   else
+      name++;
+
+   NameKey_init(&new_file->key, name, strlen(name));
+   new_file->name = Intern_acquire(name, new_file->key.length,
+                                   new_file->key.hash);
+
+   if (new_file->name == NULL) {
+      free(new_file->path);
+      free(new_file);
+      return NULL;
+   }
+
+   /* Packs and shares contents, if the respective modes are active */
+   if (!File_storeContents(new_file, contents, length)) {
+      Intern_release(new_file->name);
+      free(new_file->path);
+      free(new_file);
       return NULL;
+   }
    
    new_file->parent = parent;
-   new_file->contents = contents;
-   new_file->length = length;
+   new_file->refCount = 1;
+   new_file->version = Dir_stampTree(parent);
+
+   Lock_add(numFiles, 1);
+   Lock_add(nodeBytes, sizeof(struct file));
+   Lock_add(pathBytes, strlen(new_file->path) + 1);
+   Lock_add(contentBytes, length);
 
    return new_file;
 }
@@ -75,17 +246,76 @@ File_T File_create(Dir_T parent, const char *path, void *contents,
 void File_destroy(File_T file) {
 
    assert(file != NULL);
-   
+   assert(file->refCount > 0);
+
+   if (--file->refCount > 0)
+      return;
+
+   Lock_sub(numFiles, 1);
+   Lock_sub(nodeBytes, sizeof(struct file));
+   Lock_sub(pathBytes, strlen(file->path) + 1);
+   Lock_sub(contentBytes, file->length);
+
+   (void) File_releaseContents(file, file->contents, file->length,
+                               file->packedLength, FALSE);
+   Intern_release(file->name);
    free(file->path);
    free(file);
 }
 
+/* see file.h for specification */
+void File_share(File_T file, Dir_T parent) {
+
+   assert(file != NULL);
+   assert(parent != NULL);
+
+   file->refCount++;
+   file->parent = parent;
+}
+
+/* see file.h for specification */
+void File_setParent(File_T file, Dir_T parent) {
+
+   assert(file != NULL);
+   assert(parent != NULL);
+
+   file->parent = parent;
+}
+
+/* see file.h for specification */
+boolean File_isShared(File_T file) {
+
+   assert(file != NULL);
+
+   return file->refCount > 1;
+}
+
+/* see file.h for specification */
+boolean File_hasSameContents(File_T file1, File_T file2) {
+
+   assert(file1 != NULL);
+   assert(file2 != NULL);
+
+   return (boolean)(file1->length == file2->length &&
+                    file1->packedLength == file2->packedLength &&
+                    file1->contents == file2->contents);
+}
+
 /* see file.h for specification*/
 int File_compare(File_T file1, File_T file2) {
 
    assert(file1 != NULL);
    assert(file2 != NULL);
 
+   /* siblings are ordered by name, and interned names are equal
+      exactly when they are the same pointer */
+   if (file1->parent == file2->parent) {
+      if (file1->name == file2->name)
+         return 0;
+      return NameKey_compare(&file1->key, file1->name,
+                             &file2->key, file2->name);
+   }
+
    return strcmp(file1->path, file2->path);
    
 }
@@ -98,6 +328,22 @@ const char* File_getPath(File_T file) {
    return file->path;
 }
 
+/* see file.h for specification */
+const char* File_getName(File_T file) {
+
+   assert(file != NULL);
+
+   return file->name;
+}
+
+/* see file.h for specification */
+const struct NameKey* File_getKey(File_T file) {
+
+   assert(file != NULL);
+
+   return &file->key;
+}
+
 /* see file.h for specification */
 Dir_T File_getParent(File_T file) {
 
@@ -110,33 +356,116 @@ Dir_T File_getParent(File_T file) {
 /* see file.h for specification */
 void *File_getContents(File_T file) {
 
+   size_t packedLength;
+
    assert(file != NULL);
 
-   return file->contents;
+   packedLength = Epoch_load(file->packedLength);
+   if (packedLength != 0)
+      return Compressor_unpack(file, file->contents, packedLength,
+                               file->length);
+
+   return Epoch_load(file->contents);
 }
 
 /* see file.h for specification */
-void *File_replaceContents(File_T file, void* newContents,
-                           size_t newLength) {
+boolean File_setContents(File_T file, void* newContents,
+                         size_t newLength, void** pOldContents) {
 
    void* oldContents;
+   size_t oldLength;
+   size_t oldPackedLength;
+   void* seen;
 
    assert(file != NULL);
 
    oldContents = file->contents;
+   oldLength = file->length;
+   oldPackedLength = file->packedLength;
+
+   /* leaves file unchanged if newContents cannot be stored */
+   if (!File_storeContents(file, newContents, newLength))
+      return FALSE;
+
+   Lock_sub(contentBytes, oldLength);
+   Lock_add(contentBytes, newLength);
+   Dir_markDirty(file->parent);
+   file->version = Dir_stampTree(file->parent);
 
-   file->contents = newContents;
-   file->length = newLength;
+   /* old contents stay valid for the caller until the next change */
+   seen = File_releaseContents(file, oldContents, oldLength,
+                               oldPackedLength, pOldContents != NULL);
+   if (pOldContents != NULL)
+      *pOldContents = seen;
 
+   return TRUE;
+}
+
+/* see file.h for specification */
+void *File_replaceContents(File_T file, void* newContents,
+                           size_t newLength) {
+
+   void* oldContents = NULL;
+
+   (void) File_setContents(file, newContents, newLength, &oldContents);
    return oldContents;
 }
 
+/* see file.h for specification */
+boolean File_loadContents(File_T file, void **pContents) {
+
+   void *contents;
+
+   assert(file != NULL);
+   assert(pContents != NULL);
+
+   contents = File_getContents(file);
+   if (contents == NULL && Epoch_load(file->packedLength) != 0)
+      return FALSE;
+
+   *pContents = contents;
+   return TRUE;
+}
+
+/* see file.h for specification */
+unsigned long File_getVersion(File_T file) {
+
+   assert(file != NULL);
+
+   return file->version;
+}
+
 /* see file.h for specification */
 size_t File_getLength(File_T file) {
 
    assert(file != NULL);
 
-   return file->length;
+   return Epoch_load(file->length);
+}
+
+/* see file.h for specification */
+boolean File_getHash(File_T file, unsigned long *hash) {
+
+   void *contents;
+
+   assert(file != NULL);
+   assert(hash != NULL);
+
+   if (!file->hashed) {
+      contents = File_getContents(file);
+      if (contents == NULL && Epoch_load(file->packedLength) != 0)
+         return FALSE;
+
+      /* NULL contents hash as no bytes, followed by their length */
+      file->hash = NameKey_hash(NAMEKEY_HASH_BASIS, contents,
+                                contents != NULL ? file->length : 0);
+      file->hash = NameKey_hash(file->hash, &file->length,
+                                sizeof(file->length));
+      file->hashed = TRUE;
+   }
+
+   *hash = file->hash;
+   return TRUE;
 }
 
 /* see file.h for specification */
@@ -147,6 +476,21 @@ char* File_toString(File_T file) {
    return File_copyPath(file->path);
 }
 
+/* see file.h for specification */
+void File_getMemoryStats(size_t* pNumFiles, size_t* pNodeBytes,
+                         size_t* pPathBytes, size_t* pContentBytes) {
+
+   assert(pNumFiles != NULL);
+   assert(pNodeBytes != NULL);
+   assert(pPathBytes != NULL);
+   assert(pContentBytes != NULL);
+
+   *pNumFiles = numFiles;
+   *pNodeBytes = nodeBytes;
+   *pPathBytes = pathBytes;
+   *pContentBytes = contentBytes;
+}
+
 
 
 
@@ -9,6 +9,7 @@
 #include "directory.h"
 #include <stddef.h>
 #include "a4def.h"
+#include "namekey.h"
 
 /*
    a File_T is an object that contains a path payload and references to
@@ -24,14 +25,45 @@ typedef struct file* File_T;
    the file or its fields.
 
    The parent is not changed to link to the file.
+
+   If the Compressor packs contents, the file keeps a packed copy of
+   them instead of contents itself, and if the ContentStore is active,
+   the file references a shared copy instead of contents itself.
 */
 File_T File_create(Dir_T parent, const char *path, void *contents,
                    size_t length);
 /*
-  Frees File_T file
+  Drops a reference to File_T file, freeing it if that was the last
+  one. File_create returns a file with one reference.
 */
 void File_destroy(File_T file);
 
+/*
+  Adds a reference to file, which a copy of its parent also holds
+  (see Dir_copy), and makes parent, that copy, its parent.
+*/
+void File_share(File_T file, Dir_T parent);
+
+/*
+  Makes parent the parent of file, as it was before a copy of parent
+  replaced it (see File_share).
+*/
+void File_setParent(File_T file, Dir_T parent);
+
+/*
+  Returns TRUE if file has more than one reference, so that it must
+  be replaced by a new file rather than changed, and FALSE otherwise.
+*/
+boolean File_isShared(File_T file);
+
+/*
+  Returns TRUE if file1 and file2 have the same length and store the
+  same contents, as a file and the copy that replaced it do until the
+  copy's contents are replaced, and FALSE otherwise. Contents stored
+  apart may still be equal, unless the ContentStore is active.
+*/
+boolean File_hasSameContents(File_T file1, File_T file2);
+
 
 /*
   Compares file1 and file2 based on their paths.
@@ -45,6 +77,18 @@ int File_compare(File_T file1, File_T file2);
 */
 const char* File_getPath(File_T file);
 
+/*
+   Returns file's name, the last component of its path. Names are
+   interned: two directories or files have equal names if and only if
+   they return the same pointer.
+*/
+const char* File_getName(File_T file);
+
+/*
+   Returns the key of file's name, which lives as long as file.
+*/
+const struct NameKey* File_getKey(File_T file);
+
 /*
    Returns the parent Dir_T directory of file
 */
@@ -54,6 +98,9 @@ Dir_T File_getParent(File_T file);
    Returns the contents associated with file
 
    Note that contents can be NULL
+
+   If the contents are packed, returns an unpacked copy owned by the
+   Compressor, or NULL if unable to allocate it.
  */
 void *File_getContents(File_T file);
 
@@ -64,16 +111,55 @@ void *File_getContents(File_T file);
    Returns the old contents.
 
    Node that the old contents can be NULL
+
+   If newContents are packed or shared (see File_create), the
+   returned old contents stay valid until the next change to any file,
+   and NULL is returned (leaving file unchanged) if unable to allocate
+   the copy.
 */
 void *File_replaceContents(File_T file, void* newContents,
                            size_t newLength);
 
+/*
+   Replaces the contents of file as File_replaceContents does, storing
+   the old contents in *pOldContents, or releasing them if
+   pOldContents is NULL.
+   Returns FALSE, leaving file and *pOldContents unchanged, if unable
+   to allocate sufficient memory to store newContents, and TRUE
+   otherwise.
+*/
+boolean File_setContents(File_T file, void* newContents,
+                         size_t newLength, void** pOldContents);
+
+/*
+   Stores in *pContents the contents of file, as File_getContents
+   returns them. Returns FALSE, leaving *pContents unchanged, if the
+   contents are packed and unable to allocate sufficient memory to
+   unpack them, and TRUE otherwise.
+*/
+boolean File_loadContents(File_T file, void **pContents);
+
+/*
+   Returns the version at which the contents of file were last stored
+   (see Dir_stampTree), 0 if Epoch was active then.
+*/
+unsigned long File_getVersion(File_T file);
+
 /* 
    Returns the length in bytes associated with the
    contents in file
 */
 size_t File_getLength(File_T file);
 
+/*
+  Stores in *hash the hash of the contents of file, which is computed
+  the first time it is asked for after the contents change, and kept.
+  Returns FALSE, leaving *hash unchanged, if the contents are packed
+  and unable to allocate sufficient memory to unpack them, and TRUE
+  otherwise.
+*/
+boolean File_getHash(File_T file, unsigned long *hash);
+
 /*
   Returns a string representation for file, 
   or NULL if there is an allocation error.
@@ -83,4 +169,13 @@ size_t File_getLength(File_T file);
 */
 char* File_toString(File_T file);
 
+/*
+  Stores in *pNumFiles the number of existing files, in *pNodeBytes
+  and *pPathBytes the bytes of their structures and paths, and in
+  *pContentBytes the sum of the lengths of their contents, whether or
+  not those are packed or shared.
+*/
+void File_getMemoryStats(size_t* pNumFiles, size_t* pNodeBytes,
+                         size_t* pPathBytes, size_t* pContentBytes);
+
 #endif
@@ -10,19 +10,449 @@
 #include "file.h"
 #include "checkerFT.h"
 #include "traverser.h"
-
-/* A File Tree is an AO with 3 state variables: */
+#include "contentstore.h"
+#include "compressor.h"
+#include "pathindex.h"
+#include "intern.h"
+#include "pathview.h"
+#include "metrics.h"
+#include "epoch.h"
+#include "lock.h"
+#include "delta.h"
+#include "watch.h"
+#include "ring.h"
+#include "shard.h"
+#include "image.h"
+#include "pathsort.h"
+
+/* A shard of count, alone in its cache line */
+union countShard {
+   size_t count;
+   char line[LOCK_CACHE_LINE];
+};
+
+/* A snapshot holds the root of the tree as it was when taken, which
+   holds the directories and files then in the tree: those since
+   changed were replaced in the live tree by copies (see FT_unshare) */
+struct FT_Snapshot {
+   /* the root, NULL if the tree was empty */
+   Dir_T root;
+   /* the number of directories and files */
+   size_t count;
+};
+
+/* A File Tree is an AO with 6 state variables: */
 
 /* a flag for if it is in an initialized state (TRUE) or not (FALSE) */
 static boolean isInitialized;
-/* a pointer to the root directory in the hierarchy */
+/* a pointer to the root directory in the hierarchy, published with
+   Epoch_publish for readers */
 static Dir_T root;
-/* a counter of the number of directories and files in the hierarchy */
-static size_t count;
+/* the lock a writer holds while it changes root, or looks at it to
+   lock the root next (see Dir_lock) */
+static struct Lock rootLock;
+/* a counter of the number of directories and files in the hierarchy,
+   split into shards that writers on different threads update without
+   contending for one: it is the sum of the shards (see FT_getCount) */
+static union countShard counts[LOCK_NUM_SHARDS];
+
+/* the number of snapshots not yet released */
+static size_t numSnapshots;
+
+/* the number of rings not yet destroyed */
+static size_t numRings;
+
+/* the snapshot of the tree as it was when the open transaction began,
+   to which FT_abort returns it, NULL if there is no open transaction */
+static struct FT_Snapshot *transaction;
+/* the path index, kept as it was when the open transaction began
+   until FT_commit brings it up to date, NULL if disabled or if there
+   is no open transaction (see FT_begin) */
+static PathIndex_T heldIndex;
+/* the directory the last search of the open transaction reached, from
+   which the next one starts if it can, NULL if there is none */
+static Dir_T lastDir;
+
+/* whether the next FT_init enables the content store */
+static boolean useContentStore;
+
+/* the packing threshold the next FT_init gives the compressor */
+static size_t compressionThreshold;
+
+/* whether the next FT_init enables the path index */
+static boolean usePathIndex;
+/* the index of every directory and file by path, NULL if disabled */
+static PathIndex_T pathIndex;
+
+/* whether the next FT_init enables concurrent reads */
+static boolean useConcurrentReads;
+
+/* whether the next FT_init enables concurrent writes */
+static boolean useConcurrentWrites;
+
+/* the number of shards, and their depth, the next FT_init gives Shard
+   if it enables concurrent writes */
+static size_t numShards;
+static size_t shardDepth = 2;
+
+
+/* Adds n to count, in the calling thread's shard */
+static void FT_addCount(size_t n) {
+   Lock_add(counts[Lock_getShard()].count, n);
+}
+
+/* Subtracts n from count, in the calling thread's shard, which may
+   wrap around below 0 as long as the sum of the shards does not */
+static void FT_subCount(size_t n) {
+   Lock_sub(counts[Lock_getShard()].count, n);
+}
+
+/* Returns count, the sum of its shards */
+static size_t FT_getCount(void) {
+   size_t sum = 0;
+   size_t i;
+
+   for (i = 0; i < LOCK_NUM_SHARDS; i++)
+      sum += counts[i].count;
+
+   return sum;
+}
+
+
+/* Returns the directory from which to search for path without the
+   path index: the root, or, in an open transaction, the directory
+   the last search reached or the nearest directory above it whose
+   path is a prefix of path, so that operations on the same
+   directories share their traversals */
+static Dir_T FT_searchStart(const char* path) {
+   Dir_T dir;
+   size_t length;
+
+   for (dir = lastDir; dir != NULL; dir = Dir_getParent(dir)) {
+      length = strlen(Dir_getPath(dir));
+      if (strncmp(path, Dir_getPath(dir), length) == EQUAL &&
+          (path[length] == '\0' || path[length] == '/'))
+         return dir;
+   }
+
+   return Epoch_load(root);
+}
+
+/* Returns the farthest directory down the hierarchy matching a prefix
+   of path (see Traverser_traversePath), using the path index if it
+   is enabled */
+static Dir_T FT_traversePath(char* path) {
+   size_t length;
+   void* found;
+   int type;
+   Dir_T dir;
+
+   assert(path != NULL);
+
+   if (pathIndex == NULL) {
+      dir = Traverser_traversePath(FT_searchStart(path), path);
+      if (transaction != NULL && dir != NULL)
+         lastDir = dir;
+      return dir;
+   }
+
+   length = strlen(path);
+
+   /* looks up path, then each shorter prefix ending before a '/' */
+   for (;;) {
+      found = PathIndex_get(pathIndex, path, length, &type);
+      if (found != NULL && type == DIR)
+         return (Dir_T)found;
+
+      while (length > 0 && path[length - 1] != '/')
+         length--;
+
+      if (length == 0)
+         return NULL;
+
+      length--;
+   }
+}
+
+/* Returns the directory whose path is path, or NULL if there is none,
+   using the path index if it is enabled */
+static Dir_T FT_getDir(char* path) {
+   void* found;
+   int type;
+
+   assert(path != NULL);
+
+   if (pathIndex == NULL)
+      return Traverser_getDir(FT_searchStart(path), path);
+
+   found = PathIndex_get(pathIndex, path, strlen(path), &type);
+   if (found == NULL || type != DIR)
+      return NULL;
+
+   return (Dir_T)found;
+}
+
+/* Returns the file whose path is path, or NULL if there is none,
+   using the path index if it is enabled */
+static File_T FT_getFile(char* path) {
+   Dir_T top;
+   void* found;
+   int type;
+
+   assert(path != NULL);
+
+   if (pathIndex == NULL) {
+      top = FT_searchStart(path);
+      if (top == NULL)
+         return NULL;
+      return Traverser_getFile(top, path);
+   }
+
+   found = PathIndex_get(pathIndex, path, strlen(path), &type);
+   if (found == NULL || type != FILES)
+      return NULL;
+
+   return (File_T)found;
+}
+
+/* Locks the directories on path below curr, which the calling writer
+   holds and whose path is the first index bytes of path, hand over
+   hand, and returns the farthest one, held, as FT_lockPath does. If
+   pParent is not NULL, its parent is also held and stored in
+   *pParent, or NULL if it is curr, and rootLock, if fromRoot, is held
+   until a directory below curr is */
+static Dir_T FT_lockBelow(Dir_T curr, char* path, size_t index,
+                          Dir_T* pParent, boolean fromRoot) {
+   Dir_T child;
+   Dir_T parent = NULL;
+   struct PathView view;
+
+   /* holds each directory while finding and locking the next one,
+      keeping the last two if asked for the parent */
+   if (path[index] != '\0') {
+      PathView_init(&view, path, index + 1);
+      while (PathView_next(&view)) {
+         child = Dir_findChild(curr, path + view.offset, view.length,
+                               DIR);
+         if (child == NULL)
+            break;
+
+         Dir_lock(child);
+         if (pParent == NULL)
+            Dir_unlock(curr);
+         else if (parent != NULL)
+            Dir_unlock(parent);
+         else if (fromRoot)
+            Lock_release(&rootLock);
+
+         parent = curr;
+         curr = child;
+      }
+   }
+
+   if (pParent != NULL)
+      *pParent = parent;
+   return curr;
+}
+
+/* Returns the farthest directory down the hierarchy matching a prefix
+   of path, as FT_traversePath does, for a writer to change: while
+   Lock is active, it is found by locking directories hand over hand
+   from the root (see Dir_lock), or from the directory of path's shard
+   if Shard has it (see Shard_lockDir), and is held on return. If
+   pParent is not NULL, the directory's parent, which is also held, is
+   stored in *pParent, or NULL if the directory is the root. rootLock
+   is held on return if there is no such directory, and if pParent is
+   not NULL and the directory is the root. FT_unlockPath(dir, pParent)
+   then releases what is held */
+static Dir_T FT_lockPath(char* path, Dir_T* pParent) {
+   Dir_T curr;
+   size_t index;
+
+   assert(path != NULL);
+
+   if (!Lock_isActive) {
+      curr = FT_traversePath(path);
+      if (pParent != NULL)
+         *pParent = curr != NULL ? Dir_getParent(curr) : NULL;
+      return curr;
+   }
+
+   /* a shard's directory is locked without the ones above it, so that
+      the path starts there unless it must hold the one above */
+   curr = Shard_lockDir(path, &index);
+   if (curr != NULL) {
+      curr = FT_lockBelow(curr, path, index, pParent, FALSE);
+      if (pParent == NULL || *pParent != NULL)
+         return curr;
+      Dir_unlock(curr);
+   }
+
+   Lock_acquire(&rootLock);
+   curr = root;
+   if (pParent != NULL)
+      *pParent = NULL;
+   if (curr == NULL)
+      return NULL;
+
+   Dir_lock(curr);
+   index = strlen(Dir_getPath(curr));
+
+   /* if the root's path is not a prefix of path, up to a '/' */
+   if (strncmp(path, Dir_getPath(curr), index) != EQUAL ||
+       (path[index] != '\0' && path[index] != '/')) {
+      Dir_unlock(curr);
+      return NULL;
+   }
+
+   if (pParent == NULL)
+      Lock_release(&rootLock);
 
+   return FT_lockBelow(curr, path, index, pParent, TRUE);
+}
+
+/* Releases what FT_lockPath(path, pParent) left held, dir aside if
+   it is NULL: dir, the parent stored in *pParent, and rootLock */
+static void FT_unlockPath(Dir_T dir, Dir_T* pParent) {
+   if (dir != NULL)
+      Dir_unlock(dir);
+
+   if (pParent != NULL && *pParent != NULL)
+      Dir_unlock(*pParent);
+   else if (pParent != NULL || dir == NULL)
+      Lock_release(&rootLock);
+}
+
+/* Returns dir, a directory of the live tree that the calling writer
+   is about to change, or, if a snapshot shares it or a directory above
+   it, a copy of dir put in its place in the live tree and the path
+   index, above which every shared directory has been replaced in the
+   same way. Each copy shares its children with the directory it
+   replaces, which the snapshots keep (see Dir_copy). Returns NULL,
+   leaving the tree as it was as far as the client can tell, if unable
+   to allocate sufficient memory. */
+static Dir_T FT_unshare(Dir_T dir) {
+   Dir_T parent = NULL;
+   Dir_T copy;
+
+   assert(dir != NULL);
+
+   /* once they are all released, nothing is shared */
+   if (numSnapshots == 0)
+      return dir;
+
+   if (Dir_getParent(dir) != NULL) {
+      parent = FT_unshare(Dir_getParent(dir));
+      if (parent == NULL)
+         return NULL;
+   }
+
+   if (!Dir_isShared(dir))
+      return dir;
+
+   copy = Dir_copy(dir, parent);
+   if (copy == NULL)
+      return NULL;
+
+   if (pathIndex != NULL)
+      PathIndex_replace(pathIndex, Dir_getPath(copy), copy, DIR);
+   if (lastDir == dir)
+      lastDir = copy;
+
+   if (parent == NULL) {
+      Epoch_publish(root, copy);
+      (void) Dir_destroy(dir);
+   }
+   else
+      Dir_replaceChild(parent, dir, copy, DIR);
+
+   return copy;
+}
+
+static void FT_unindexDir(Dir_T dir);
+
+/* Removes every directory and file below dir from the path index, if
+   it is enabled */
+static void FT_unindexChildren(Dir_T dir) {
+   size_t i;
+
+   assert(dir != NULL);
+
+   if (pathIndex == NULL)
+      return;
+
+   for (i = 0; i < Dir_getNumChildren(dir, FILES); i++)
+      PathIndex_remove(pathIndex,
+                       File_getPath(Dir_getChild(dir, i, FILES)));
+
+   for (i = 0; i < Dir_getNumChildren(dir, DIR); i++)
+      FT_unindexDir(Dir_getChild(dir, i, DIR));
+}
+
+/* Removes dir and every directory and file below it from the path
+   index, if it is enabled */
+static void FT_unindexDir(Dir_T dir) {
+
+   assert(dir != NULL);
+
+   if (pathIndex == NULL)
+      return;
+
+   FT_unindexChildren(dir);
+   PathIndex_remove(pathIndex, Dir_getPath(dir));
+}
+
+/* Adds each directory of the new chain starting at first (in which
+   each directory is the only child of the previous one) to the path
+   index, if it is enabled.
+   Returns MEMORY_ERROR, leaving the index unchanged, if unable to
+   allocate sufficient memory, and SUCCESS otherwise */
+static int FT_indexChain(Dir_T first) {
+   Dir_T dir;
+
+   assert(first != NULL);
+
+   if (pathIndex == NULL)
+      return SUCCESS;
+
+   for (dir = first; dir != NULL; dir = Dir_getChild(dir, 0, DIR)) {
+      if (!PathIndex_put(pathIndex, Dir_getPath(dir), dir, DIR)) {
+         FT_unindexDir(first);
+         return MEMORY_ERROR;
+      }
+   }
+
+   return SUCCESS;
+}
 
-/* Inserts a new path of subdirectories into the tree rooted at parent,
-   or, if parent is NULL, as the root of the data structure.
+/* Tells the watches that each directory from first down to last, a
+   chain of new directories in which each is the only child of the
+   previous one, was added */
+static void FT_publishChain(Dir_T first, Dir_T last) {
+   if (last != first)
+      FT_publishChain(first, Dir_getParent(last));
+
+   Watch_publish(Dir_getPath(last), FALSE, FT_ADDED);
+}
+
+/* Adds the new directories from last up to held, the directory above
+   them that the calling writer holds, or NULL if they include the
+   root, to their shards. Other writers may reach them from there at
+   once, so that the writer must be done changing them. Those left by
+   a failed insertion are only reached from the root. */
+static void FT_shardNew(Dir_T last, Dir_T held) {
+   if (!Shard_isActive)
+      return;
+
+   for (; last != held && last != NULL; last = Dir_getParent(last))
+      Shard_add(last);
+}
+
+
+/* Inserts a new path of subdirectories, the first length bytes of
+   path, into the tree rooted at parent, or, if parent is NULL, as the
+   root of the data structure. If pLast is not NULL, stores the last
+   (deepest) new directory in *pLast.
 
    If there is an allocation error in creating any of the new
    directories or their fields, returns MEMORY_ERROR
@@ -33,14 +463,20 @@ static size_t count;
    returns PARENT_CHILD_ERROR
 
    Otherwise, returns SUCCESS 
+
+   The calling writer must hold parent, or rootLock if parent is NULL
+   (see FT_lockPath). The new directories are linked to it only once
+   they are all created, so that it is the only one held meanwhile.
+   If a snapshot shares parent, they are linked to its copy instead
+   (see FT_unshare).
 */
-static int FT_insertRestOfDir(Dir_T parent, char* path) {
+static int FT_insertRestOfDir(Dir_T parent, const char* path,
+                              size_t length, Dir_T* pLast) {
    Dir_T curr = parent;
    Dir_T firstNew = NULL;
    Dir_T new;
-   char* copyPath;
-   char* restPath = path;
-   char* dirToken;
+   struct PathView view;
+   size_t start = 0;
    size_t newCount = 0;
 
    assert(path != NULL);
@@ -49,22 +485,32 @@ static int FT_insertRestOfDir(Dir_T parent, char* path) {
    if (curr == NULL && root != NULL)
       return CONFLICTING_PATH;
 
-   if (curr != NULL)
-      restPath += (strlen(Dir_getPath(curr)) + 1);
+   if (curr != NULL) {
+      parent = FT_unshare(parent);
+      if (parent == NULL)
+         return MEMORY_ERROR;
+
+      curr = parent;
+      start = strlen(Dir_getPath(curr)) + 1;
+   }
+
+   PathView_init(&view, path, start);
 
-   copyPath = malloc(strlen(restPath) + 1);
-   if (copyPath == NULL)
-      return MEMORY_ERROR;
+   /* For each component separated by / in the first length bytes
+      of path, creates new directory  */
+   while (PathView_next(&view) && view.offset < length) {
 
-   *copyPath = '\0';
+      /* skips the empty components between repeated slashes */
+      if (view.length == 0)
+         continue;
 
-   strcpy(copyPath, restPath);
-   dirToken = strtok(copyPath, "/");
+      new = Dir_create(curr, path + view.offset, view.length);
 
-   /* For each token separated by / in path,
-      creates new directory  */
-   while (dirToken != NULL) {
-      new = Dir_create(curr, dirToken);
+      if (new == NULL) {
+         if (firstNew != NULL)
+            (void) Dir_destroy(firstNew);
+         return MEMORY_ERROR;
+      }
       newCount++;
 
       /* saves first dir created for future 
@@ -79,53 +525,50 @@ static int FT_insertRestOfDir(Dir_T parent, char* path) {
          if (Dir_linkChild(curr, new, DIR) != SUCCESS) {
             (void) Dir_destroy(new);
             (void) Dir_destroy(firstNew);
-            free(copyPath);
             return PARENT_CHILD_ERROR;
          }
       }
 
-      if (new == NULL) {
-         (void) Dir_destroy(firstNew);
-         free(copyPath);
-         return MEMORY_ERROR;
-      }
       curr = new;
-      dirToken = strtok(NULL, "/");
    }
 
-   free(copyPath);
+   /* Adds the new directories to the path index */
+   if (FT_indexChain(firstNew) != SUCCESS) {
+      (void) Dir_destroy(firstNew);
+      return MEMORY_ERROR;
+   }
+
+   if (pLast != NULL)
+      *pLast = curr;
 
    /* if firstNew should be the root */
    if (parent == NULL) {
-      root = firstNew;
-      count = newCount;
+      Epoch_publish(root, firstNew);
+      FT_addCount(newCount);
+      FT_publishChain(firstNew, curr);
       return SUCCESS;
    }
    
 /* if linkage fails, destroys previous insertions(s) and 
    reports error */
    if (Dir_linkChild(parent, firstNew, DIR) != SUCCESS) {
+      FT_unindexDir(firstNew);
       (void) Dir_destroy(firstNew);
       return PARENT_CHILD_ERROR;
    }
  
-      count += newCount;
+   FT_addCount(newCount);
+   FT_publishChain(firstNew, curr);
 
    return SUCCESS;
 }
 
-/* see ft.h for specification */
-int FT_insertDir(char* path) {
-   Dir_T dir;
+/* Inserts the directory at path below dir, the farthest directory
+   matching a prefix of path, which the calling writer holds, or as
+   the root if dir is NULL (see FT_insertDir) */
+static int FT_insertDirBelow(Dir_T dir, char* path) {
    int result;
-
-   assert(CheckerFT_isValid(isInitialized, root, count));
-   assert(path != NULL);
-
-   if (!isInitialized)
-      return INITIALIZATION_ERROR;
-
-   dir = Traverser_traversePath(root, path);
+   Dir_T last;
 
    if (dir != NULL) {
 
@@ -143,61 +586,126 @@ int FT_insertDir(char* path) {
       return result;
    }
 
-   result = FT_insertRestOfDir(dir, path);
+   result = FT_insertRestOfDir(dir, path, strlen(path), &last);
+   if (result == SUCCESS)
+      FT_shardNew(last, dir);
+
+   return result;
+}
+
+/* Does FT_insertDir (see ft.h) without recording its metrics */
+static int FT_doInsertDir(char* path) {
+   Dir_T dir;
+   int result;
+
+   /* writers cannot check a tree other writers may be changing */
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   assert(path != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   dir = FT_lockPath(path, NULL);
+   result = FT_insertDirBelow(dir, path);
+   FT_unlockPath(dir, NULL);
    
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    return result;
 }
 
 /* see ft.h for specification */
-boolean FT_containsDir(char* path) {  
+int FT_insertDir(char* path) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doInsertDir(path);
+   Metrics_end(FT_OP_INSERT_DIR, result, start);
+   return result;
+}
+
+/* Does FT_containsDir (see ft.h) without recording its metrics */
+static boolean FT_doContainsDir(char* path) {  
    Dir_T dir;
    boolean result = FALSE;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   /* readers cannot check a tree that a writer may be changing */
+   assert(Epoch_isActive() ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(path != NULL);
 
    if(!isInitialized)
       return FALSE;
 
-   dir = Traverser_getDir(root, path);
+   dir = FT_getDir(path);
 
    if (dir != NULL)
       result = TRUE;
    
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Epoch_isActive() ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return result;
+}
+
+/* see ft.h for specification */
+boolean FT_containsDir(char* path) {
+   boolean result;
+   unsigned long start = Metrics_start();
+
+   Epoch_enter();
+   result = FT_doContainsDir(path);
+   Epoch_exit();
+   Metrics_end(FT_OP_CONTAINS_DIR, METRICS_NO_STATUS, start);
    return result;
 }
 
+/* Destroys dir and the hierarchy below it, for Epoch_retire */
+static void FT_releaseDir(void* dir) {
+   (void) Dir_destroy((Dir_T)dir);
+}
+
+/* Destroys file, for Epoch_retire */
+static void FT_releaseFile(void* file) {
+   File_destroy((File_T)file);
+}
+
 /* 
    Destroys the entire herarchy of directories and files rooted
    at parameter dir, including dir itself, updating count accordingly.
    If dir is the root, it points the root to NULL. Returns SUCCESS
+
+   While Epoch is active, the hierarchy is destroyed once no reader
+   can reach it. What snapshots share of it is kept for them. The
+   calling writer must hold rootLock if dir is the root, and be the
+   only one that can reach dir.
 */
 static int FT_removeDirFrom(Dir_T dir) {
 
-   if (dir == root)
-      root = NULL;
+   /* the search may not start below dir any more */
+   if (transaction != NULL)
+      lastDir = NULL;
+
+   if (dir == Epoch_load(root))
+      Epoch_publish(root, NULL);
    
-   if (dir != NULL)
-      count -= Dir_destroy(dir);
+   if (dir != NULL && (Epoch_isActive() || numSnapshots > 0)) {
+      FT_subCount(Dir_getTreeSize(dir));
+      Epoch_retire(dir, FT_releaseDir);
+   }
+   else if (dir != NULL)
+      FT_subCount(Dir_destroy(dir));
 
    return SUCCESS;
 }
 
-/* see ft.h for specification */
-int FT_rmDir(char *path) {
-   Dir_T dir;
+/* Removes the directory at path, if it is dir, the farthest
+   directory matching a prefix of path, from its parent parent (see
+   FT_rmDir). The calling writer must hold both as FT_lockPath(path,
+   &parent) left them; dir is no longer held if SUCCESS is returned */
+static int FT_rmDirAt(Dir_T dir, Dir_T parent, char *path) {
+   boolean isRemovingShards;
    int result;
-   Dir_T parent;
-
-   assert(CheckerFT_isValid(isInitialized, root, count));
-   assert(path != NULL);
-
-   if (!isInitialized)
-      return INITIALIZATION_ERROR;
-
-   dir = Traverser_traversePath(root, path);
 
    /* Checks if path does not exist or exists as a file */
    if (dir == NULL)
@@ -211,36 +719,79 @@ int FT_rmDir(char *path) {
          return NO_SUCH_PATH;
    }
 
+   if (parent != NULL) {
+      parent = FT_unshare(parent);
+      if (parent == NULL)
+         return MEMORY_ERROR;
+   }
+
+   /* writers may no longer reach dir, or those below it, through their
+      shards once it is unlinked, nor add new ones below it there */
+   isRemovingShards = Shard_removeBelow(dir);
+
    /* Unlink parent and child directories if dir is not the root */
-   parent = Dir_getParent(dir);
-   if (parent != NULL)
-      Dir_unlinkChild(parent, dir, DIR);
+   if (parent != NULL &&
+       Dir_unlinkChild(parent, dir, DIR) == MEMORY_ERROR) {
+      if (isRemovingShards)
+         Shard_endRemoval();
+      return MEMORY_ERROR;
+   }
 
+   FT_unindexDir(dir);
+   Watch_publish(path, FALSE, FT_REMOVED);
+
+   /* writers in the hierarchy below dir reached it before it was
+      unlinked, and FT_removeDirFrom waits for them */
+   Dir_unlock(dir);
    result = FT_removeDirFrom(dir);
-   
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   if (isRemovingShards)
+      Shard_endRemoval();
+
    return result;
 }
 
-/* see ft.h for specification */
-int FT_insertFile(char *path, void *contents, size_t length) {
-   Dir_T parent;
-   File_T file;
+/* Does FT_rmDir (see ft.h) without recording its metrics */
+static int FT_doRmDir(char *path) {
+   Dir_T dir;
    int result;
-   char* prefix;
-
+   Dir_T parent;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(path != NULL);
 
    if (!isInitialized)
       return INITIALIZATION_ERROR;
 
-   /* Ensures that file will not be the root */
-   if (root == NULL)
-      return CONFLICTING_PATH;
+   dir = FT_lockPath(path, &parent);
+   result = FT_rmDirAt(dir, parent, path);
+   FT_unlockPath(result == SUCCESS ? NULL : dir, &parent);
    
-   parent = Traverser_traversePath(root, path);
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_rmDir(char *path) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doRmDir(path);
+   Metrics_end(FT_OP_RM_DIR, result, start);
+   return result;
+}
+
+/* Inserts the file at path, with the given contents of size length
+   bytes, below parent, the farthest directory matching a prefix of
+   path, which the calling writer holds, or NULL if there is none (see
+   FT_insertFile) */
+static int FT_insertFileBelow(Dir_T parent, char *path, void *contents,
+                              size_t length) {
+   File_T file;
+   int result;
+   size_t prefixLength;
+   Dir_T held;
 
    /* Checks if path is not underneath existing root */
    if (parent == NULL)
@@ -259,28 +810,27 @@ int FT_insertFile(char *path, void *contents, size_t length) {
    if (result != SUCCESS)
       return result;
 
-   /* Gets the path of the new file's parent directory */
-   prefix = Traverser_getPrefix(path);
-   if (prefix == NULL)
+   parent = FT_unshare(parent);
+   if (parent == NULL)
       return MEMORY_ERROR;
+   held = parent;
+
+   /* Gets the length of the path of the new file's parent */
+   prefixLength = Traverser_getPrefix(path);
 
    /* If current parent should not be the new file's parent,
       insert rest of directories and get the file's  true parent */
-   if (strcmp(prefix, Dir_getPath(parent)) != EQUAL) {     
-   result = FT_insertRestOfDir(parent, prefix);
-   if (result != SUCCESS) {
-      free(prefix);
+   if (strlen(Dir_getPath(parent)) != prefixLength) {     
+   result = FT_insertRestOfDir(parent, path, prefixLength, &parent);
+   if (result != SUCCESS)
       return result;
    }
-   parent = Traverser_traversePath(parent, prefix);
-   }
 
    /* Asserts invariances */
    assert(CheckerFT_Dir_isValid(parent));
-   assert(strcmp(prefix, Dir_getPath(parent)) == EQUAL);
-   assert(strcmp(prefix, path) != EQUAL);
-
-   free(prefix);
+   assert(strncmp(path, Dir_getPath(parent), prefixLength) == EQUAL);
+   assert(Dir_getPath(parent)[prefixLength] == '\0');
+   assert(path[prefixLength] != '\0');
 
    file = File_create(parent, path, contents, length);
    if (file == NULL)
@@ -291,50 +841,102 @@ int FT_insertFile(char *path, void *contents, size_t length) {
       File_destroy(file);
       return PARENT_CHILD_ERROR;
    }
+
+   /* if indexing fails, removes file and reports error */
+   if (pathIndex != NULL &&
+       !PathIndex_put(pathIndex, File_getPath(file), file, FILES)) {
+      (void) Dir_unlinkChild(parent, file, FILES);
+      File_destroy(file);
+      return MEMORY_ERROR;
+   }
    
-   count++;
+   FT_addCount(1);
+   Watch_publish(path, TRUE, FT_ADDED);
    
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(CheckerFT_File_isValid(file));
 
+   FT_shardNew(parent, held);
    return SUCCESS;
 }
 
+/* Does FT_insertFile (see ft.h) without recording its metrics */
+static int FT_doInsertFile(char *path, void *contents,
+                           size_t length) {
+   Dir_T parent;
+   int result;
+
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   assert(path != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   /* Ensures that file will not be the root */
+   if (Epoch_load(root) == NULL)
+      return CONFLICTING_PATH;
+   
+   parent = FT_lockPath(path, NULL);
+   result = FT_insertFileBelow(parent, path, contents, length);
+   FT_unlockPath(parent, NULL);
+
+   return result;
+}
+
 /* see ft.h for specification */
-boolean FT_containsFile(char* path) {   
+int FT_insertFile(char *path, void *contents, size_t length) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doInsertFile(path, contents, length);
+   Metrics_end(FT_OP_INSERT_FILE, result, start);
+   return result;
+}
+
+/* Does FT_containsFile (see ft.h) without recording its metrics */
+static boolean FT_doContainsFile(char* path) {   
    File_T file;
    boolean result = FALSE;
   
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Epoch_isActive() ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(path != NULL);
 
    if(!isInitialized)
       return FALSE;
 
-   file = Traverser_getFile(root, path);
+   file = FT_getFile(path);
 
    if (file != NULL)
       result = TRUE;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Epoch_isActive() ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    return result;
 
 }
 
 /* see ft.h for specification */
-int FT_rmFile(char *path) {
-   Dir_T parent;
+boolean FT_containsFile(char* path) {
+   boolean result;
+   unsigned long start = Metrics_start();
+
+   Epoch_enter();
+   result = FT_doContainsFile(path);
+   Epoch_exit();
+   Metrics_end(FT_OP_CONTAINS_FILE, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Removes the file at path from parent, the farthest directory
+   matching a prefix of path, which the calling writer holds, or NULL
+   if there is none (see FT_rmFile) */
+static int FT_rmFileFrom(Dir_T parent, char *path) {
    File_T file;
    size_t childID = 0;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
-   assert(path != NULL);
-
-   if (!isInitialized)
-      return INITIALIZATION_ERROR;
-
-   parent = Traverser_traversePath(root, path);
-
    /* Checks if path does not exist or exists as a directory */
    if (parent == NULL)
       return NO_SUCH_PATH;
@@ -345,68 +947,195 @@ int FT_rmFile(char *path) {
    if (Dir_hasChild(parent, path, &childID, FILES) != TRUE)
       return NO_SUCH_PATH; 
    
+   parent = FT_unshare(parent);
+   if (parent == NULL)
+      return MEMORY_ERROR;
+
    file = Dir_getChild(parent, childID, FILES);
 
    /* Removes file and updates count */
-   (void) Dir_unlinkChild(parent, file, FILES);
-   File_destroy(file);
-   count--;
+   if (Dir_unlinkChild(parent, file, FILES) == MEMORY_ERROR)
+      return MEMORY_ERROR;
+   if (pathIndex != NULL)
+      PathIndex_remove(pathIndex, path);
+   Epoch_retire(file, FT_releaseFile);
+   FT_subCount(1);
+   Watch_publish(path, TRUE, FT_REMOVED);
 
    return SUCCESS;
 }
 
-/* see ft.h for specification */
-void *FT_getFileContents(char *path) { 
-   File_T file;
+/* Does FT_rmFile (see ft.h) without recording its metrics */
+static int FT_doRmFile(char *path) {
+   Dir_T parent;
+   int result;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(path != NULL);
 
    if (!isInitialized)
-      return NULL;
-
-   file = Traverser_getFile(root, path);
+      return INITIALIZATION_ERROR;
 
-   if (file == NULL)
-      return NULL;
+   parent = FT_lockPath(path, NULL);
+   result = FT_rmFileFrom(parent, path);
+   FT_unlockPath(parent, NULL);
 
-   return File_getContents(file);
+   return result;
 }
 
 /* see ft.h for specification */
-void *FT_replaceFileContents(char *path, void *newContents,
-                             size_t newLength) {
+int FT_rmFile(char *path) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doRmFile(path);
+   Metrics_end(FT_OP_RM_FILE, result, start);
+   return result;
+}
+
+/* Does FT_getFileContents (see ft.h) without recording its metrics */
+static void *FT_doGetFileContents(char *path) { 
    File_T file;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Epoch_isActive() ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(path != NULL);
 
    if (!isInitialized)
       return NULL;
 
-   file = Traverser_getFile(root, path);
+   file = FT_getFile(path);
 
    if (file == NULL)
       return NULL;
 
-   return File_replaceContents(file, newContents, newLength);
+   return File_getContents(file);
 }
 
 /* see ft.h for specification */
-int FT_stat(char *path, boolean *type, size_t *length) {
-   Dir_T dir;
+void *FT_getFileContents(char *path) {
+   void *result;
+   unsigned long start = Metrics_start();
+
+   Epoch_enter();
+   result = FT_doGetFileContents(path);
+   Epoch_exit();
+   Metrics_end(FT_OP_GET_FILE_CONTENTS, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Replaces file, a file of parent in the live tree that a snapshot
+   shares, by a new file with the same path and the given contents of
+   size length bytes, in the live tree and the path index. Returns
+   FALSE, leaving the tree unchanged, if unable to allocate sufficient
+   memory, and TRUE otherwise. */
+static boolean FT_replaceFile(Dir_T parent, File_T file, void *contents,
+                              size_t length) {
+   File_T new;
+
+   new = File_create(parent, File_getPath(file), contents, length);
+   if (new == NULL)
+      return FALSE;
+
+   if (pathIndex != NULL)
+      PathIndex_replace(pathIndex, File_getPath(new), new, FILES);
+
+   /* the snapshots keep file, and so its contents */
+   Dir_replaceChild(parent, file, new, FILES);
+   return TRUE;
+}
+
+/* Replaces the contents of file, a file of the live tree, with
+   newContents of size newLength bytes, as File_setContents does,
+   storing the old contents in *pOldContents, or releasing them if
+   pOldContents is NULL. If a snapshot shares file, it is replaced in
+   the live tree and the path index by a new file with the new
+   contents instead (see FT_unshare), and its contents are stored as
+   File_getContents returns them. Returns MEMORY_ERROR, leaving the
+   tree unchanged as far as the client can tell, if unable to allocate
+   sufficient memory, and SUCCESS otherwise. */
+static int FT_replaceContentsOf(File_T file, void *newContents,
+                                size_t newLength, void **pOldContents) {
+   Dir_T parent;
+   void *oldContents;
+   boolean stored;
+
+   assert(file != NULL);
+
+   parent = FT_unshare(File_getParent(file));
+   if (parent == NULL)
+      return MEMORY_ERROR;
+
+   if (!File_isShared(file))
+      stored = File_setContents(file, newContents, newLength,
+                                pOldContents);
+   else {
+      oldContents = File_getContents(file);
+      stored = FT_replaceFile(parent, file, newContents, newLength);
+      if (stored && pOldContents != NULL)
+         *pOldContents = oldContents;
+   }
+
+   if (!stored)
+      return MEMORY_ERROR;
+
+   Watch_publish(File_getPath(file), TRUE, FT_MODIFIED);
+   return SUCCESS;
+}
+
+/* Does FT_replaceFileContents (see ft.h) without recording its
+   metrics */
+static void *FT_doReplaceFileContents(char *path, void *newContents,
+                                      size_t newLength) {
+   Dir_T parent = NULL;
    File_T file;
-   size_t childID = 0;
+   void *oldContents = NULL;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
+   assert(Lock_isActive ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
    assert(path != NULL);
-   assert(type != NULL);
-   assert(length != NULL);
 
    if (!isInitialized)
-      return INITIALIZATION_ERROR;
+      return NULL;
+
+   /* other writers may change the file while its parent is not held */
+   if (!Lock_isActive)
+      file = FT_getFile(path);
+   else {
+      parent = FT_lockPath(path, NULL);
+      file = parent != NULL ? Traverser_getFile(parent, path) : NULL;
+   }
+
+   if (file != NULL)
+      (void) FT_replaceContentsOf(file, newContents, newLength,
+                                  &oldContents);
 
-   dir = Traverser_traversePath(root, path);
+   if (Lock_isActive)
+      FT_unlockPath(parent, NULL);
+
+   return oldContents;
+}
+
+/* see ft.h for specification */
+void *FT_replaceFileContents(char *path, void *newContents,
+                             size_t newLength) {
+   void *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doReplaceFileContents(path, newContents, newLength);
+   Metrics_end(FT_OP_REPLACE_FILE_CONTENTS, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_stat (see ft.h) given dir, the farthest directory matching
+   a prefix of path in the tree at hand, or NULL if there is none */
+static int FT_statAt(Dir_T dir, char *path, boolean *type,
+                     size_t *length) {
+   File_T file;
+
+   if (dir == NULL)
+      return NO_SUCH_PATH;
 
    /* Checks if path exists as a directory */
    if (strcmp(path, Dir_getPath(dir)) == EQUAL) {
@@ -415,8 +1144,8 @@ int FT_stat(char *path, boolean *type, size_t *length) {
    }
 
    /* Checks if path exists as a file */
-   if (Dir_hasChild(dir, path, &childID, FILES) == TRUE) {
-      file = Dir_getChild(dir, childID, FILES);
+   file = Traverser_getFile(dir, path);
+   if (file != NULL) {
       *type = TRUE;
       *length = File_getLength(file);
       return SUCCESS;
@@ -425,42 +1154,2040 @@ int FT_stat(char *path, boolean *type, size_t *length) {
    return NO_SUCH_PATH;
 }
 
-/* see ft.h for specification */
-int FT_init(void) {
-   assert(CheckerFT_isValid(isInitialized, root, count));
+/* Does FT_stat (see ft.h) without recording its metrics */
+static int FT_doStat(char *path, boolean *type, size_t *length) {
+   assert(Epoch_isActive() ||
+          CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
 
-   if (isInitialized)
+   if (!isInitialized)
       return INITIALIZATION_ERROR;
 
-   isInitialized = 1;
-   root = NULL;
-   count = 0;
+   return FT_statAt(FT_traversePath(path), path, type, length);
+}
+
+/* see ft.h for specification */
+int FT_stat(char *path, boolean *type, size_t *length) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   Epoch_enter();
+   result = FT_doStat(path, type, length);
+   Epoch_exit();
+   Metrics_end(FT_OP_STAT, result, start);
+   return result;
+}
+
+/* Does FT_listDir (see ft.h) given dir, the farthest directory
+   matching a prefix of path in the tree at hand, or NULL if there is
+   none */
+static int FT_listDirAt(Dir_T dir, char *path, const char *startAfter,
+                        size_t max, struct FT_DirEntry *out,
+                        size_t *numEntries) {
+   Dir_T childDir = NULL;
+   File_T childFile = NULL;
+   const char* dirName = NULL;
+   const char* fileName = NULL;
+   size_t dirID;
+   size_t fileID;
+   size_t numDirC;
+   size_t numFileC;
+   size_t n = 0;
+
+   if (dir == NULL)
+      return NO_SUCH_PATH;
+
+   /* Checks if path does not exist or exists as a file */
+   if (strcmp(path, Dir_getPath(dir)) != EQUAL) {
+      if (Dir_hasChild(dir, path, NULL, FILES) == TRUE)
+         return NOT_A_DIRECTORY;
+
+      return NO_SUCH_PATH;
+   }
+
+   numDirC = Dir_getNumChildren(dir, DIR);
+   numFileC = Dir_getNumChildren(dir, FILES);
+   dirID = Dir_getChildAfter(dir, startAfter, DIR);
+   fileID = Dir_getChildAfter(dir, startAfter, FILES);
+
+   /* Merges the two sorted child arrays into out, in order by name */
+   while (n < max && (dirID < numDirC || fileID < numFileC)) {
+
+      if (dirID < numDirC && dirName == NULL) {
+         childDir = Dir_getChild(dir, dirID, DIR);
+         dirName = Dir_getName(childDir);
+      }
+
+      if (fileID < numFileC && fileName == NULL) {
+         childFile = Dir_getChild(dir, fileID, FILES);
+         fileName = File_getName(childFile);
+      }
+
+      if (fileName == NULL ||
+          (dirName != NULL && strcmp(dirName, fileName) < 0)) {
+         out[n].name = dirName;
+         out[n].type = FALSE;
+         out[n].length = 0;
+         dirName = NULL;
+         dirID++;
+      }
+
+      else {
+         out[n].name = fileName;
+         out[n].type = TRUE;
+         out[n].length = File_getLength(childFile);
+         fileName = NULL;
+         fileID++;
+      }
+
+      n++;
+   }
+
+   *numEntries = n;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
    return SUCCESS;
 }
 
-/* see ft.h for specification */
-int FT_destroy(void) {
-   assert(CheckerFT_isValid(isInitialized, root, count));
+/* Does FT_listDir (see ft.h) without recording its metrics */
+static int FT_doListDir(char *path, const char *startAfter, size_t max,
+                        struct FT_DirEntry *out, size_t *numEntries) {
+   int result;
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   assert(path != NULL);
+   assert(out != NULL || max == 0);
+   assert(numEntries != NULL);
 
    if (!isInitialized)
       return INITIALIZATION_ERROR;
 
-   FT_removeDirFrom(root);
+   result = FT_listDirAt(FT_traversePath(path), path, startAfter, max,
+                         out, numEntries);
 
-   isInitialized = 0;
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_listDir(char *path, const char *startAfter, size_t max,
+               struct FT_DirEntry *out, size_t *numEntries) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doListDir(path, startAfter, max, out, numEntries);
+   Metrics_end(FT_OP_LIST_DIR, result, start);
+   return result;
+}
+
+/* Does FT_getHash (see ft.h) without recording its metrics */
+static int FT_doGetHash(char *path, unsigned long *hash) {
+   Dir_T dir;
+   File_T file;
+   boolean hashed;
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   assert(path != NULL);
+   assert(hash != NULL);
+
+   /* hashes are not kept while readers and writers may overlap */
+   if (!isInitialized || Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   dir = FT_traversePath(path);
+   if (dir == NULL)
+      return NO_SUCH_PATH;
+
+   if (strcmp(path, Dir_getPath(dir)) == EQUAL)
+      hashed = Dir_getHash(dir, hash);
+
+   else {
+      file = Traverser_getFile(dir, path);
+      if (file == NULL)
+         return NO_SUCH_PATH;
+      hashed = File_getHash(file, hash);
+   }
+
+   if (!hashed)
+      return MEMORY_ERROR;
 
-   assert(CheckerFT_isValid(isInitialized, root, count));
    return SUCCESS;
 }
- 
+
 /* see ft.h for specification */
-char *FT_toString(void) {
-   assert(CheckerFT_isValid(isInitialized, root, count));
+int FT_getHash(char *path, unsigned long *hash) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doGetHash(path, hash);
+   Metrics_end(FT_OP_GET_HASH, result, start);
+   return result;
+}
+
+/* Does FT_snapshot (see ft.h) without recording its metrics */
+static struct FT_Snapshot *FT_doSnapshot(void) {
+   struct FT_Snapshot *snapshot;
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   /* readers may not wait for a writer to copy what they read */
+   if (!isInitialized || Epoch_isActive())
+      return NULL;
+
+   snapshot = (struct FT_Snapshot *)malloc(sizeof(struct FT_Snapshot));
+   if (snapshot == NULL)
+      return NULL;
+
+   snapshot->root = root != NULL ? Dir_share(root) : NULL;
+   snapshot->count = FT_getCount();
+   numSnapshots++;
+
+   return snapshot;
+}
+
+/* see ft.h for specification */
+struct FT_Snapshot *FT_snapshot(void) {
+   struct FT_Snapshot *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doSnapshot();
+   Metrics_end(FT_OP_SNAPSHOT, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_releaseSnapshot (see ft.h) without recording its metrics */
+static int FT_doReleaseSnapshot(struct FT_Snapshot *snapshot) {
+
+   assert(snapshot != NULL);
 
    if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   if (snapshot->root != NULL)
+      (void) Dir_destroy(snapshot->root);
+   free(snapshot);
+   numSnapshots--;
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_releaseSnapshot(struct FT_Snapshot *snapshot) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doReleaseSnapshot(snapshot);
+   Metrics_end(FT_OP_RELEASE_SNAPSHOT, result, start);
+   return result;
+}
+
+/* Does FT_snapshotStat (see ft.h) without recording its metrics */
+static int FT_doSnapshotStat(struct FT_Snapshot *snapshot, char *path,
+                             boolean *type, size_t *length) {
+
+   assert(snapshot != NULL);
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
+
+   return FT_statAt(Traverser_traversePath(snapshot->root, path), path,
+                    type, length);
+}
+
+/* see ft.h for specification */
+int FT_snapshotStat(struct FT_Snapshot *snapshot, char *path,
+                    boolean *type, size_t *length) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doSnapshotStat(snapshot, path, type, length);
+   Metrics_end(FT_OP_SNAPSHOT_STAT, result, start);
+   return result;
+}
+
+/* Does FT_snapshotGetFileContents (see ft.h) without recording its
+   metrics */
+static void *FT_doSnapshotGetFileContents(struct FT_Snapshot *snapshot,
+                                          char *path) {
+   File_T file;
+
+   assert(snapshot != NULL);
+   assert(path != NULL);
+
+   if (snapshot->root == NULL)
+      return NULL;
+
+   file = Traverser_getFile(snapshot->root, path);
+   if (file == NULL)
       return NULL;
 
-   return Traverser_toString(root, count);
+   return File_getContents(file);
+}
+
+/* see ft.h for specification */
+void *FT_snapshotGetFileContents(struct FT_Snapshot *snapshot,
+                                 char *path) {
+   void *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doSnapshotGetFileContents(snapshot, path);
+   Metrics_end(FT_OP_SNAPSHOT_GET_FILE_CONTENTS, METRICS_NO_STATUS,
+               start);
+   return result;
+}
+
+/* Does FT_snapshotListDir (see ft.h) without recording its metrics */
+static int FT_doSnapshotListDir(struct FT_Snapshot *snapshot,
+                                char *path, const char *startAfter,
+                                size_t max, struct FT_DirEntry *out,
+                                size_t *numEntries) {
+
+   assert(snapshot != NULL);
+   assert(path != NULL);
+   assert(out != NULL || max == 0);
+   assert(numEntries != NULL);
+
+   return FT_listDirAt(Traverser_traversePath(snapshot->root, path),
+                       path, startAfter, max, out, numEntries);
+}
+
+/* see ft.h for specification */
+int FT_snapshotListDir(struct FT_Snapshot *snapshot, char *path,
+                       const char *startAfter, size_t max,
+                       struct FT_DirEntry *out, size_t *numEntries) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doSnapshotListDir(snapshot, path, startAfter, max, out,
+                                 numEntries);
+   Metrics_end(FT_OP_SNAPSHOT_LIST_DIR, result, start);
+   return result;
+}
+
+/* Does FT_snapshotToString (see ft.h) without recording its metrics */
+static char *FT_doSnapshotToString(struct FT_Snapshot *snapshot) {
+
+   assert(snapshot != NULL);
+
+   return Traverser_toString(snapshot->root, snapshot->count);
+}
+
+/* see ft.h for specification */
+char *FT_snapshotToString(struct FT_Snapshot *snapshot) {
+   char *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doSnapshotToString(snapshot);
+   Metrics_end(FT_OP_SNAPSHOT_TO_STRING, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Tells callback, with extra, that each directory and file of the
+   hierarchy rooted at dir, dir included, differs as change */
+static void FT_diffAll(Dir_T dir, enum FT_Change change,
+                       FT_DiffCallback callback, void *extra) {
+   size_t i;
+
+   callback(Dir_getPath(dir), FALSE, change, extra);
+
+   for (i = 0; i < Dir_getNumChildren(dir, FILES); i++)
+      callback(File_getPath(Dir_getChild(dir, i, FILES)), TRUE, change,
+               extra);
+
+   for (i = 0; i < Dir_getNumChildren(dir, DIR); i++)
+      FT_diffAll(Dir_getChild(dir, i, DIR), change, callback, extra);
+}
+
+/* Compares name1 and name2, the names of children of directories
+   with the same path, in the order of those children */
+static int FT_compareNames(const char *name1, const char *name2) {
+
+   /* interned names are equal exactly when they are the same pointer,
+      and others usually are when they are */
+   if (name1 == name2)
+      return EQUAL;
+
+   return strcmp(name1, name2);
+}
+
+/* Tells callback, with extra, how the hierarchy below to differs from
+   the one below from, directories with the same path, by merging
+   their children, which both keep sorted by name */
+static void FT_diffDirs(Dir_T from, Dir_T to, FT_DiffCallback callback,
+                        void *extra) {
+   File_T fromFile;
+   File_T toFile;
+   Dir_T fromDir;
+   Dir_T toDir;
+   size_t i = 0;
+   size_t j = 0;
+   int cmp;
+
+   /* hierarchies shared by both trees are the same */
+   if (from == to)
+      return;
+
+   while (i < Dir_getNumChildren(from, FILES) ||
+          j < Dir_getNumChildren(to, FILES)) {
+      fromFile = i < Dir_getNumChildren(from, FILES) ?
+         Dir_getChild(from, i, FILES) : NULL;
+      toFile = j < Dir_getNumChildren(to, FILES) ?
+         Dir_getChild(to, j, FILES) : NULL;
+
+      if (fromFile == NULL)
+         cmp = 1;
+      else if (toFile == NULL)
+         cmp = -1;
+      else
+         cmp = FT_compareNames(File_getName(fromFile),
+                               File_getName(toFile));
+
+      if (cmp < 0) {
+         callback(File_getPath(fromFile), TRUE, FT_REMOVED, extra);
+         i++;
+      }
+      else if (cmp > 0) {
+         callback(File_getPath(toFile), TRUE, FT_ADDED, extra);
+         j++;
+      }
+      else {
+         if (fromFile != toFile &&
+             !File_hasSameContents(fromFile, toFile))
+            callback(File_getPath(toFile), TRUE, FT_MODIFIED, extra);
+         i++;
+         j++;
+      }
+   }
+
+   i = 0;
+   j = 0;
+   while (i < Dir_getNumChildren(from, DIR) ||
+          j < Dir_getNumChildren(to, DIR)) {
+      fromDir = i < Dir_getNumChildren(from, DIR) ?
+         Dir_getChild(from, i, DIR) : NULL;
+      toDir = j < Dir_getNumChildren(to, DIR) ?
+         Dir_getChild(to, j, DIR) : NULL;
+
+      if (fromDir == NULL)
+         cmp = 1;
+      else if (toDir == NULL)
+         cmp = -1;
+      else
+         cmp = FT_compareNames(Dir_getName(fromDir),
+                               Dir_getName(toDir));
+
+      if (cmp < 0) {
+         FT_diffAll(fromDir, FT_REMOVED, callback, extra);
+         i++;
+      }
+      else if (cmp > 0) {
+         FT_diffAll(toDir, FT_ADDED, callback, extra);
+         j++;
+      }
+      else {
+         FT_diffDirs(fromDir, toDir, callback, extra);
+         i++;
+         j++;
+      }
+   }
+}
+
+/* Does FT_diff (see ft.h) without recording its metrics */
+static int FT_doDiff(struct FT_Snapshot *from, struct FT_Snapshot *to,
+                     FT_DiffCallback callback, void *extra) {
+   Dir_T fromRoot;
+   Dir_T toRoot;
+
+   assert(callback != NULL);
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   /* readers may not read what a writer is changing */
+   if (!isInitialized || Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   fromRoot = from != NULL ? from->root : root;
+   toRoot = to != NULL ? to->root : root;
+
+   if (fromRoot != NULL && toRoot != NULL &&
+       strcmp(Dir_getPath(fromRoot), Dir_getPath(toRoot)) == EQUAL)
+      FT_diffDirs(fromRoot, toRoot, callback, extra);
+
+   else {
+      if (fromRoot != NULL)
+         FT_diffAll(fromRoot, FT_REMOVED, callback, extra);
+      if (toRoot != NULL)
+         FT_diffAll(toRoot, FT_ADDED, callback, extra);
+   }
+
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_diff(struct FT_Snapshot *from, struct FT_Snapshot *to,
+            FT_DiffCallback callback, void *extra) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doDiff(from, to, callback, extra);
+   Metrics_end(FT_OP_DIFF, result, start);
+   return result;
+}
+
+/* Returns TRUE if dir has a child, directory or file, named name */
+static boolean FT_hasName(Dir_T dir, const char *name) {
+   return (boolean)(Dir_hasChildName(dir, name, strlen(name), DIR) ||
+                    Dir_hasChildName(dir, name, strlen(name), FILES));
+}
+
+/* Puts in the path index each directory and file below new, a
+   directory of the live tree, whose path the hierarchy below old,
+   the directory with new's path when the open transaction began (or
+   NULL if there was none), lacks; or, if undo is TRUE, removes them.
+   Returns FALSE if unable to allocate sufficient memory, and TRUE
+   otherwise. The hierarchies below the directories the transaction
+   did not change are the same, and are skipped. */
+static boolean FT_indexAdded(Dir_T old, Dir_T new, boolean undo) {
+   Dir_T child;
+   File_T file;
+   const char *name;
+   size_t i;
+
+   if (old == new)
+      return TRUE;
+
+   for (i = 0; i < Dir_getNumChildren(new, FILES); i++) {
+      file = Dir_getChild(new, i, FILES);
+      if (old != NULL && FT_hasName(old, File_getName(file)))
+         continue;
+
+      if (undo)
+         PathIndex_remove(pathIndex, File_getPath(file));
+      else if (!PathIndex_put(pathIndex, File_getPath(file), file,
+                              FILES))
+         return FALSE;
+   }
+
+   for (i = 0; i < Dir_getNumChildren(new, DIR); i++) {
+      child = Dir_getChild(new, i, DIR);
+      name = Dir_getName(child);
+
+      if (old == NULL || !FT_hasName(old, name)) {
+         if (undo)
+            PathIndex_remove(pathIndex, Dir_getPath(child));
+         else if (!PathIndex_put(pathIndex, Dir_getPath(child), child,
+                                 DIR))
+            return FALSE;
+      }
+
+      if (!FT_indexAdded(old == NULL ? NULL :
+                         Dir_findChild(old, name, strlen(name), DIR),
+                         child, undo))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* Brings the path index up to date for the directories and files
+   below new, a directory of the live tree, whose paths were below
+   old, the directory with new's path when the open transaction began,
+   as they were then: maps those still there to what is there now,
+   and removes the others. Cannot fail: the paths added are already
+   in the index (see FT_indexAdded). */
+static void FT_indexChanged(Dir_T old, Dir_T new) {
+   Dir_T child;
+   Dir_T oldDir;
+   File_T file;
+   File_T oldFile;
+   const char *name;
+   size_t i;
+
+   if (old == new)
+      return;
+
+   for (i = 0; i < Dir_getNumChildren(new, FILES); i++) {
+      file = Dir_getChild(new, i, FILES);
+      name = File_getName(file);
+      oldFile = Dir_findChild(old, name, strlen(name), FILES);
+      oldDir = Dir_findChild(old, name, strlen(name), DIR);
+
+      if (oldDir != NULL)
+         FT_unindexChildren(oldDir);
+      if ((oldFile != NULL && oldFile != file) || oldDir != NULL)
+         PathIndex_replace(pathIndex, File_getPath(file), file, FILES);
+   }
+
+   for (i = 0; i < Dir_getNumChildren(new, DIR); i++) {
+      child = Dir_getChild(new, i, DIR);
+      name = Dir_getName(child);
+      oldDir = Dir_findChild(old, name, strlen(name), DIR);
+
+      if ((oldDir != NULL && oldDir != child) ||
+          Dir_hasChildName(old, name, strlen(name), FILES))
+         PathIndex_replace(pathIndex, Dir_getPath(child), child, DIR);
+      if (oldDir != NULL)
+         FT_indexChanged(oldDir, child);
+   }
+
+   for (i = 0; i < Dir_getNumChildren(old, FILES); i++) {
+      file = Dir_getChild(old, i, FILES);
+      if (!FT_hasName(new, File_getName(file)))
+         PathIndex_remove(pathIndex, File_getPath(file));
+   }
+
+   for (i = 0; i < Dir_getNumChildren(old, DIR); i++) {
+      child = Dir_getChild(old, i, DIR);
+      if (!FT_hasName(new, Dir_getName(child)))
+         FT_unindexDir(child);
+   }
+}
+
+/* Brings the path index, as it was when the open transaction began
+   with the tree rooted at old, up to date with the tree rooted at
+   new. Returns MEMORY_ERROR, leaving the index as it was, if unable
+   to allocate sufficient memory, and SUCCESS otherwise */
+static int FT_syncIndex(Dir_T old, Dir_T new) {
+   Dir_T from = NULL;
+
+   if (old == new)
+      return SUCCESS;
+
+   if (old != NULL && new != NULL &&
+       strcmp(Dir_getPath(old), Dir_getPath(new)) == EQUAL)
+      from = old;
+
+   /* the paths added first, as only they may fail */
+   if (new != NULL &&
+       ((from == NULL &&
+         !PathIndex_put(pathIndex, Dir_getPath(new), new, DIR)) ||
+        !FT_indexAdded(from, new, FALSE))) {
+      (void) FT_indexAdded(from, new, TRUE);
+      if (from == NULL)
+         PathIndex_remove(pathIndex, Dir_getPath(new));
+      return MEMORY_ERROR;
+   }
+
+   if (from != NULL) {
+      PathIndex_replace(pathIndex, Dir_getPath(new), new, DIR);
+      FT_indexChanged(old, new);
+   }
+   else if (old != NULL)
+      FT_unindexDir(old);
+
+   return SUCCESS;
+}
+
+/* Makes each directory of the hierarchy rooted at old (if any), as
+   it was when the open transaction began, the parent of its children
+   again, where new, the directory with the same path in the live tree
+   (or NULL if there is none), replaced it (see FT_unshare) */
+static void FT_restoreParents(Dir_T old, Dir_T new) {
+   Dir_T child;
+   const char *name;
+   size_t i;
+
+   if (old == new || old == NULL)
+      return;
+
+   Dir_adopt(old);
+
+   for (i = 0; i < Dir_getNumChildren(old, DIR); i++) {
+      child = Dir_getChild(old, i, DIR);
+      name = Dir_getName(child);
+      FT_restoreParents(child, new == NULL ? NULL :
+                        Dir_findChild(new, name, strlen(name), DIR));
+   }
+}
+
+/* Returns the tree, the path index and count to the state they were
+   in when the open transaction began, and closes it */
+static void FT_rollBack(void) {
+   Dir_T current = root;
+
+   assert(transaction != NULL);
+
+   FT_restoreParents(transaction->root, current);
+
+   /* the tree takes over the transaction's reference to its root */
+   root = transaction->root;
+   memset(counts, 0, sizeof(counts));
+   counts[0].count = transaction->count;
+   free(transaction);
+   transaction = NULL;
+   numSnapshots--;
+
+   if (current != NULL)
+      (void) Dir_destroy(current);
+
+   if (heldIndex != NULL) {
+      pathIndex = heldIndex;
+      heldIndex = NULL;
+   }
+   lastDir = NULL;
+   Watch_release(FALSE);
+}
+
+/* Does FT_begin (see ft.h) without recording its metrics */
+static int FT_doBegin(void) {
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (!isInitialized || transaction != NULL || Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   transaction = FT_snapshot();
+   if (transaction == NULL)
+      return MEMORY_ERROR;
+
+   /* the index is searched as it was until the transaction ends */
+   heldIndex = pathIndex;
+   pathIndex = NULL;
+   lastDir = NULL;
+   Watch_hold();
+
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_begin(void) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doBegin();
+   Metrics_end(FT_OP_BEGIN, result, start);
+   return result;
+}
+
+/* Does FT_commit (see ft.h) without recording its metrics */
+static int FT_doCommit(void) {
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (!isInitialized || transaction == NULL)
+      return INITIALIZATION_ERROR;
+
+   if (heldIndex != NULL) {
+      pathIndex = heldIndex;
+      heldIndex = NULL;
+
+      if (FT_syncIndex(transaction->root, root) != SUCCESS) {
+         FT_rollBack();
+         assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+         return MEMORY_ERROR;
+      }
+   }
+
+   (void) FT_releaseSnapshot(transaction);
+   transaction = NULL;
+   lastDir = NULL;
+   Watch_release(TRUE);
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_commit(void) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doCommit();
+   Metrics_end(FT_OP_COMMIT, result, start);
+   return result;
+}
+
+/* Does FT_abort (see ft.h) without recording its metrics */
+static int FT_doAbort(void) {
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (!isInitialized || transaction == NULL)
+      return INITIALIZATION_ERROR;
+
+   FT_rollBack();
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_abort(void) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doAbort();
+   Metrics_end(FT_OP_ABORT, result, start);
+   return result;
+}
+
+/* Writes to stream the names of the children of the given type of
+   dir, preceded by their number. Returns FALSE if unable to write
+   them, and TRUE otherwise. */
+static boolean FT_exportNames(Dir_T dir, int type, FILE *stream) {
+   size_t n = Dir_getNumChildren(dir, type);
+   size_t i;
+
+   if (!Delta_putNumber(stream, (unsigned long)n))
+      return FALSE;
+
+   for (i = 0; i < n; i++) {
+      if (!Delta_putString(stream, type == DIR ?
+                           Dir_getName(Dir_getChild(dir, i, DIR)) :
+                           File_getName(Dir_getChild(dir, i, FILES))))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* Writes to stream the records of the changes made since version to
+   dir and the hierarchy below it (see FT_exportDelta), skipping the
+   directories below which nothing changed since then. Returns
+   MEMORY_ERROR if unable to write them or to unpack contents, and
+   SUCCESS otherwise. */
+static int FT_exportDir(Dir_T dir, unsigned long version, FILE *stream) {
+   File_T file;
+   Dir_T child;
+   void *contents;
+   size_t i;
+   int result;
+
+   /* the children it lost are those not named */
+   if (Dir_getVersion(dir) > version &&
+       (!Delta_putNumber(stream, DELTA_DIR) ||
+        !Delta_putString(stream, Dir_getPath(dir)) ||
+        !FT_exportNames(dir, FILES, stream) ||
+        !FT_exportNames(dir, DIR, stream)))
+      return MEMORY_ERROR;
+
+   for (i = 0; i < Dir_getNumChildren(dir, FILES); i++) {
+      file = Dir_getChild(dir, i, FILES);
+      if (File_getVersion(file) <= version)
+         continue;
+
+      if (!File_loadContents(file, &contents) ||
+          !Delta_putNumber(stream, DELTA_FILE) ||
+          !Delta_putString(stream, File_getPath(file)) ||
+          !Delta_putNumber(stream, File_getLength(file)) ||
+          !Delta_putNumber(stream, contents != NULL) ||
+          (contents != NULL &&
+           !Delta_putBytes(stream, contents, File_getLength(file))))
+         return MEMORY_ERROR;
+   }
+
+   for (i = 0; i < Dir_getNumChildren(dir, DIR); i++) {
+      child = Dir_getChild(dir, i, DIR);
+      if (Dir_getTreeVersion(child) <= version)
+         continue;
+
+      result = FT_exportDir(child, version, stream);
+      if (result != SUCCESS)
+         return result;
+   }
+
+   return SUCCESS;
+}
+
+/* Does FT_exportDelta (see ft.h) without recording its metrics */
+static int FT_doExportDelta(unsigned long version, FILE *stream,
+                            unsigned long *newVersion) {
+   int result = SUCCESS;
+
+   assert(stream != NULL);
+   assert(newVersion != NULL);
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   /* versions are not kept while readers and writers may overlap, and
+      an open transaction may still undo its changes */
+   if (!isInitialized || transaction != NULL || Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   if (!Delta_putNumber(stream, DELTA_MAGIC) ||
+       !Delta_putNumber(stream, DELTA_ROOT) ||
+       !Delta_putString(stream, root != NULL ? Dir_getPath(root) : ""))
+      return MEMORY_ERROR;
+
+   if (root != NULL && Dir_getTreeVersion(root) > version)
+      result = FT_exportDir(root, version, stream);
+
+   if (result == SUCCESS && !Delta_putNumber(stream, DELTA_END))
+      result = MEMORY_ERROR;
+
+   if (result == SUCCESS)
+      *newVersion = Dir_getLatestVersion();
+
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_exportDelta(unsigned long version, FILE *stream,
+                   unsigned long *newVersion) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doExportDelta(version, stream, newVersion);
+   Metrics_end(FT_OP_EXPORT_DELTA, result, start);
+   return result;
+}
+
+/* Removes the child of the given type of *pDir, a directory of the
+   live tree, at index childID, with the hierarchy below it, storing in
+   *pDir the copy that replaced it if a snapshot shared it (see
+   FT_unshare). Returns MEMORY_ERROR, leaving the tree unchanged, if
+   unable to allocate sufficient memory, and SUCCESS otherwise. */
+static int FT_removeChild(Dir_T *pDir, size_t childID, int type) {
+   Dir_T dir;
+   void *child;
+
+   dir = FT_unshare(*pDir);
+   if (dir == NULL)
+      return MEMORY_ERROR;
+   *pDir = dir;
+
+   child = Dir_getChild(dir, childID, type);
+   if (Dir_unlinkChild(dir, child, type) == MEMORY_ERROR)
+      return MEMORY_ERROR;
+
+   if (type == DIR) {
+      FT_unindexDir((Dir_T)child);
+      Watch_publish(Dir_getPath((Dir_T)child), FALSE, FT_REMOVED);
+      return FT_removeDirFrom((Dir_T)child);
+   }
+
+   if (pathIndex != NULL)
+      PathIndex_remove(pathIndex, File_getPath((File_T)child));
+   Watch_publish(File_getPath((File_T)child), TRUE, FT_REMOVED);
+   Epoch_retire(child, FT_releaseFile);
+   FT_subCount(1);
+
+   return SUCCESS;
+}
+
+/* Reads from stream the number and names of the children of the given
+   type that the directory with *pDir's path has in the exporting tree,
+   in order by name, and removes from *pDir, a directory of the live
+   tree, those it has that are not named, as FT_removeChild does.
+   Returns as FT_applyDelta does. */
+static int FT_applyNames(Dir_T *pDir, int type, FILE *stream) {
+   unsigned long n;
+   char *name;
+   size_t childID = 0;
+   const char *childName;
+   int cmp;
+   int result = SUCCESS;
+
+   if (!Delta_getNumber(stream, &n))
+      return CONFLICTING_PATH;
+
+   /* merges the names with the children, which are in the same order */
+   for (; n > 0 && result == SUCCESS; n--) {
+      result = Delta_getString(stream, &name);
+      if (result != SUCCESS)
+         return result;
+
+      while (childID < Dir_getNumChildren(*pDir, type)) {
+         childName = type == DIR ?
+            Dir_getName(Dir_getChild(*pDir, childID, DIR)) :
+            File_getName(Dir_getChild(*pDir, childID, FILES));
+         cmp = FT_compareNames(childName, name);
+
+         if (cmp > 0)
+            break;
+
+         if (cmp == EQUAL) {
+            childID++;
+            break;
+         }
+
+         result = FT_removeChild(pDir, childID, type);
+         if (result != SUCCESS)
+            break;
+      }
+
+      free(name);
+   }
+
+   /* those after the last one named */
+   while (result == SUCCESS && childID < Dir_getNumChildren(*pDir, type))
+      result = FT_removeChild(pDir, childID, type);
+
+   return result;
+}
+
+/* Applies the DELTA_ROOT record read from stream (see FT_applyDelta) */
+static int FT_applyRoot(FILE *stream) {
+   char *path;
+   int result;
+
+   result = Delta_getString(stream, &path);
+   if (result != SUCCESS)
+      return result;
+
+   /* a root with another path goes, with everything below it */
+   if (root != NULL && strcmp(Dir_getPath(root), path) != EQUAL) {
+      FT_unindexDir(root);
+      Watch_publish(Dir_getPath(root), FALSE, FT_REMOVED);
+      (void) FT_removeDirFrom(root);
+   }
+
+   if (root == NULL && *path != '\0')
+      result = FT_doInsertDir(path);
+
+   free(path);
+   return result;
+}
+
+/* Applies the DELTA_DIR record read from stream (see FT_applyDelta) */
+static int FT_applyDir(FILE *stream) {
+   char *path;
+   Dir_T dir;
+   int result;
+
+   result = Delta_getString(stream, &path);
+   if (result != SUCCESS)
+      return result;
+
+   /* path may already exist as a file, if the trees differ */
+   result = FT_doInsertDir(path);
+   dir = FT_getDir(path);
+   if (result == ALREADY_IN_TREE && dir != NULL)
+      result = SUCCESS;
+
+   if (result == SUCCESS)
+      result = FT_applyNames(&dir, FILES, stream);
+   if (result == SUCCESS)
+      result = FT_applyNames(&dir, DIR, stream);
+
+   free(path);
+   return result;
+}
+
+/* Applies the DELTA_FILE record read from stream (see FT_applyDelta) */
+static int FT_applyFile(FILE *stream) {
+   char *path;
+   char *contents = NULL;
+   unsigned long length;
+   unsigned long hasContents;
+   File_T file;
+   int result;
+
+   result = Delta_getString(stream, &path);
+   if (result != SUCCESS)
+      return result;
+
+   if (!Delta_getNumber(stream, &length) || length > (size_t)-1 ||
+       !Delta_getNumber(stream, &hasContents) || hasContents > 1)
+      result = CONFLICTING_PATH;
+   else if (hasContents)
+      result = Delta_getBytes(stream, (size_t)length, &contents);
+
+   if (result == SUCCESS) {
+      /* the content store keeps its own copy of contents */
+      file = FT_getFile(path);
+      if (file != NULL)
+         result = FT_replaceContentsOf(file, contents, (size_t)length,
+                                       NULL);
+      else
+         result = FT_doInsertFile(path, contents, (size_t)length);
+   }
+
+   free(contents);
+   free(path);
+   return result;
+}
+
+/* Applies the records of the delta read from stream, up to its
+   DELTA_END record, to the tree (see FT_applyDelta) */
+static int FT_applyRecords(FILE *stream) {
+   unsigned long kind;
+   int result = SUCCESS;
+
+   if (!Delta_getNumber(stream, &kind) || kind != DELTA_MAGIC)
+      return CONFLICTING_PATH;
+
+   while (result == SUCCESS) {
+      if (!Delta_getNumber(stream, &kind))
+         return CONFLICTING_PATH;
+
+      switch (kind) {
+      case DELTA_ROOT:
+         result = FT_applyRoot(stream);
+         break;
+      case DELTA_DIR:
+         result = FT_applyDir(stream);
+         break;
+      case DELTA_FILE:
+         result = FT_applyFile(stream);
+         break;
+      case DELTA_END:
+         return SUCCESS;
+      default:
+         return CONFLICTING_PATH;
+      }
+   }
+
+   /* the tree differs from the exporting one */
+   if (result != MEMORY_ERROR)
+      result = CONFLICTING_PATH;
+
+   return result;
+}
+
+/* Does FT_applyDelta (see ft.h) without recording its metrics */
+static int FT_doApplyDelta(FILE *stream) {
+   int result;
+
+   assert(stream != NULL);
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (!isInitialized || !ContentStore_isActive() ||
+       transaction != NULL || Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   result = FT_doBegin();
+   if (result != SUCCESS)
+      return result;
+
+   result = FT_applyRecords(stream);
+   if (result != SUCCESS) {
+      (void) FT_doAbort();
+      return result;
+   }
+
+   return FT_doCommit();
+}
+
+/* see ft.h for specification */
+int FT_applyDelta(FILE *stream) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doApplyDelta(stream);
+   Metrics_end(FT_OP_APPLY_DELTA, result, start);
+   return result;
+}
+
+/* Returns TRUE if path has no empty component, and FALSE otherwise */
+static boolean FT_isWellFormed(const char *path) {
+   const char *p;
+
+   if (path[0] == '\0' || path[0] == '/')
+      return FALSE;
+
+   for (p = path; *p != '\0'; p++) {
+      if (*p == '/' && (p[1] == '/' || p[1] == '\0'))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* Returns TRUE if path is below the directory whose path is the
+   length bytes at dirPath, and FALSE otherwise */
+static boolean FT_isBelow(const char *path, const char *dirPath,
+                          size_t length) {
+   return strncmp(path, dirPath, length) == EQUAL && path[length] == '/';
+}
+
+/* Checks the *pN entries of entries, sorted by PathSort_sort, in one
+   sweep, dropping each that repeats the path and type of the one
+   before it and storing the number left in *pN. Returns the status
+   of FT_buildFromPaths for the first conflict found, and SUCCESS if
+   there is none. */
+static int FT_checkPaths(const struct FT_PathEntry **entries,
+                         size_t *pN) {
+   const struct FT_PathEntry *last;
+   const char *path;
+   size_t rootLength;
+   size_t numKept = 0;
+   size_t i;
+
+   /* every path is below the first component of the first */
+   rootLength = strcspn(entries[0]->path, "/");
+
+   for (i = 0; i < *pN; i++) {
+      path = entries[i]->path;
+      if (!FT_isWellFormed(path) ||
+          strncmp(path, entries[0]->path, rootLength) != EQUAL ||
+          (path[rootLength] != '/' && path[rootLength] != '\0') ||
+          (entries[i]->type && path[rootLength] == '\0'))
+         return CONFLICTING_PATH;
+
+      if (numKept > 0) {
+         last = entries[numKept - 1];
+         if (strcmp(path, last->path) == EQUAL) {
+            if (entries[i]->type != last->type)
+               return ALREADY_IN_TREE;
+            continue;
+         }
+
+         /* the paths below a file come right after it */
+         if (last->type && FT_isBelow(path, last->path, strlen(last->path)))
+            return NOT_A_DIRECTORY;
+      }
+
+      entries[numKept++] = entries[i];
+   }
+
+   *pN = numKept;
+   return SUCCESS;
+}
+
+/* The state of FT_buildFromPaths: the n entries to build, sorted and
+   checked, of which the next one is the next to build, and the
+   children already built of the directories being built, each
+   directory's following those of the directories above it */
+struct build {
+   const struct FT_PathEntry **entries;
+   size_t n;
+   size_t next;
+   DynArray_T files;
+   DynArray_T dirs;
+};
+
+/* Removes the children of the given type from index first on from
+   children, destroying them if destroy is TRUE */
+static void FT_popChildren(DynArray_T children, size_t first, int type,
+                           boolean destroy) {
+   void *child;
+
+   while (DynArray_getLength(children) > first) {
+      child = DynArray_removeAt(children, DynArray_getLength(children) - 1);
+      if (destroy && type == DIR)
+         (void) Dir_destroy((Dir_T)child);
+      else if (destroy)
+         File_destroy((File_T)child);
+   }
+}
+
+/* Builds the children of dir, a new directory, and the hierarchies
+   below them, from the entries of build from the next one on that
+   are below dir, giving dir each array of children once it is
+   complete. Returns MEMORY_ERROR, having destroyed the children not
+   yet given to dir, if unable to allocate sufficient memory, and
+   SUCCESS otherwise. */
+static int FT_buildDir(Dir_T dir, struct build *build) {
+   const struct FT_PathEntry *entry;
+   const char *dirPath = Dir_getPath(dir);
+   const char *name;
+   size_t dirLength = strlen(dirPath);
+   size_t firstFile = DynArray_getLength(build->files);
+   size_t firstDir = DynArray_getLength(build->dirs);
+   size_t length;
+   File_T file;
+   Dir_T child;
+   int result = SUCCESS;
+
+   while (result == SUCCESS && build->next < build->n) {
+      entry = build->entries[build->next];
+      if (!FT_isBelow(entry->path, dirPath, dirLength))
+         break;
+
+      name = entry->path + dirLength + 1;
+      length = strcspn(name, "/");
+
+      if (entry->type && name[length] == '\0') {
+         build->next++;
+         file = File_create(dir, entry->path, entry->contents,
+                            entry->length);
+         if (file == NULL)
+            result = MEMORY_ERROR;
+         else if (!DynArray_add(build->files, file)) {
+            File_destroy(file);
+            result = MEMORY_ERROR;
+         }
+         continue;
+      }
+
+      /* a directory only named by the paths below it is built all
+         the same */
+      if (name[length] == '\0')
+         build->next++;
+
+      child = Dir_create(dir, name, length);
+      if (child == NULL) {
+         result = MEMORY_ERROR;
+         break;
+      }
+
+      result = FT_buildDir(child, build);
+      if (result == SUCCESS && !DynArray_add(build->dirs, child))
+         result = MEMORY_ERROR;
+      if (result != SUCCESS)
+         (void) Dir_destroy(child);
+   }
+
+   /* the children dir holds are destroyed with it */
+   if (result == SUCCESS) {
+      if (Dir_setChildren(dir, build->files, firstFile, FILES))
+         FT_popChildren(build->files, firstFile, FILES, FALSE);
+      else
+         result = MEMORY_ERROR;
+   }
+   if (result == SUCCESS) {
+      if (Dir_setChildren(dir, build->dirs, firstDir, DIR))
+         FT_popChildren(build->dirs, firstDir, DIR, FALSE);
+      else
+         result = MEMORY_ERROR;
+   }
+
+   FT_popChildren(build->files, firstFile, FILES, TRUE);
+   FT_popChildren(build->dirs, firstDir, DIR, TRUE);
+   return result;
+}
+
+/* Adds dir, and every directory and file below it, to the path index,
+   if it is enabled. Returns MEMORY_ERROR, leaving some of them in the
+   index, if unable to allocate sufficient memory, and SUCCESS
+   otherwise. */
+static int FT_indexTree(Dir_T dir) {
+   File_T file;
+   size_t i;
+
+   if (pathIndex == NULL)
+      return SUCCESS;
+
+   if (!PathIndex_put(pathIndex, Dir_getPath(dir), dir, DIR))
+      return MEMORY_ERROR;
+
+   for (i = 0; i < Dir_getNumChildren(dir, FILES); i++) {
+      file = Dir_getChild(dir, i, FILES);
+      if (!PathIndex_put(pathIndex, File_getPath(file), file, FILES))
+         return MEMORY_ERROR;
+   }
+
+   for (i = 0; i < Dir_getNumChildren(dir, DIR); i++) {
+      if (FT_indexTree(Dir_getChild(dir, i, DIR)) != SUCCESS)
+         return MEMORY_ERROR;
+   }
+
+   return SUCCESS;
+}
+
+/* Tells the watches that dir, and every directory and file below it,
+   was added. Returns their number. */
+static size_t FT_publishTree(Dir_T dir) {
+   size_t count = 1;
+   size_t i;
+
+   Watch_publish(Dir_getPath(dir), FALSE, FT_ADDED);
+
+   for (i = 0; i < Dir_getNumChildren(dir, FILES); i++)
+      Watch_publish(File_getPath(Dir_getChild(dir, i, FILES)), TRUE,
+                    FT_ADDED);
+   count += Dir_getNumChildren(dir, FILES);
+
+   for (i = 0; i < Dir_getNumChildren(dir, DIR); i++)
+      count += FT_publishTree(Dir_getChild(dir, i, DIR));
+
+   return count;
+}
+
+/* Does FT_buildFromPaths (see ft.h) without recording its metrics */
+static int FT_doBuildFromPaths(const struct FT_PathEntry *entries,
+                               size_t n, size_t numThreads) {
+   const struct FT_PathEntry **sorted;
+   struct build build;
+   Dir_T newRoot = NULL;
+   size_t rootLength;
+   size_t i;
+   int result;
+
+   assert(entries != NULL || n == 0);
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   /* the tree is built whole, before anyone else may see it */
+   if (!isInitialized || root != NULL || transaction != NULL ||
+       Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   if (n == 0)
+      return SUCCESS;
+
+   /* the entries are sorted by reference, leaving them as they are */
+   sorted = (const struct FT_PathEntry **)malloc(n * sizeof(*sorted));
+   if (sorted == NULL)
+      return MEMORY_ERROR;
+   for (i = 0; i < n; i++)
+      sorted[i] = &entries[i];
+
+   if (!PathSort_sort(sorted, n, numThreads)) {
+      free(sorted);
+      return MEMORY_ERROR;
+   }
+
+   result = FT_checkPaths(sorted, &n);
+   if (result != SUCCESS) {
+      free(sorted);
+      return result;
+   }
+
+   build.entries = sorted;
+   build.n = n;
+   build.files = DynArray_new(0);
+   build.dirs = DynArray_new(0);
+
+   /* the root may only be named by the paths below it */
+   rootLength = strcspn(sorted[0]->path, "/");
+   build.next = sorted[0]->path[rootLength] == '\0' ? 1 : 0;
+
+   result = MEMORY_ERROR;
+   if (build.files != NULL && build.dirs != NULL)
+      newRoot = Dir_create(NULL, sorted[0]->path, rootLength);
+   if (newRoot != NULL)
+      result = FT_buildDir(newRoot, &build);
+   assert(result != SUCCESS || build.next == n);
+
+   if (build.files != NULL)
+      DynArray_free(build.files);
+   if (build.dirs != NULL)
+      DynArray_free(build.dirs);
+   free(sorted);
+
+   if (result == SUCCESS && FT_indexTree(newRoot) != SUCCESS) {
+      FT_unindexDir(newRoot);
+      result = MEMORY_ERROR;
+   }
+
+   if (result != SUCCESS) {
+      if (newRoot != NULL)
+         (void) Dir_destroy(newRoot);
+      return result;
+   }
+
+   Epoch_publish(root, newRoot);
+   FT_addCount(FT_publishTree(newRoot));
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_buildFromPaths(const struct FT_PathEntry *entries, size_t n,
+                      size_t numThreads) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doBuildFromPaths(entries, n, numThreads);
+   Metrics_end(FT_OP_BUILD_FROM_PATHS, result, start);
+   return result;
+}
+
+/* Does FT_watch (see ft.h) without recording its metrics */
+static struct FT_Watch *FT_doWatch(const char *prefix,
+                                   FT_WatchCallback callback,
+                                   void *ctx) {
+
+   assert(prefix != NULL);
+   assert(callback != NULL);
+
+   if (!isInitialized)
+      return NULL;
+
+   return Watch_add(prefix, callback, ctx);
+}
+
+/* see ft.h for specification */
+struct FT_Watch *FT_watch(const char *prefix, FT_WatchCallback callback,
+                          void *ctx) {
+   struct FT_Watch *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doWatch(prefix, callback, ctx);
+   Metrics_end(FT_OP_WATCH, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_unwatch (see ft.h) without recording its metrics */
+static int FT_doUnwatch(struct FT_Watch *watch) {
+
+   assert(watch != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   Watch_remove(watch);
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_unwatch(struct FT_Watch *watch) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doUnwatch(watch);
+   Metrics_end(FT_OP_UNWATCH, result, start);
+   return result;
+}
+
+/* Does FT_flushWatches (see ft.h) without recording its metrics */
+static int FT_doFlushWatches(void) {
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   Watch_flush();
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_flushWatches(void) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doFlushWatches();
+   Metrics_end(FT_OP_FLUSH_WATCHES, result, start);
+   return result;
+}
+
+/* Does FT_createRing (see ft.h) without recording its metrics */
+static struct FT_Ring *FT_doCreateRing(size_t capacity) {
+   struct FT_Ring *ring;
+
+   if (!isInitialized || capacity == 0)
+      return NULL;
+
+   ring = Ring_new(capacity);
+   if (ring != NULL)
+      numRings++;
+
+   return ring;
+}
+
+/* see ft.h for specification */
+struct FT_Ring *FT_createRing(size_t capacity) {
+   struct FT_Ring *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doCreateRing(capacity);
+   Metrics_end(FT_OP_CREATE_RING, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_submit (see ft.h) without recording its metrics */
+static size_t FT_doSubmit(struct FT_Ring *ring,
+                          const struct FT_Submission *submissions,
+                          size_t numSubmissions) {
+
+   assert(ring != NULL);
+   assert(submissions != NULL || numSubmissions == 0);
+
+   return Ring_submit(ring, submissions, numSubmissions);
+}
+
+/* see ft.h for specification */
+size_t FT_submit(struct FT_Ring *ring,
+                 const struct FT_Submission *submissions,
+                 size_t numSubmissions) {
+   size_t result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doSubmit(ring, submissions, numSubmissions);
+   Metrics_end(FT_OP_SUBMIT, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_reap (see ft.h) without recording its metrics */
+static size_t FT_doReap(struct FT_Ring *ring,
+                        struct FT_Completion *completions, size_t max,
+                        boolean wait) {
+
+   assert(ring != NULL);
+   assert(completions != NULL || max == 0);
+
+   return Ring_reap(ring, completions, max, wait);
+}
+
+/* see ft.h for specification */
+size_t FT_reap(struct FT_Ring *ring, struct FT_Completion *completions,
+               size_t max, boolean wait) {
+   size_t result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doReap(ring, completions, max, wait);
+   Metrics_end(FT_OP_REAP, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_destroyRing (see ft.h) without recording its metrics */
+static int FT_doDestroyRing(struct FT_Ring *ring) {
+
+   assert(ring != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   Ring_free(ring);
+   numRings--;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_destroyRing(struct FT_Ring *ring) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doDestroyRing(ring);
+   Metrics_end(FT_OP_DESTROY_RING, result, start);
+   return result;
+}
+
+/* Adds to image the records of dir and of the hierarchy below it,
+   storing the offset of dir's in *pRecord. Returns MEMORY_ERROR if
+   unable to allocate sufficient memory or to unpack contents, and
+   SUCCESS otherwise. */
+static int FT_imageDir(Image_T image, Dir_T dir, unsigned long *pRecord) {
+   size_t numFiles = Dir_getNumChildren(dir, FILES);
+   size_t numDirs = Dir_getNumChildren(dir, DIR);
+   unsigned long record;
+   unsigned long child;
+   File_T file;
+   void *contents;
+   size_t i;
+   int result;
+
+   record = Image_addDir(image, Dir_getPath(dir), numFiles, numDirs);
+   if (record == 0)
+      return MEMORY_ERROR;
+
+   for (i = 0; i < numFiles; i++) {
+      file = Dir_getChild(dir, i, FILES);
+      if (!File_loadContents(file, &contents))
+         return MEMORY_ERROR;
+
+      child = Image_addFile(image, File_getPath(file), contents,
+                            File_getLength(file));
+      if (child == 0)
+         return MEMORY_ERROR;
+      Image_setChild(image, record, i, child);
+   }
+
+   for (i = 0; i < numDirs; i++) {
+      result = FT_imageDir(image, Dir_getChild(dir, i, DIR), &child);
+      if (result != SUCCESS)
+         return result;
+      Image_setChild(image, record, numFiles + i, child);
+   }
+
+   *pRecord = record;
+   return SUCCESS;
+}
+
+/* Does FT_publishImage (see ft.h) without recording its metrics */
+static int FT_doPublishImage(const char *filename) {
+   Image_T image;
+   unsigned long record;
+   int result = SUCCESS;
+
+   assert(filename != NULL);
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   /* the tree must not change while it is copied, and an open
+      transaction may still undo its changes */
+   if (!isInitialized || transaction != NULL || Epoch_isActive())
+      return INITIALIZATION_ERROR;
+
+   image = Image_new();
+   if (image == NULL)
+      return MEMORY_ERROR;
+
+   if (root != NULL) {
+      result = FT_imageDir(image, root, &record);
+      if (result == SUCCESS)
+         Image_setRoot(image, record);
+   }
+
+   if (result == SUCCESS)
+      result = Image_publish(image, filename);
+
+   Image_free(image);
+   return result;
+}
+
+/* see ft.h for specification */
+int FT_publishImage(const char *filename) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doPublishImage(filename);
+   Metrics_end(FT_OP_PUBLISH_IMAGE, result, start);
+   return result;
+}
+
+/* Does FT_openImage (see ft.h) without recording its metrics */
+static struct FT_Image *FT_doOpenImage(const char *filename) {
+
+   assert(filename != NULL);
+
+   return Image_open(filename);
+}
+
+/* see ft.h for specification */
+struct FT_Image *FT_openImage(const char *filename) {
+   struct FT_Image *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doOpenImage(filename);
+   Metrics_end(FT_OP_OPEN_IMAGE, METRICS_NO_STATUS, start);
+   return result;
+}
+
+/* Does FT_imageStat (see ft.h) without recording its metrics */
+static int FT_doImageStat(struct FT_Image *image, char *path,
+                          boolean *type, size_t *length) {
+
+   assert(image != NULL);
+   assert(path != NULL);
+   assert(type != NULL);
+   assert(length != NULL);
+
+   return Image_lookUp(image, path, type, length, NULL, 0);
+}
+
+/* see ft.h for specification */
+int FT_imageStat(struct FT_Image *image, char *path, boolean *type,
+                 size_t *length) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doImageStat(image, path, type, length);
+   Metrics_end(FT_OP_IMAGE_STAT, result, start);
+   return result;
+}
+
+/* Does FT_imageReadFile (see ft.h) without recording its metrics */
+static int FT_doImageReadFile(struct FT_Image *image, char *path,
+                              void *buffer, size_t size,
+                              size_t *length) {
+   boolean type;
+   size_t fileLength;
+   int result;
+
+   assert(image != NULL);
+   assert(path != NULL);
+   assert(buffer != NULL || size == 0);
+   assert(length != NULL);
+
+   result = Image_lookUp(image, path, &type, &fileLength, buffer, size);
+   if (result != SUCCESS)
+      return result;
+   if (!type)
+      return NOT_A_FILE;
+
+   *length = fileLength;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_imageReadFile(struct FT_Image *image, char *path, void *buffer,
+                     size_t size, size_t *length) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doImageReadFile(image, path, buffer, size, length);
+   Metrics_end(FT_OP_IMAGE_READ_FILE, result, start);
+   return result;
+}
+
+/* Does FT_closeImage (see ft.h) without recording its metrics */
+static void FT_doCloseImage(struct FT_Image *image) {
+
+   assert(image != NULL);
+
+   Image_close(image);
+}
+
+/* see ft.h for specification */
+void FT_closeImage(struct FT_Image *image) {
+   unsigned long start = Metrics_start();
+
+   FT_doCloseImage(image);
+   Metrics_end(FT_OP_CLOSE_IMAGE, METRICS_NO_STATUS, start);
+}
+
+/* see ft.h for specification */
+int FT_useContentStore(boolean enable) {
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   useContentStore = enable;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_getContentStats(struct FT_ContentStats *stats) {
+
+   assert(stats != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   ContentStore_getStats(&stats->numBlobs, &stats->numRefs,
+                         &stats->storedBytes, &stats->logicalBytes);
+
+   if (stats->storedBytes == 0)
+      stats->dedupRatio = 1.0;
+   else
+      stats->dedupRatio = (double)stats->logicalBytes /
+         (double)stats->storedBytes;
+
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_useCompression(size_t threshold) {
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   compressionThreshold = threshold;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_getCompressionStats(struct FT_CompressionStats *stats) {
+
+   assert(stats != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   Compressor_getStats(&stats->numPacked, &stats->packedBytes,
+                       &stats->logicalBytes, &stats->numHits,
+                       &stats->numMisses);
+   stats->savedBytes = stats->logicalBytes - stats->packedBytes;
+
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_usePathIndex(boolean enable) {
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   usePathIndex = enable;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_getInternStats(struct FT_InternStats *stats) {
+
+   assert(stats != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   Intern_getStats(&stats->numLookups, &stats->numHits,
+                   &stats->numNames, &stats->storedBytes,
+                   &stats->tableBytes);
+
+   if (stats->numLookups == 0)
+      stats->hitRate = 0.0;
+   else
+      stats->hitRate = (double)stats->numHits /
+         (double)stats->numLookups;
+
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_memoryStats(struct FT_MemoryStats *stats) {
+
+   size_t dirNodeBytes, dirPathBytes;
+   size_t fileNodeBytes, filePathBytes;
+   size_t dynBytes, dynUsedBytes;
+   size_t unused;
+
+   assert(stats != NULL);
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   Dir_getMemoryStats(&stats->numDirs, &dirNodeBytes, &dirPathBytes,
+                      &stats->arrayBytes, &stats->arrayUsedBytes);
+   File_getMemoryStats(&stats->numFiles, &fileNodeBytes,
+                       &filePathBytes, &stats->contentBytes);
+   Intern_getStats(&unused, &unused, &unused, &unused,
+                   &stats->nameBytes);
+
+   /* arrays of the DynArray module, such as those of traversals */
+   DynArray_getMemoryUsage(&dynBytes, &dynUsedBytes);
+
+   stats->nodeBytes = dirNodeBytes + fileNodeBytes;
+   stats->pathBytes = dirPathBytes + filePathBytes;
+   stats->arrayBytes += dynBytes;
+   stats->arrayUsedBytes += dynUsedBytes;
+
+   /* packed contents live in the store when it is active, and the
+      compressor copies the others otherwise */
+   if (ContentStore_isActive())
+      ContentStore_getStats(&unused, &unused,
+                            &stats->storedContentBytes, &unused);
+   else {
+      Compressor_getStats(&unused, &stats->storedContentBytes,
+                          &unused, &unused, &unused);
+      stats->storedContentBytes += Compressor_getCopiedBytes();
+   }
+
+   stats->indexBytes = PathIndex_getBytes();
+   stats->tableBytes = ContentStore_getTableBytes();
+   stats->cacheBytes = Compressor_getCacheBytes();
+
+   stats->totalBytes = stats->nodeBytes + stats->pathBytes +
+      stats->nameBytes + stats->arrayBytes + stats->storedContentBytes +
+      stats->indexBytes + stats->tableBytes + stats->cacheBytes;
+
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_useConcurrentReads(boolean enable) {
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   useConcurrentReads = enable;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_useConcurrentWrites(boolean enable) {
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   useConcurrentWrites = enable;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_useShards(size_t numShardsToUse, size_t depth) {
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   numShards = numShardsToUse;
+   shardDepth = depth < 2 ? 2 : depth;
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_getMetrics(struct FT_Metrics *metrics) {
+
+   assert(metrics != NULL);
+
+   Metrics_get(metrics);
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_resetMetrics(void) {
+
+   Metrics_reset();
+   return SUCCESS;
+}
+
+/* Does FT_init (see ft.h) without recording its metrics */
+static int FT_doInit(void) {
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (isInitialized)
+      return INITIALIZATION_ERROR;
+
+   isInitialized = 1;
+   root = NULL;
+   memset(counts, 0, sizeof(counts));
+
+   /* readers share nothing but the tree and what Epoch protects, and
+      writers also share what Lock protects */
+   Epoch_init(useConcurrentReads || useConcurrentWrites);
+   Lock_setActive(useConcurrentWrites && Epoch_isActive());
+   Shard_init(Lock_isActive ? numShards : 0, shardDepth);
+   Metrics_setShared(Epoch_isActive());
+   ContentStore_init(useContentStore && !Epoch_isActive());
+   Compressor_init(Epoch_isActive() ? 0 : compressionThreshold);
+
+   /* without an index, lookups simply traverse the tree */
+   pathIndex = NULL;
+   if (usePathIndex && !Epoch_isActive())
+      pathIndex = PathIndex_new();
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_init(void) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doInit();
+   Metrics_end(FT_OP_INIT, result, start);
+   return result;
+}
+
+/* Does FT_destroy (see ft.h) without recording its metrics */
+static int FT_doDestroy(void) {
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (!isInitialized)
+      return INITIALIZATION_ERROR;
+
+   if (transaction != NULL)
+      FT_rollBack();
+   assert(numSnapshots == 0);
+   assert(numRings == 0);
+
+   FT_removeDirFrom(root);
+   Watch_destroy();
+   Shard_destroy();
+   Epoch_destroy();
+   Lock_setActive(FALSE);
+   Metrics_setShared(FALSE);
+   if (pathIndex != NULL) {
+      PathIndex_free(pathIndex);
+      pathIndex = NULL;
+   }
+   ContentStore_destroy();
+   Compressor_destroy();
+   Intern_destroy();
+
+   isInitialized = 0;
+
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+   return SUCCESS;
+}
+
+/* see ft.h for specification */
+int FT_destroy(void) {
+   int result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doDestroy();
+   Metrics_end(FT_OP_DESTROY, result, start);
+   return result;
+}
+ 
+/* Does FT_toString (see ft.h) without recording its metrics */
+static char *FT_doToString(void) {
+   assert(CheckerFT_isValid(isInitialized, root, FT_getCount()));
+
+   if (!isInitialized)
+      return NULL;
+
+   return Traverser_toString(root, FT_getCount());
+}
+
+/* see ft.h for specification */
+char *FT_toString(void) {
+   char *result;
+   unsigned long start = Metrics_start();
+
+   result = FT_doToString();
+   Metrics_end(FT_OP_TO_STRING, METRICS_NO_STATUS, start);
+   return result;
 }
@@ -13,8 +13,24 @@
 */
 
 #include <stddef.h>
+#include <stdio.h>
 #include "a4def.h"
 
+/*
+  An FT_DirEntry describes one child of a directory as reported by
+  FT_listDir: name is the last component of the child's path,
+  type is FALSE for a directory and TRUE for a file (as in FT_stat),
+  and length is the length of a file's contents (0 for directories).
+
+  name points into the tree's own storage, so it is only valid until
+  the next operation that modifies the tree.
+*/
+struct FT_DirEntry {
+   const char *name;
+   boolean type;
+   size_t length;
+};
+
 /*
    Inserts a new directory into the tree at path, if possible.
    Returns SUCCESS if the new directory is inserted.
@@ -39,6 +55,8 @@ boolean FT_containsDir(char *path);
   Returns INITIALIZATION_ERROR if not in an initialized state.
   Returns NOT_A_DIRECTORY if path exists but is a file not a directory.
   Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
+  Returns MEMORY_ERROR if unable to allocate sufficient memory, which
+  only happens with concurrent reads (see FT_useConcurrentReads).
 */
 int FT_rmDir(char *path);
 
@@ -68,6 +86,8 @@ boolean FT_containsFile(char *path);
   Returns INITIALIZATION_ERROR if not in an initialized state.
   Returns NOT_A_FILE if path exists but is a directory not a file.
   Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
+  Returns MEMORY_ERROR if unable to allocate sufficient memory, which
+  only happens with concurrent reads (see FT_useConcurrentReads).
 */
 int FT_rmFile(char *path);
 
@@ -103,6 +123,812 @@ void *FT_replaceFileContents(char *path, void *newContents,
  */
 int FT_stat(char *path, boolean *type, size_t *length);
 
+/*
+  Lists the children (files and directories alike) of the directory
+  at path in lexicographic order by name, starting with the first
+  child whose name is greater than startAfter, or with the first child
+  if startAfter is NULL. At most max entries are stored in out, and
+  *numEntries is set to the number of entries stored.
+
+  To page through a large directory, pass the name of the last entry
+  of the previous page as startAfter.
+
+  Returns SUCCESS if path exists as a directory.
+  Returns INITIALIZATION_ERROR if not in an initialized state.
+  Returns NOT_A_DIRECTORY if path exists but is a file.
+  Returns NO_SUCH_PATH if the path does not exist in the hierarchy.
+
+  When returning a non-SUCCESS status, out and *numEntries are
+  unchanged.
+*/
+int FT_listDir(char *path, const char *startAfter, size_t max,
+               struct FT_DirEntry *out, size_t *numEntries);
+
+/*
+  Stores in *hash the hash of path: for a file, the hash of its
+  contents and length; for a directory, the Merkle hash of the
+  hierarchy below it, which combines the names and hashes of its
+  children but not its own name, so that two trees whose hierarchies
+  below path are equal give equal hashes there, and otherwise almost
+  surely differ. Comparing hashes, and those of children only where
+  they differ, thus finds the changes between two trees.
+
+  A change marks the hashes of the directories above it out of date,
+  up to the first one already marked, and each hash is computed again
+  only when next asked for, so that asking costs as much as the
+  changes made since the last time.
+
+  Returns INITIALIZATION_ERROR if not in an initialized state or if
+  concurrent reads or writes are enabled (see FT_useConcurrentReads),
+  NO_SUCH_PATH if path does not exist in the hierarchy, MEMORY_ERROR,
+  leaving *hash unchanged, if unable to allocate sufficient memory to
+  unpack compressed contents (see FT_useCompression), and SUCCESS
+  otherwise.
+*/
+int FT_getHash(char *path, unsigned long *hash);
+
+/*
+  An FT_ContentStats reports how much the content store saves:
+  numBlobs distinct contents are referenced numRefs times by files,
+  storedBytes is the memory held by the distinct contents,
+  logicalBytes is the memory the files would hold with one copy each,
+  and dedupRatio is logicalBytes / storedBytes (1.0 if nothing is
+  stored).
+*/
+struct FT_ContentStats {
+   size_t numBlobs;
+   size_t numRefs;
+   size_t storedBytes;
+   size_t logicalBytes;
+   double dedupRatio;
+};
+
+/*
+  Selects whether the next FT_init enables the content store.
+
+  With the content store enabled, FT_insertFile and
+  FT_replaceFileContents store a single shared copy of each distinct
+  contents instead of keeping the client's pointer, so
+  FT_getFileContents returns that shared copy, which the client must
+  not modify or free. The old contents returned by
+  FT_replaceFileContents remain valid until the next call that
+  modifies the tree. FT_insertFile returns MEMORY_ERROR and
+  FT_replaceFileContents returns NULL if the copy cannot be stored.
+
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_useContentStore(boolean enable);
+
+/*
+  Fills *stats with the content store's statistics (all zero if the
+  store is not enabled).
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_getContentStats(struct FT_ContentStats *stats);
+
+/*
+  An FT_CompressionStats reports how much compression saves:
+  numPacked file contents are held packed in packedBytes instead of
+  logicalBytes (savedBytes is the difference), and numHits and
+  numMisses count the reads of packed contents that were and were not
+  served from the cache of recently read contents.
+*/
+struct FT_CompressionStats {
+   size_t numPacked;
+   size_t packedBytes;
+   size_t logicalBytes;
+   size_t savedBytes;
+   size_t numHits;
+   size_t numMisses;
+};
+
+/*
+  Selects whether the next FT_init enables compression of contents:
+  contents of at least threshold bytes are packed (a threshold of 0
+  disables compression).
+
+  With compression enabled, FT_insertFile and FT_replaceFileContents
+  keep their own copy of the contents of every file, packed when
+  packing saves space, so that the client may free or reuse its
+  buffer as soon as they return. FT_getFileContents then returns the
+  tree's copy (unpacked, if packed), which the client must not modify
+  or free, and which stays valid only until a few other packed files
+  are read or the file is changed. FT_stat still reports
+  the unpacked length. The old contents returned by
+  FT_replaceFileContents remain valid until the next call that
+  modifies the tree. FT_insertFile returns MEMORY_ERROR and
+  FT_replaceFileContents returns NULL if the copy cannot be stored,
+  and FT_getFileContents returns NULL if unable to allocate the
+  unpacked copy.
+
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_useCompression(size_t threshold);
+
+/*
+  Fills *stats with the compression statistics (all zero if
+  compression is not enabled).
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_getCompressionStats(struct FT_CompressionStats *stats);
+
+/*
+  Selects whether the next FT_init enables the path index.
+
+  With the path index enabled, every directory and file is also kept
+  in an adaptive radix trie keyed by its full path, so lookups of a
+  path cost time proportional to the length of the path instead of
+  traversing the hierarchy. Mutations keep the index up to date, and
+  return MEMORY_ERROR if unable to allocate the index entries. If the
+  index itself cannot be allocated, FT_init proceeds without it.
+
+  The index is kept in addition to the hierarchy, not instead of it,
+  so it costs memory rather than saving it. Its leaves are the
+  directories and files themselves, keyed by the paths they already
+  store, so only its inner nodes are allocated: about 30 bytes per
+  directory and file where pointers have 64 bits, or roughly a tenth
+  more than the tree takes without it. FT_memoryStats reports it as
+  indexBytes.
+
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_usePathIndex(boolean enable);
+
+/*
+  An FT_InternStats reports on the table in which directory and file
+  names are interned, so that equal names are recognized by comparing
+  pointers: it keeps numNames distinct names, of storedBytes, in
+  tableBytes in all, counting its entries and buckets. Every directory
+  and file still keeps its own full path, so tableBytes is memory the
+  table adds to the tree, not memory it saves. Of numLookups name
+  lookups, numHits (a fraction hitRate) found the name already
+  interned.
+*/
+struct FT_InternStats {
+   size_t numLookups;
+   size_t numHits;
+   size_t numNames;
+   size_t storedBytes;
+   size_t tableBytes;
+   double hitRate;
+};
+
+/*
+  Fills *stats with the statistics of the name intern table since
+  FT_init.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_getInternStats(struct FT_InternStats *stats);
+
+/*
+  An FT_MemoryStats reports where the memory of the tree goes:
+  numDirs directories and numFiles files take nodeBytes for their
+  structures, pathBytes for their paths, and nameBytes for the table
+  of their interned names (tableBytes of FT_InternStats). Their lists
+  of children take arrayBytes, of which arrayUsedBytes hold children
+  (the rest is spare capacity). contentBytes is the sum of the lengths
+  of the file contents, of which the tree itself holds
+  storedContentBytes (all of them if the content store or compression
+  is enabled, since the tree then keeps its own copies; none
+  otherwise, since they are the client's). The path index takes
+  indexBytes (see FT_usePathIndex), the content store's table takes
+  tableBytes beyond the contents it shares, and the unpacked copies of
+  recently read packed contents take cacheBytes. totalBytes is the sum
+  of all the bytes the tree holds, as requested from malloc (the
+  allocator's own overhead per block is not counted).
+*/
+struct FT_MemoryStats {
+   size_t numDirs;
+   size_t numFiles;
+   size_t nodeBytes;
+   size_t pathBytes;
+   size_t nameBytes;
+   size_t arrayBytes;
+   size_t arrayUsedBytes;
+   size_t contentBytes;
+   size_t storedContentBytes;
+   size_t indexBytes;
+   size_t tableBytes;
+   size_t cacheBytes;
+   size_t totalBytes;
+};
+
+/*
+  Fills *stats with the current memory usage of the tree. The counts
+  are maintained as the tree changes, so this takes constant time.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_memoryStats(struct FT_MemoryStats *stats);
+
+/* the operations whose calls FT_getMetrics reports */
+enum FT_Operation {
+   FT_OP_INSERT_DIR, FT_OP_CONTAINS_DIR, FT_OP_RM_DIR,
+   FT_OP_INSERT_FILE, FT_OP_CONTAINS_FILE, FT_OP_RM_FILE,
+   FT_OP_GET_FILE_CONTENTS, FT_OP_REPLACE_FILE_CONTENTS, FT_OP_STAT,
+   FT_OP_LIST_DIR, FT_OP_INIT, FT_OP_DESTROY, FT_OP_TO_STRING,
+   FT_OP_SNAPSHOT, FT_OP_RELEASE_SNAPSHOT, FT_OP_SNAPSHOT_STAT,
+   FT_OP_SNAPSHOT_GET_FILE_CONTENTS, FT_OP_SNAPSHOT_LIST_DIR,
+   FT_OP_SNAPSHOT_TO_STRING, FT_OP_BEGIN, FT_OP_COMMIT, FT_OP_ABORT,
+   FT_OP_DIFF, FT_OP_GET_HASH, FT_OP_EXPORT_DELTA, FT_OP_APPLY_DELTA,
+   FT_OP_PUBLISH_IMAGE, FT_OP_BUILD_FROM_PATHS,
+   FT_OP_WATCH, FT_OP_UNWATCH, FT_OP_FLUSH_WATCHES,
+   FT_OP_CREATE_RING, FT_OP_SUBMIT, FT_OP_REAP, FT_OP_DESTROY_RING,
+   FT_OP_OPEN_IMAGE, FT_OP_IMAGE_STAT, FT_OP_IMAGE_READ_FILE,
+   FT_OP_CLOSE_IMAGE,
+   FT_NUM_OPERATIONS
+};
+
+enum {
+   FT_NUM_STATUSES = MEMORY_ERROR + 1, FT_NUM_LATENCY_BUCKETS = 32
+};
+
+/*
+  An FT_OpMetrics reports the numCalls calls to one operation:
+  numByStatus[s] of them returned status s (operations that return a
+  boolean, a count or a pointer are not broken down), latency[i] of
+  them took from 2^i to 2^(i+1) - 1 nanoseconds (the last bucket also
+  holds slower calls, the first also holds faster ones), and all of
+  them took totalNanos nanoseconds.
+*/
+struct FT_OpMetrics {
+   size_t numCalls;
+   size_t numByStatus[FT_NUM_STATUSES];
+   size_t latency[FT_NUM_LATENCY_BUCKETS];
+   unsigned long totalNanos;
+};
+
+/*
+  An FT_Metrics reports, indexed by enum FT_Operation, the calls to
+  each operation, and counts the directories visited while traversing
+  paths (nodesVisited), the comparisons made while searching for
+  children (comparisons), and the allocations of directories, files,
+  and their lists of children (allocations). enabled is FALSE if the
+  metrics were compiled out (see FT_getMetrics).
+*/
+struct FT_Metrics {
+   struct FT_OpMetrics ops[FT_NUM_OPERATIONS];
+   size_t nodesVisited;
+   size_t comparisons;
+   size_t allocations;
+   boolean enabled;
+};
+
+/*
+  Fills *metrics with the metrics recorded since the program started
+  or since the last FT_resetMetrics, across any number of FT_init and
+  FT_destroy calls. If the module was compiled with FT_NO_METRICS
+  defined, nothing is recorded and *metrics is all zero.
+  Returns SUCCESS.
+*/
+int FT_getMetrics(struct FT_Metrics *metrics);
+
+/*
+  Discards the metrics recorded so far.
+  Returns SUCCESS.
+*/
+int FT_resetMetrics(void);
+
+/*
+  Selects whether the next FT_init enables concurrent reads.
+
+  With concurrent reads enabled, any number of threads may call
+  FT_containsDir, FT_containsFile, FT_getFileContents and FT_stat at
+  once, without locks, while one other thread at a time calls
+  FT_insertDir, FT_insertFile, FT_rmDir, FT_rmFile and
+  FT_replaceFileContents: the client must keep the writers from
+  overlapping one another (unless concurrent writes are enabled, see
+  FT_useConcurrentWrites), but not the readers. A writer publishes
+  new versions of the lists of children it changes, so readers never
+  see a list being changed or wait for a writer, and the memory it
+  removes from the tree is freed once no reader can still reach it.
+  The other operations must not overlap any call.
+
+  Lists of children are then copied rather than changed in place, so
+  that FT_rmDir and FT_rmFile may also return MEMORY_ERROR, and FT_init
+  enables neither the content store, compression, nor the path index.
+  Each thread records its metrics in one of a few shards, which
+  FT_getMetrics adds up. Concurrent reads need GCC's atomic builtins;
+  compiled without them, FT_init leaves them disabled.
+
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_useConcurrentReads(boolean enable);
+
+/*
+  Selects whether the next FT_init enables concurrent writes, which
+  imply concurrent reads (see FT_useConcurrentReads).
+
+  With concurrent writes enabled, any number of threads may also call
+  FT_insertDir, FT_insertFile, FT_rmDir, FT_rmFile and
+  FT_replaceFileContents at once. Every directory has a lock, and a
+  writer locks the directories on its path hand over hand, from the
+  root down to the ones it changes: the parent of a removed directory
+  or file, the directory new ones are linked to once built, or the
+  parent of a file whose contents are replaced. Writers on disjoint
+  subtrees therefore only wait for one another while passing through
+  their common ancestors. The count of directories and files is kept
+  in per-thread shards, and the other state that writers share is
+  locked only briefly. Concurrent writes need GCC's atomic builtins;
+  compiled without them, FT_init leaves them disabled.
+
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_useConcurrentWrites(boolean enable);
+
+/*
+  Selects how many shards the next FT_init splits the tree into for
+  concurrent writes (see FT_useConcurrentWrites), none if numShards is
+  0, as it is at first, and the depth of the directories at their tops
+  (the root's children's at 2, as at first; a depth below 2 is taken
+  as 2).
+
+  Without shards, every writer locks the root and each directory on
+  its way down, so that all of them pass through the same few locks.
+  With them, the directories depth components deep are routed to the
+  shards by the hash of their paths, and a writer below one of them
+  finds and locks it in its shard, with a lock of its own, without
+  locking the ones above: writers below different ones only meet in
+  their shard's lock, and, with enough shards, seldom even there. The
+  tree stays one tree, so that FT_toString, and FT_rmDir above the
+  shards' directories, cover them all as they do without shards. A
+  writer that must hold a shard's directory's parent, or that finds
+  its directory held by another writer for long, takes the path from
+  the root as usual.
+
+  Returns INITIALIZATION_ERROR if already initialized,
+  and SUCCESS otherwise.
+*/
+int FT_useShards(size_t numShards, size_t depth);
+
+/*
+  An FT_Snapshot is a read-only view of the tree as it was when
+  FT_snapshot took it, which later changes to the tree do not affect.
+*/
+struct FT_Snapshot;
+
+/*
+  Returns a new snapshot of the tree, or NULL if not in an initialized
+  state, if concurrent reads or writes are enabled (see
+  FT_useConcurrentReads), or if unable to allocate sufficient memory.
+
+  Taking a snapshot copies nothing: the snapshot shares every
+  directory and file with the tree. Until it is released, the first
+  change below a directory it shares copies that directory, and each
+  one above it still shared, along with their lists of children, and
+  a file whose contents are replaced is replaced by a new file. Later
+  changes there cost nothing extra. Snapshots hold the directories and
+  files the tree no longer does, so that FT_memoryStats counts them.
+  They must all be released before FT_destroy.
+*/
+struct FT_Snapshot *FT_snapshot(void);
+
+/*
+  Releases snapshot, freeing what only it holds.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_releaseSnapshot(struct FT_Snapshot *snapshot);
+
+/*
+  Does FT_stat, FT_getFileContents and FT_listDir (and so also
+  contains checks) on snapshot rather than on the tree, with the same
+  results, other than for INITIALIZATION_ERROR. Contents are returned
+  as FT_getFileContents returns them.
+*/
+int FT_snapshotStat(struct FT_Snapshot *snapshot, char *path,
+                    boolean *type, size_t *length);
+void *FT_snapshotGetFileContents(struct FT_Snapshot *snapshot,
+                                 char *path);
+int FT_snapshotListDir(struct FT_Snapshot *snapshot, char *path,
+                       const char *startAfter, size_t max,
+                       struct FT_DirEntry *out, size_t *numEntries);
+
+/*
+  Returns a string representation of snapshot, as FT_toString does
+  of the tree, or NULL if there is an allocation error.
+
+  Allocates memory for the returned string,
+  which is then owned by client!
+*/
+char *FT_snapshotToString(struct FT_Snapshot *snapshot);
+
+/* the ways FT_diff finds a path to differ between two trees */
+enum FT_Change {FT_ADDED, FT_REMOVED, FT_MODIFIED};
+
+/*
+  An FT_DiffCallback is told by FT_diff that path, a directory if
+  type is FALSE and a file if it is TRUE (as in FT_stat), differs as
+  change, and receives the extra argument given to FT_diff. path is
+  only valid until the callback returns.
+*/
+typedef void (*FT_DiffCallback)(const char *path, boolean type,
+                                enum FT_Change change, void *extra);
+
+/*
+  Calls callback, with extra, for each path that differs between
+  from and to, each a snapshot or NULL for the tree: FT_ADDED for a
+  path only in to, FT_REMOVED for one only in from, and FT_MODIFIED
+  for a file in both whose length or stored contents differ (see
+  FT_getFileContents). A path that is a directory in one and a file
+  in the other is removed and added. Paths are reported in the order
+  in which FT_toString lists them: below each directory, its files by
+  name, then its directories by name, each followed by the paths
+  below it.
+
+  Directories and files that from and to share (see FT_snapshot) are
+  the same, and are skipped with everything below them, so that the
+  time taken grows with the changes made between the two trees, and
+  the numbers of children of the directories they made, rather than
+  with the size of the trees. callback may not change the tree.
+
+  Returns INITIALIZATION_ERROR if not in an initialized state or if
+  concurrent reads or writes are enabled (see FT_useConcurrentReads),
+  and SUCCESS otherwise.
+*/
+int FT_diff(struct FT_Snapshot *from, struct FT_Snapshot *to,
+            FT_DiffCallback callback, void *extra);
+
+/*
+  An FT_WatchEvent tells a watch (see FT_watch) that path, a directory
+  if type is FALSE and a file if it is TRUE (as in FT_stat), was
+  added or removed, or that its contents were replaced, as change is
+  FT_ADDED, FT_REMOVED or FT_MODIFIED.
+*/
+struct FT_WatchEvent {
+   const char *path;
+   boolean type;
+   enum FT_Change change;
+};
+
+/*
+  An FT_WatchCallback is given the numEvents changes in events, in
+  the order they were made, and the ctx given to FT_watch. events is
+  only valid until the callback returns.
+*/
+typedef void (*FT_WatchCallback)(const struct FT_WatchEvent *events,
+                                 size_t numEvents, void *ctx);
+
+/*
+  An FT_Watch is a subscription to the changes made below a prefix.
+*/
+struct FT_Watch;
+
+/*
+  Returns a new watch that calls callback, with ctx, for the changes
+  made to the tree at or below prefix, a path ("" watches the whole
+  tree): each directory inserted, with those inserted on the way to
+  it, each file inserted or removed, each file whose contents are
+  replaced, and each directory removed (once, with everything below
+  it, for the watches below it too). Returns NULL if not in an
+  initialized state, or if unable to allocate sufficient memory or to
+  start the dispatcher thread.
+
+  Writers only queue their changes, and a dispatcher thread calls the
+  callbacks with all the changes queued since the last call, so that
+  a slow callback never slows a writer down. Repeated replacements of
+  the contents of a file are told once. The changes made in a
+  transaction (see FT_begin) are queued once it is committed, and
+  forgotten if it is aborted. A change is lost if unable to allocate
+  sufficient memory for it, and one made while the first watch is
+  being added may be missed.
+
+  Callbacks run on the dispatcher thread, while the client may be
+  changing the tree, so that they may only read it as concurrent reads
+  allow (see FT_useConcurrentReads), and must not call FT_watch,
+  FT_unwatch or FT_flushWatches. FT_destroy removes every watch, once
+  the changes queued so far are told. Without GCC's thread support,
+  changes are only told by FT_flushWatches and FT_destroy.
+*/
+struct FT_Watch *FT_watch(const char *prefix, FT_WatchCallback callback,
+                          void *ctx);
+
+/*
+  Removes watch, after which its callback is not called again: a
+  call in progress returns first.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_unwatch(struct FT_Watch *watch);
+
+/*
+  Waits until the callbacks have been told every change made so far.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_flushWatches(void);
+
+/*
+  Begins a transaction: the changes made to the tree until FT_commit
+  or FT_abort take effect together or not at all. Within it, the
+  operations behave and return as they otherwise would, and see the
+  changes made so far, but FT_abort returns the tree to the state it
+  was in when the transaction began.
+
+  A transaction keeps a snapshot of the tree (see FT_snapshot), so
+  that each of its changes copies what the snapshot shares, and
+  undoing them costs nothing. The path index (see FT_usePathIndex) is
+  brought up to date only once, by FT_commit: meanwhile, each search
+  starts from where the last one ended, so that operations on the
+  same directories share their traversals. Contents that
+  FT_replaceFileContents returned within an aborted transaction are
+  back in the tree.
+
+  Returns INITIALIZATION_ERROR if not in an initialized state, if a
+  transaction is already open, or if concurrent reads or writes are
+  enabled (see FT_useConcurrentReads), MEMORY_ERROR if unable to
+  allocate sufficient memory, and SUCCESS otherwise.
+*/
+int FT_begin(void);
+
+/*
+  Ends the open transaction, keeping its changes.
+  Returns INITIALIZATION_ERROR if not in an initialized state or if
+  no transaction is open, MEMORY_ERROR, aborting the transaction (see
+  FT_abort), if unable to allocate sufficient memory to bring the
+  path index up to date, and SUCCESS otherwise.
+*/
+int FT_commit(void);
+
+/*
+  Ends the open transaction, returning the tree to the state it was
+  in when the transaction began. FT_destroy aborts an open
+  transaction.
+  Returns INITIALIZATION_ERROR if not in an initialized state or if
+  no transaction is open, and SUCCESS otherwise.
+*/
+int FT_abort(void);
+
+/*
+  Writes to stream a delta holding the changes made to the tree since
+  version, a version stored by an earlier FT_exportDelta (0 for all
+  of the tree), and stores in *newVersion the version to pass to the
+  next one. FT_applyDelta makes those changes to another tree that was
+  equal to this one at version, so that it becomes equal to it now.
+
+  Every change to a directory's children or a file's contents stamps
+  a new version on it and on the directories above it, so that the
+  delta is written by visiting only the directories the changes were
+  made below. It holds, in a compact binary form (see delta.h), the
+  root's path, the path and contents of each file whose contents were
+  stored since version, and the path and the names of the children of
+  each directory created or that lost a child since then.
+
+  Returns INITIALIZATION_ERROR if not in an initialized state, if a
+  transaction is open (see FT_begin), or if concurrent reads or
+  writes are enabled (see FT_useConcurrentReads), MEMORY_ERROR if
+  unable to write to stream or to allocate sufficient memory to
+  unpack compressed contents (see FT_useCompression), and SUCCESS
+  otherwise. *newVersion is unchanged unless returning SUCCESS.
+*/
+int FT_exportDelta(unsigned long version, FILE *stream,
+                   unsigned long *newVersion);
+
+/*
+  Reads a delta that FT_exportDelta wrote from stream and makes its
+  changes to the tree, as a transaction (see FT_begin): either all of
+  them or, if one fails, none. The cost is that of the changes, not of
+  reloading the whole tree. The tree keeps its own copy of the
+  contents it applies, so that the content store must be enabled (see
+  FT_useContentStore).
+
+  Returns INITIALIZATION_ERROR if not in an initialized state, if the
+  content store is not enabled, if a transaction is open, or if
+  concurrent reads or writes are enabled, CONFLICTING_PATH if stream
+  does not hold a delta or if the tree was not equal to the exporting
+  one at the delta's first version, so that a change cannot be made,
+  MEMORY_ERROR if unable to allocate sufficient memory, and SUCCESS
+  otherwise.
+*/
+int FT_applyDelta(FILE *stream);
+
+/*
+  An FT_PathEntry is a directory or file for FT_buildFromPaths: its
+  path, its type, FALSE for a directory and TRUE for a file (as in
+  FT_stat), and a file's contents and their length, as FT_insertFile
+  takes them.
+*/
+struct FT_PathEntry {
+   char *path;
+   boolean type;
+   void *contents;
+   size_t length;
+};
+
+/*
+  Builds the tree, which must be empty, from the n entries of
+  entries, in any order, as if each were inserted, along with the
+  directories above it that no entry names, but without looking any
+  path up in the tree: the entries are sorted by path, on up to
+  numThreads threads at once, checked in one sweep, and each
+  directory is given its children in arrays of their final size, in
+  the order they come in. Entries repeating the path and type of
+  another are skipped.
+
+  Returns INITIALIZATION_ERROR if not in an initialized state, if the
+  tree is not empty, if a transaction is open, or if concurrent reads
+  or writes are enabled, CONFLICTING_PATH if a path has an empty
+  component, if two paths do not share their first component, or if
+  a file would be the root, ALREADY_IN_TREE if a path is both a
+  directory and a file, NOT_A_DIRECTORY if a path is below a file,
+  MEMORY_ERROR if unable to allocate sufficient memory, and SUCCESS
+  otherwise. The tree is only changed on SUCCESS.
+*/
+int FT_buildFromPaths(const struct FT_PathEntry *entries, size_t n,
+                      size_t numThreads);
+
+/* The operations an FT_Ring runs, each named after the function it
+   calls */
+enum FT_RingOp {
+   FT_RING_INSERT_DIR, FT_RING_CONTAINS_DIR, FT_RING_RM_DIR,
+   FT_RING_INSERT_FILE, FT_RING_CONTAINS_FILE, FT_RING_RM_FILE,
+   FT_RING_GET_FILE_CONTENTS, FT_RING_REPLACE_FILE_CONTENTS,
+   FT_RING_STAT, FT_RING_TO_STRING
+};
+
+/*
+  An FT_Submission describes an operation to run: op on path (unused
+  by FT_RING_TO_STRING), with contents and length for
+  FT_RING_INSERT_FILE and FT_RING_REPLACE_FILE_CONTENTS. userData is
+  only handed back with the operation's completion.
+
+  The ring keeps path and contents, not copies of them, so that they
+  must stay valid until the completion is reaped.
+*/
+struct FT_Submission {
+   enum FT_RingOp op;
+   char *path;
+   void *contents;
+   size_t length;
+   void *userData;
+};
+
+/*
+  An FT_Completion is the result of an operation, with the userData
+  it was submitted with. status is the status the function returns,
+  SUCCESS or NO_SUCH_PATH for the contains checks, the status of
+  FT_stat (or NOT_A_FILE for a directory) for FT_RING_GET_FILE_CONTENTS
+  and FT_RING_REPLACE_FILE_CONTENTS, and SUCCESS or MEMORY_ERROR for
+  FT_RING_TO_STRING. result is the contents, the old contents, or the
+  string those return, which the client then owns as it would, and
+  NULL otherwise. type and length are set as FT_stat sets them by
+  FT_RING_STAT, FT_RING_GET_FILE_CONTENTS and
+  FT_RING_REPLACE_FILE_CONTENTS, and are FALSE and 0 otherwise.
+*/
+struct FT_Completion {
+   int status;
+   void *result;
+   boolean type;
+   size_t length;
+   void *userData;
+};
+
+/*
+  An FT_Ring runs the operations submitted to it on a worker thread of
+  its own, so that a client need not wait for them: it submits
+  operations to a submission ring and later reaps their results from
+  a completion ring.
+*/
+struct FT_Ring;
+
+/*
+  Returns a new ring that holds up to capacity operations submitted
+  but not yet reaped, or NULL if not in an initialized state, if
+  capacity is 0, or if unable to allocate sufficient memory or to
+  start the worker thread.
+
+  The worker runs the operations in the order they were submitted,
+  each batch of those submitted while it ran the last one in a row.
+  The client and the worker only hand operations over through the
+  counts of those submitted, completed and reaped, so that neither
+  takes a lock, nor makes a system call, for each one: the worker only
+  sleeps once the ring is empty, and the client only when it waits
+  for a completion. One thread at a time may submit to and reap from
+  a ring.
+
+  The worker calls the functions as another thread would, so that
+  while operations are in flight, the client's own calls, and the
+  workers of other rings, must keep to what concurrent reads and
+  writes allow (see FT_useConcurrentReads). Rings must all be
+  destroyed before FT_destroy. Without GCC's thread support,
+  operations are run by FT_reap instead.
+*/
+struct FT_Ring *FT_createRing(size_t capacity);
+
+/*
+  Submits the numSubmissions operations in submissions to ring, as
+  many of them, in order, as it has room for.
+  Returns the number of operations submitted.
+*/
+size_t FT_submit(struct FT_Ring *ring,
+                 const struct FT_Submission *submissions,
+                 size_t numSubmissions);
+
+/*
+  Reaps up to max completions from ring, in the order the operations
+  were submitted, into completions. If wait is TRUE and none are
+  ready, waits for one, unless no operation is in flight.
+  Returns the number of completions reaped.
+*/
+size_t FT_reap(struct FT_Ring *ring, struct FT_Completion *completions,
+               size_t max, boolean wait);
+
+/*
+  Waits for the operations in flight on ring to complete, then stops
+  its worker and frees it, along with the completions not yet reaped,
+  but not their results.
+  Returns INITIALIZATION_ERROR if not in an initialized state,
+  and SUCCESS otherwise.
+*/
+int FT_destroyRing(struct FT_Ring *ring);
+
+/*
+  Writes an image of the tree to the file filename, creating it if
+  needed, for processes that then read it in place rather than each
+  building a tree of their own (see FT_openImage). The image links its
+  directories and files by their offsets in the file rather than by
+  pointers, so that it means the same wherever it is mapped, and all
+  the processes that map it share one copy of it.
+
+  Writers in other processes wait for the lock this one holds on the
+  file while writing it. The file only ever grows, so that a reader
+  never maps past its end, and a count in it is odd while the image
+  is being written, so that readers that saw it change look again.
+  Returns INITIALIZATION_ERROR if not in an initialized state, if a
+  transaction is open, or if concurrent reads or writes are enabled,
+  MEMORY_ERROR if unable to allocate sufficient memory or to write the
+  file, and SUCCESS otherwise.
+*/
+int FT_publishImage(const char *filename);
+
+/*
+  An FT_Image is an image written by FT_publishImage, mapped by a
+  reader, which need not be in an initialized state, nor even have
+  the tree. One thread at a time may use it.
+*/
+struct FT_Image;
+
+/*
+  Maps the image in the file filename.
+  Returns the mapping, or NULL if unable to map the file, or if it
+  holds no image.
+*/
+struct FT_Image *FT_openImage(const char *filename);
+
+/*
+  Looks path up in the latest image published in the file of image,
+  without copying it, as FT_stat looks it up in the tree.
+  Returns SUCCESS, NO_SUCH_PATH as FT_stat does, MEMORY_ERROR if
+  unable to map the image that outgrew the file's mapping, and
+  CONFLICTING_PATH if the file holds an image that is not well formed.
+*/
+int FT_imageStat(struct FT_Image *image, char *path, boolean *type,
+                 size_t *length);
+
+/*
+  Copies up to size bytes of the contents of the file at path in the
+  latest image published in the file of image into buffer, and stores
+  their whole length in *length. Nothing is copied if the file has
+  NULL contents.
+  Returns NOT_A_FILE if path is a directory, the other statuses as
+  FT_imageStat returns them, and SUCCESS otherwise.
+*/
+int FT_imageReadFile(struct FT_Image *image, char *path, void *buffer,
+                     size_t size, size_t *length);
+
+/*
+  Unmaps image and frees it.
+*/
+void FT_closeImage(struct FT_Image *image);
+
 /*
   Sets the data structure to initialized status.
   The data structure is initially empty.
@@ -10,6 +10,29 @@
 #include <string.h>
 #include "ft.h"
 
+/* Appends path to the string extra, after '+', '-' or '~' as change
+   is FT_ADDED, FT_REMOVED or FT_MODIFIED, and before "/" if type is
+   FALSE and "\n" in any case. */
+static void recordChange(const char *path, boolean type,
+                         enum FT_Change change, void *extra) {
+  char *changes = (char *)extra;
+  const char *signs = "+-~";
+
+  assert(strlen(changes) + strlen(path) + 3 < 1000);
+  sprintf(changes + strlen(changes), "%c%s%s\n", signs[change], path,
+          type ? "" : "/");
+}
+
+/* Appends each of the numEvents events to the string ctx, as
+   recordChange does */
+static void recordEvents(const struct FT_WatchEvent *events,
+                         size_t numEvents, void *ctx) {
+  size_t i;
+
+  for (i = 0; i < numEvents; i++)
+    recordChange(events[i].path, events[i].type, events[i].change, ctx);
+}
+
 /* Tests the FT implementation with an assortment of checks.
    Prints the status of the data structure along the way to stderr.
    Returns 0. */
@@ -18,6 +41,34 @@ int main(void) {
   boolean b;
   size_t l;
   char arr[1000] = {'\0'};
+  struct FT_DirEntry entries[5];
+  size_t n;
+  struct FT_ContentStats stats;
+  struct FT_CompressionStats cstats;
+  struct FT_InternStats istats;
+  struct FT_MemoryStats mstats;
+  struct FT_Metrics metrics;
+  struct FT_Snapshot* snap;
+  struct FT_Snapshot* empty;
+  char big[1000];
+  size_t i;
+  unsigned long h1;
+  unsigned long h2;
+  FILE* full;
+  FILE* delta;
+  unsigned long v1;
+  unsigned long v2;
+  char* expected;
+  char seen[1000] = {'\0'};
+  char below[1000] = {'\0'};
+  struct FT_Watch* watch;
+  struct FT_Watch* deep;
+  struct FT_Ring* ring;
+  struct FT_Image* image;
+  struct FT_PathEntry paths[6];
+  struct FT_PathEntry* many;
+  struct FT_Submission subs[6];
+  struct FT_Completion comps[6];
 
   /* Before the data structure is initialized, insert*, remove*,
      and destroy operations should return INITIALIZATION_ERROR, and
@@ -191,13 +242,797 @@ int main(void) {
   assert((temp = FT_toString()) != NULL);
   fprintf(stderr, "Checkpoint 5.6:\n%s\n", temp);
   free(temp);
+
+  /* listDir merges files and directories in order by name,
+     one page at a time */
+  assert(FT_listDir("a/y", NULL, 2, entries, &n) == SUCCESS);
+  assert(n == 2);
+  assert(!strcmp(entries[0].name, "CHILD1DIR"));
+  assert(entries[0].type == FALSE);
+  assert(!strcmp(entries[1].name, "CHILD1FILE"));
+  assert(entries[1].type == TRUE);
+  assert(FT_listDir("a/y", entries[1].name, 5, entries, &n) == SUCCESS);
+  assert(n == 3);
+  assert(!strcmp(entries[0].name, "CHILD2DIR"));
+  assert(!strcmp(entries[1].name, "CHILD2FILE"));
+  assert(!strcmp(entries[2].name, "CHILD3DIR"));
+  assert(FT_listDir("a/y", "CHILD3DIR", 5, entries, &n) == SUCCESS);
+  assert(n == 0);
+  assert(FT_listDir("a/x", NULL, 5, entries, &n) == SUCCESS);
+  assert(n == 2);
+  assert(!strcmp(entries[0].name, "B"));
+  assert(entries[0].length == 9);
+  assert(FT_listDir("a/x/B", NULL, 5, entries, &n) == NOT_A_DIRECTORY);
+  assert(FT_listDir("a/z", NULL, 5, entries, &n) == NO_SUCH_PATH);
   
   assert(FT_destroy() == SUCCESS);
   assert(FT_destroy() == INITIALIZATION_ERROR);
   assert(FT_containsDir("a") == FALSE);
   assert(FT_containsFile("a") == FALSE);
   assert((temp = FT_toString()) == NULL);
-  
+
+  /* with the content store, identical contents are stored once
+     and freed when the last file referencing them goes */
+  assert(FT_useContentStore(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_useContentStore(FALSE) == INITIALIZATION_ERROR);
+  assert(FT_insertDir("s") == SUCCESS);
+  assert(FT_insertFile("s/A", "Kernighan", 10) == SUCCESS);
+  assert(FT_insertFile("s/B", "Kernighan", 10) == SUCCESS);
+  assert(FT_insertFile("s/C", "Ritchie", 8) == SUCCESS);
+  assert(FT_getFileContents("s/A") == FT_getFileContents("s/B"));
+  assert(FT_getContentStats(&stats) == SUCCESS);
+  assert(stats.numBlobs == 2);
+  assert(stats.numRefs == 3);
+  assert(stats.storedBytes == 18);
+  assert(stats.logicalBytes == 28);
+  assert(!strcmp(FT_replaceFileContents("s/A", "Ritchie", 8),
+                 "Kernighan"));
+  assert(FT_getFileContents("s/A") == FT_getFileContents("s/C"));
+  assert(FT_rmFile("s/B") == SUCCESS);
+  assert(FT_getContentStats(&stats) == SUCCESS);
+  assert(stats.numBlobs == 1);
+  assert(stats.numRefs == 2);
+  assert(stats.dedupRatio == 2.0);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_getContentStats(&stats) == INITIALIZATION_ERROR);
+  assert(FT_useContentStore(FALSE) == SUCCESS);
+
+  /* with compression, large contents are held packed, but read back
+     and stat'ed as they were inserted */
+  for (i = 0; i < sizeof(big); i++)
+    big[i] = "Thompson and Ritchie "[i % 21];
+  assert(FT_useCompression(64) == SUCCESS);
+  assert(FT_useContentStore(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("c") == SUCCESS);
+  assert(FT_insertFile("c/A", big, sizeof(big)) == SUCCESS);
+  assert(FT_insertFile("c/B", big, sizeof(big)) == SUCCESS);
+  assert(FT_insertFile("c/C", "Kernighan", 10) == SUCCESS);
+  assert(!memcmp(FT_getFileContents("c/A"), big, sizeof(big)));
+  assert(!memcmp(FT_getFileContents("c/A"), big, sizeof(big)));
+  assert(!strcmp(FT_getFileContents("c/C"), "Kernighan"));
+  assert(FT_stat("c/A", &b, &l) == SUCCESS);
+  assert(l == sizeof(big));
+  assert(FT_getCompressionStats(&cstats) == SUCCESS);
+  assert(cstats.numPacked == 2);
+  assert(cstats.logicalBytes == 2 * sizeof(big));
+  assert(cstats.savedBytes > sizeof(big));
+  assert(cstats.numHits == 1);
+  assert(cstats.numMisses == 1);
+  assert(FT_getContentStats(&stats) == SUCCESS);
+  assert(stats.numBlobs == 2);
+  assert(!memcmp(FT_replaceFileContents("c/B", "Ritchie", 8), big,
+                 sizeof(big)));
+  assert(!strcmp(FT_getFileContents("c/B"), "Ritchie"));
+  assert(FT_rmDir("c") == SUCCESS);
+  assert(FT_getCompressionStats(&cstats) == SUCCESS);
+  assert(cstats.numPacked == 0);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useCompression(0) == SUCCESS);
+  assert(FT_useContentStore(FALSE) == SUCCESS);
+
+  /* with compression alone, the tree also copies the contents it does
+     not pack, so that the client may reuse its buffers */
+  assert(FT_useCompression(64) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("c") == SUCCESS);
+  strcpy(arr, "Kernighan");
+  assert(FT_insertFile("c/C", arr, 10) == SUCCESS);
+  assert(FT_insertFile("c/A", big, sizeof(big)) == SUCCESS);
+  strcpy(arr, "Pike");
+  assert(!strcmp(FT_getFileContents("c/C"), "Kernighan"));
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.storedContentBytes > 10);
+  assert(mstats.storedContentBytes < sizeof(big));
+  assert(!strcmp(FT_replaceFileContents("c/C", arr, 5), "Kernighan"));
+  strcpy(arr, "Thompson");
+  assert(!strcmp(FT_getFileContents("c/C"), "Pike"));
+  assert(FT_rmDir("c") == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.storedContentBytes == 0);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useCompression(0) == SUCCESS);
+
+  /* lookups through the path index agree with the tree, including
+     paths that share long prefixes */
+  assert(FT_usePathIndex(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_usePathIndex(FALSE) == INITIALIZATION_ERROR);
+  assert(FT_insertDir("a/bbbbbbbbbbbbbbbb/c") == SUCCESS);
+  assert(FT_insertDir("a/bbbbbbbbbbbbbbbbX") == SUCCESS);
+  assert(FT_insertFile("a/bbbbbbbbbbbbbbbb/D", "Ritchie", 8) == SUCCESS);
+  assert(FT_insertDir("a/bbbbbbbbbbbbbbbb/D/e") == NOT_A_DIRECTORY);
+  assert(FT_insertDir("ab") == CONFLICTING_PATH);
+  assert(FT_containsDir("a/bbbbbbbbbbbbbbbb") == TRUE);
+  assert(FT_containsDir("a/bbbbbbbbbbbbbbb") == FALSE);
+  assert(FT_containsFile("a/bbbbbbbbbbbbbbbb/D") == TRUE);
+  assert(FT_containsDir("a/bbbbbbbbbbbbbbbb/D") == FALSE);
+  assert(!strcmp(FT_getFileContents("a/bbbbbbbbbbbbbbbb/D"), "Ritchie"));
+  assert(FT_rmDir("a/bbbbbbbbbbbbbbbb") == SUCCESS);
+  assert(FT_containsFile("a/bbbbbbbbbbbbbbbb/D") == FALSE);
+  assert(FT_containsDir("a/bbbbbbbbbbbbbbbb/c") == FALSE);
+  assert(FT_containsDir("a/bbbbbbbbbbbbbbbbX") == TRUE);
+
+  /* repeated names are interned once */
+  assert(FT_insertDir("a/x/src") == SUCCESS);
+  assert(FT_insertDir("a/y/src") == SUCCESS);
+  assert(FT_insertFile("a/y/src/x", NULL, 0) == SUCCESS);
+  assert(FT_getInternStats(&istats) == SUCCESS);
+  assert(istats.numNames == 5);
+  assert(istats.storedBytes == 28);
+  assert(istats.tableBytes > istats.storedBytes);
+  assert(istats.numHits > 0);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_usePathIndex(FALSE) == SUCCESS);
+
+  /* memory statistics follow the tree as it changes */
+  assert(FT_memoryStats(&mstats) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.numDirs == 0 && mstats.numFiles == 0);
+  assert(mstats.totalBytes == mstats.arrayBytes);
+  assert(FT_insertDir("a") == SUCCESS);
+  assert(FT_insertFile("a/b/c", big, 100) == SUCCESS);
+  assert(FT_insertFile("a/b/d", big, 200) == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.numDirs == 2 && mstats.numFiles == 2);
+  assert(mstats.pathBytes == 2 + 4 + 6 + 6);
+  assert(mstats.contentBytes == 300);
+  assert(mstats.storedContentBytes == 0);
+  assert(mstats.arrayUsedBytes <= mstats.arrayBytes);
+  assert(mstats.nodeBytes > 0 && mstats.nameBytes > 0);
+  assert(FT_replaceFileContents("a/b/d", big, 50) == big);
+  assert(FT_rmFile("a/b/c") == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.numFiles == 1 && mstats.contentBytes == 50);
+  assert(FT_destroy() == SUCCESS);
+
+  /* the path index and the content store's table count too */
+  assert(FT_usePathIndex(TRUE) == SUCCESS);
+  assert(FT_useContentStore(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("a") == SUCCESS);
+  assert(FT_insertFile("a/b/c", big, 100) == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.indexBytes > 0 && mstats.tableBytes > 0);
+  assert(mstats.totalBytes == mstats.nodeBytes + mstats.pathBytes +
+         mstats.nameBytes + mstats.arrayBytes +
+         mstats.storedContentBytes + mstats.indexBytes +
+         mstats.tableBytes + mstats.cacheBytes);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_usePathIndex(FALSE) == SUCCESS);
+  assert(FT_useContentStore(FALSE) == SUCCESS);
+
+  /* metrics count the calls to each operation by status */
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("a/b") == SUCCESS);
+  assert(FT_insertDir("a/b") == ALREADY_IN_TREE);
+  assert(FT_containsDir("a/b") == TRUE);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_INIT].numCalls == 1);
+    assert(metrics.ops[FT_OP_INSERT_DIR].numCalls == 2);
+    assert(metrics.ops[FT_OP_INSERT_DIR].numByStatus[SUCCESS] == 1);
+    assert(metrics.ops[FT_OP_INSERT_DIR].
+           numByStatus[ALREADY_IN_TREE] == 1);
+    assert(metrics.ops[FT_OP_CONTAINS_DIR].numCalls == 1);
+    assert(metrics.ops[FT_OP_RM_DIR].numCalls == 0);
+    for (n = 0, i = 0; i < FT_NUM_LATENCY_BUCKETS; i++)
+      n += metrics.ops[FT_OP_INSERT_DIR].latency[i];
+    assert(n == 2);
+    assert(metrics.nodesVisited > 0);
+    assert(metrics.allocations > 0);
+  }
+  else
+    assert(metrics.ops[FT_OP_INSERT_DIR].numCalls == 0);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  assert(metrics.ops[FT_OP_INSERT_DIR].numCalls == 0);
+  assert(FT_destroy() == SUCCESS);
+
+  /* concurrent reads leave the results of every operation as is */
+  assert(FT_useConcurrentReads(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_useConcurrentReads(FALSE) == INITIALIZATION_ERROR);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_insertDir("a/b") == SUCCESS);
+  assert(FT_insertFile("a/b/c", big, 100) == SUCCESS);
+  assert(FT_insertFile("a/b/d", big, 200) == SUCCESS);
+  assert(FT_insertDir("a/b/e/f") == SUCCESS);
+  assert(FT_containsFile("a/b/c") == TRUE);
+  assert(FT_containsDir("a/b/e") == TRUE);
+  assert(FT_stat("a/b/d", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 200);
+  assert(FT_replaceFileContents("a/b/d", NULL, 0) == big);
+  assert(FT_getFileContents("a/b/d") == NULL);
+  assert(FT_rmFile("a/b/c") == SUCCESS);
+  assert(FT_containsFile("a/b/c") == FALSE);
+  assert(FT_rmDir("a/b/e") == SUCCESS);
+  assert(FT_containsDir("a/b/e/f") == FALSE);
+  assert(FT_rmDir("a") == SUCCESS);
+  assert(FT_containsDir("a") == FALSE);
+  assert(FT_insertDir("x") == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, "x\n") == 0);
+  free(temp);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_INSERT_DIR].numByStatus[SUCCESS] == 3);
+    assert(metrics.ops[FT_OP_CONTAINS_DIR].numCalls == 3);
+    assert(metrics.nodesVisited > 0);
+  }
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useConcurrentReads(FALSE) == SUCCESS);
+
+  /* Concurrent writes lock directories on the way, one thread here */
+  assert(FT_useConcurrentWrites(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_useConcurrentWrites(FALSE) == INITIALIZATION_ERROR);
+  assert(FT_insertFile("a", big, 1) == CONFLICTING_PATH);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertDir("x") == CONFLICTING_PATH);
+  assert(FT_insertDir("a/b/c") == ALREADY_IN_TREE);
+  assert(FT_insertFile("a/b/c/d/e", big, 10) == SUCCESS);
+  assert(FT_insertFile("a/b/f", big, 20) == SUCCESS);
+  assert(FT_insertDir("a/b/f/g") == NOT_A_DIRECTORY);
+  assert(FT_insertFile("a/b/f", big, 20) == ALREADY_IN_TREE);
+  assert(FT_rmDir("a/b/f") == NOT_A_DIRECTORY);
+  assert(FT_rmFile("a/b") == NOT_A_FILE);
+  assert(FT_rmFile("a/b/z") == NO_SUCH_PATH);
+  assert(FT_replaceFileContents("a/b/f", NULL, 0) == big);
+  assert(FT_replaceFileContents("a/b/z", NULL, 0) == NULL);
+  assert(FT_stat("a/b/f", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 0);
+  assert(FT_rmDir("a/b/c") == SUCCESS);
+  assert(FT_containsFile("a/b/c/d/e") == FALSE);
+  assert(FT_rmFile("a/b/f") == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, "a\na/b\n") == 0);
+  free(temp);
+  assert(FT_rmDir("a") == SUCCESS);
+  assert(FT_rmDir("a") == NO_SUCH_PATH);
+  assert(FT_insertDir("x/y") == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, "x\nx/y\n") == 0);
+  free(temp);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useConcurrentWrites(FALSE) == SUCCESS);
+
+  /* Shards let writers start below the directories they route to */
+  assert(FT_useShards(4, 2) == SUCCESS);
+  assert(FT_useConcurrentWrites(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_useShards(0, 2) == INITIALIZATION_ERROR);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertDir("a/d") == SUCCESS);
+  assert(FT_insertFile("a/b/c/f", big, 10) == SUCCESS);
+  assert(FT_insertFile("a/d/f", big, 20) == SUCCESS);
+  assert(FT_insertDir("a/b/c") == ALREADY_IN_TREE);
+  assert(FT_insertDir("a/b/f") == SUCCESS);
+  assert(FT_replaceFileContents("a/d/f", NULL, 0) == big);
+  assert(FT_rmFile("a/d/f") == SUCCESS);
+  assert(FT_rmFile("a/d/f") == NO_SUCH_PATH);
+  assert(FT_rmDir("a/b/c") == SUCCESS);
+  assert(FT_containsFile("a/b/c/f") == FALSE);
+  assert(FT_rmDir("a/d") == SUCCESS);
+  assert(FT_insertFile("a/d/f", big, 20) == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL &&
+         strcmp(temp, "a\na/b\na/b/f\na/d\na/d/f\n") == 0);
+  free(temp);
+  /* removing the root removes every shard's directory below it */
+  assert(FT_rmDir("a") == SUCCESS);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/d/f", big, 10) == SUCCESS);
+  assert(FT_rmDir("a/b") == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, "a\na/d\na/d/f\n") == 0);
+  free(temp);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useConcurrentWrites(FALSE) == SUCCESS);
+  assert(FT_useShards(0, 2) == SUCCESS);
+
+  /* Snapshots keep the tree as it was while it changes */
+  assert(FT_snapshot() == NULL);
+  assert(FT_usePathIndex(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  empty = FT_snapshot();
+  assert(empty != NULL);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/f", big, 10) == SUCCESS);
+  assert(FT_insertFile("a/g", big, 20) == SUCCESS);
+  snap = FT_snapshot();
+  assert(snap != NULL);
+  assert(FT_replaceFileContents("a/b/f", NULL, 0) == big);
+  assert(FT_rmDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/h", big, 30) == SUCCESS);
+  assert(FT_rmFile("a/g") == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, "a\na/b\na/b/f\na/b/h\n") == 0);
+  free(temp);
+  temp = FT_snapshotToString(snap);
+  assert(temp != NULL &&
+         strcmp(temp, "a\na/g\na/b\na/b/f\na/b/c\n") == 0);
+  free(temp);
+  assert(FT_snapshotStat(snap, "a/b/f", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 10);
+  assert(FT_snapshotGetFileContents(snap, "a/b/f") == big);
+  assert(FT_getFileContents("a/b/f") == NULL);
+  assert(FT_snapshotStat(snap, "a/b/c", &b, &l) == SUCCESS);
+  assert(b == FALSE);
+  assert(FT_snapshotStat(snap, "a/b/h", &b, &l) == NO_SUCH_PATH);
+  assert(FT_snapshotListDir(snap, "a", NULL, 5, entries, &n) ==
+         SUCCESS);
+  assert(n == 2 && strcmp(entries[0].name, "b") == 0);
+  assert(strcmp(entries[1].name, "g") == 0 && entries[1].length == 20);
+  assert(FT_snapshotListDir(snap, "a/g", NULL, 5, entries, &n) ==
+         NOT_A_DIRECTORY);
+  assert(FT_snapshotStat(empty, "a", &b, &l) == NO_SUCH_PATH);
+  temp = FT_snapshotToString(empty);
+  assert(temp != NULL && strcmp(temp, "") == 0);
+  free(temp);
+  assert(FT_releaseSnapshot(empty) == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.numDirs == 5 && mstats.numFiles == 4);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_SNAPSHOT].numCalls == 2);
+    assert(metrics.ops[FT_OP_SNAPSHOT_STAT].numCalls == 4);
+    assert(metrics.ops[FT_OP_SNAPSHOT_STAT].
+           numByStatus[NO_SUCH_PATH] == 2);
+    assert(metrics.ops[FT_OP_SNAPSHOT_LIST_DIR].
+           numByStatus[NOT_A_DIRECTORY] == 1);
+    assert(metrics.ops[FT_OP_SNAPSHOT_GET_FILE_CONTENTS].numCalls == 1);
+    assert(metrics.ops[FT_OP_SNAPSHOT_TO_STRING].numCalls == 2);
+    assert(metrics.ops[FT_OP_RELEASE_SNAPSHOT].numCalls == 1);
+  }
+  assert(FT_releaseSnapshot(snap) == SUCCESS);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.numDirs == 2 && mstats.numFiles == 2);
+  assert(FT_rmDir("a") == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_usePathIndex(FALSE) == SUCCESS);
+
+  /* Transactions take effect together or not at all */
+  assert(FT_begin() == INITIALIZATION_ERROR);
+  assert(FT_usePathIndex(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_commit() == INITIALIZATION_ERROR);
+  assert(FT_abort() == INITIALIZATION_ERROR);
+  assert(FT_insertDir("a/b") == SUCCESS);
+  assert(FT_insertFile("a/f", big, 10) == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_begin() == INITIALIZATION_ERROR);
+  assert(FT_insertDir("a/b/c/d") == SUCCESS);
+  assert(FT_insertDir("a/b/c") == ALREADY_IN_TREE);
+  assert(FT_replaceFileContents("a/f", NULL, 0) == big);
+  assert(FT_rmDir("a/b") == SUCCESS);
+  assert(FT_containsDir("a/b/c") == FALSE);
+  assert(FT_abort() == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, "a\na/f\na/b\n") == 0);
+  free(temp);
+  assert(FT_getFileContents("a/f") == big);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_insertFile("a/b/g", big, 20) == SUCCESS);
+  assert(FT_rmFile("a/f") == SUCCESS);
+  assert(FT_insertDir("a/f/h") == SUCCESS);
+  assert(FT_commit() == SUCCESS);
+  assert(FT_containsFile("a/b/g") == TRUE);
+  assert(FT_containsFile("a/f") == FALSE);
+  assert(FT_containsDir("a/f/h") == TRUE);
+  assert(FT_stat("a/b/g", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 20);
+  assert(FT_memoryStats(&mstats) == SUCCESS);
+  assert(mstats.numDirs == 4 && mstats.numFiles == 1);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_BEGIN].numCalls == 3);
+    assert(metrics.ops[FT_OP_BEGIN].
+           numByStatus[INITIALIZATION_ERROR] == 1);
+    assert(metrics.ops[FT_OP_COMMIT].numByStatus[SUCCESS] == 1);
+    assert(metrics.ops[FT_OP_ABORT].numCalls == 2);
+  }
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("a/f") == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_usePathIndex(FALSE) == SUCCESS);
+
+  /* Diffs report what changed, skipping what the trees share */
+  arr[0] = '\0';
+  assert(FT_diff(NULL, NULL, recordChange, arr) ==
+         INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  empty = FT_snapshot();
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertDir("a/d") == SUCCESS);
+  assert(FT_insertFile("a/b/f", big, 10) == SUCCESS);
+  assert(FT_insertFile("a/b/g", big, 20) == SUCCESS);
+  snap = FT_snapshot();
+  assert(FT_replaceFileContents("a/b/f", big, 10) == big);
+  assert(FT_replaceFileContents("a/b/g", big, 5) == big);
+  assert(FT_rmDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/c", NULL, 0) == SUCCESS);
+  assert(FT_insertDir("a/b/e/h") == SUCCESS);
+  assert(FT_diff(snap, NULL, recordChange, arr) == SUCCESS);
+  assert(strcmp(arr, "+a/b/c\n~a/b/g\n-a/b/c/\n"
+                "+a/b/e/\n+a/b/e/h/\n") == 0);
+  arr[0] = '\0';
+  assert(FT_diff(NULL, NULL, recordChange, arr) == SUCCESS);
+  assert(FT_diff(snap, snap, recordChange, arr) == SUCCESS);
+  assert(strcmp(arr, "") == 0);
+  assert(FT_diff(snap, empty, recordChange, arr) == SUCCESS);
+  assert(strcmp(arr, "-a/\n-a/b/\n-a/b/f\n-a/b/g\n-a/b/c/\n"
+                "-a/d/\n") == 0);
+  arr[0] = '\0';
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled)
+    assert(metrics.ops[FT_OP_DIFF].numByStatus[SUCCESS] == 4);
+  assert(FT_releaseSnapshot(snap) == SUCCESS);
+  assert(FT_releaseSnapshot(empty) == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+
+  /* Equal hierarchies have equal hashes, wherever they are */
+  assert(FT_getHash("a", &h1) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_getHash("a", &h1) == NO_SUCH_PATH);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled)
+    assert(metrics.ops[FT_OP_GET_HASH].numByStatus[NO_SUCH_PATH] == 1);
+  assert(FT_insertDir("a/x/d") == SUCCESS);
+  assert(FT_insertFile("a/x/f", big, 10) == SUCCESS);
+  assert(FT_insertFile("a/y/f", big, 10) == SUCCESS);
+  assert(FT_insertDir("a/y/d") == SUCCESS);
+  assert(FT_getHash("a/x/g", &h1) == NO_SUCH_PATH);
+  assert(FT_getHash("a/x", &h1) == SUCCESS);
+  assert(FT_getHash("a/y", &h2) == SUCCESS);
+  assert(h1 == h2);
+  assert(FT_getHash("a/x/f", &h1) == SUCCESS);
+  assert(FT_getHash("a/x/d", &h2) == SUCCESS);
+  assert(h1 != h2);
+  assert(FT_getHash("a", &h1) == SUCCESS);
+  assert(FT_replaceFileContents("a/y/f", big, 9) == big);
+  assert(FT_getHash("a", &h2) == SUCCESS);
+  assert(h1 != h2);
+  assert(FT_getHash("a/y", &h2) == SUCCESS);
+  assert(FT_getHash("a/x", &h1) == SUCCESS);
+  assert(h1 != h2);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_replaceFileContents("a/y/f", big, 10) == big);
+  assert(FT_getHash("a/y", &h2) == SUCCESS);
+  assert(h1 == h2);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_getHash("a/y", &h2) == SUCCESS);
+  assert(h1 != h2);
+  assert(FT_rmDir("a/y/d") == SUCCESS);
+  assert(FT_insertDir("a/y/d") == SUCCESS);
+  assert(FT_replaceFileContents("a/y/f", big, 10) == big);
+  assert(FT_getHash("a/y", &h2) == SUCCESS);
+  assert(h1 == h2);
+  assert(FT_destroy() == SUCCESS);
+
+  /* Deltas carry the changes made since a version to another tree */
+  full = tmpfile();
+  delta = tmpfile();
+  assert(full != NULL && delta != NULL);
+  assert(FT_exportDelta(0, full, &v1) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertDir("a/d") == SUCCESS);
+  assert(FT_insertFile("a/b/f", "abc", 4) == SUCCESS);
+  assert(FT_insertFile("a/d/g", NULL, 7) == SUCCESS);
+  for (i = 0; i < 50; i++) {
+    sprintf(big, "a/d/e%lu", (unsigned long)i);
+    assert(FT_insertFile(big, "xyz", 3) == SUCCESS);
+  }
+  assert(FT_exportDelta(0, full, &v1) == SUCCESS);
+  assert(FT_rmDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/c", "new", 4) == SUCCESS);
+  assert(FT_replaceFileContents("a/b/f", "defg", 5) != NULL);
+  assert(FT_insertDir("a/h/i") == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_exportDelta(v1, delta, &v2) == INITIALIZATION_ERROR);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_exportDelta(v1, delta, &v2) == SUCCESS);
+  assert(v2 > v1);
+  assert(ftell(delta) < ftell(full) / 4);
+  expected = FT_toString();
+  assert(expected != NULL);
+  assert(FT_destroy() == SUCCESS);
+
+  rewind(full);
+  assert(FT_init() == SUCCESS);
+  assert(FT_applyDelta(full) == INITIALIZATION_ERROR);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useContentStore(TRUE) == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_insertDir("a/x") == SUCCESS);
+  assert(FT_applyDelta(full) == SUCCESS);
+  assert(FT_containsDir("a/x") == FALSE);
+  assert(FT_stat("a/d/g", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 7 && FT_getFileContents("a/d/g") == NULL);
+  rewind(delta);
+  assert(FT_applyDelta(delta) == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, expected) == 0);
+  free(temp);
+  free(expected);
+  assert(strcmp((char*)FT_getFileContents("a/b/f"), "defg") == 0);
+  assert(strcmp((char*)FT_getFileContents("a/b/c"), "new") == 0);
+  rewind(delta);
+  assert(FT_rmDir("a/b") == SUCCESS);
+  assert(FT_insertFile("a/b", NULL, 0) == SUCCESS);
+  assert(FT_applyDelta(delta) == CONFLICTING_PATH);
+  assert(FT_containsFile("a/b") == TRUE);
+  rewind(full);
+  assert(fputc(0, full) != EOF);
+  rewind(full);
+  assert(FT_applyDelta(full) == CONFLICTING_PATH);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_APPLY_DELTA].numCalls == 4);
+    assert(metrics.ops[FT_OP_APPLY_DELTA].
+           numByStatus[CONFLICTING_PATH] == 2);
+    assert(metrics.ops[FT_OP_BEGIN].numCalls == 0);
+    assert(metrics.ops[FT_OP_INSERT_DIR].numCalls == 1);
+  }
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_useContentStore(FALSE) == SUCCESS);
+  fclose(full);
+  fclose(delta);
+
+  /* Watches are told the changes below their prefixes */
+  assert(FT_watch("a", recordEvents, seen) == NULL);
+  assert(FT_flushWatches() == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  watch = FT_watch("a/b", recordEvents, seen);
+  deep = FT_watch("a//b/c/d", recordEvents, below);
+  assert(watch != NULL && deep != NULL);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/x", NULL, 0) == SUCCESS);
+  assert(FT_insertFile("a/b/c/d/f", NULL, 0) == SUCCESS);
+  assert(FT_flushWatches() == SUCCESS);
+  assert(strcmp(seen, "+a/b/\n+a/b/c/\n+a/b/c/d/\n+a/b/c/d/f\n") == 0);
+  assert(strcmp(below, "+a/b/c/d/\n+a/b/c/d/f\n") == 0);
+  seen[0] = '\0';
+  below[0] = '\0';
+  assert(FT_begin() == SUCCESS);
+  assert(FT_replaceFileContents("a/b/c/d/f", big, 1) == NULL);
+  assert(FT_replaceFileContents("a/b/c/d/f", big, 2) == big);
+  assert(FT_rmFile("a/x") == SUCCESS);
+  assert(FT_commit() == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_rmDir("a/b/c/d") == SUCCESS);
+  assert(FT_abort() == SUCCESS);
+  assert(FT_flushWatches() == SUCCESS);
+  assert(strcmp(seen, "~a/b/c/d/f\n") == 0);
+  assert(strcmp(below, "~a/b/c/d/f\n") == 0);
+  seen[0] = '\0';
+  below[0] = '\0';
+  assert(FT_unwatch(watch) == SUCCESS);
+  assert(FT_rmDir("a/b") == SUCCESS);
+  assert(FT_flushWatches() == SUCCESS);
+  assert(strcmp(seen, "") == 0);
+  assert(strcmp(below, "-a/b/\n") == 0);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_WATCH].numCalls == 2);
+    assert(metrics.ops[FT_OP_UNWATCH].numByStatus[SUCCESS] == 1);
+    assert(metrics.ops[FT_OP_FLUSH_WATCHES].numByStatus[SUCCESS] == 3);
+  }
+  assert(FT_destroy() == SUCCESS);
+
+  /* Rings run the operations submitted in order, on their worker */
+  assert(FT_createRing(3) == NULL);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_createRing(0) == NULL);
+  ring = FT_createRing(3);
+  assert(ring != NULL);
+  assert(FT_reap(ring, comps, 6, TRUE) == 0);
+  memset(subs, 0, sizeof(subs));
+  subs[0].op = FT_RING_INSERT_DIR;
+  subs[0].path = "r/s";
+  subs[1].op = FT_RING_INSERT_FILE;
+  subs[1].path = "r/s/f";
+  subs[1].contents = big;
+  subs[1].length = 5;
+  subs[2].op = FT_RING_CONTAINS_DIR;
+  subs[2].path = "r/s/f";
+  subs[3].op = FT_RING_GET_FILE_CONTENTS;
+  subs[3].path = "r/s/f";
+  subs[4].op = FT_RING_STAT;
+  subs[4].path = "r";
+  subs[5].op = FT_RING_TO_STRING;
+  for (i = 0; i < 6; i++)
+    subs[i].userData = &subs[i];
+  /* only as many as the ring holds are submitted until some are reaped */
+  assert(FT_submit(ring, subs, 6) == 3);
+  assert(FT_submit(ring, subs + 3, 3) == 0);
+  for (n = 0; n < 3; n += l)
+    l = FT_reap(ring, comps + n, 6, TRUE);
+  assert(n == 3);
+  assert(FT_submit(ring, subs + 3, 3) == 3);
+  for (; n < 6; n += l)
+    l = FT_reap(ring, comps + n, 6 - n, TRUE);
+  assert(FT_reap(ring, comps, 6, FALSE) == 0);
+  for (i = 0; i < 6; i++)
+    assert(comps[i].userData == &subs[i]);
+  assert(comps[0].status == SUCCESS && comps[1].status == SUCCESS);
+  assert(comps[2].status == NO_SUCH_PATH);
+  assert(comps[3].status == SUCCESS && comps[3].result == big);
+  assert(comps[3].type == TRUE && comps[3].length == 5);
+  assert(comps[4].status == SUCCESS && comps[4].type == FALSE);
+  assert(comps[5].status == SUCCESS);
+  temp = FT_toString();
+  assert(temp != NULL && strcmp(temp, comps[5].result) == 0);
+  free(temp);
+  free(comps[5].result);
+  /* destroying a ring waits for the operations in flight */
+  subs[0].op = FT_RING_RM_DIR;
+  subs[0].path = "r";
+  assert(FT_submit(ring, subs, 1) == 1);
+  assert(FT_destroyRing(ring) == SUCCESS);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_CREATE_RING].numCalls == 2);
+    assert(metrics.ops[FT_OP_SUBMIT].numCalls == 4);
+    assert(metrics.ops[FT_OP_REAP].numCalls >= 3);
+    assert(metrics.ops[FT_OP_DESTROY_RING].numByStatus[SUCCESS] == 1);
+  }
+  assert(FT_containsDir("r") == FALSE);
+  assert(FT_destroy() == SUCCESS);
+
+  /* Images are read in place, and readers see those published later */
+  assert(FT_publishImage("ft_client.image") == INITIALIZATION_ERROR);
+  assert(FT_openImage("ft_client.missing") == NULL);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  assert(FT_publishImage("ft_client.image") == SUCCESS);
+  image = FT_openImage("ft_client.image");
+  assert(image != NULL);
+  assert(FT_imageStat(image, "a", &b, &l) == NO_SUCH_PATH);
+  assert(FT_insertDir("a/b/c") == SUCCESS);
+  assert(FT_insertFile("a/b/f", "abc", 4) == SUCCESS);
+  assert(FT_insertFile("a/g", NULL, 9) == SUCCESS);
+  assert(FT_insertDir("a/b/e") == SUCCESS);
+  assert(FT_publishImage("ft_client.image") == SUCCESS);
+  assert(FT_imageStat(image, "a/b", &b, &l) == SUCCESS && b == FALSE);
+  assert(FT_imageStat(image, "a/b/c", &b, &l) == SUCCESS && b == FALSE);
+  assert(FT_imageStat(image, "a/g", &b, &l) == SUCCESS);
+  assert(b == TRUE && l == 9);
+  assert(FT_imageStat(image, "a/b/f/x", &b, &l) == NO_SUCH_PATH);
+  assert(FT_imageStat(image, "a//b", &b, &l) == NO_SUCH_PATH);
+  assert(FT_imageStat(image, "b", &b, &l) == NO_SUCH_PATH);
+  assert(FT_imageReadFile(image, "a/b", arr, 1, &l) == NOT_A_FILE);
+  assert(FT_imageReadFile(image, "a/b/f", arr, sizeof(arr), &l) == SUCCESS);
+  assert(l == 4 && strcmp(arr, "abc") == 0);
+  for (i = 0; i < 50; i++) {
+    sprintf(big, "a/b/c/d%lu", (unsigned long)i);
+    assert(FT_insertFile(big, "xyz", 4) == SUCCESS);
+  }
+  assert(FT_rmDir("a/b/e") == SUCCESS);
+  assert(FT_begin() == SUCCESS);
+  assert(FT_publishImage("ft_client.image") == INITIALIZATION_ERROR);
+  assert(FT_commit() == SUCCESS);
+  assert(FT_publishImage("ft_client.image") == SUCCESS);
+  assert(FT_imageStat(image, "a/b/e", &b, &l) == NO_SUCH_PATH);
+  assert(FT_imageReadFile(image, "a/b/c/d42", arr, sizeof(arr), &l)
+         == SUCCESS);
+  assert(l == 4 && strcmp(arr, "xyz") == 0);
+  FT_closeImage(image);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_PUBLISH_IMAGE].numByStatus[SUCCESS] == 3);
+    assert(metrics.ops[FT_OP_PUBLISH_IMAGE].
+           numByStatus[INITIALIZATION_ERROR] == 1);
+    assert(metrics.ops[FT_OP_OPEN_IMAGE].numCalls == 1);
+    assert(metrics.ops[FT_OP_IMAGE_STAT].numCalls == 8);
+    assert(metrics.ops[FT_OP_IMAGE_STAT].
+           numByStatus[NO_SUCH_PATH] == 5);
+    assert(metrics.ops[FT_OP_IMAGE_READ_FILE].
+           numByStatus[NOT_A_FILE] == 1);
+    assert(metrics.ops[FT_OP_IMAGE_READ_FILE].
+           numByStatus[SUCCESS] == 2);
+    assert(metrics.ops[FT_OP_CLOSE_IMAGE].numCalls == 1);
+  }
+  assert(FT_destroy() == SUCCESS);
+  assert(remove("ft_client.image") == 0);
+
+  /* Trees are built whole from paths in any order */
+  memset(paths, 0, sizeof(paths));
+  paths[0].path = "a/b/c";
+  paths[1].path = "a/x/f";
+  paths[1].type = TRUE;
+  paths[1].contents = "abc";
+  paths[1].length = 4;
+  paths[2].path = "a/b-c";
+  paths[3].path = "a/b/c";
+  paths[4].path = "a";
+  paths[5].path = "a/b/c/g";
+  paths[5].type = TRUE;
+  assert(FT_buildFromPaths(paths, 6, 1) == INITIALIZATION_ERROR);
+  assert(FT_init() == SUCCESS);
+  assert(FT_buildFromPaths(paths, 6, 1) == SUCCESS);
+  assert(FT_buildFromPaths(paths, 6, 1) == INITIALIZATION_ERROR);
+  temp = FT_toString();
+  assert(temp != NULL);
+  assert(strcmp(temp, "a\na/b\na/b/c\na/b/c/g\na/b-c\na/x\na/x/f\n") == 0);
+  free(temp);
+  assert(strcmp((char*)FT_getFileContents("a/x/f"), "abc") == 0);
+  assert(FT_insertDir("a/b/d") == SUCCESS);
+  assert(FT_destroy() == SUCCESS);
+  assert(FT_init() == SUCCESS);
+  assert(FT_resetMetrics() == SUCCESS);
+  paths[0].type = TRUE;
+  assert(FT_buildFromPaths(paths, 6, 1) == ALREADY_IN_TREE);
+  paths[3].type = TRUE;
+  assert(FT_buildFromPaths(paths, 6, 1) == NOT_A_DIRECTORY);
+  paths[3].type = FALSE;
+  paths[0].path = "b";
+  assert(FT_buildFromPaths(paths, 6, 1) == CONFLICTING_PATH);
+  paths[0].path = "a//c";
+  assert(FT_buildFromPaths(paths, 6, 1) == CONFLICTING_PATH);
+  assert(FT_containsDir("a") == FALSE);
+  assert(FT_getMetrics(&metrics) == SUCCESS);
+  if (metrics.enabled) {
+    assert(metrics.ops[FT_OP_BUILD_FROM_PATHS].numCalls == 4);
+    assert(metrics.ops[FT_OP_BUILD_FROM_PATHS].
+           numByStatus[CONFLICTING_PATH] == 2);
+  }
+  /* past a thousand children, they are kept in a sequence */
+  many = malloc(20000 * sizeof(struct FT_PathEntry));
+  assert(many != NULL);
+  for (i = 0; i < 20000; i++) {
+    many[i].path = malloc(20);
+    assert(many[i].path != NULL);
+    sprintf(many[i].path, "r/%lu/%lu", (unsigned long)(i * 7919 % 2000),
+            (unsigned long)(i / 2000));
+    many[i].type = i % 3 == 0;
+    many[i].contents = NULL;
+    many[i].length = i;
+  }
+  assert(FT_buildFromPaths(many, 20000, 4) == SUCCESS);
+  assert(FT_listDir("r", NULL, 5, entries, &n) == SUCCESS && n == 5);
+  assert(strcmp(entries[0].name, "0") == 0);
+  assert(strcmp(entries[1].name, "1") == 0);
+  assert(strcmp(entries[2].name, "10") == 0);
+  assert(FT_stat("r/1999", &b, &l) == SUCCESS && b == FALSE);
+  assert(FT_insertDir("r/1000/a") == SUCCESS);
+  assert(FT_rmDir("r/17") == SUCCESS);
+  for (i = 0; i < 20000; i++)
+    free(many[i].path);
+  free(many);
+  assert(FT_destroy() == SUCCESS);
+
   return 0;
 }
 
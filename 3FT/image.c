@@ -0,0 +1,620 @@
+/*--------------------------------------------------------------------*/
+/* image.c                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+/* mmap, fcntl and sched_yield are POSIX, not ANSI C */
+#define _POSIX_C_SOURCE 200112L
+
+#include "defs.h"
+#include "image.h"
+
+#if defined(__GNUC__) && defined(__unix__)
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+/* The bytes of a word */
+enum {WORD = sizeof(unsigned long)};
+
+/* The words of the header */
+enum {HEADER_MAGIC, HEADER_SEQUENCE, HEADER_LENGTH, HEADER_ROOT,
+      HEADER_WORDS};
+
+/* The words every record starts with, then those of a directory's
+   record before the offsets of its children, and those of a file's */
+enum {RECORD_KIND, RECORD_PATH, RECORD_NAME, RECORD_WORDS};
+enum {DIR_NUM_FILES = RECORD_WORDS, DIR_NUM_DIRS, DIR_WORDS};
+enum {FILE_LENGTH = RECORD_WORDS, FILE_CONTENTS, FILE_WORDS};
+
+/* What looking a path up returns if the image is not well formed,
+   because it was changed meanwhile or is corrupt */
+enum {IMAGE_TORN = -1};
+
+/* An image being built, length bytes of an array of capacity */
+struct Image {
+   char *bytes;
+   size_t length;
+   size_t capacity;
+};
+
+/* A file mapped by a reader */
+struct FT_Image {
+   /* the file, and its first mapped bytes, of which there are mapped */
+   int fd;
+   char *map;
+   size_t mapped;
+};
+
+/* The part of a mapped file an image is looked up in: the first length
+   bytes at base, which may be less than the image claims */
+struct view {
+   const char *base;
+   size_t length;
+};
+
+
+/* Adds size bytes, rounded up to a word, set to 0, to the end of
+   image. Returns their offset, or 0 if unable to allocate sufficient
+   memory. */
+static unsigned long Image_reserve(Image_T image, size_t size) {
+   size_t offset = image->length;
+   size_t capacity;
+   char *bytes;
+
+   if (size > (size_t)-1 - WORD - offset)
+      return 0;
+   size = (size + WORD - 1) / WORD * WORD;
+
+   if (offset + size > image->capacity) {
+      capacity = image->capacity * 2;
+      if (capacity < offset + size)
+         capacity = offset + size;
+      bytes = (char *)realloc(image->bytes, capacity);
+      if (bytes == NULL)
+         return 0;
+      image->bytes = bytes;
+      image->capacity = capacity;
+   }
+
+   memset(image->bytes + offset, 0, size);
+   image->length = offset + size;
+   return (unsigned long)offset;
+}
+
+/* Returns the words of image at offset */
+static unsigned long *Image_getWords(Image_T image, unsigned long offset) {
+   return (unsigned long *)(image->bytes + offset);
+}
+
+/* Adds the length bytes at bytes to image. Returns their offset, or 0
+   if unable to allocate sufficient memory. */
+static unsigned long Image_addBytes(Image_T image, const void *bytes,
+                                    size_t length) {
+   unsigned long offset = Image_reserve(image, length);
+
+   if (offset != 0 && length > 0)
+      memcpy(image->bytes + offset, bytes, length);
+
+   return offset;
+}
+
+/* Adds the record of kind kind, of numWords words, of the directory or
+   file at path to image. Returns its offset, or 0 if unable to
+   allocate sufficient memory. */
+static unsigned long Image_addRecord(Image_T image, int kind,
+                                     const char *path, size_t numWords) {
+   unsigned long pathOffset;
+   unsigned long record;
+   unsigned long *words;
+   const char *slash;
+
+   pathOffset = Image_addBytes(image, path, strlen(path) + 1);
+   if (pathOffset == 0 || numWords > (size_t)-1 / WORD)
+      return 0;
+
+   record = Image_reserve(image, numWords * WORD);
+   if (record == 0)
+      return 0;
+
+   slash = strrchr(path, '/');
+   words = Image_getWords(image, record);
+   words[RECORD_KIND] = (unsigned long)kind;
+   words[RECORD_PATH] = pathOffset;
+   words[RECORD_NAME] = slash != NULL ? (unsigned long)(slash - path + 1) : 0;
+   return record;
+}
+
+/* see image.h for specification */
+Image_T Image_new(void) {
+   Image_T image;
+
+   image = (Image_T)calloc(1, sizeof(struct Image));
+   if (image == NULL)
+      return NULL;
+
+   /* the header is at offset 0, which no record can then have, so
+      only its length tells whether it was added */
+   (void) Image_reserve(image, HEADER_WORDS * WORD);
+   if (image->length == 0) {
+      Image_free(image);
+      return NULL;
+   }
+
+   Image_getWords(image, 0)[HEADER_MAGIC] = IMAGE_MAGIC;
+   return image;
+}
+
+/* see image.h for specification */
+void Image_free(Image_T image) {
+   assert(image != NULL);
+
+   free(image->bytes);
+   free(image);
+}
+
+/* see image.h for specification */
+unsigned long Image_addDir(Image_T image, const char *path,
+                           size_t numFiles, size_t numDirs) {
+   unsigned long record;
+   unsigned long *words;
+
+   assert(image != NULL);
+   assert(path != NULL);
+
+   if (numFiles > (size_t)-1 - DIR_WORDS - numDirs)
+      return 0;
+
+   record = Image_addRecord(image, IMAGE_DIR, path,
+                            DIR_WORDS + numFiles + numDirs);
+   if (record == 0)
+      return 0;
+
+   words = Image_getWords(image, record);
+   words[DIR_NUM_FILES] = (unsigned long)numFiles;
+   words[DIR_NUM_DIRS] = (unsigned long)numDirs;
+   return record;
+}
+
+/* see image.h for specification */
+unsigned long Image_addFile(Image_T image, const char *path,
+                            const void *contents, size_t length) {
+   unsigned long contentsOffset = 0;
+   unsigned long record;
+   unsigned long *words;
+
+   assert(image != NULL);
+   assert(path != NULL);
+
+   if (contents != NULL) {
+      contentsOffset = Image_addBytes(image, contents, length);
+      if (contentsOffset == 0)
+         return 0;
+   }
+
+   record = Image_addRecord(image, IMAGE_FILE, path, FILE_WORDS);
+   if (record == 0)
+      return 0;
+
+   words = Image_getWords(image, record);
+   words[FILE_LENGTH] = (unsigned long)length;
+   words[FILE_CONTENTS] = contentsOffset;
+   return record;
+}
+
+/* see image.h for specification */
+void Image_setChild(Image_T image, unsigned long dir, size_t index,
+                    unsigned long child) {
+   assert(image != NULL);
+   assert(dir != 0 && child != 0);
+
+   Image_getWords(image, dir)[DIR_WORDS + index] = child;
+}
+
+/* see image.h for specification */
+void Image_setRoot(Image_T image, unsigned long dir) {
+   assert(image != NULL);
+
+   Image_getWords(image, 0)[HEADER_ROOT] = dir;
+}
+
+/* Returns the numWords words of the record at offset in view, or NULL
+   if they are not all in it */
+static const unsigned long *Image_getRecord(const struct view *view,
+                                            unsigned long offset,
+                                            size_t numWords) {
+   if (offset % WORD != 0 || offset < HEADER_WORDS * WORD ||
+       offset > view->length ||
+       numWords > (view->length - (size_t)offset) / WORD)
+      return NULL;
+
+   return (const unsigned long *)(view->base + offset);
+}
+
+/* Returns the name of the record at offset in view, of kind kind,
+   which must be in view and end there, or NULL if it does not */
+static const char *Image_getName(const struct view *view,
+                                 unsigned long offset, int kind) {
+   const unsigned long *record;
+   const char *path;
+   const char *end;
+
+   record = Image_getRecord(view, offset, RECORD_WORDS);
+   if (record == NULL || record[RECORD_KIND] != (unsigned long)kind ||
+       record[RECORD_PATH] >= view->length)
+      return NULL;
+
+   path = view->base + record[RECORD_PATH];
+   end = (const char *)memchr(path, '\0',
+                              view->length - (size_t)record[RECORD_PATH]);
+   if (end == NULL || record[RECORD_NAME] > (unsigned long)(end - path))
+      return NULL;
+
+   return path + record[RECORD_NAME];
+}
+
+/* Compares the length bytes at component with the name name, in the
+   order of strcmp */
+static int Image_compare(const char *component, size_t length,
+                         const char *name) {
+   int result = strncmp(component, name, length);
+
+   if (result != 0)
+      return result;
+
+   return name[length] == '\0' ? 0 : -1;
+}
+
+/* Looks for the child of kind kind named by the length bytes at name
+   of the directory whose record is at dir in view, and stores the
+   offset of its record in *pChild. Returns SUCCESS if found,
+   NO_SUCH_PATH if not, and IMAGE_TORN if a record is not in view. */
+static int Image_findChild(const struct view *view, unsigned long dir,
+                           const char *name, size_t length, int kind,
+                           unsigned long *pChild) {
+   const unsigned long *words;
+   const char *childName;
+   size_t first;
+   size_t low = 0;
+   size_t high;
+   size_t middle;
+   int comparison;
+
+   words = Image_getRecord(view, dir, DIR_WORDS);
+   if (words == NULL || words[RECORD_KIND] != IMAGE_DIR ||
+       words[DIR_NUM_FILES] > view->length / WORD ||
+       words[DIR_NUM_DIRS] > view->length / WORD)
+      return IMAGE_TORN;
+
+   words = Image_getRecord(view, dir, DIR_WORDS +
+                           (size_t)words[DIR_NUM_FILES] +
+                           (size_t)words[DIR_NUM_DIRS]);
+   if (words == NULL)
+      return IMAGE_TORN;
+
+   first = DIR_WORDS;
+   high = (size_t)words[DIR_NUM_FILES];
+   if (kind == IMAGE_DIR) {
+      first += high;
+      high = (size_t)words[DIR_NUM_DIRS];
+   }
+
+   /* the children of each kind are in order by name */
+   while (low < high) {
+      middle = low + (high - low) / 2;
+      childName = Image_getName(view, words[first + middle], kind);
+      if (childName == NULL)
+         return IMAGE_TORN;
+
+      comparison = Image_compare(name, length, childName);
+      if (comparison == 0) {
+         *pChild = words[first + middle];
+         return SUCCESS;
+      }
+      if (comparison < 0)
+         high = middle;
+      else
+         low = middle + 1;
+   }
+
+   return NO_SUCH_PATH;
+}
+
+/* Looks path up in view, as Image_lookUp does, storing what it finds
+   in *type and *length. Returns IMAGE_TORN if a record is not in
+   view, and what Image_lookUp does otherwise. */
+static int Image_find(const struct view *view, const char *path,
+                      boolean *type, size_t *length, void *buffer,
+                      size_t size) {
+   const unsigned long *header = (const unsigned long *)view->base;
+   const unsigned long *file;
+   unsigned long dir;
+   unsigned long child;
+   const char *rootName;
+   size_t start;
+   size_t end;
+   size_t rootLength;
+   int result;
+
+   dir = header[HEADER_ROOT];
+   if (dir == 0)
+      return NO_SUCH_PATH;
+
+   /* the root's name is its whole path */
+   rootName = Image_getName(view, dir, IMAGE_DIR);
+   if (rootName == NULL)
+      return IMAGE_TORN;
+
+   rootLength = strlen(rootName);
+   if (strncmp(path, rootName, rootLength) != EQUAL ||
+       (path[rootLength] != '\0' && path[rootLength] != '/'))
+      return NO_SUCH_PATH;
+
+   for (end = rootLength; path[end] != '\0'; ) {
+      start = end + 1;
+      for (end = start; path[end] != '\0' && path[end] != '/'; end++)
+         ;
+      if (end == start)
+         return NO_SUCH_PATH;
+
+      result = Image_findChild(view, dir, path + start, end - start,
+                               IMAGE_DIR, &child);
+      if (result == SUCCESS) {
+         dir = child;
+         continue;
+      }
+      if (result != NO_SUCH_PATH || path[end] != '\0')
+         return result;
+
+      /* only the last component may be a file */
+      result = Image_findChild(view, dir, path + start, end - start,
+                               IMAGE_FILE, &child);
+      if (result != SUCCESS)
+         return result;
+
+      file = Image_getRecord(view, child, FILE_WORDS);
+      if (file == NULL)
+         return IMAGE_TORN;
+
+      *type = TRUE;
+      *length = (size_t)file[FILE_LENGTH];
+      if (buffer != NULL && file[FILE_CONTENTS] != 0) {
+         if (size > *length)
+            size = *length;
+         if (file[FILE_CONTENTS] > view->length ||
+             size > view->length - (size_t)file[FILE_CONTENTS])
+            return IMAGE_TORN;
+         memcpy(buffer, view->base + file[FILE_CONTENTS], size);
+      }
+      return SUCCESS;
+   }
+
+   *type = FALSE;
+   return SUCCESS;
+}
+
+#if defined(__GNUC__) && defined(__unix__)
+
+/* Maps all of the file of image, in place of what it mapped before.
+   Returns FALSE, leaving that mapped, if unable to, and TRUE
+   otherwise. */
+static boolean Image_map(struct FT_Image *image) {
+   struct stat status;
+   void *map;
+
+   if (fstat(image->fd, &status) != 0 ||
+       (size_t)status.st_size < HEADER_WORDS * WORD)
+      return FALSE;
+
+   map = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED,
+              image->fd, 0);
+   if (map == MAP_FAILED)
+      return FALSE;
+
+   if (image->map != NULL)
+      (void) munmap(image->map, image->mapped);
+   image->map = (char *)map;
+   image->mapped = (size_t)status.st_size;
+   return TRUE;
+}
+
+/* see image.h for specification */
+int Image_publish(Image_T image, const char *filename) {
+   unsigned long *header;
+   unsigned long sequence;
+   struct flock lock;
+   struct stat status;
+   size_t mapped;
+   void *map;
+   int fd;
+   int result = MEMORY_ERROR;
+
+   assert(image != NULL);
+   assert(filename != NULL);
+
+   Image_getWords(image, 0)[HEADER_LENGTH] = (unsigned long)image->length;
+
+   fd = open(filename, O_RDWR | O_CREAT, 0666);
+   if (fd < 0)
+      return MEMORY_ERROR;
+
+   /* writers in other processes wait until the file is closed */
+   memset(&lock, 0, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+   if (fcntl(fd, F_SETLKW, &lock) != 0 || fstat(fd, &status) != 0) {
+      (void) close(fd);
+      return MEMORY_ERROR;
+   }
+
+   /* the file only grows, so that no reader maps past its end */
+   mapped = (size_t)status.st_size;
+   if (mapped < image->length) {
+      if (ftruncate(fd, (off_t)image->length) != 0) {
+         (void) close(fd);
+         return MEMORY_ERROR;
+      }
+      mapped = image->length;
+   }
+
+   map = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (map != MAP_FAILED) {
+      header = (unsigned long *)map;
+
+      /* a writer that died while writing left the count odd */
+      sequence = header[HEADER_MAGIC] == IMAGE_MAGIC ?
+         header[HEADER_SEQUENCE] : 0;
+      if (sequence % 2 == 0)
+         sequence++;
+      __atomic_store_n(&header[HEADER_SEQUENCE], sequence,
+                       __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+
+      memcpy((char *)map + HEADER_WORDS * WORD,
+             image->bytes + HEADER_WORDS * WORD,
+             image->length - HEADER_WORDS * WORD);
+      header[HEADER_MAGIC] = IMAGE_MAGIC;
+      header[HEADER_LENGTH] = image->length;
+      header[HEADER_ROOT] = Image_getWords(image, 0)[HEADER_ROOT];
+
+      __atomic_store_n(&header[HEADER_SEQUENCE], sequence + 1,
+                       __ATOMIC_RELEASE);
+      (void) munmap(map, mapped);
+      result = SUCCESS;
+   }
+
+   (void) close(fd);
+   return result;
+}
+
+/* see image.h for specification */
+struct FT_Image *Image_open(const char *filename) {
+   struct FT_Image *image;
+
+   assert(filename != NULL);
+
+   image = (struct FT_Image *)calloc(1, sizeof(struct FT_Image));
+   if (image == NULL)
+      return NULL;
+
+   image->fd = open(filename, O_RDONLY);
+   if (image->fd < 0) {
+      free(image);
+      return NULL;
+   }
+
+   if (!Image_map(image) ||
+       ((const unsigned long *)image->map)[HEADER_MAGIC] != IMAGE_MAGIC) {
+      Image_close(image);
+      return NULL;
+   }
+
+   return image;
+}
+
+/* see image.h for specification */
+void Image_close(struct FT_Image *image) {
+   assert(image != NULL);
+
+   if (image->map != NULL)
+      (void) munmap(image->map, image->mapped);
+   (void) close(image->fd);
+   free(image);
+}
+
+/* see image.h for specification */
+int Image_lookUp(struct FT_Image *image, const char *path,
+                 boolean *type, size_t *length, void *buffer,
+                 size_t size) {
+   const unsigned long *header;
+   unsigned long before;
+   struct view view;
+   boolean foundType = FALSE;
+   size_t foundLength = 0;
+   int result;
+
+   assert(image != NULL);
+   assert(path != NULL);
+
+   for (;;) {
+      header = (const unsigned long *)image->map;
+      before = __atomic_load_n(&header[HEADER_SEQUENCE],
+                               __ATOMIC_ACQUIRE);
+
+      /* the writer is changing the image */
+      if (before % 2 != 0) {
+         (void) sched_yield();
+         continue;
+      }
+
+      /* the image outgrew the file when it was mapped */
+      view.length = (size_t)header[HEADER_LENGTH];
+      if (view.length > image->mapped) {
+         if (!Image_map(image))
+            return MEMORY_ERROR;
+         continue;
+      }
+
+      view.base = image->map;
+      result = Image_find(&view, path, &foundType, &foundLength,
+                          buffer, size);
+
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&header[HEADER_SEQUENCE],
+                          __ATOMIC_RELAXED) == before)
+         break;
+   }
+
+   /* an image that is not well formed while it is not changing is
+      not one FT_publishImage wrote */
+   if (result == IMAGE_TORN)
+      return CONFLICTING_PATH;
+
+   if (result == SUCCESS) {
+      *type = foundType;
+      if (foundType)
+         *length = foundLength;
+   }
+
+   return result;
+}
+
+#else
+
+/* Without POSIX mappings, images are never written nor read */
+
+/* see image.h for specification */
+int Image_publish(Image_T image, const char *filename) {
+   assert(image != NULL);
+   assert(filename != NULL);
+
+   return MEMORY_ERROR;
+}
+
+/* see image.h for specification */
+struct FT_Image *Image_open(const char *filename) {
+   assert(filename != NULL);
+
+   return NULL;
+}
+
+/* see image.h for specification */
+void Image_close(struct FT_Image *image) {
+   assert(image != NULL);
+}
+
+/* see image.h for specification */
+int Image_lookUp(struct FT_Image *image, const char *path,
+                 boolean *type, size_t *length, void *buffer,
+                 size_t size) {
+   assert(image != NULL);
+   assert(path != NULL);
+
+   return NO_SUCH_PATH;
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*--------------------------------------------------------------------*/
+/* image.h                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef IMAGE_INCLUDED
+#define IMAGE_INCLUDED
+
+#include <stddef.h>
+#include "ft.h"
+
+/*
+   The Image module builds the images of the tree that FT_publishImage
+   writes to a file, and looks paths up in them, in place, for the
+   processes that map the file (see FT_openImage).
+
+   An image is an array of words (unsigned longs) and bytes in which
+   records are linked by their offsets from its start rather than by
+   pointers, so that it means the same wherever it is mapped. It
+   starts with a header: IMAGE_MAGIC, the sequence count of the file,
+   the length of the image in bytes, and the offset of the root's
+   record, 0 if the tree is empty. A directory's record holds
+   IMAGE_DIR, the offset of its path, the index of its name in the
+   path, its numbers of files and of directories, and then the offsets
+   of the records of its files and of its directories, each in order
+   by name. A file's record holds IMAGE_FILE, the offset of its path,
+   the index of its name, the length of its contents, and their
+   offset, 0 if they are NULL. Records, paths and contents each start
+   on a word.
+
+   The writer makes the sequence count odd before changing the image
+   in the file and even after, so that a reader that saw the same even
+   count before and after looking a path up knows that it was not
+   changed meanwhile, and looks it up again otherwise. Readers check
+   every offset they follow, so that an image changed under them can
+   make them look again, but never read outside it.
+*/
+
+/* The first word of an image, "FTI1" in ASCII */
+#define IMAGE_MAGIC 0x31495446UL
+
+/* The kinds of records of an image */
+enum {IMAGE_DIR = 1, IMAGE_FILE};
+
+/* An image being built */
+typedef struct Image *Image_T;
+
+/*
+   Returns a new image of an empty tree, or NULL if unable to allocate
+   sufficient memory.
+*/
+Image_T Image_new(void);
+
+/*
+   Frees image.
+*/
+void Image_free(Image_T image);
+
+/*
+   Adds to image the record of the directory at path, with numFiles
+   files and numDirs directories, which Image_setChild then sets.
+   Returns its offset, or 0 if unable to allocate sufficient memory.
+*/
+unsigned long Image_addDir(Image_T image, const char *path,
+                           size_t numFiles, size_t numDirs);
+
+/*
+   Adds to image the record of the file at path, with the length
+   bytes of contents, or NULL contents.
+   Returns its offset, or 0 if unable to allocate sufficient memory.
+*/
+unsigned long Image_addFile(Image_T image, const char *path,
+                            const void *contents, size_t length);
+
+/*
+   Sets the index-th child of the directory of image whose record is
+   at dir, its files first and then its directories, to the record at
+   child.
+*/
+void Image_setChild(Image_T image, unsigned long dir, size_t index,
+                    unsigned long child);
+
+/*
+   Makes the directory whose record is at dir the root of image.
+*/
+void Image_setRoot(Image_T image, unsigned long dir);
+
+/*
+   Writes image to the file filename, creating it if needed, holding
+   the lock on the file that keeps other writers out meanwhile.
+   Returns MEMORY_ERROR if unable to, and SUCCESS otherwise.
+*/
+int Image_publish(Image_T image, const char *filename);
+
+/*
+   Maps the file filename, as FT_openImage does.
+*/
+struct FT_Image *Image_open(const char *filename);
+
+/*
+   Unmaps image, as FT_closeImage does.
+*/
+void Image_close(struct FT_Image *image);
+
+/*
+   Looks path up in image, as FT_imageStat and FT_imageReadFile do:
+   copies up to size bytes of the contents of a file into buffer if
+   buffer is not NULL.
+*/
+int Image_lookUp(struct FT_Image *image, const char *path,
+                 boolean *type, size_t *length, void *buffer,
+                 size_t size);
+
+#endif
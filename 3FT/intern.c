@@ -0,0 +1,223 @@
+/*--------------------------------------------------------------------*/
+/* intern.c                                                           */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "intern.h"
+#include "lock.h"
+
+/*
+   An entry holds one interned name. Its bytes (with a '\0') are
+   allocated right after the struct, so an entry's address can be
+   recovered from the address of its name.
+*/
+struct entry {
+   /* the hash of this entry's name */
+   unsigned long hash;
+
+   /* the length of this entry's name, not counting the '\0' */
+   size_t length;
+
+   /* the number of references to this entry */
+   size_t refCount;
+
+   /* the next entry in the same bucket */
+   struct entry *next;
+};
+
+/* The minimum (and initial) number of buckets in the table */
+static const size_t MIN_BUCKETS = 256;
+
+/* Intern is an AO with the following state variables: */
+
+/* the hash table of entries, chained by bucket, NULL if unallocated */
+static struct entry **buckets;
+/* the number of buckets in the table */
+static size_t numBuckets;
+/* the number of entries in the table */
+static size_t numNames;
+/* the bytes held by all names, counting their '\0' */
+static size_t storedBytes;
+/* the bytes held by the table: its buckets, and its entries with
+   their names */
+static size_t tableBytes;
+/* the number of lookups, and of those that found their name */
+static size_t numLookups;
+static size_t numHits;
+/* the lock of the table, which writers changing different
+   directories share */
+static struct Lock tableLock;
+
+
+/* Returns the name of entry */
+static char *Intern_nameOf(struct entry *entry) {
+   assert(entry != NULL);
+   return (char *)(entry + 1);
+}
+
+/* Returns the entry whose name is at name */
+static struct entry *Intern_entryOf(const char *name) {
+   assert(name != NULL);
+   return ((struct entry *)name) - 1;
+}
+
+/* Doubles the number of buckets, rehashing every entry. If unable to
+   allocate sufficient memory, leaves the table unchanged. */
+static void Intern_grow(void) {
+   struct entry **newBuckets;
+   struct entry *entry;
+   struct entry *next;
+   size_t newNum = 2 * numBuckets;
+   size_t i;
+   size_t b;
+
+   newBuckets = (struct entry **)calloc(newNum, sizeof(struct entry *));
+   if (newBuckets == NULL)
+      return;
+
+   for (i = 0; i < numBuckets; i++) {
+      for (entry = buckets[i]; entry != NULL; entry = next) {
+         next = entry->next;
+         b = entry->hash % newNum;
+         entry->next = newBuckets[b];
+         newBuckets[b] = entry;
+      }
+   }
+
+   free(buckets);
+   buckets = newBuckets;
+   tableBytes += (newNum - numBuckets) * sizeof(struct entry *);
+   numBuckets = newNum;
+}
+
+/* Does Intern_acquire (see intern.h) while holding tableLock */
+static const char *Intern_doAcquire(const char *name, size_t length,
+                                    unsigned long hash) {
+   struct entry *entry;
+   size_t b;
+
+   assert(name != NULL);
+
+   if (buckets == NULL) {
+      buckets = (struct entry **)calloc(MIN_BUCKETS,
+                                        sizeof(struct entry *));
+      if (buckets == NULL)
+         return NULL;
+      numBuckets = MIN_BUCKETS;
+      tableBytes += MIN_BUCKETS * sizeof(struct entry *);
+   }
+
+   numLookups++;
+   b = hash % numBuckets;
+
+   for (entry = buckets[b]; entry != NULL; entry = entry->next) {
+      if (entry->hash == hash && entry->length == length &&
+          strncmp(Intern_nameOf(entry), name, length) == EQUAL) {
+         numHits++;
+         break;
+      }
+   }
+
+   if (entry == NULL) {
+      entry = (struct entry *)malloc(sizeof(struct entry) + length + 1);
+      if (entry == NULL)
+         return NULL;
+
+      entry->hash = hash;
+      entry->length = length;
+      entry->refCount = 0;
+      memcpy(Intern_nameOf(entry), name, length);
+      Intern_nameOf(entry)[length] = '\0';
+
+      entry->next = buckets[b];
+      buckets[b] = entry;
+      numNames++;
+      storedBytes += length + 1;
+      tableBytes += sizeof(struct entry) + length + 1;
+
+      if (numNames > numBuckets)
+         Intern_grow();
+   }
+
+   entry->refCount++;
+
+   return Intern_nameOf(entry);
+}
+
+/* Does Intern_release (see intern.h) while holding tableLock */
+static void Intern_doRelease(const char *name) {
+   struct entry *entry;
+   struct entry **link;
+
+   entry = Intern_entryOf(name);
+   assert(entry->refCount > 0);
+
+   entry->refCount--;
+
+   if (entry->refCount > 0)
+      return;
+
+   link = &buckets[entry->hash % numBuckets];
+   while (*link != entry)
+      link = &(*link)->next;
+   *link = entry->next;
+
+   numNames--;
+   storedBytes -= entry->length + 1;
+   tableBytes -= sizeof(struct entry) + entry->length + 1;
+   free(entry);
+}
+
+/* see intern.h for specification */
+const char *Intern_acquire(const char *name, size_t length,
+                           unsigned long hash) {
+   const char *interned;
+
+   assert(name != NULL);
+
+   Lock_acquire(&tableLock);
+   interned = Intern_doAcquire(name, length, hash);
+   Lock_release(&tableLock);
+
+   return interned;
+}
+
+/* see intern.h for specification */
+void Intern_release(const char *name) {
+   if (name == NULL)
+      return;
+
+   Lock_acquire(&tableLock);
+   Intern_doRelease(name);
+   Lock_release(&tableLock);
+}
+
+/* see intern.h for specification */
+void Intern_destroy(void) {
+   assert(numNames == 0);
+
+   free(buckets);
+   buckets = NULL;
+   numBuckets = 0;
+   tableBytes = 0;
+   numLookups = 0;
+   numHits = 0;
+}
+
+/* see intern.h for specification */
+void Intern_getStats(size_t *pNumLookups, size_t *pNumHits,
+                     size_t *pNumNames, size_t *pStoredBytes,
+                     size_t *pTableBytes) {
+   assert(pNumLookups != NULL);
+   assert(pNumHits != NULL);
+   assert(pNumNames != NULL);
+   assert(pStoredBytes != NULL);
+   assert(pTableBytes != NULL);
+
+   *pNumLookups = numLookups;
+   *pNumHits = numHits;
+   *pNumNames = numNames;
+   *pStoredBytes = storedBytes;
+   *pTableBytes = tableBytes;
+}
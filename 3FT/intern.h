@@ -0,0 +1,54 @@
+/*--------------------------------------------------------------------*/
+/* intern.h                                                           */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef INTERN_INCLUDED
+#define INTERN_INCLUDED
+
+#include <stddef.h>
+
+/*
+   Intern is an AO that keeps a single reference-counted copy of each
+   distinct path component (directory or file name) in the tree, so
+   that two nodes have equal names if and only if they hold the same
+   name pointer. The names are held in addition to the full paths
+   that directories and files keep, so the table costs memory rather
+   than saving it, in exchange for comparing names by pointer.
+*/
+
+/*
+   Returns the interned copy of the length bytes at name (which need
+   not be '\0'-terminated), whose hash is hash (the hash of its
+   NameKey, see namekey.h), adding one reference to it, or NULL if
+   unable to allocate sufficient memory. The returned string is
+   '\0'-terminated and must not be modified.
+*/
+const char *Intern_acquire(const char *name, size_t length,
+                           unsigned long hash);
+
+/*
+   Drops one reference to name, a string returned by Intern_acquire,
+   freeing it if that was its last reference.
+*/
+void Intern_release(const char *name);
+
+/*
+   Frees the table of names, which must hold no names, and resets the
+   statistics. The table is allocated again by the next
+   Intern_acquire.
+*/
+void Intern_destroy(void);
+
+/*
+   Stores in *pNumLookups the number of calls to Intern_acquire, in
+   *pNumHits the number of those that found the name already interned,
+   in *pNumNames the number of distinct names held, in *pStoredBytes
+   the bytes of those names, and in *pTableBytes all the bytes the
+   table holds: its buckets, and its entries with their names.
+*/
+void Intern_getStats(size_t *pNumLookups, size_t *pNumHits,
+                     size_t *pNumNames, size_t *pStoredBytes,
+                     size_t *pTableBytes);
+
+#endif
@@ -0,0 +1,134 @@
+/*--------------------------------------------------------------------*/
+/* lock.c                                                             */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+/* sched_yield is POSIX, not ANSI C */
+#define _POSIX_C_SOURCE 199309L
+
+#include "defs.h"
+#include "lock.h"
+
+/* The Lock AO has 1 state variable: */
+
+/* whether Lock is active */
+boolean Lock_isActive;
+
+#if defined(__GNUC__)
+
+#include <sched.h>
+
+/* The times a thread checks a held lock before letting another
+   thread run, which may be the one holding it */
+enum {MAX_SPINS = 100};
+
+/* the next shard to give a thread */
+static size_t nextShard;
+/* the calling thread's shard plus 1, or 0 until it asks for one */
+static __thread size_t myShard;
+
+/* see lock.h for specification */
+void Lock_setActive(boolean enabled) {
+   Lock_isActive = enabled;
+}
+
+/* see lock.h for specification */
+void Lock_clear(struct Lock *lock) {
+   assert(lock != NULL);
+
+   lock->held = 0;
+}
+
+/* see lock.h for specification */
+void Lock_acquire(struct Lock *lock) {
+   int spins;
+
+   assert(lock != NULL);
+
+   if (!Lock_isActive)
+      return;
+
+   /* waits reading rather than writing the lock, so that the holder
+      keeps its cache line */
+   while (__atomic_exchange_n(&lock->held, 1, __ATOMIC_ACQUIRE) != 0) {
+      spins = 0;
+      while (__atomic_load_n(&lock->held, __ATOMIC_RELAXED) != 0) {
+         if (++spins == MAX_SPINS) {
+            (void) sched_yield();
+            spins = 0;
+         }
+      }
+   }
+}
+
+/* see lock.h for specification */
+boolean Lock_tryAcquire(struct Lock *lock) {
+   assert(lock != NULL);
+
+   if (!Lock_isActive)
+      return TRUE;
+
+   return (boolean)(__atomic_load_n(&lock->held, __ATOMIC_RELAXED) == 0 &&
+                    __atomic_exchange_n(&lock->held, 1,
+                                        __ATOMIC_ACQUIRE) == 0);
+}
+
+/* see lock.h for specification */
+void Lock_release(struct Lock *lock) {
+   assert(lock != NULL);
+
+   if (!Lock_isActive)
+      return;
+
+   assert(__atomic_load_n(&lock->held, __ATOMIC_RELAXED) != 0);
+   __atomic_store_n(&lock->held, 0, __ATOMIC_RELEASE);
+}
+
+/* see lock.h for specification */
+size_t Lock_getShard(void) {
+   if (myShard == 0)
+      myShard = __atomic_fetch_add(&nextShard, 1, __ATOMIC_RELAXED) %
+         LOCK_NUM_SHARDS + 1;
+
+   return myShard - 1;
+}
+
+#else
+
+/* Without atomic builtins, Lock is never active */
+
+/* see lock.h for specification */
+void Lock_setActive(boolean enabled) {
+   (void) enabled;
+}
+
+/* see lock.h for specification */
+void Lock_clear(struct Lock *lock) {
+   assert(lock != NULL);
+
+   lock->held = 0;
+}
+
+/* see lock.h for specification */
+void Lock_acquire(struct Lock *lock) {
+   assert(lock != NULL);
+}
+
+/* see lock.h for specification */
+boolean Lock_tryAcquire(struct Lock *lock) {
+   assert(lock != NULL);
+
+   return TRUE;
+}
+
+/* see lock.h for specification */
+void Lock_release(struct Lock *lock) {
+   assert(lock != NULL);
+}
+
+/* see lock.h for specification */
+size_t Lock_getShard(void) {
+   return 0;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*--------------------------------------------------------------------*/
+/* lock.h                                                             */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef LOCK_INCLUDED
+#define LOCK_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+   Lock is an AO of locks small enough for every directory to have
+   its own, so that writers changing different directories do not
+   wait for one another. While Lock is not active, acquiring and
+   releasing a lock do nothing, so that a single writer pays nothing
+   for them.
+*/
+
+/*
+   A struct Lock is a lock, which Lock_clear leaves free, as does
+   static initialization
+*/
+struct Lock {
+   /* 1 if a thread holds the lock, 0 otherwise */
+   int held;
+};
+
+/* whether Lock is active; only Lock_setActive may change it */
+extern boolean Lock_isActive;
+
+/*
+   Makes Lock active if enabled is TRUE and the compiler provides
+   GCC's atomic builtins, and inactive otherwise. No lock may be held.
+*/
+void Lock_setActive(boolean enabled);
+
+/*
+   Makes lock free.
+*/
+void Lock_clear(struct Lock *lock);
+
+/*
+   Waits until lock is free, then holds it until Lock_release(lock).
+   Locks are not recursive.
+*/
+void Lock_acquire(struct Lock *lock);
+
+/*
+   Holds lock, as Lock_acquire does, if it is free, and returns TRUE,
+   or returns FALSE at once if it is not.
+*/
+boolean Lock_tryAcquire(struct Lock *lock);
+
+/*
+   Frees lock, which the calling thread holds.
+*/
+void Lock_release(struct Lock *lock);
+
+/*
+   Lock_add(lvalue, delta) and Lock_sub(lvalue, delta) add delta to
+   and subtract it from the size_t lvalue, atomically while Lock is
+   active, so that writers holding different locks may share it.
+*/
+#if defined(__GNUC__)
+#define Lock_add(lvalue, delta)                                        \
+   (Lock_isActive ?                                                    \
+    (void)__atomic_fetch_add(&(lvalue), (delta), __ATOMIC_RELAXED) :   \
+    (void)((lvalue) += (delta)))
+#define Lock_sub(lvalue, delta)                                        \
+   (Lock_isActive ?                                                    \
+    (void)__atomic_fetch_sub(&(lvalue), (delta), __ATOMIC_RELAXED) :   \
+    (void)((lvalue) -= (delta)))
+#else
+#define Lock_add(lvalue, delta) ((void)((lvalue) += (delta)))
+#define Lock_sub(lvalue, delta) ((void)((lvalue) -= (delta)))
+#endif
+
+/*
+   Returns the calling thread's shard, below LOCK_NUM_SHARDS, of the
+   counters that writers update so often that they would contend for
+   a single one. Threads are spread over the shards, but two of them
+   may share one, which they must then update with Lock_add.
+*/
+size_t Lock_getShard(void);
+enum {LOCK_NUM_SHARDS = 16};
+
+/* The size of a cache line, to which shards are padded so that
+   updating one does not slow down the threads of the others */
+enum {LOCK_CACHE_LINE = 64};
+
+#endif
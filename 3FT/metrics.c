@@ -0,0 +1,142 @@
+/*--------------------------------------------------------------------*/
+/* metrics.c                                                          */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not ANSI C */
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+#include "defs.h"
+#include "metrics.h"
+
+#ifndef FT_NO_METRICS
+
+/* The Metrics AO has 3 state variables: */
+
+/* the calls, statuses, and latencies of each operation, in a shard
+   per thread (see Lock_getShard) */
+static struct FT_OpMetrics ops[LOCK_NUM_SHARDS][FT_NUM_OPERATIONS];
+/* the counts of internal events, sharded the same way */
+union Metrics_Shard Metrics_shards[LOCK_NUM_SHARDS];
+/* whether several threads may update the shards at once */
+boolean Metrics_isShared = FALSE;
+
+/* Adds delta to the lvalue of a shard, atomically while Metrics is
+   shared, since two threads may then share a shard */
+#if defined(__GNUC__)
+#define Metrics_add(lvalue, delta)                                     \
+   (Metrics_isShared ?                                                 \
+    (void)__atomic_fetch_add(&(lvalue), (delta), __ATOMIC_RELAXED) :   \
+    (void)((lvalue) += (delta)))
+#else
+#define Metrics_add(lvalue, delta) ((void)((lvalue) += (delta)))
+#endif
+
+/* see metrics.h for specification */
+unsigned long Metrics_start(void) {
+
+   struct timespec now;
+
+   if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+      return 0;
+
+   /* may wrap around, but differences stay right */
+   return (unsigned long)now.tv_sec * 1000000000UL +
+      (unsigned long)now.tv_nsec;
+}
+
+/* see metrics.h for specification */
+void Metrics_end(enum FT_Operation op, int status,
+                 unsigned long start) {
+
+   struct FT_OpMetrics *shard;
+   unsigned long nanos;
+   size_t bucket = 0;
+
+   assert((int)op >= 0 && op < FT_NUM_OPERATIONS);
+
+   /* a call whose start could not be read has no timestamp */
+   if (start == 0)
+      return;
+
+   nanos = Metrics_start() - start;
+
+   /* bucket i holds latencies of 2^i to 2^(i+1) - 1 nanoseconds */
+   while (nanos >> (bucket + 1) != 0 &&
+          bucket < FT_NUM_LATENCY_BUCKETS - 1)
+      bucket++;
+
+   shard = &ops[Metrics_isShared ? Lock_getShard() : 0][op];
+   Metrics_add(shard->numCalls, 1);
+   Metrics_add(shard->latency[bucket], 1);
+   Metrics_add(shard->totalNanos, nanos);
+
+   if (status >= 0 && status < FT_NUM_STATUSES)
+      Metrics_add(shard->numByStatus[status], 1);
+}
+
+/* see metrics.h for specification */
+void Metrics_setShared(boolean shared) {
+   Metrics_isShared = shared;
+}
+
+/* see metrics.h for specification */
+void Metrics_get(struct FT_Metrics *metrics) {
+
+   struct FT_OpMetrics *sum;
+   struct FT_OpMetrics *shard;
+   size_t i;
+   size_t op;
+   size_t j;
+
+   assert(metrics != NULL);
+
+   memset(metrics, 0, sizeof(*metrics));
+
+   for (i = 0; i < LOCK_NUM_SHARDS; i++) {
+      for (op = 0; op < FT_NUM_OPERATIONS; op++) {
+         sum = &metrics->ops[op];
+         shard = &ops[i][op];
+         sum->numCalls += shard->numCalls;
+         for (j = 0; j < FT_NUM_STATUSES; j++)
+            sum->numByStatus[j] += shard->numByStatus[j];
+         for (j = 0; j < FT_NUM_LATENCY_BUCKETS; j++)
+            sum->latency[j] += shard->latency[j];
+         sum->totalNanos += shard->totalNanos;
+      }
+
+      metrics->nodesVisited +=
+         Metrics_shards[i].counters[METRICS_NODES_VISITED];
+      metrics->comparisons +=
+         Metrics_shards[i].counters[METRICS_COMPARISONS];
+      metrics->allocations +=
+         Metrics_shards[i].counters[METRICS_ALLOCATIONS];
+   }
+
+   metrics->enabled = TRUE;
+}
+
+/* see metrics.h for specification */
+void Metrics_reset(void) {
+
+   memset(ops, 0, sizeof(ops));
+   memset(Metrics_shards, 0, sizeof(Metrics_shards));
+}
+
+#else
+
+/* see metrics.h for specification */
+void Metrics_get(struct FT_Metrics *metrics) {
+
+   assert(metrics != NULL);
+
+   memset(metrics, 0, sizeof(*metrics));
+   metrics->enabled = FALSE;
+}
+
+/* see metrics.h for specification */
+void Metrics_reset(void) {
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*--------------------------------------------------------------------*/
+/* metrics.h                                                          */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef METRICS_INCLUDED
+#define METRICS_INCLUDED
+
+#include <stddef.h>
+#include "ft.h"
+#include "lock.h"
+
+/*
+   Metrics is an AO that counts the calls to each FT operation by
+   returned status, keeps a histogram of their latencies, and counts
+   internal events, for FT_getMetrics to report.
+
+   Compiling with FT_NO_METRICS defined turns every macro below into
+   a no-op, so the instrumentation costs nothing.
+*/
+
+/* the internal events that Metrics counts */
+enum Metrics_Counter {
+   METRICS_NODES_VISITED, METRICS_COMPARISONS, METRICS_ALLOCATIONS,
+   METRICS_NUM_COUNTERS
+};
+
+/* the status Metrics_end records for operations returning none */
+enum { METRICS_NO_STATUS = -1 };
+
+#ifdef FT_NO_METRICS
+
+#define Metrics_start() 0UL
+#define Metrics_end(op, status, start) ((void)(start))
+#define Metrics_count(counter) ((void)0)
+#define Metrics_setShared(shared) ((void)(shared))
+
+#else
+
+/* The counts of internal events, indexed by enum Metrics_Counter, of
+   the threads of one shard (see Lock_getShard), padded to a cache
+   line */
+union Metrics_Shard {
+   size_t counters[METRICS_NUM_COUNTERS];
+   char line[LOCK_CACHE_LINE];
+};
+
+/* the shards of the counts of internal events, and whether several
+   threads may update them at once; exposed only so that
+   Metrics_count can be a single increment */
+extern union Metrics_Shard Metrics_shards[LOCK_NUM_SHARDS];
+extern boolean Metrics_isShared;
+
+/*
+   Counts one event of the given enum Metrics_Counter.
+*/
+#if defined(__GNUC__)
+#define Metrics_count(counter)                                         \
+   (Metrics_isShared ?                                                 \
+    (void)__atomic_fetch_add(                                          \
+       &Metrics_shards[Lock_getShard()].counters[counter], 1,          \
+       __ATOMIC_RELAXED) :                                             \
+    (void)Metrics_shards[0].counters[counter]++)
+#else
+#define Metrics_count(counter)                                         \
+   ((void)Metrics_shards[0].counters[counter]++)
+#endif
+
+/*
+   Makes Metrics record the calls and events of each thread in its own
+   shard, atomically, if shared is TRUE, for when several threads may
+   be calling FT operations at once, and all of them in the first
+   shard otherwise, as it does initially.
+*/
+void Metrics_setShared(boolean shared);
+
+/*
+   Returns a timestamp for Metrics_end, in nanoseconds of a monotonic
+   clock, or 0 if the clock cannot be read.
+*/
+unsigned long Metrics_start(void);
+
+/*
+   Records a call to op that returned status (METRICS_NO_STATUS if op
+   returns no status) and that started at the timestamp start, if
+   start is not 0.
+*/
+void Metrics_end(enum FT_Operation op, int status, unsigned long start);
+
+#endif
+
+/*
+   Fills *metrics with everything recorded, in every shard, since the
+   program started or since the last Metrics_reset (all zero if
+   compiled out).
+*/
+void Metrics_get(struct FT_Metrics *metrics);
+
+/*
+   Discards everything recorded so far.
+*/
+void Metrics_reset(void);
+
+#endif
@@ -0,0 +1,89 @@
+/*--------------------------------------------------------------------*/
+/* namekey.c                                                          */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "namekey.h"
+
+/* The number of leading bytes held in a key */
+#define LEAD_BYTES sizeof(unsigned long)
+
+/* The FNV prime of the width of NAMEKEY_HASH_BASIS */
+#if ULONG_MAX > 0xFFFFFFFFUL
+#define HASH_PRIME 0x100000001b3UL
+#else
+#define HASH_PRIME 16777619UL
+#endif
+
+/* see namekey.h for specification */
+unsigned long NameKey_hash(unsigned long hash, const void *bytes,
+                           size_t length) {
+   const unsigned char *p = (const unsigned char *)bytes;
+   size_t i;
+
+   assert(bytes != NULL || length == 0);
+
+   for (i = 0; i < length; i++) {
+      hash ^= p[i];
+      hash *= HASH_PRIME;
+   }
+
+   return hash;
+}
+
+/* see namekey.h for specification */
+void NameKey_init(struct NameKey *key, const char *name,
+                  size_t length) {
+   const unsigned char *p = (const unsigned char *)name;
+   unsigned long lead = 0;
+   size_t i;
+
+   assert(key != NULL);
+   assert(name != NULL);
+
+   /* packs the leading bytes so that keys order as their names do */
+   for (i = 0; i < LEAD_BYTES; i++) {
+      lead <<= 8;
+      if (i < length)
+         lead |= p[i];
+   }
+
+   key->lead = lead;
+   key->hash = NameKey_hash(NAMEKEY_HASH_BASIS, name, length);
+   key->length = length;
+}
+
+/* see namekey.h for specification */
+int NameKey_compare(const struct NameKey *key1, const char *name1,
+                    const struct NameKey *key2, const char *name2) {
+   size_t shorter;
+   int cmp;
+
+   assert(key1 != NULL);
+   assert(key2 != NULL);
+
+   /* most names differ in their leading bytes */
+   if (key1->lead != key2->lead)
+      return key1->lead < key2->lead ? -1 : 1;
+
+   shorter = key1->length < key2->length ? key1->length : key2->length;
+
+   /* names with matching hashes and lengths are (almost surely) equal:
+      confirms it, so no other name is read in full */
+   if (key1->hash == key2->hash && key1->length == key2->length)
+      return memcmp(name1, name2, key1->length);
+
+   /* past the equal leading bytes, the first difference decides */
+   if (shorter > LEAD_BYTES) {
+      cmp = memcmp(name1 + LEAD_BYTES, name2 + LEAD_BYTES,
+                    shorter - LEAD_BYTES);
+      if (cmp != EQUAL)
+         return cmp;
+   }
+
+   /* otherwise, a name is less than the longer names it begins */
+   if (key1->length == key2->length)
+      return 0;
+   return key1->length < key2->length ? -1 : 1;
+}
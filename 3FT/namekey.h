@@ -0,0 +1,64 @@
+/*--------------------------------------------------------------------*/
+/* namekey.h                                                          */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef NAMEKEY_INCLUDED
+#define NAMEKEY_INCLUDED
+
+#include <stddef.h>
+#include <limits.h>
+
+/*
+   A NameKey summarizes a name (a path component, or the rest of a
+   path below a directory) so that most comparisons of names are
+   decided by their keys alone, without reading the names' bytes.
+   A directory or file keeps the key of its name next to it.
+*/
+struct NameKey {
+   /* the first bytes of the name (as many as an unsigned long holds),
+      first byte most significant, padded with 0 bytes */
+   unsigned long lead;
+
+   /* the hash of the name */
+   unsigned long hash;
+
+   /* the length of the name in bytes */
+   size_t length;
+};
+
+/* The hash of no bytes, from which NameKey_hash starts: the FNV-1a
+   offset basis of the width of unsigned long */
+#if ULONG_MAX > 0xFFFFFFFFUL
+#define NAMEKEY_HASH_BASIS 0xcbf29ce484222325UL
+#else
+#define NAMEKEY_HASH_BASIS 2166136261UL
+#endif
+
+/*
+   Returns the FNV-1a hash of the length bytes at bytes, continuing
+   from hash, the hash of the bytes before them (NAMEKEY_HASH_BASIS if
+   there are none). The hash takes the constants of 64-bit FNV-1a if
+   unsigned long has 64 bits, and those of 32-bit FNV-1a otherwise.
+   Every hash of bytes in the tree is this one.
+*/
+unsigned long NameKey_hash(unsigned long hash, const void *bytes,
+                           size_t length);
+
+/*
+   Stores in *key the key of the length bytes at name, which need not
+   be '\0'-terminated.
+*/
+void NameKey_init(struct NameKey *key, const char *name,
+                  size_t length);
+
+/*
+   Compares name1, whose key is *key1, with name2, whose key is *key2,
+   in the order of strcmp. Returns <0, 0 or >0 if name1 is less than,
+   equal to or greater than name2. The names need not be
+   '\0'-terminated.
+*/
+int NameKey_compare(const struct NameKey *key1, const char *name1,
+                    const struct NameKey *key2, const char *name2);
+
+#endif
@@ -0,0 +1,852 @@
+/*--------------------------------------------------------------------*/
+/* pathindex.c                                                        */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "a4def.h"
+#include "directory.h"
+#include "file.h"
+#include "pathindex.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+   The index is an adaptive radix trie (as in Leis et al., "The
+   Adaptive Radix Tree") whose keys are the bytes of a path followed
+   by its '\0', so no key is a prefix of another and values are always
+   in leaves. A leaf is not allocated: it is the pointer to the
+   directory or file itself, told apart from a pointer to an inner
+   node by its lowest bit, which is set for leaves, with its type in
+   the bit above. Its key is the path of the directory or file.
+*/
+
+/* The kinds of inner nodes, by their number of child slots */
+enum {NODE4, NODE16, NODE48, NODE256};
+
+/* The number of prefix bytes stored in an inner node. Longer prefixes
+   are checked against the key of a leaf below the node. */
+enum {MAX_PREFIX = 8};
+
+/* The header shared by all kinds of inner nodes, kept small since
+   there is about one inner node per leaf */
+struct inner {
+   /* the kind of this node */
+   unsigned char kind;
+
+   /* the number of children of this node, at most 256 */
+   unsigned short numChildren;
+
+   /* the length of the compressed prefix of this node */
+   unsigned int prefixLen;
+
+   /* the first (up to MAX_PREFIX) bytes of the compressed prefix */
+   unsigned char prefix[MAX_PREFIX];
+};
+
+/* An inner node with up to 4 children, sorted by key byte */
+struct node4 {
+   struct inner header;
+   unsigned char keys[4];
+   void *children[4];
+};
+
+/* An inner node with up to 16 children, sorted by key byte */
+struct node16 {
+   struct inner header;
+   unsigned char keys[16];
+   void *children[16];
+};
+
+/* An inner node with up to 48 children, indexed by key byte
+   (slot + 1, or 0 for none) */
+struct node48 {
+   struct inner header;
+   unsigned char slots[256];
+   void *children[48];
+};
+
+/* An inner node with a child slot for each key byte */
+struct node256 {
+   struct inner header;
+   void *children[256];
+};
+
+/* A PathIndex is the root of the trie */
+struct PathIndex {
+   /* the root node (inner or leaf), NULL if the index is empty */
+   void *root;
+};
+
+/* The bytes held by all indexes, their inner nodes included */
+static size_t indexBytes;
+
+
+/* Returns TRUE if node is a (tagged) leaf */
+static boolean PathIndex_isLeaf(const void *node) {
+   return (boolean)(((size_t)node & 1) != 0);
+}
+
+/* Returns the leaf for value, of the given type */
+static void *PathIndex_tag(void *value, int type) {
+   return (void *)((size_t)value | ((size_t)type << 1) | 1);
+}
+
+/* Returns the directory or file that leaf refers to */
+static void *PathIndex_valueOf(const void *leaf) {
+   return (void *)((size_t)leaf & ~(size_t)3);
+}
+
+/* Returns the type of the directory or file that leaf refers to */
+static int PathIndex_typeOf(const void *leaf) {
+   return (int)(((size_t)leaf >> 1) & 1);
+}
+
+/* Returns the key of leaf: the path of its directory or file */
+static const char *PathIndex_keyOf(const void *leaf) {
+   if (PathIndex_typeOf(leaf) == DIR)
+      return Dir_getPath((Dir_T)PathIndex_valueOf(leaf));
+   return File_getPath((File_T)PathIndex_valueOf(leaf));
+}
+
+/* Returns the byte of the length-byte key at depth, where the byte
+   just past the key is its terminating '\0' */
+static unsigned char PathIndex_byteAt(const char *key, size_t length,
+                                      size_t depth) {
+   if (depth < length)
+      return (unsigned char)key[depth];
+   return '\0';
+}
+
+/* Returns TRUE if leaf's key is the length-byte key */
+static boolean PathIndex_leafMatches(const void *leaf, const char *key,
+                                     size_t length) {
+   const char *leafKey = PathIndex_keyOf(leaf);
+
+   return (boolean)(strncmp(leafKey, key, length) == EQUAL &&
+                    leafKey[length] == '\0');
+}
+
+/* Returns the smaller of a and b */
+static size_t PathIndex_min(size_t a, size_t b) {
+   return a < b ? a : b;
+}
+
+/* Returns the size of an inner node of the given kind */
+static size_t PathIndex_nodeSize(int kind) {
+   switch (kind) {
+      case NODE4:   return sizeof(struct node4);
+      case NODE16:  return sizeof(struct node16);
+      case NODE48:  return sizeof(struct node48);
+      default:      return sizeof(struct node256);
+   }
+}
+
+/* Returns a new inner node of the given kind with no children and
+   no prefix, or NULL if unable to allocate sufficient memory */
+static struct inner *PathIndex_newNode(int kind) {
+   struct inner *node;
+
+   node = (struct inner *)calloc(1, PathIndex_nodeSize(kind));
+   if (node == NULL)
+      return NULL;
+
+   indexBytes += PathIndex_nodeSize(kind);
+   node->kind = (unsigned char)kind;
+   return node;
+}
+
+/* Frees the inner node node, but not its children */
+static void PathIndex_freeInner(struct inner *node) {
+   indexBytes -= PathIndex_nodeSize(node->kind);
+   free(node);
+}
+
+/* Copies the header of from (but its kind) to to */
+static void PathIndex_copyHeader(struct inner *to,
+                                 const struct inner *from) {
+   to->numChildren = from->numChildren;
+   to->prefixLen = from->prefixLen;
+   memcpy(to->prefix, from->prefix, MAX_PREFIX);
+}
+
+/* Returns the index of the child of the 16-way node with key byte c,
+   or its number of children if there is none */
+static size_t PathIndex_find16(const struct node16 *n,
+                               unsigned char c) {
+   size_t num = n->header.numChildren;
+#if defined(__SSE2__)
+   /* compares c against all 16 key bytes at once */
+   __m128i cmp;
+   unsigned int bits;
+#if !defined(__GNUC__)
+   size_t i;
+#endif
+
+   cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+                        _mm_loadu_si128((const __m128i *)n->keys));
+   bits = (unsigned int)_mm_movemask_epi8(cmp) & ((1U << num) - 1);
+   if (bits == 0)
+      return num;
+#if defined(__GNUC__)
+   return (size_t)__builtin_ctz(bits);
+#else
+   for (i = 0; (bits & 1U) == 0; i++)
+      bits >>= 1;
+   return i;
+#endif
+#else
+   size_t i;
+
+   for (i = 0; i < num; i++)
+      if (n->keys[i] == c)
+         return i;
+   return num;
+#endif
+}
+
+/* Returns the address of the child slot of node for key byte c, or
+   NULL if node has no such child */
+static void **PathIndex_findChild(struct inner *node, unsigned char c) {
+   struct node4 *n4;
+   struct node16 *n16;
+   struct node48 *n48;
+   struct node256 *n256;
+   size_t i;
+
+   switch (node->kind) {
+      case NODE4:
+         n4 = (struct node4 *)node;
+         for (i = 0; i < node->numChildren; i++)
+            if (n4->keys[i] == c)
+               return &n4->children[i];
+         return NULL;
+
+      case NODE16:
+         n16 = (struct node16 *)node;
+         i = PathIndex_find16(n16, c);
+         if (i < node->numChildren)
+            return &n16->children[i];
+         return NULL;
+
+      case NODE48:
+         n48 = (struct node48 *)node;
+         if (n48->slots[c] != 0)
+            return &n48->children[n48->slots[c] - 1];
+         return NULL;
+
+      default:
+         n256 = (struct node256 *)node;
+         if (n256->children[c] != NULL)
+            return &n256->children[c];
+         return NULL;
+   }
+}
+
+/* Returns the leaf with the smallest key below node */
+static const void *PathIndex_minimum(const void *node) {
+   const struct inner *inner;
+   const struct node48 *n48;
+   const struct node256 *n256;
+   size_t c;
+
+   while (!PathIndex_isLeaf(node)) {
+      inner = (const struct inner *)node;
+
+      switch (inner->kind) {
+         case NODE4:
+            node = ((const struct node4 *)inner)->children[0];
+            break;
+
+         case NODE16:
+            node = ((const struct node16 *)inner)->children[0];
+            break;
+
+         case NODE48:
+            n48 = (const struct node48 *)inner;
+            for (c = 0; n48->slots[c] == 0; c++)
+               ;
+            node = n48->children[n48->slots[c] - 1];
+            break;
+
+         default:
+            n256 = (const struct node256 *)inner;
+            for (c = 0; n256->children[c] == NULL; c++)
+               ;
+            node = n256->children[c];
+            break;
+      }
+   }
+
+   return node;
+}
+
+/* Returns the number of leading bytes of node's stored prefix that
+   match the length-byte key from depth on */
+static size_t PathIndex_checkPrefix(const struct inner *node,
+                                    const char *key, size_t length,
+                                    size_t depth) {
+   size_t max;
+   size_t i;
+
+   max = PathIndex_min(node->prefixLen, MAX_PREFIX);
+   for (i = 0; i < max; i++)
+      if (node->prefix[i] != PathIndex_byteAt(key, length, depth + i))
+         return i;
+
+   return max;
+}
+
+/* Returns the number of leading bytes of node's prefix that match
+   the length-byte key from depth on. Bytes beyond the stored prefix
+   are taken from a leaf below node. */
+static size_t PathIndex_prefixMismatch(const struct inner *node,
+                                       const char *key, size_t length,
+                                       size_t depth) {
+   const char *leafKey;
+   size_t i;
+
+   i = PathIndex_checkPrefix(node, key, length, depth);
+   if (i < PathIndex_min(node->prefixLen, MAX_PREFIX))
+      return i;
+
+   if (node->prefixLen > MAX_PREFIX) {
+      leafKey = PathIndex_keyOf(PathIndex_minimum(node));
+      for (; i < node->prefixLen; i++)
+         if ((unsigned char)leafKey[depth + i] !=
+             PathIndex_byteAt(key, length, depth + i))
+            return i;
+   }
+
+   return node->prefixLen;
+}
+
+/* Adds child under key byte c to the node at *ref, which must not
+   already have such a child, growing the node into a larger one
+   (and updating *ref) if it is full.
+   Returns FALSE, leaving the node unchanged, if unable to allocate
+   sufficient memory. */
+static boolean PathIndex_addChild(void **ref, unsigned char c,
+                                  void *child) {
+   struct inner *node = (struct inner *)*ref;
+   struct inner *bigger;
+   struct node4 *n4;
+   struct node16 *n16;
+   struct node48 *n48;
+   struct node256 *n256;
+   size_t i;
+   size_t num = node->numChildren;
+
+   switch (node->kind) {
+      case NODE4:
+         n4 = (struct node4 *)node;
+         if (num < 4) {
+            /* keeps the keys sorted */
+            for (i = num; i > 0 && n4->keys[i - 1] > c; i--) {
+               n4->keys[i] = n4->keys[i - 1];
+               n4->children[i] = n4->children[i - 1];
+            }
+            n4->keys[i] = c;
+            n4->children[i] = child;
+            node->numChildren++;
+            return TRUE;
+         }
+
+         bigger = PathIndex_newNode(NODE16);
+         if (bigger == NULL)
+            return FALSE;
+         PathIndex_copyHeader(bigger, node);
+         memcpy(((struct node16 *)bigger)->keys, n4->keys, 4);
+         memcpy(((struct node16 *)bigger)->children, n4->children,
+                4 * sizeof(void *));
+         break;
+
+      case NODE16:
+         n16 = (struct node16 *)node;
+         if (num < 16) {
+            for (i = num; i > 0 && n16->keys[i - 1] > c; i--) {
+               n16->keys[i] = n16->keys[i - 1];
+               n16->children[i] = n16->children[i - 1];
+            }
+            n16->keys[i] = c;
+            n16->children[i] = child;
+            node->numChildren++;
+            return TRUE;
+         }
+
+         bigger = PathIndex_newNode(NODE48);
+         if (bigger == NULL)
+            return FALSE;
+         PathIndex_copyHeader(bigger, node);
+         n48 = (struct node48 *)bigger;
+         for (i = 0; i < 16; i++) {
+            n48->children[i] = n16->children[i];
+            n48->slots[n16->keys[i]] = (unsigned char)(i + 1);
+         }
+         break;
+
+      case NODE48:
+         n48 = (struct node48 *)node;
+         if (num < 48) {
+            /* finds a free child slot */
+            for (i = 0; n48->children[i] != NULL; i++)
+               ;
+            n48->children[i] = child;
+            n48->slots[c] = (unsigned char)(i + 1);
+            node->numChildren++;
+            return TRUE;
+         }
+
+         bigger = PathIndex_newNode(NODE256);
+         if (bigger == NULL)
+            return FALSE;
+         PathIndex_copyHeader(bigger, node);
+         n256 = (struct node256 *)bigger;
+         for (i = 0; i < 256; i++)
+            if (n48->slots[i] != 0)
+               n256->children[i] = n48->children[n48->slots[i] - 1];
+         break;
+
+      default:
+         n256 = (struct node256 *)node;
+         n256->children[c] = child;
+         node->numChildren++;
+         return TRUE;
+   }
+
+   /* the bigger node has room for child */
+   PathIndex_freeInner(node);
+   *ref = bigger;
+   return PathIndex_addChild(ref, c, child);
+}
+
+/* Inserts leaf into the subtrie at *ref, whose keys match leaf's key
+   up to depth. Returns FALSE, leaving the subtrie unchanged, if
+   unable to allocate sufficient memory. */
+static boolean PathIndex_insert(void **ref, void *leaf,
+                                size_t depth) {
+   void *node = *ref;
+   struct inner *inner;
+   struct inner *split;
+   void *splitRef;
+   const char *other;
+   void **child;
+   const char *key = PathIndex_keyOf(leaf);
+   size_t length = strlen(key);
+   size_t p;
+
+   if (node == NULL) {
+      *ref = leaf;
+      return TRUE;
+   }
+
+   /* splits a leaf into a node with it and leaf as children */
+   if (PathIndex_isLeaf(node)) {
+      other = PathIndex_keyOf(node);
+
+      split = PathIndex_newNode(NODE4);
+      if (split == NULL)
+         return FALSE;
+
+      for (p = 0; other[depth + p] == key[depth + p]; p++)
+         ;
+
+      split->prefixLen = (unsigned int)p;
+      memcpy(split->prefix, key + depth, PathIndex_min(p, MAX_PREFIX));
+
+      *ref = split;
+      (void) PathIndex_addChild(ref, (unsigned char)other[depth + p],
+                                node);
+      (void) PathIndex_addChild(ref, (unsigned char)key[depth + p],
+                                leaf);
+      return TRUE;
+   }
+
+   inner = (struct inner *)node;
+
+   /* splits the prefix of inner where it stops matching key */
+   if (inner->prefixLen > 0) {
+      p = PathIndex_prefixMismatch(inner, key, length, depth);
+
+      if (p < inner->prefixLen) {
+         split = PathIndex_newNode(NODE4);
+         if (split == NULL)
+            return FALSE;
+
+         split->prefixLen = (unsigned int)p;
+         memcpy(split->prefix, key + depth,
+                PathIndex_min(p, MAX_PREFIX));
+
+         /* inner keeps what is left of its prefix after the split */
+         splitRef = split;
+         if (inner->prefixLen <= MAX_PREFIX) {
+            (void) PathIndex_addChild(&splitRef, inner->prefix[p],
+                                      inner);
+            inner->prefixLen -= (unsigned int)(p + 1);
+            memmove(inner->prefix, inner->prefix + p + 1,
+                    inner->prefixLen);
+         }
+         else {
+            other = PathIndex_keyOf(PathIndex_minimum(inner));
+            (void) PathIndex_addChild(&splitRef,
+                                      (unsigned char)other[depth + p],
+                                      inner);
+            inner->prefixLen -= (unsigned int)(p + 1);
+            memcpy(inner->prefix, other + depth + p + 1,
+                   PathIndex_min(inner->prefixLen, MAX_PREFIX));
+         }
+
+         (void) PathIndex_addChild(&splitRef,
+                                   (unsigned char)key[depth + p],
+                                   leaf);
+         *ref = splitRef;
+         return TRUE;
+      }
+
+      depth += inner->prefixLen;
+   }
+
+   child = PathIndex_findChild(inner, (unsigned char)key[depth]);
+   if (child != NULL)
+      return PathIndex_insert(child, leaf, depth + 1);
+
+   return PathIndex_addChild(ref, (unsigned char)key[depth], leaf);
+}
+
+/* Removes the child under key byte c (at slot child) from the node
+   at *ref, shrinking the node into a smaller one (and updating *ref)
+   when it becomes sparse. If unable to allocate a smaller node, the
+   node keeps its size. */
+static void PathIndex_removeChild(void **ref, unsigned char c,
+                                  void **child) {
+   struct inner *node = (struct inner *)*ref;
+   struct inner *smaller;
+   struct node4 *n4;
+   struct node16 *n16;
+   struct node48 *n48;
+   struct node256 *n256;
+   struct inner *only;
+   size_t i;
+   size_t j;
+   size_t p;
+
+   switch (node->kind) {
+      case NODE4:
+         n4 = (struct node4 *)node;
+         i = (size_t)(child - n4->children);
+         memmove(n4->keys + i, n4->keys + i + 1,
+                 node->numChildren - i - 1);
+         memmove(n4->children + i, n4->children + i + 1,
+                 (node->numChildren - i - 1) * sizeof(void *));
+         node->numChildren--;
+
+         /* a node with a single child is merged into it */
+         if (node->numChildren == 1) {
+            if (!PathIndex_isLeaf(n4->children[0])) {
+               only = (struct inner *)n4->children[0];
+               p = node->prefixLen;
+               if (p < MAX_PREFIX)
+                  node->prefix[p++] = n4->keys[0];
+               if (p < MAX_PREFIX) {
+                  j = PathIndex_min(only->prefixLen, MAX_PREFIX - p);
+                  memcpy(node->prefix + p, only->prefix, j);
+                  p += j;
+               }
+               memcpy(only->prefix, node->prefix,
+                      PathIndex_min(p, MAX_PREFIX));
+               only->prefixLen += node->prefixLen + 1;
+            }
+            *ref = n4->children[0];
+            PathIndex_freeInner(node);
+         }
+         return;
+
+      case NODE16:
+         n16 = (struct node16 *)node;
+         i = (size_t)(child - n16->children);
+         memmove(n16->keys + i, n16->keys + i + 1,
+                 node->numChildren - i - 1);
+         memmove(n16->children + i, n16->children + i + 1,
+                 (node->numChildren - i - 1) * sizeof(void *));
+         node->numChildren--;
+
+         if (node->numChildren == 3) {
+            smaller = PathIndex_newNode(NODE4);
+            if (smaller == NULL)
+               return;
+            PathIndex_copyHeader(smaller, node);
+            memcpy(((struct node4 *)smaller)->keys, n16->keys, 3);
+            memcpy(((struct node4 *)smaller)->children, n16->children,
+                   3 * sizeof(void *));
+            *ref = smaller;
+            PathIndex_freeInner(node);
+         }
+         return;
+
+      case NODE48:
+         n48 = (struct node48 *)node;
+         n48->children[n48->slots[c] - 1] = NULL;
+         n48->slots[c] = 0;
+         node->numChildren--;
+
+         if (node->numChildren == 12) {
+            smaller = PathIndex_newNode(NODE16);
+            if (smaller == NULL)
+               return;
+            PathIndex_copyHeader(smaller, node);
+            n16 = (struct node16 *)smaller;
+            for (i = 0, j = 0; i < 256; i++) {
+               if (n48->slots[i] != 0) {
+                  n16->keys[j] = (unsigned char)i;
+                  n16->children[j] = n48->children[n48->slots[i] - 1];
+                  j++;
+               }
+            }
+            *ref = smaller;
+            PathIndex_freeInner(node);
+         }
+         return;
+
+      default:
+         n256 = (struct node256 *)node;
+         n256->children[c] = NULL;
+         node->numChildren--;
+
+         if (node->numChildren == 37) {
+            smaller = PathIndex_newNode(NODE48);
+            if (smaller == NULL)
+               return;
+            PathIndex_copyHeader(smaller, node);
+            n48 = (struct node48 *)smaller;
+            for (i = 0, j = 0; i < 256; i++) {
+               if (n256->children[i] != NULL) {
+                  n48->children[j] = n256->children[i];
+                  n48->slots[i] = (unsigned char)(j + 1);
+                  j++;
+               }
+            }
+            *ref = smaller;
+            PathIndex_freeInner(node);
+         }
+         return;
+   }
+}
+
+/* Frees the subtrie rooted at node */
+static void PathIndex_freeNode(void *node) {
+   struct inner *inner;
+   struct node48 *n48;
+   void **children;
+   size_t num;
+   size_t i;
+
+   if (node == NULL || PathIndex_isLeaf(node))
+      return;
+
+   inner = (struct inner *)node;
+   switch (inner->kind) {
+      case NODE4:
+         children = ((struct node4 *)inner)->children;
+         num = inner->numChildren;
+         break;
+      case NODE16:
+         children = ((struct node16 *)inner)->children;
+         num = inner->numChildren;
+         break;
+      case NODE48:
+         n48 = (struct node48 *)inner;
+         children = n48->children;
+         num = 48;
+         break;
+      default:
+         children = ((struct node256 *)inner)->children;
+         num = 256;
+         break;
+   }
+
+   for (i = 0; i < num; i++)
+      PathIndex_freeNode(children[i]);
+
+   PathIndex_freeInner(inner);
+}
+
+/* see pathindex.h for specification */
+PathIndex_T PathIndex_new(void) {
+   PathIndex_T index;
+
+   index = (PathIndex_T)malloc(sizeof(struct PathIndex));
+   if (index == NULL)
+      return NULL;
+
+   indexBytes += sizeof(struct PathIndex);
+   index->root = NULL;
+   return index;
+}
+
+/* see pathindex.h for specification */
+void PathIndex_free(PathIndex_T index) {
+   assert(index != NULL);
+
+   PathIndex_freeNode(index->root);
+   indexBytes -= sizeof(struct PathIndex);
+   free(index);
+}
+
+/* Returns the slot holding the leaf mapping the first length bytes of
+   path in index, or NULL if there is none */
+static void **PathIndex_findLeaf(PathIndex_T index, const char *path,
+                                 size_t length) {
+   void **ref;
+   void **child;
+   struct inner *inner;
+   size_t depth = 0;
+
+   ref = &index->root;
+
+   while (*ref != NULL) {
+
+      if (PathIndex_isLeaf(*ref)) {
+         if (!PathIndex_leafMatches(*ref, path, length))
+            return NULL;
+         return ref;
+      }
+
+      inner = (struct inner *)*ref;
+
+      /* only the stored prefix bytes are checked here; the rest are
+         checked against the leaf's key */
+      if (inner->prefixLen > 0) {
+         if (PathIndex_checkPrefix(inner, path, length, depth) <
+             PathIndex_min(inner->prefixLen, MAX_PREFIX))
+            return NULL;
+         depth += inner->prefixLen;
+      }
+
+      if (depth > length)
+         return NULL;
+
+      child = PathIndex_findChild(inner, PathIndex_byteAt(path, length,
+                                                          depth));
+      if (child == NULL)
+         return NULL;
+
+      ref = child;
+      depth++;
+   }
+
+   return NULL;
+}
+
+/* see pathindex.h for specification */
+int PathIndex_put(PathIndex_T index, const char *path, void *value,
+                  int type) {
+   void *leaf;
+
+   assert(index != NULL);
+   assert(path != NULL);
+   assert(value != NULL);
+   assert(((size_t)value & 3) == 0);
+   assert(type == DIR || type == FILES);
+
+   leaf = PathIndex_tag(value, type);
+   assert(strcmp(PathIndex_keyOf(leaf), path) == EQUAL);
+
+   /* drops any previous mapping of path */
+   PathIndex_remove(index, path);
+
+   return PathIndex_insert(&index->root, leaf, 0);
+}
+
+/* see pathindex.h for specification */
+void *PathIndex_get(PathIndex_T index, const char *path,
+                    size_t length, int *pType) {
+   void **leaf;
+
+   assert(index != NULL);
+   assert(path != NULL);
+   assert(pType != NULL);
+
+   leaf = PathIndex_findLeaf(index, path, length);
+   if (leaf == NULL)
+      return NULL;
+
+   *pType = PathIndex_typeOf(*leaf);
+   return PathIndex_valueOf(*leaf);
+}
+
+/* see pathindex.h for specification */
+void PathIndex_replace(PathIndex_T index, const char *path,
+                       void *value, int type) {
+   void **leaf;
+
+   assert(index != NULL);
+   assert(path != NULL);
+   assert(value != NULL);
+   assert(((size_t)value & 3) == 0);
+
+   leaf = PathIndex_findLeaf(index, path, strlen(path));
+   assert(leaf != NULL);
+
+   /* the bytes of the key are the same, so the trie is unchanged */
+   *leaf = PathIndex_tag(value, type);
+}
+
+/* see pathindex.h for specification */
+void PathIndex_remove(PathIndex_T index, const char *path) {
+   void **ref;
+   void **child;
+   struct inner *inner;
+   unsigned char c;
+   size_t length;
+   size_t depth = 0;
+
+   assert(index != NULL);
+   assert(path != NULL);
+
+   length = strlen(path);
+   ref = &index->root;
+
+   if (*ref == NULL)
+      return;
+
+   if (PathIndex_isLeaf(*ref)) {
+      if (PathIndex_leafMatches(*ref, path, length))
+         *ref = NULL;
+      return;
+   }
+
+   for (;;) {
+      inner = (struct inner *)*ref;
+
+      if (inner->prefixLen > 0) {
+         if (PathIndex_prefixMismatch(inner, path, length, depth) <
+             inner->prefixLen)
+            return;
+         depth += inner->prefixLen;
+      }
+
+      if (depth > length)
+         return;
+
+      c = PathIndex_byteAt(path, length, depth);
+      child = PathIndex_findChild(inner, c);
+      if (child == NULL)
+         return;
+
+      if (PathIndex_isLeaf(*child)) {
+         if (PathIndex_leafMatches(*child, path, length))
+            PathIndex_removeChild(ref, c, child);
+         return;
+      }
+
+      ref = child;
+      depth++;
+   }
+}
+
+/* see pathindex.h for specification */
+size_t PathIndex_getBytes(void) {
+   return indexBytes;
+}
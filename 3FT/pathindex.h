@@ -0,0 +1,73 @@
+/*--------------------------------------------------------------------*/
+/* pathindex.h                                                        */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef PATHINDEX_INCLUDED
+#define PATHINDEX_INCLUDED
+
+#include <stddef.h>
+
+/*
+   A PathIndex_T maps full paths to the directories and files of the
+   tree. It is an adaptive radix trie over the bytes of the paths:
+   chains of single-child nodes are compressed into a prefix, and each
+   inner node grows (and shrinks) between 4, 16, 48 and 256 child
+   slots as needed.
+
+   The index neither copies paths nor allocates leaves: a leaf is the
+   pointer to the directory or file itself, and its key is the path
+   that Dir_getPath or File_getPath returns for it, which must stay
+   unchanged until it is removed from the index.
+*/
+typedef struct PathIndex *PathIndex_T;
+
+/*
+   Returns a new empty PathIndex_T, or NULL if unable to allocate
+   sufficient memory.
+*/
+PathIndex_T PathIndex_new(void);
+
+/*
+   Frees index. The values in it are unchanged.
+*/
+void PathIndex_free(PathIndex_T index);
+
+/*
+   Maps path to value, of the given type (0 (DIR) or 1 (FILES)),
+   replacing any previous mapping of path. value must be the Dir_T or
+   File_T whose path is path.
+   Returns 1 (TRUE) if successful, or 0 (FALSE) if unable to allocate
+   sufficient memory.
+*/
+int PathIndex_put(PathIndex_T index, const char *path, void *value,
+                  int type);
+
+/*
+   Returns the value path is mapped to and stores its type in *pType,
+   considering only the first length bytes of path. If path is not
+   mapped, returns NULL and leaves *pType unchanged.
+*/
+void *PathIndex_get(PathIndex_T index, const char *path,
+                    size_t length, int *pType);
+
+/*
+   Maps path, which must be mapped, to value instead, of the given
+   type, whose path must be equal to the path mapped before. Cannot
+   fail.
+*/
+void PathIndex_replace(PathIndex_T index, const char *path,
+                       void *value, int type);
+
+/*
+   Removes the mapping of path, if any.
+*/
+void PathIndex_remove(PathIndex_T index, const char *path);
+
+/*
+   Returns the bytes held by all indexes: their roots and inner nodes
+   (the leaves and paths are the tree's).
+*/
+size_t PathIndex_getBytes(void);
+
+#endif
@@ -0,0 +1,234 @@
+/*--------------------------------------------------------------------*/
+/* pathsort.c                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "pathsort.h"
+
+#if defined(__GNUC__)
+#include <pthread.h>
+#endif
+
+/* The number of items up to which a part is sorted by insertion,
+   and the fewest a thread is given to sort */
+enum {RUN_LENGTH = 16, MIN_PART = 4096};
+
+/* An entry being sorted, next to its path, so that comparing two
+   entries reads their paths without reading the entries first */
+struct item {
+   const char *path;
+   const struct FT_PathEntry *entry;
+};
+
+/* A part of the items being sorted, from lo up to hi, of which those
+   up to mid are already sorted if it is to be merged, and the array
+   as long as the items that the part of the same span may use */
+struct part {
+   struct item *items;
+   struct item *scratch;
+   size_t lo;
+   size_t mid;
+   size_t hi;
+};
+
+
+/* Compares the paths path1 and path2 in the order described in
+   pathsort.h, in which the end of a component, '/' or '\0', comes
+   before any other byte */
+static int PathSort_compare(const char *path1, const char *path2) {
+   unsigned int byte1;
+   unsigned int byte2;
+
+   while (*path1 == *path2 && *path1 != '\0') {
+      path1++;
+      path2++;
+   }
+
+   byte1 = *path1 == '\0' ? 0 : *path1 == '/' ? 1 :
+      (unsigned int)(unsigned char)*path1 + 2;
+   byte2 = *path2 == '\0' ? 0 : *path2 == '/' ? 1 :
+      (unsigned int)(unsigned char)*path2 + 2;
+
+   return byte1 < byte2 ? -1 : byte1 > byte2;
+}
+
+/* Merges the sorted items from part->lo up to part->mid with the
+   sorted ones from there up to part->hi, taking the first of equal
+   ones from the first */
+static void PathSort_merge(const struct part *part) {
+   struct item *items = part->items;
+   struct item *left = part->scratch + part->lo;
+   size_t numLeft = part->mid - part->lo;
+   size_t i = 0;
+   size_t j = part->mid;
+   size_t k = part->lo;
+
+   /* already in order */
+   if (numLeft == 0 || j == part->hi ||
+       PathSort_compare(items[j - 1].path, items[j].path) <= 0)
+      return;
+
+   /* the items merged never overtake those of the second half not yet
+      merged, so only the first half is set aside */
+   memcpy(left, items + part->lo, numLeft * sizeof(struct item));
+
+   while (i < numLeft && j < part->hi) {
+      if (PathSort_compare(items[j].path, left[i].path) < 0)
+         items[k++] = items[j++];
+      else
+         items[k++] = left[i++];
+   }
+
+   while (i < numLeft)
+      items[k++] = left[i++];
+}
+
+/* Sorts the items of part from part->lo up to part->hi */
+static void PathSort_sortPart(const struct part *part) {
+   struct item item;
+   struct part half;
+   size_t i;
+   size_t j;
+
+   if (part->hi - part->lo <= RUN_LENGTH) {
+      for (i = part->lo + 1; i < part->hi; i++) {
+         item = part->items[i];
+         for (j = i; j > part->lo &&
+                 PathSort_compare(item.path,
+                                  part->items[j - 1].path) < 0; j--)
+            part->items[j] = part->items[j - 1];
+         part->items[j] = item;
+      }
+      return;
+   }
+
+   half = *part;
+   half.hi = part->lo + (part->hi - part->lo) / 2;
+   PathSort_sortPart(&half);
+   half.lo = half.hi;
+   half.hi = part->hi;
+   PathSort_sortPart(&half);
+
+   half.mid = half.lo;
+   half.lo = part->lo;
+   PathSort_merge(&half);
+}
+
+/* Sorts or merges arg, a part, whichever its mid tells, for
+   pthread_create */
+static void *PathSort_work(void *arg) {
+   const struct part *part = (const struct part *)arg;
+
+   if (part->mid == part->lo)
+      PathSort_sortPart(part);
+   else
+      PathSort_merge(part);
+
+   return NULL;
+}
+
+/* Sorts or merges the numParts parts of parts at once, each on a
+   thread of its own but the first, which the calling thread does */
+static void PathSort_runParts(struct part *parts, size_t numParts) {
+#if defined(__GNUC__)
+   pthread_t *threads;
+   boolean *isStarted;
+   size_t i;
+
+   threads = (pthread_t *)malloc(numParts * sizeof(pthread_t));
+   isStarted = (boolean *)calloc(numParts, sizeof(boolean));
+
+   for (i = 1; i < numParts; i++) {
+      if (threads != NULL && isStarted != NULL)
+         isStarted[i] = pthread_create(&threads[i], NULL, PathSort_work,
+                                       &parts[i]) == 0;
+      if (isStarted == NULL || !isStarted[i])
+         (void) PathSort_work(&parts[i]);
+   }
+
+   (void) PathSort_work(&parts[0]);
+
+   for (i = 1; i < numParts; i++) {
+      if (isStarted != NULL && isStarted[i])
+         (void) pthread_join(threads[i], NULL);
+   }
+
+   free(threads);
+   free(isStarted);
+#else
+   size_t i;
+
+   for (i = 0; i < numParts; i++)
+      (void) PathSort_work(&parts[i]);
+#endif
+}
+
+/* see pathsort.h for specification */
+boolean PathSort_sort(const struct FT_PathEntry **entries, size_t n,
+                      size_t numThreads) {
+   struct item *items;
+   struct item *scratch;
+   struct part *parts;
+   size_t numParts;
+   size_t width;
+   size_t i;
+
+   assert(entries != NULL || n == 0);
+
+   if (n < 2)
+      return TRUE;
+
+   /* each thread is given a part worth starting it for */
+   numParts = n / MIN_PART;
+   if (numParts > numThreads)
+      numParts = numThreads;
+   if (numParts == 0)
+      numParts = 1;
+
+   items = (struct item *)malloc(n * sizeof(struct item));
+   scratch = (struct item *)malloc(n * sizeof(struct item));
+   parts = (struct part *)malloc(numParts * sizeof(struct part));
+   if (items == NULL || scratch == NULL || parts == NULL) {
+      free(items);
+      free(scratch);
+      free(parts);
+      return FALSE;
+   }
+
+   for (i = 0; i < n; i++) {
+      items[i].path = entries[i]->path;
+      items[i].entry = entries[i];
+   }
+
+   for (i = 0; i < numParts; i++) {
+      parts[i].items = items;
+      parts[i].scratch = scratch;
+      parts[i].lo = n / numParts * i;
+      parts[i].mid = parts[i].lo;
+      parts[i].hi = i + 1 < numParts ? n / numParts * (i + 1) : n;
+   }
+   PathSort_runParts(parts, numParts);
+
+   /* the k-th merge of a round merges the parts 2k and 2k + 1 of
+      the last one */
+   for (width = 1; width < numParts; width *= 2) {
+      for (i = 0; i + width < numParts; i += 2 * width) {
+         parts[i / (2 * width)].items = items;
+         parts[i / (2 * width)].scratch = scratch;
+         parts[i / (2 * width)].lo = n / numParts * i;
+         parts[i / (2 * width)].mid = n / numParts * (i + width);
+         parts[i / (2 * width)].hi = i + 2 * width < numParts ?
+            n / numParts * (i + 2 * width) : n;
+      }
+      PathSort_runParts(parts, i / (2 * width));
+   }
+
+   for (i = 0; i < n; i++)
+      entries[i] = items[i].entry;
+
+   free(items);
+   free(scratch);
+   free(parts);
+   return TRUE;
+}
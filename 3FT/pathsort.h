@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------------*/
+/* pathsort.h                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef PATHSORT_INCLUDED
+#define PATHSORT_INCLUDED
+
+#include <stddef.h>
+#include "ft.h"
+
+/*
+   The PathSort module sorts the entries of FT_buildFromPaths by path,
+   in the order in which a pre-order traversal of the tree visits
+   them: component by component, each in the order of strcmp. A path
+   then comes right before the paths below it, and those are grouped
+   by the child of its directory they are below, the children in the
+   order by name in which directories keep them.
+
+   It is a merge sort, so that equal paths keep their order: the
+   entries are split into parts, each sorted by a thread of its own,
+   and then pairs of sorted parts are merged, each pair by a thread of
+   its own, until one is left.
+*/
+
+/*
+   Sorts the n elements of entries as described above, on up to
+   numThreads threads at once, the calling thread included. Without
+   GCC's thread support, or if unable to start a thread, the calling
+   thread does the work of the threads not started.
+   Returns FALSE, leaving entries unchanged, if unable to allocate
+   sufficient memory, and TRUE otherwise.
+*/
+boolean PathSort_sort(const struct FT_PathEntry **entries, size_t n,
+                      size_t numThreads);
+
+#endif
@@ -0,0 +1,142 @@
+/*--------------------------------------------------------------------*/
+/* pathview.c                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "pathview.h"
+
+/*
+   The vector scan loads whole aligned blocks, which may extend past
+   the path's '\0' (but never past its page). Address sanitizers
+   report those bytes, so sanitized builds scan byte by byte.
+*/
+#if defined(__SANITIZE_ADDRESS__)
+/* scans byte by byte */
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define PATHVIEW_BLOCK 32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PATHVIEW_BLOCK 16
+#endif
+
+#if defined(PATHVIEW_BLOCK)
+
+/* Returns the bits of the '/' and '\0' bytes of the aligned block
+   starting at block, bit i standing for block[i] */
+static unsigned long PathView_scanBlock(const char *block) {
+#if PATHVIEW_BLOCK == 32
+   __m256i v = _mm256_load_si256((const __m256i *)block);
+   __m256i hits = _mm256_or_si256(
+      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')),
+      _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+
+   return (unsigned long)(unsigned int)_mm256_movemask_epi8(hits);
+#else
+   __m128i v = _mm_load_si128((const __m128i *)block);
+   __m128i hits = _mm_or_si128(
+      _mm_cmpeq_epi8(v, _mm_set1_epi8('/')),
+      _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+
+   return (unsigned long)(unsigned int)_mm_movemask_epi8(hits);
+#endif
+}
+
+/* Returns the index of the lowest set bit of bits, which is not 0 */
+static size_t PathView_lowestBit(unsigned long bits) {
+#if defined(__GNUC__)
+   return (size_t)__builtin_ctzl(bits);
+#else
+   size_t i;
+
+   for (i = 0; (bits & 1UL) == 0; i++)
+      bits >>= 1;
+   return i;
+#endif
+}
+
+/* Returns the offset of the first '/' or '\0' of view's path at or
+   after view->next, scanning a block at a time */
+static size_t PathView_findStop(struct PathView *view) {
+   const char *from = view->path + view->next;
+   unsigned long bits;
+
+   /* loads the block holding from, unless it is already loaded */
+   if (view->block == NULL || from >= view->block + PATHVIEW_BLOCK) {
+      view->block = (const char *)
+         ((size_t)from & ~(size_t)(PATHVIEW_BLOCK - 1));
+      view->stops = PathView_scanBlock(view->block);
+   }
+
+   /* ignores the stops before from */
+   bits = view->stops & (~0UL << (size_t)(from - view->block));
+
+   while (bits == 0) {
+      view->block += PATHVIEW_BLOCK;
+      view->stops = PathView_scanBlock(view->block);
+      bits = view->stops;
+   }
+
+   return (size_t)(view->block - view->path) + PathView_lowestBit(bits);
+}
+
+#else
+
+/* Returns the offset of the first '/' or '\0' of view's path at or
+   after view->next, scanning a byte at a time */
+static size_t PathView_findStop(struct PathView *view) {
+   const char *path = view->path;
+   size_t i = view->next;
+
+   while (path[i] != '/' && path[i] != '\0')
+      i++;
+
+   return i;
+}
+
+#endif
+
+/* see pathview.h for specification */
+void PathView_init(struct PathView *view, const char *path,
+                   size_t start) {
+   assert(view != NULL);
+   assert(path != NULL);
+   assert(start == 0 || path[start - 1] == '/');
+
+   view->offset = start;
+   view->length = 0;
+   view->path = path;
+   view->next = start;
+   view->block = NULL;
+   view->stops = 0;
+}
+
+/* see pathview.h for specification */
+boolean PathView_next(struct PathView *view) {
+   size_t stop;
+
+   assert(view != NULL);
+
+   if (view->next == PATHVIEW_END)
+      return FALSE;
+
+   stop = PathView_findStop(view);
+
+   view->offset = view->next;
+   view->length = stop - view->next;
+
+   if (view->path[stop] == '\0')
+      view->next = PATHVIEW_END;
+   else
+      view->next = stop + 1;
+
+   return TRUE;
+}
+
+/* see pathview.h for specification */
+boolean PathView_isLast(const struct PathView *view) {
+   assert(view != NULL);
+
+   return (boolean)(view->next == PATHVIEW_END);
+}
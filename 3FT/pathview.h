@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------*/
+/* pathview.h                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef PATHVIEW_INCLUDED
+#define PATHVIEW_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+
+/*
+   A PathView splits a path into its '/'-separated components without
+   copying it: each component is reported as a span (offset, length)
+   of the path. The path is scanned once, many bytes at a time when
+   SSE2 or AVX2 is available.
+
+   A PathView lives wherever the client declares it (usually on the
+   stack); its fields other than offset and length are private.
+*/
+struct PathView {
+   /* the current component: length bytes starting at path[offset] */
+   size_t offset;
+   size_t length;
+
+   /* the path being split */
+   const char *path;
+   /* the offset of the next component, or PATHVIEW_END if none */
+   size_t next;
+   /* the first byte of the block of path being scanned */
+   const char *block;
+   /* the bits of the '/' and '\0' bytes of block not yet passed */
+   unsigned long stops;
+};
+
+/* The value of the next field once the last component is reached */
+#define PATHVIEW_END ((size_t)-1)
+
+/*
+   Prepares view to split the part of path starting at offset start.
+   start must be 0 or just after a '/' of path.
+*/
+void PathView_init(struct PathView *view, const char *path,
+                   size_t start);
+
+/*
+   Advances view to the next component, storing its span in
+   view->offset and view->length. Returns TRUE if there is such a
+   component, or FALSE (leaving the span unchanged) if the previous
+   one was the last.
+*/
+boolean PathView_next(struct PathView *view);
+
+/*
+   Returns TRUE if the current component of view is the last one of
+   its path, or FALSE otherwise.
+*/
+boolean PathView_isLast(const struct PathView *view);
+
+#endif
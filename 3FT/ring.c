@@ -0,0 +1,367 @@
+/*--------------------------------------------------------------------*/
+/* ring.c                                                             */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "ring.h"
+
+#if defined(__GNUC__)
+#include <pthread.h>
+#endif
+
+/* A ring of operations and their worker */
+struct FT_Ring {
+   /* the slots, capacity of them, of the operations submitted and of
+      their completions */
+   struct FT_Submission *submissions;
+   struct FT_Completion *completions;
+   size_t capacity;
+
+   /* the number of operations ever submitted and reaped, which only
+      the client writes, and completed, which only the worker writes */
+   unsigned long numSubmitted;
+   unsigned long numReaped;
+   unsigned long numCompleted;
+
+#if defined(__GNUC__)
+   /* the lock the worker holds to sleep while the ring is empty, and
+      the client to sleep while it waits for a completion, each then
+      signalled by the other */
+   pthread_mutex_t lock;
+   pthread_cond_t submitted;
+   pthread_cond_t completed;
+   /* whether the worker and the client are, or are about to be,
+      asleep, and whether the worker must stop once the ring is empty */
+   boolean isIdle;
+   boolean isWaiting;
+   boolean mustStop;
+   pthread_t worker;
+#endif
+};
+
+/* Ring_load(lvalue) and Ring_store(lvalue, value) read and write a
+   count, or a flag, that the client and the worker share. Their order
+   is total, so that a thread going to sleep, which sets its flag then
+   reads the count it waits on, and a thread updating that count, which
+   then reads the flag, cannot both miss the other's write. */
+#if defined(__GNUC__)
+enum {RING_HAS_WORKER = TRUE};
+#define Ring_load(lvalue) __atomic_load_n(&(lvalue), __ATOMIC_SEQ_CST)
+#define Ring_store(lvalue, value)                                      \
+   __atomic_store_n(&(lvalue), (value), __ATOMIC_SEQ_CST)
+#else
+/* without a worker, Ring_reap runs the operations even if not told to
+   wait for them */
+enum {RING_HAS_WORKER = FALSE};
+#define Ring_load(lvalue) (lvalue)
+#define Ring_store(lvalue, value) ((void)((lvalue) = (value)))
+#endif
+
+
+/* Runs the operation submission, storing its result in completion */
+static void Ring_run(const struct FT_Submission *submission,
+                     struct FT_Completion *completion) {
+   assert(submission != NULL);
+   assert(completion != NULL);
+
+   completion->result = NULL;
+   completion->type = FALSE;
+   completion->length = 0;
+   completion->userData = submission->userData;
+
+   switch (submission->op) {
+   case FT_RING_INSERT_DIR:
+      completion->status = FT_insertDir(submission->path);
+      break;
+   case FT_RING_CONTAINS_DIR:
+      completion->status = FT_containsDir(submission->path) ?
+         SUCCESS : NO_SUCH_PATH;
+      break;
+   case FT_RING_RM_DIR:
+      completion->status = FT_rmDir(submission->path);
+      break;
+   case FT_RING_INSERT_FILE:
+      completion->status = FT_insertFile(submission->path,
+                                         submission->contents,
+                                         submission->length);
+      break;
+   case FT_RING_CONTAINS_FILE:
+      completion->status = FT_containsFile(submission->path) ?
+         SUCCESS : NO_SUCH_PATH;
+      break;
+   case FT_RING_RM_FILE:
+      completion->status = FT_rmFile(submission->path);
+      break;
+   case FT_RING_GET_FILE_CONTENTS:
+   case FT_RING_REPLACE_FILE_CONTENTS:
+      /* the functions return NULL both for a missing file and for
+         one without contents, which FT_stat tells apart */
+      completion->status = FT_stat(submission->path, &completion->type,
+                                   &completion->length);
+      if (completion->status == SUCCESS && !completion->type)
+         completion->status = NOT_A_FILE;
+      if (completion->status != SUCCESS)
+         break;
+      if (submission->op == FT_RING_GET_FILE_CONTENTS)
+         completion->result = FT_getFileContents(submission->path);
+      else
+         completion->result =
+            FT_replaceFileContents(submission->path,
+                                   submission->contents,
+                                   submission->length);
+      break;
+   case FT_RING_STAT:
+      completion->status = FT_stat(submission->path, &completion->type,
+                                   &completion->length);
+      break;
+   case FT_RING_TO_STRING:
+      completion->result = FT_toString();
+      completion->status = completion->result != NULL ?
+         SUCCESS : MEMORY_ERROR;
+      break;
+   default:
+      assert(FALSE);
+      completion->status = CONFLICTING_PATH;
+   }
+}
+
+/* Runs the operations submitted to ring up to the numSubmitted-th, in
+   order, completing each as soon as it is run */
+static void Ring_runBatch(struct FT_Ring *ring,
+                          unsigned long numSubmitted) {
+   unsigned long i;
+   size_t slot;
+
+   assert(ring != NULL);
+
+   for (i = ring->numCompleted; i != numSubmitted; i++) {
+      slot = (size_t)(i % ring->capacity);
+      Ring_run(&ring->submissions[slot], &ring->completions[slot]);
+      Ring_store(ring->numCompleted, i + 1);
+
+#if defined(__GNUC__)
+      if (Ring_load(ring->isWaiting)) {
+         (void) pthread_mutex_lock(&ring->lock);
+         (void) pthread_cond_signal(&ring->completed);
+         (void) pthread_mutex_unlock(&ring->lock);
+      }
+#endif
+   }
+}
+
+#if defined(__GNUC__)
+
+/* Runs the operations submitted to ring as they come, a batch at a
+   time, until it must stop, for pthread_create */
+static void *Ring_work(void *arg) {
+   struct FT_Ring *ring = (struct FT_Ring *)arg;
+   unsigned long numSubmitted;
+
+   for (;;) {
+      numSubmitted = Ring_load(ring->numSubmitted);
+      if (numSubmitted != ring->numCompleted) {
+         Ring_runBatch(ring, numSubmitted);
+         continue;
+      }
+
+      (void) pthread_mutex_lock(&ring->lock);
+      Ring_store(ring->isIdle, TRUE);
+      while (Ring_load(ring->numSubmitted) == ring->numCompleted &&
+             !ring->mustStop)
+         (void) pthread_cond_wait(&ring->submitted, &ring->lock);
+      Ring_store(ring->isIdle, FALSE);
+      numSubmitted = Ring_load(ring->numSubmitted);
+      (void) pthread_mutex_unlock(&ring->lock);
+
+      if (numSubmitted == ring->numCompleted)
+         break;
+   }
+
+   return NULL;
+}
+
+/* Starts the worker of ring. Returns FALSE if unable to, and TRUE
+   otherwise. */
+static boolean Ring_start(struct FT_Ring *ring) {
+   if (pthread_mutex_init(&ring->lock, NULL) != 0)
+      return FALSE;
+   if (pthread_cond_init(&ring->submitted, NULL) != 0) {
+      (void) pthread_mutex_destroy(&ring->lock);
+      return FALSE;
+   }
+   if (pthread_cond_init(&ring->completed, NULL) != 0) {
+      (void) pthread_cond_destroy(&ring->submitted);
+      (void) pthread_mutex_destroy(&ring->lock);
+      return FALSE;
+   }
+
+   if (pthread_create(&ring->worker, NULL, Ring_work, ring) != 0) {
+      (void) pthread_cond_destroy(&ring->completed);
+      (void) pthread_cond_destroy(&ring->submitted);
+      (void) pthread_mutex_destroy(&ring->lock);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* Wakes up the worker of ring if it is asleep, now that operations
+   were submitted */
+static void Ring_signal(struct FT_Ring *ring) {
+   if (!Ring_load(ring->isIdle))
+      return;
+
+   (void) pthread_mutex_lock(&ring->lock);
+   (void) pthread_cond_signal(&ring->submitted);
+   (void) pthread_mutex_unlock(&ring->lock);
+}
+
+/* Waits until ring has completed more than numReaped operations, and
+   returns the number it has */
+static unsigned long Ring_wait(struct FT_Ring *ring,
+                               unsigned long numReaped) {
+   unsigned long numCompleted;
+
+   (void) pthread_mutex_lock(&ring->lock);
+   Ring_store(ring->isWaiting, TRUE);
+   while ((numCompleted = Ring_load(ring->numCompleted)) == numReaped)
+      (void) pthread_cond_wait(&ring->completed, &ring->lock);
+   Ring_store(ring->isWaiting, FALSE);
+   (void) pthread_mutex_unlock(&ring->lock);
+
+   return numCompleted;
+}
+
+/* Stops the worker of ring, once it has run the operations submitted */
+static void Ring_stop(struct FT_Ring *ring) {
+   (void) pthread_mutex_lock(&ring->lock);
+   ring->mustStop = TRUE;
+   (void) pthread_cond_signal(&ring->submitted);
+   (void) pthread_mutex_unlock(&ring->lock);
+
+   (void) pthread_join(ring->worker, NULL);
+   (void) pthread_cond_destroy(&ring->completed);
+   (void) pthread_cond_destroy(&ring->submitted);
+   (void) pthread_mutex_destroy(&ring->lock);
+}
+
+#else
+
+/* without threads, Ring_reap and Ring_stop run the operations */
+
+/* see above */
+static boolean Ring_start(struct FT_Ring *ring) {
+   return TRUE;
+}
+
+/* see above */
+static void Ring_signal(struct FT_Ring *ring) {
+}
+
+/* see above */
+static unsigned long Ring_wait(struct FT_Ring *ring,
+                               unsigned long numReaped) {
+   Ring_runBatch(ring, ring->numSubmitted);
+   return ring->numCompleted;
+}
+
+/* see above */
+static void Ring_stop(struct FT_Ring *ring) {
+   Ring_runBatch(ring, ring->numSubmitted);
+}
+
+#endif
+
+/* see ring.h for specification */
+struct FT_Ring *Ring_new(size_t capacity) {
+   struct FT_Ring *ring;
+
+   assert(capacity > 0);
+
+   ring = (struct FT_Ring *)calloc(1, sizeof(struct FT_Ring));
+   if (ring == NULL)
+      return NULL;
+
+   ring->capacity = capacity;
+   ring->submissions = (struct FT_Submission *)
+      malloc(capacity * sizeof(struct FT_Submission));
+   ring->completions = (struct FT_Completion *)
+      malloc(capacity * sizeof(struct FT_Completion));
+   if (ring->submissions == NULL || ring->completions == NULL ||
+       !Ring_start(ring)) {
+      free(ring->submissions);
+      free(ring->completions);
+      free(ring);
+      return NULL;
+   }
+
+   return ring;
+}
+
+/* see ring.h for specification */
+size_t Ring_submit(struct FT_Ring *ring,
+                   const struct FT_Submission *submissions,
+                   size_t numSubmissions) {
+   unsigned long numSubmitted;
+   size_t room;
+   size_t i;
+
+   assert(ring != NULL);
+   assert(submissions != NULL || numSubmissions == 0);
+
+   /* a slot is free once the operation last in it is reaped */
+   numSubmitted = ring->numSubmitted;
+   room = ring->capacity - (size_t)(numSubmitted - ring->numReaped);
+   if (numSubmissions > room)
+      numSubmissions = room;
+   if (numSubmissions == 0)
+      return 0;
+
+   for (i = 0; i < numSubmissions; i++)
+      ring->submissions[(numSubmitted + i) % ring->capacity] =
+         submissions[i];
+
+   Ring_store(ring->numSubmitted, numSubmitted + numSubmissions);
+   Ring_signal(ring);
+   return numSubmissions;
+}
+
+/* see ring.h for specification */
+size_t Ring_reap(struct FT_Ring *ring, struct FT_Completion *completions,
+                 size_t max, boolean wait) {
+   unsigned long numReaped;
+   unsigned long numCompleted;
+   size_t numReady;
+   size_t i;
+
+   assert(ring != NULL);
+   assert(completions != NULL || max == 0);
+
+   numReaped = ring->numReaped;
+   numCompleted = Ring_load(ring->numCompleted);
+   if (numCompleted == numReaped && (wait || !RING_HAS_WORKER) &&
+       ring->numSubmitted != numReaped)
+      numCompleted = Ring_wait(ring, numReaped);
+
+   numReady = (size_t)(numCompleted - numReaped);
+   if (numReady > max)
+      numReady = max;
+
+   for (i = 0; i < numReady; i++)
+      completions[i] =
+         ring->completions[(numReaped + i) % ring->capacity];
+
+   ring->numReaped = numReaped + numReady;
+   return numReady;
+}
+
+/* see ring.h for specification */
+void Ring_free(struct FT_Ring *ring) {
+   assert(ring != NULL);
+
+   Ring_stop(ring);
+   free(ring->submissions);
+   free(ring->completions);
+   free(ring);
+}
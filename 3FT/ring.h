@@ -0,0 +1,46 @@
+/*--------------------------------------------------------------------*/
+/* ring.h                                                             */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef RING_INCLUDED
+#define RING_INCLUDED
+
+#include "ft.h"
+
+/*
+   The Ring module implements the rings of FT_createRing. A ring is an
+   array of slots, in which operation i is submitted to, and completes
+   in, slot i modulo its capacity. The client counts the operations it
+   submits and reaps, and the worker those it completes, each count
+   written by one thread and read by the other, so that the slot of
+   an operation is handed from one to the other by updating a count:
+   neither ever locks a slot.
+*/
+
+/*
+   Returns a new ring of capacity slots, whose worker is running, or
+   NULL if unable to allocate sufficient memory or to start it.
+*/
+struct FT_Ring *Ring_new(size_t capacity);
+
+/*
+   Submits up to numSubmissions operations to ring, as FT_submit does.
+*/
+size_t Ring_submit(struct FT_Ring *ring,
+                   const struct FT_Submission *submissions,
+                   size_t numSubmissions);
+
+/*
+   Reaps up to max completions from ring, as FT_reap does.
+*/
+size_t Ring_reap(struct FT_Ring *ring, struct FT_Completion *completions,
+                 size_t max, boolean wait);
+
+/*
+   Waits for the operations in flight on ring, stops its worker and
+   frees it.
+*/
+void Ring_free(struct FT_Ring *ring);
+
+#endif
@@ -0,0 +1,373 @@
+/*--------------------------------------------------------------------*/
+/* shard.c                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "shard.h"
+#include "namekey.h"
+#include "lock.h"
+#include "epoch.h"
+
+/* The times a writer looks for a directory that another writer holds
+   before taking its path from the root instead */
+enum {MAX_TRIES = 100};
+
+/* The number of buckets of a new shard, and the number of directories
+   per bucket past which the buckets double */
+enum {INITIAL_BUCKETS = 8, MAX_LOAD = 2};
+
+/* A directory in its shard */
+struct entry {
+   Dir_T dir;
+   /* the hash of its path */
+   unsigned long hash;
+   /* the next directory in the same bucket */
+   struct entry *next;
+};
+
+/* A shard: a hash table of directories, with its lock */
+struct shard {
+   struct Lock lock;
+   /* the buckets, numBuckets of them, of numEntries directories */
+   struct entry **buckets;
+   size_t numBuckets;
+   size_t numEntries;
+};
+
+/* A shard, alone in its cache line */
+union shardLine {
+   struct shard shard;
+   char line[LOCK_CACHE_LINE];
+};
+
+/* The Shard AO has 5 state variables: */
+
+/* whether it is active */
+boolean Shard_isActive;
+/* the shards, numShards of them */
+static union shardLine *shards;
+static size_t numShards;
+/* the number of components of the paths of their directories */
+static size_t shardDepth;
+/* the number of removals of directories above theirs in progress,
+   during which no directory is added (see Shard_removeBelow) */
+static size_t numRemovals;
+
+
+/* Returns the bucket of shard to which hash leads. Shards are chosen
+   by the low part of hash, so buckets are by the rest. */
+static struct entry **Shard_getBucket(struct shard *shard,
+                                      unsigned long hash) {
+   return &shard->buckets[(hash / numShards) % shard->numBuckets];
+}
+
+/* Returns the link to the directory of shard whose path is the length
+   bytes at path, of hash hash, the one to the end of its bucket if
+   there is none */
+static struct entry **Shard_find(struct shard *shard, const char *path,
+                                 size_t length, unsigned long hash) {
+   struct entry **link;
+   const char *other;
+
+   for (link = Shard_getBucket(shard, hash); *link != NULL;
+        link = &(*link)->next) {
+      other = Dir_getPath((*link)->dir);
+      if ((*link)->hash == hash &&
+          strncmp(other, path, length) == EQUAL && other[length] == '\0')
+         return link;
+   }
+
+   return link;
+}
+
+/* Doubles the buckets of shard, which stays as it is if unable to
+   allocate them */
+static void Shard_grow(struct shard *shard) {
+   struct entry **old = shard->buckets;
+   size_t oldCount = shard->numBuckets;
+   struct entry *entry;
+   struct entry **bucket;
+   size_t i;
+
+   shard->buckets = (struct entry **)
+      calloc(oldCount * 2, sizeof(struct entry *));
+   if (shard->buckets == NULL) {
+      shard->buckets = old;
+      return;
+   }
+   shard->numBuckets = oldCount * 2;
+
+   for (i = 0; i < oldCount; i++) {
+      while (old[i] != NULL) {
+         entry = old[i];
+         old[i] = entry->next;
+         bucket = Shard_getBucket(shard, entry->hash);
+         entry->next = *bucket;
+         *bucket = entry;
+      }
+   }
+
+   free(old);
+}
+
+/* Returns the number of components of the directory path path */
+static size_t Shard_getDepth(const char *path) {
+   size_t depth = 1;
+
+   for (; *path != '\0'; path++) {
+      if (*path == '/')
+         depth++;
+   }
+
+   return depth;
+}
+
+/* Returns the length of the first shardDepth components of path, or 0
+   if it has fewer or if one of them is empty */
+static size_t Shard_getPrefix(const char *path) {
+   size_t length;
+   size_t depth = 0;
+
+   for (length = 0; ; length++) {
+      if (path[length] != '/' && path[length] != '\0')
+         continue;
+
+      if (length == 0 || path[length - 1] == '/')
+         return 0;
+      if (++depth == shardDepth)
+         return length;
+      if (path[length] == '\0')
+         return 0;
+   }
+}
+
+/* see shard.h for specification */
+void Shard_init(size_t numShardsToUse, size_t depth) {
+   size_t i;
+
+   assert(!Shard_isActive);
+   assert(numShardsToUse == 0 || Lock_isActive);
+
+   if (numShardsToUse == 0)
+      return;
+
+   shards = (union shardLine *)
+      calloc(numShardsToUse, sizeof(union shardLine));
+   if (shards == NULL)
+      return;
+
+   for (i = 0; i < numShardsToUse; i++) {
+      Lock_clear(&shards[i].shard.lock);
+      shards[i].shard.numBuckets = INITIAL_BUCKETS;
+      shards[i].shard.buckets = (struct entry **)
+         calloc(INITIAL_BUCKETS, sizeof(struct entry *));
+      if (shards[i].shard.buckets == NULL) {
+         numShards = i;
+         Shard_destroy();
+         return;
+      }
+   }
+
+   numShards = numShardsToUse;
+   shardDepth = depth;
+   Shard_isActive = TRUE;
+}
+
+/* see shard.h for specification */
+void Shard_destroy(void) {
+   struct shard *shard;
+   struct entry *entry;
+   size_t i;
+   size_t j;
+
+   for (i = 0; i < numShards; i++) {
+      shard = &shards[i].shard;
+      for (j = 0; j < shard->numBuckets; j++) {
+         while (shard->buckets[j] != NULL) {
+            entry = shard->buckets[j];
+            shard->buckets[j] = entry->next;
+            free(entry);
+         }
+      }
+      free(shard->buckets);
+   }
+
+   free(shards);
+   shards = NULL;
+   numShards = 0;
+   Shard_isActive = FALSE;
+}
+
+/* see shard.h for specification */
+Dir_T Shard_lockDir(const char *path, size_t *pLength) {
+   struct NameKey key;
+   struct shard *shard;
+   struct entry *entry;
+   Dir_T dir;
+   boolean isLocked;
+   size_t length;
+   size_t tries;
+
+   assert(path != NULL);
+   assert(pLength != NULL);
+
+   if (!Shard_isActive)
+      return NULL;
+
+   length = Shard_getPrefix(path);
+   if (length == 0)
+      return NULL;
+
+   NameKey_init(&key, path, length);
+   shard = &shards[key.hash % numShards].shard;
+
+   /* the directory cannot be removed while it is in the shard, nor
+      can its writer wait for the shard while holding it */
+   for (tries = 0; tries < MAX_TRIES; tries++) {
+      Lock_acquire(&shard->lock);
+      entry = *Shard_find(shard, path, length, key.hash);
+      dir = entry != NULL ? entry->dir : NULL;
+      isLocked = dir != NULL && Dir_tryLock(dir);
+      Lock_release(&shard->lock);
+
+      if (dir == NULL)
+         return NULL;
+
+      if (isLocked) {
+         *pLength = length;
+         return dir;
+      }
+   }
+
+   return NULL;
+}
+
+/* see shard.h for specification */
+void Shard_add(Dir_T dir) {
+   struct NameKey key;
+   struct shard *shard;
+   struct entry *entry;
+   struct entry **bucket;
+   const char *path;
+
+   assert(dir != NULL);
+
+   if (!Shard_isActive)
+      return;
+
+   path = Dir_getPath(dir);
+   if (Shard_getDepth(path) != shardDepth)
+      return;
+
+   entry = (struct entry *)malloc(sizeof(struct entry));
+   if (entry == NULL)
+      return;
+
+   NameKey_init(&key, path, strlen(path));
+   entry->dir = dir;
+   entry->hash = key.hash;
+   shard = &shards[key.hash % numShards].shard;
+
+   Lock_acquire(&shard->lock);
+
+   /* a removal that counted before scanning this shard either finds
+      dir here or is seen now */
+   if (Epoch_load(numRemovals) != 0) {
+      Lock_release(&shard->lock);
+      free(entry);
+      return;
+   }
+
+   if (shard->numEntries >= shard->numBuckets * MAX_LOAD)
+      Shard_grow(shard);
+
+   bucket = Shard_getBucket(shard, key.hash);
+   entry->next = *bucket;
+   *bucket = entry;
+   shard->numEntries++;
+
+   Lock_release(&shard->lock);
+}
+
+/* Removes the directories of shard whose paths start with the length
+   bytes at path followed by a '/' */
+static void Shard_removePrefix(struct shard *shard, const char *path,
+                               size_t length) {
+   struct entry **link;
+   struct entry *entry;
+   const char *other;
+   size_t i;
+
+   Lock_acquire(&shard->lock);
+
+   for (i = 0; i < shard->numBuckets; i++) {
+      link = &shard->buckets[i];
+      while (*link != NULL) {
+         entry = *link;
+         other = Dir_getPath(entry->dir);
+         if (strncmp(other, path, length) == EQUAL &&
+             other[length] == '/') {
+            *link = entry->next;
+            free(entry);
+            shard->numEntries--;
+         }
+         else
+            link = &entry->next;
+      }
+   }
+
+   Lock_release(&shard->lock);
+}
+
+/* see shard.h for specification */
+boolean Shard_removeBelow(Dir_T dir) {
+   struct NameKey key;
+   struct shard *shard;
+   struct entry **link;
+   struct entry *entry;
+   const char *path;
+   size_t depth;
+   size_t i;
+
+   assert(dir != NULL);
+
+   if (!Shard_isActive)
+      return FALSE;
+
+   path = Dir_getPath(dir);
+   depth = Shard_getDepth(path);
+   if (depth > shardDepth)
+      return FALSE;
+
+   /* the directories below one above them may be in any shard */
+   if (depth < shardDepth) {
+      Lock_add(numRemovals, 1);
+      for (i = 0; i < numShards; i++)
+         Shard_removePrefix(&shards[i].shard, path, strlen(path));
+      return TRUE;
+   }
+
+   NameKey_init(&key, path, strlen(path));
+   shard = &shards[key.hash % numShards].shard;
+
+   Lock_acquire(&shard->lock);
+
+   link = Shard_find(shard, path, strlen(path), key.hash);
+   if (*link != NULL) {
+      entry = *link;
+      *link = entry->next;
+      free(entry);
+      shard->numEntries--;
+   }
+
+   Lock_release(&shard->lock);
+   return FALSE;
+}
+
+/* see shard.h for specification */
+void Shard_endRemoval(void) {
+   assert(numRemovals > 0);
+
+   Lock_sub(numRemovals, 1);
+}
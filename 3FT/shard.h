@@ -0,0 +1,79 @@
+/*--------------------------------------------------------------------*/
+/* shard.h                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef SHARD_INCLUDED
+#define SHARD_INCLUDED
+
+#include <stddef.h>
+#include "a4def.h"
+#include "directory.h"
+
+/*
+   Shard is an AO that routes concurrent writers (see FT_useShards)
+   past the top of the tree. The directories at a fixed depth, the
+   tops of the subtrees writers are spread over, are kept by path in
+   shards, to which the hash of its path routes each, and each shard
+   has a lock of its own, so that a writer below one of them finds and
+   locks it there rather than locking every directory above it, and
+   writers routed to different shards do not wait for one another.
+
+   A writer finds and locks a directory holding its shard, without
+   waiting for the directory, while writers add and remove them
+   holding directories above them, so that neither ever waits for
+   what the other holds.
+*/
+
+/* whether Shard is active; only Shard_init and Shard_destroy may
+   change it */
+extern boolean Shard_isActive;
+
+/*
+   Makes Shard active, with numShards shards of the directories depth
+   components deep, if numShards is not 0, and if able to allocate
+   them. Lock must be active (see lock.h).
+*/
+void Shard_init(size_t numShards, size_t depth);
+
+/*
+   Forgets every directory and makes Shard inactive.
+*/
+void Shard_destroy(void);
+
+/*
+   Returns the directory whose path is the first depth components of
+   path, locked as Dir_lock locks it, and stores the length of its
+   path in *pLength. Returns NULL, leaving *pLength unchanged, if
+   Shard is not active, if path is not that deep, or if the directory
+   is not in its shard or is held by another writer for long.
+*/
+Dir_T Shard_lockDir(const char *path, size_t *pLength);
+
+/*
+   Adds dir to its shard if it is depth components deep, unless
+   unable to allocate sufficient memory, or unless a directory above
+   the shards' directories is being removed (see Shard_removeBelow).
+   The calling writer must hold a directory above dir, through which
+   dir was just linked into the tree, and be done changing dir and
+   the directories below it.
+*/
+void Shard_add(Dir_T dir);
+
+/*
+   Removes dir, and every directory below it, from their shards. The
+   calling writer must hold dir, and unlink it from the tree only
+   once they are removed. Returns TRUE if dir is above the shards'
+   directories, so that writers still below it might otherwise add
+   new ones: none is then added until Shard_endRemoval, which the
+   caller must call once no writer is left below dir. Returns FALSE
+   otherwise.
+*/
+boolean Shard_removeBelow(Dir_T dir);
+
+/*
+   Ends the removal that made Shard_removeBelow return TRUE.
+*/
+void Shard_endRemoval(void);
+
+#endif
@@ -8,6 +8,8 @@
 #include "defs.h"
 #include "traverser.h"
 #include "checkerFT.h"
+#include "pathview.h"
+#include "metrics.h"
 
 /* 
    Traverser is a stateless module whose functions are related to the
@@ -25,11 +27,9 @@
 */
 Dir_T Traverser_traversePath(Dir_T curr, char* path) {
 
-   Dir_T found;
    Dir_T child;
-   size_t i;
-   size_t lenDirC;
-   const char* currPath;
+   struct PathView view;
+   size_t index;
 
    if (curr == NULL)
       return NULL;
@@ -37,84 +37,68 @@ Dir_T Traverser_traversePath(Dir_T curr, char* path) {
    assert(path != NULL);
    assert(CheckerFT_Dir_isValid(curr));
 
-   currPath = Dir_getPath(curr);
-   lenDirC = Dir_getNumChildren(curr, DIR);
-
-   /* if current path matches full path, returns current directory */
-   if (strcmp(path, currPath) == EQUAL)
-      return curr;
+   Metrics_count(METRICS_NODES_VISITED);
+   index = strlen(Dir_getPath(curr));
 
-   /* if current path is a prefix of full path */
-   if (strncmp(path, currPath, strlen(currPath)) == EQUAL) {
+   /* if current path is not a prefix of full path, up to a '/' */
+   if (strncmp(path, Dir_getPath(curr), index) != EQUAL ||
+       (path[index] != '\0' && path[index] != '/'))
+      return NULL;
 
-      for (i = 0; i < lenDirC; i++) {
-         child = Dir_getChild(curr, i, DIR);
-         found = Traverser_traversePath(child, path);
-         if (found != NULL)
-            return found;
-      }  
+   if (path[index] == '\0')
       return curr;
+
+   /* 
+      Each child's path is its parent's path, a '/' and its name, so
+      the next component of path names the only child that may match
+      further. Searching by name finds it without reading the other
+      children, which readers may do while Epoch is active.
+   */
+   PathView_init(&view, path, index + 1);
+   while (PathView_next(&view)) {
+      child = Dir_findChild(curr, path + view.offset, view.length, DIR);
+      if (child == NULL)
+         break;
+
+      Metrics_count(METRICS_NODES_VISITED);
+      curr = child;
    }
 
-   return NULL;
+   return curr;
 }
 
 /* Returns NOT_A_DIRECTORY if proper prefix of path exists in the tree 
-   as a file. Returns MEMORY_ERROR if unable to allocate sufficient
-   memory. Returns SUCCESS if there is no file with such proper prefix
+   as a file. Returns SUCCESS if there is no file with such proper
+   prefix
 
    Parameter path is the full path at hand. dir is farthest matching
    directory in the path
 */
 int Traverser_NotADir(Dir_T dir, const char* path) {
 
+   struct PathView view;
    size_t index;
-   size_t slashCount = 0;
-   size_t i;
-   char* copy;
-   enum {SECOND_SLASH = 2};
 
    assert(dir != NULL);
    assert(path != NULL);
 
    index = strlen(Dir_getPath(dir));
 
+   /* if path is dir's own path, it has no prefix below dir */
+   if (path[index] != '/')
+      return SUCCESS;
+
    /* 
-      For a given parentPath/next/restOfPath, we need to
-      break not in the first, but in the second occurrence
-      of / to get parentPath/next
+      For a given parentPath/next/restOfPath, only next may name
+      a file of dir
    */
-   while (path[index] != '\0') {
-
-      if (path[index] == '/') {
-         slashCount++;
-
-            if (slashCount == SECOND_SLASH)
-            break;
-      }
-      index++;
-   }
-
-   /* enough memory for parentPath/next + '\0' */
-   copy = (char*)malloc(index+1);
-
-   if (copy == NULL)
-      return MEMORY_ERROR;
-
-   *copy = '\0';
-
-   /* copy parentPath/next */
-   for (i = 0; i < index; i++)
-      copy[i] = path[i];
+   PathView_init(&view, path, index + 1);
+   (void) PathView_next(&view);
 
-   copy[i] = '\0';
-         
-   if (Dir_hasChild(dir, copy, NULL, FILES) == TRUE) {
-      free(copy);
+   if (Dir_hasChildName(dir, path + view.offset, view.length,
+                        FILES) == TRUE)
       return NOT_A_DIRECTORY;
-   }
 
-   free(copy);
    return SUCCESS;
 }
 
@@ -144,46 +128,25 @@ Dir_T Traverser_getDir(Dir_T dir, char* path) {
 }
 
 /* for a given file whose path (parameter path) is "prefix/filename," 
-   creates string prefix and returns it.
+   returns the length of prefix.
 
-   If unable to allocate sufficient memory, returns NULL.
-
-   Allocates memory for prefix, which is then owned by the caller!
+   If path is unique (i.e, root's path), returns the length of path.
 */
-char *Traverser_getPrefix(char *path) {
+size_t Traverser_getPrefix(const char *path) {
 
-   char* prefix;
-   size_t index = 0;
-   size_t i = 0;
+   struct PathView view;
    
    assert(path != NULL);
 
-   while (path[i] != '\0') {
-
-      if (path[i] == '/')
-         index = i;
-
-      i++;
-   }
+   PathView_init(&view, path, 0);
+   while (PathView_next(&view))
+      ;
 
    /* if path is the root (no /) */
-   if (index == 0)
-      index = i + 1;
-
-   /* enough memory for char* from 0 to index-1 plus \0 */
-   prefix = (char*)malloc(index+1);
+   if (view.offset == 0)
+      return view.length;
 
-   if (prefix == NULL)
-      return NULL;
-
-   *prefix = '\0';
-
-   for (i = 0; i < index; i++)
-      prefix[i] = path[i];
-
-   prefix[index] = '\0';
-
-   return prefix;
+   return view.offset - 1;
 }
 
 /* 
@@ -194,7 +157,7 @@ char *Traverser_getPrefix(char *path) {
 File_T Traverser_getFile(Dir_T dir, char* path) {
 
    Dir_T parent;
-   size_t childID = 0;
+   const char* name;
 
    assert(dir != NULL);
    assert(path != NULL);
@@ -204,10 +167,13 @@ File_T Traverser_getFile(Dir_T dir, char* path) {
    if (parent == NULL)
       return NULL;
 
-   if (Dir_hasChild(parent, path, &childID, FILES) == TRUE)
-      return Dir_getChild(parent, childID, FILES);
+   /* the file's name is the rest of path after parent's path */
+   name = path + strlen(Dir_getPath(parent));
+   if (*name != '/')
+      return NULL;
+   name++;
 
-   return NULL;
+   return Dir_findChild(parent, name, strlen(name), FILES);
 }
 
 /* Performs a pre-order traversal of the tree rooted at parameter dir,
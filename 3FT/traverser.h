@@ -26,8 +26,8 @@ Dir_T Traverser_traversePath(Dir_T curr, char* path);
 
 
 /* Returns NOT_A_DIRECTORY if proper prefix of path exists in the tree 
-   as a file. Returns MEMORY_ERROR if unable to allocate sufficient
-   memory. Returns SUCCESS if there is no file with such proper prefix
+   as a file. Returns SUCCESS if there is no file with such proper
+   prefix
 
    Parameter path is the full path at hand. dir is farthest matching
    directory in the path
@@ -45,15 +45,12 @@ Dir_T Traverser_getDir(Dir_T dir, char* path);
 
 
 /* For a given file whose path (parameter path) is "prefix/filename," 
-   creates string prefix and returns it.
+   returns the length of prefix, so that prefix is the first bytes
+   of path.
 
-   If path is unique (i.e, root's path), returns a copy of path.
-
-   If unable to allocate sufficient memory, returns NULL.
-
-   Allocates memory for prefix, which is then owned by the caller!
+   If path is unique (i.e, root's path), returns the length of path.
 */
-char *Traverser_getPrefix(char *path);
+size_t Traverser_getPrefix(const char *path);
 
 /* 
    Starting at parameter dir, looks for file whose full path matches 
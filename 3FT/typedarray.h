@@ -0,0 +1,268 @@
+/*--------------------------------------------------------------------*/
+/* typedarray.h                                                       */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef TYPEDARRAY_INCLUDED
+#define TYPEDARRAY_INCLUDED
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/*
+   DEFINE_DYNARRAY(Name, T, compare) defines Name_T, a DynArray whose
+   elements have type T, with the subset of the DynArray API below.
+   Unlike a DynArray_T, it stores its elements as T's, and its
+   functions are static and inlinable, so that gets, bounds checks and
+   the calls to compare in Name_bsearch can be compiled into the
+   client's own loops.
+
+   compare(T element1, T element2) must return <0, 0, or >0 depending
+   upon whether element1 is less than, equal to, or greater than
+   element2. It may be a function or a macro.
+
+   Use DEFINE_DYNARRAY at file scope, at most once per Name in each
+   module, where T and compare are declared.
+
+   A module that accounts for its memory may define
+   TYPEDARRAY_ACCOUNT(allocated, freed, used, unused) before including
+   this file. The generated functions then call it whenever bytes of
+   an array are allocated or freed, or bytes of its underlying array
+   start or stop holding elements.
+
+   Name_T Name_new(size_t uLength)
+      Return a new Name_T whose length is uLength, or NULL if
+      insufficient memory is available.
+   void Name_free(Name_T oArray)
+      Free oArray.
+   size_t Name_getLength(Name_T oArray)
+      Return the length of oArray.
+   T Name_get(Name_T oArray, size_t uIndex)
+      Return the uIndex'th element of oArray.
+   T Name_set(Name_T oArray, size_t uIndex, T element)
+      Assign element to the uIndex'th element of oArray. Return the
+      old element.
+   int Name_addAt(Name_T oArray, size_t uIndex, T element)
+      Add element to oArray such that it is the uIndex'th element.
+      Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+      memory is available.
+   T Name_removeAt(Name_T oArray, size_t uIndex)
+      Remove and return the uIndex'th element of oArray.
+   Name_T Name_addAtCopy(Name_T oArray, size_t uIndex, T element)
+      Return a new Name_T holding the elements of oArray with element
+      added as the uIndex'th one, leaving oArray unchanged, or NULL
+      if insufficient memory is available.
+   Name_T Name_removeAtCopy(Name_T oArray, size_t uIndex)
+      Return a new Name_T holding the elements of oArray but the
+      uIndex'th one, leaving oArray unchanged, or NULL if
+      insufficient memory is available.
+   int Name_bsearch(Name_T oArray, T sought, size_t *puIndex)
+      Binary search oArray, which must be sorted as determined by
+      compare, for sought. If it is found, then assign its index to
+      *puIndex and return 1. If not, then assign the index where it
+      would belong to *puIndex and return 0.
+*/
+
+/* The storage class of the generated functions. -ansi has no inline
+   keyword, but GCC accepts __inline__ in every mode. */
+#if defined(__GNUC__)
+#define TYPEDARRAY_FUNCTION static __inline__
+#else
+#define TYPEDARRAY_FUNCTION static
+#endif
+
+/* By default, the memory of typed arrays is not accounted for */
+#if !defined(TYPEDARRAY_ACCOUNT)
+#define TYPEDARRAY_ACCOUNT(allocated, freed, used, unused) ((void)0)
+#endif
+
+/* The minimum physical length of a typed array */
+#define TYPEDARRAY_MIN_PHYS_LENGTH 2
+
+#define DEFINE_DYNARRAY(Name, T, compare)                              \
+                                                                       \
+struct Name {                                                          \
+   /* the number of elements from the client's point of view */        \
+   size_t uLength;                                                     \
+   /* the number of elements of the underlying array */                \
+   size_t uPhysLength;                                                 \
+   /* the underlying array */                                          \
+   T *pArray;                                                          \
+};                                                                     \
+                                                                       \
+typedef struct Name *Name##_T;                                         \
+                                                                       \
+TYPEDARRAY_FUNCTION Name##_T Name##_new(size_t uLength) {              \
+   Name##_T oArray;                                                    \
+                                                                       \
+   oArray = (Name##_T)malloc(sizeof(struct Name));                     \
+   if (oArray == NULL)                                                 \
+      return NULL;                                                     \
+                                                                       \
+   oArray->uLength = uLength;                                          \
+   if (uLength > TYPEDARRAY_MIN_PHYS_LENGTH)                           \
+      oArray->uPhysLength = uLength;                                   \
+   else                                                                \
+      oArray->uPhysLength = TYPEDARRAY_MIN_PHYS_LENGTH;                \
+                                                                       \
+   oArray->pArray = (T *)calloc(oArray->uPhysLength, sizeof(T));       \
+   if (oArray->pArray == NULL) {                                       \
+      free(oArray);                                                    \
+      return NULL;                                                     \
+   }                                                                   \
+                                                                       \
+   TYPEDARRAY_ACCOUNT(sizeof(struct Name) +                            \
+                      oArray->uPhysLength * sizeof(T), 0,              \
+                      uLength * sizeof(T), 0);                         \
+   return oArray;                                                      \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION void Name##_free(Name##_T oArray) {                \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   TYPEDARRAY_ACCOUNT(0, sizeof(struct Name) +                         \
+                      oArray->uPhysLength * sizeof(T),                 \
+                      0, oArray->uLength * sizeof(T));                 \
+   free(oArray->pArray);                                               \
+   free(oArray);                                                       \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION size_t Name##_getLength(Name##_T oArray) {         \
+   assert(oArray != NULL);                                             \
+                                                                       \
+   return oArray->uLength;                                             \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION T Name##_get(Name##_T oArray, size_t uIndex) {     \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   return oArray->pArray[uIndex];                                      \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION T Name##_set(Name##_T oArray, size_t uIndex,       \
+                                 T element) {                          \
+   T old;                                                              \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   old = oArray->pArray[uIndex];                                       \
+   oArray->pArray[uIndex] = element;                                   \
+   return old;                                                         \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION int Name##_addAt(Name##_T oArray, size_t uIndex,   \
+                                     T element) {                      \
+   T *pNewArray;                                                       \
+   size_t u;                                                           \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex <= oArray->uLength);                                  \
+                                                                       \
+   /* doubles the physical length when full */                         \
+   if (oArray->uLength == oArray->uPhysLength) {                       \
+      pNewArray = (T *)realloc(oArray->pArray,                         \
+                               sizeof(T) * 2 * oArray->uPhysLength);   \
+      if (pNewArray == NULL)                                           \
+         return 0;                                                     \
+      TYPEDARRAY_ACCOUNT(oArray->uPhysLength * sizeof(T), 0, 0, 0);    \
+      oArray->uPhysLength *= 2;                                        \
+      oArray->pArray = pNewArray;                                      \
+   }                                                                   \
+                                                                       \
+   for (u = oArray->uLength; u > uIndex; u--)                          \
+      oArray->pArray[u] = oArray->pArray[u - 1];                       \
+   oArray->pArray[uIndex] = element;                                   \
+   oArray->uLength++;                                                  \
+   TYPEDARRAY_ACCOUNT(0, 0, sizeof(T), 0);                             \
+   return 1;                                                           \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION T Name##_removeAt(Name##_T oArray, size_t uIndex) {\
+   T old;                                                              \
+   size_t u;                                                           \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   old = oArray->pArray[uIndex];                                       \
+   for (u = uIndex + 1; u < oArray->uLength; u++)                      \
+      oArray->pArray[u - 1] = oArray->pArray[u];                       \
+   oArray->uLength--;                                                  \
+   TYPEDARRAY_ACCOUNT(0, 0, 0, sizeof(T));                             \
+   return old;                                                         \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION Name##_T Name##_addAtCopy(Name##_T oArray,         \
+                                              size_t uIndex,           \
+                                              T element) {             \
+   Name##_T oCopy;                                                     \
+   size_t u;                                                           \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex <= oArray->uLength);                                  \
+                                                                       \
+   oCopy = Name##_new(oArray->uLength + 1);                            \
+   if (oCopy == NULL)                                                  \
+      return NULL;                                                     \
+                                                                       \
+   for (u = 0; u < uIndex; u++)                                        \
+      oCopy->pArray[u] = oArray->pArray[u];                            \
+   oCopy->pArray[uIndex] = element;                                    \
+   for (u = uIndex; u < oArray->uLength; u++)                          \
+      oCopy->pArray[u + 1] = oArray->pArray[u];                        \
+   return oCopy;                                                       \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION Name##_T Name##_removeAtCopy(Name##_T oArray,      \
+                                                 size_t uIndex) {      \
+   Name##_T oCopy;                                                     \
+   size_t u;                                                           \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(uIndex < oArray->uLength);                                   \
+                                                                       \
+   oCopy = Name##_new(oArray->uLength - 1);                            \
+   if (oCopy == NULL)                                                  \
+      return NULL;                                                     \
+                                                                       \
+   for (u = 0; u < uIndex; u++)                                        \
+      oCopy->pArray[u] = oArray->pArray[u];                            \
+   for (u = uIndex + 1; u < oArray->uLength; u++)                      \
+      oCopy->pArray[u - 1] = oArray->pArray[u];                        \
+   return oCopy;                                                       \
+}                                                                      \
+                                                                       \
+TYPEDARRAY_FUNCTION int Name##_bsearch(Name##_T oArray, T sought,      \
+                                       size_t *puIndex) {              \
+   size_t uLow = 0;                                                    \
+   size_t uHigh;                                                       \
+   size_t uMid;                                                        \
+   int iCompare;                                                       \
+                                                                       \
+   assert(oArray != NULL);                                             \
+   assert(puIndex != NULL);                                            \
+                                                                       \
+   uHigh = oArray->uLength;                                            \
+   while (uLow < uHigh) {                                              \
+      uMid = uLow + (uHigh - uLow) / 2;                                \
+      iCompare = compare(sought, oArray->pArray[uMid]);                \
+      if (iCompare == 0) {                                             \
+         *puIndex = uMid;                                              \
+         return 1;                                                     \
+      }                                                                \
+      if (iCompare < 0)                                                \
+         uHigh = uMid;                                                 \
+      else                                                             \
+         uLow = uMid + 1;                                              \
+   }                                                                   \
+                                                                       \
+   *puIndex = uLow;                                                    \
+   return 0;                                                           \
+}                                                                      \
+                                                                       \
+typedef int Name##_defined
+
+#endif
@@ -0,0 +1,560 @@
+/*--------------------------------------------------------------------*/
+/* watch.c                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "defs.h"
+#include "watch.h"
+#include "pathview.h"
+
+#if defined(__GNUC__)
+#include <pthread.h>
+#endif
+
+/* A node of the trie of watches, for a prefix of paths */
+struct node {
+   /* the last component of the prefix, and its length */
+   char *name;
+   size_t length;
+
+   /* the node of the prefix without its last component, NULL for the
+      root of the trie, whose prefix is empty */
+   struct node *parent;
+   /* the first node of the prefixes with one more component, each
+      linked to the next by sibling */
+   struct node *child;
+   struct node *sibling;
+
+   /* the watches of the prefix, each linked to the next by next */
+   struct FT_Watch *watches;
+};
+
+/* A watch of a prefix */
+struct FT_Watch {
+   FT_WatchCallback callback;
+   void *ctx;
+
+   /* the node of the prefix, and the next watch there */
+   struct node *node;
+   struct FT_Watch *next;
+
+   /* the changes to tell the callback, numBatched of them in an array
+      of capacity elements */
+   struct FT_WatchEvent *batch;
+   size_t numBatched;
+   size_t capacity;
+   /* the next watch with changes to tell, while this one has some */
+   struct FT_Watch *nextPending;
+};
+
+/* A change queued for the dispatcher */
+struct change {
+   struct FT_WatchEvent event;
+   struct change *next;
+};
+
+/* A list of changes, in the order they were made */
+struct queue {
+   struct change *head;
+   struct change *tail;
+   size_t length;
+};
+
+/* The Watch AO has 7 state variables: */
+
+/* the root of the trie of watches */
+static struct node trieRoot;
+/* the number of watches, which writers read without locking, so that
+   a change made while the first watch is added may be missed */
+static size_t numWatches;
+/* the changes queued for the dispatcher */
+static struct queue queued;
+/* whether changes are held, and those held (see Watch_hold) */
+static boolean isHeld;
+static struct queue held;
+/* the number of changes ever queued, and of those told so far */
+static unsigned long numQueued;
+static unsigned long numTold;
+
+#if defined(__GNUC__)
+/* the lock of the queue, the held changes and the counts, which the
+   dispatcher waits on to be signalled of changes, and Watch_flush to
+   be signalled that they were told */
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueChanged = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t changesTold = PTHREAD_COND_INITIALIZER;
+/* the lock of the trie, held while changes are told */
+static pthread_mutex_t trieLock = PTHREAD_MUTEX_INITIALIZER;
+/* the dispatcher, if it was started, and whether it must stop */
+static pthread_t dispatcher;
+static boolean isDispatching;
+static boolean mustStop;
+
+#define Watch_lock(lock) ((void) pthread_mutex_lock(lock))
+#define Watch_unlock(lock) ((void) pthread_mutex_unlock(lock))
+#else
+/* without threads, changes are told by Watch_flush */
+#define Watch_lock(lock) ((void) 0)
+#define Watch_unlock(lock) ((void) 0)
+#endif
+
+
+/* Returns the child of node named by the length bytes at name, or NULL
+   if there is none */
+static struct node *Watch_findChild(struct node *node, const char *name,
+                                    size_t length) {
+   struct node *child;
+
+   for (child = node->child; child != NULL; child = child->sibling) {
+      if (child->length == length &&
+          memcmp(child->name, name, length) == EQUAL)
+         return child;
+   }
+
+   return NULL;
+}
+
+/* Frees node, and those above it, up to the root of the trie, as long
+   as they have neither watches nor children */
+static void Watch_prune(struct node *node) {
+   struct node *parent;
+   struct node **link;
+
+   while (node != &trieRoot && node->watches == NULL &&
+          node->child == NULL) {
+      parent = node->parent;
+      for (link = &parent->child; *link != node; link = &(*link)->sibling)
+         ;
+      *link = node->sibling;
+
+      free(node->name);
+      free(node);
+      node = parent;
+   }
+}
+
+/* Returns the node of prefix, adding the nodes it lacks to the trie,
+   or NULL, leaving the trie unchanged, if unable to allocate
+   sufficient memory. Empty components of prefix are skipped. */
+static struct node *Watch_getNode(const char *prefix) {
+   struct PathView view;
+   struct node *node = &trieRoot;
+   struct node *child;
+
+   PathView_init(&view, prefix, 0);
+
+   while (PathView_next(&view)) {
+      if (view.length == 0)
+         continue;
+
+      child = Watch_findChild(node, prefix + view.offset, view.length);
+      if (child == NULL) {
+         child = (struct node *)calloc(1, sizeof(struct node));
+         if (child != NULL)
+            child->name = (char *)malloc(view.length);
+
+         if (child == NULL || child->name == NULL) {
+            free(child);
+            Watch_prune(node);
+            return NULL;
+         }
+
+         memcpy(child->name, prefix + view.offset, view.length);
+         child->length = view.length;
+         child->parent = node;
+         child->sibling = node->child;
+         node->child = child;
+      }
+
+      node = child;
+   }
+
+   return node;
+}
+
+/* Adds event to the batch of watch, and watch to the list of watches
+   with changes starting at *pPending if it had none, unless event
+   changes the contents of the file that the last change of the batch
+   already changed. The change is lost if unable to allocate
+   sufficient memory for it. */
+static void Watch_batch(struct FT_Watch *watch,
+                        const struct FT_WatchEvent *event,
+                        struct FT_Watch **pPending) {
+   struct FT_WatchEvent *last;
+   struct FT_WatchEvent *batch;
+   size_t capacity;
+
+   /* coalesces repeated changes of the contents of a file */
+   if (watch->numBatched > 0) {
+      last = &watch->batch[watch->numBatched - 1];
+      if (event->change == FT_MODIFIED && last->change == FT_MODIFIED &&
+          strcmp(event->path, last->path) == EQUAL)
+         return;
+   }
+
+   if (watch->numBatched == watch->capacity) {
+      capacity = watch->capacity == 0 ? 8 : 2 * watch->capacity;
+      batch = (struct FT_WatchEvent *)realloc(watch->batch,
+         capacity * sizeof(struct FT_WatchEvent));
+      if (batch == NULL)
+         return;
+
+      watch->batch = batch;
+      watch->capacity = capacity;
+   }
+
+   if (watch->numBatched == 0) {
+      watch->nextPending = *pPending;
+      *pPending = watch;
+   }
+
+   watch->batch[watch->numBatched++] = *event;
+}
+
+/* Adds event to the batches of the watches of node (see Watch_batch),
+   and, if below is TRUE, to those of the nodes below it */
+static void Watch_batchNode(struct node *node,
+                            const struct FT_WatchEvent *event,
+                            boolean below, struct FT_Watch **pPending) {
+   struct FT_Watch *watch;
+   struct node *child;
+
+   for (watch = node->watches; watch != NULL; watch = watch->next)
+      Watch_batch(watch, event, pPending);
+
+   if (below) {
+      for (child = node->child; child != NULL; child = child->sibling)
+         Watch_batchNode(child, event, TRUE, pPending);
+   }
+}
+
+/* Tells the changes of queue, and frees them. The calling thread must
+   hold trieLock. */
+static void Watch_tell(struct queue *queue) {
+   struct FT_Watch *pending = NULL;
+   struct FT_Watch *watch;
+   struct change *change;
+   struct change *next;
+   struct PathView view;
+   struct node *node;
+
+   /* batches each change for the watches found down its path */
+   for (change = queue->head; change != NULL; change = change->next) {
+      node = &trieRoot;
+      Watch_batchNode(node, &change->event, FALSE, &pending);
+
+      PathView_init(&view, change->event.path, 0);
+      while (node != NULL && PathView_next(&view)) {
+         if (view.length == 0)
+            continue;
+
+         node = Watch_findChild(node, change->event.path + view.offset,
+                                view.length);
+         if (node != NULL)
+            Watch_batchNode(node, &change->event,
+                            (boolean)(PathView_isLast(&view) &&
+                                      !change->event.type &&
+                                      change->event.change == FT_REMOVED),
+                            &pending);
+      }
+   }
+
+   for (watch = pending; watch != NULL; watch = watch->nextPending) {
+      watch->callback(watch->batch, watch->numBatched, watch->ctx);
+      watch->numBatched = 0;
+   }
+
+   for (change = queue->head; change != NULL; change = next) {
+      next = change->next;
+      free(change);
+   }
+
+   queue->head = NULL;
+   queue->tail = NULL;
+   queue->length = 0;
+}
+
+/* Appends the changes of from to to, leaving from empty */
+static void Watch_append(struct queue *to, struct queue *from) {
+   if (from->head == NULL)
+      return;
+
+   if (to->tail == NULL)
+      to->head = from->head;
+   else
+      to->tail->next = from->head;
+
+   to->tail = from->tail;
+   to->length += from->length;
+
+   from->head = NULL;
+   from->tail = NULL;
+   from->length = 0;
+}
+
+#if defined(__GNUC__)
+
+/* Tells the queued changes as they come, until mustStop, for
+   pthread_create */
+static void *Watch_dispatch(void *unused) {
+   struct queue taken;
+   unsigned long target;
+
+   Watch_lock(&queueLock);
+
+   for (;;) {
+      while (queued.head == NULL && !mustStop)
+         (void) pthread_cond_wait(&queueChanged, &queueLock);
+
+      if (queued.head == NULL)
+         break;
+
+      /* the changes queued meanwhile make up the next batches */
+      taken = queued;
+      queued.head = NULL;
+      queued.tail = NULL;
+      queued.length = 0;
+      target = numQueued;
+      Watch_unlock(&queueLock);
+
+      Watch_lock(&trieLock);
+      Watch_tell(&taken);
+      Watch_unlock(&trieLock);
+
+      Watch_lock(&queueLock);
+      numTold = target;
+      (void) pthread_cond_broadcast(&changesTold);
+   }
+
+   Watch_unlock(&queueLock);
+   return unused;
+}
+
+/* Wakes up the dispatcher to tell the queued changes. The calling
+   thread must hold queueLock. */
+static void Watch_signal(void) {
+   (void) pthread_cond_signal(&queueChanged);
+}
+
+/* Starts the dispatcher if it was not. Returns FALSE if unable to,
+   and TRUE otherwise. The calling thread must hold trieLock. */
+static boolean Watch_start(void) {
+   if (isDispatching)
+      return TRUE;
+
+   mustStop = FALSE;
+   isDispatching = (boolean)(pthread_create(&dispatcher, NULL,
+                                            Watch_dispatch, NULL) == 0);
+   return isDispatching;
+}
+
+/* see watch.h for specification */
+void Watch_flush(void) {
+   unsigned long target;
+
+   Watch_lock(&queueLock);
+
+   target = numQueued;
+   while (numTold != target)
+      (void) pthread_cond_wait(&changesTold, &queueLock);
+
+   Watch_unlock(&queueLock);
+}
+
+/* Tells the changes queued so far and stops the dispatcher */
+static void Watch_stop(void) {
+   if (!isDispatching)
+      return;
+
+   Watch_lock(&queueLock);
+   mustStop = TRUE;
+   Watch_signal();
+   Watch_unlock(&queueLock);
+
+   (void) pthread_join(dispatcher, NULL);
+   isDispatching = FALSE;
+}
+
+#else
+
+/* see above */
+static void Watch_signal(void) {
+}
+
+/* see above */
+static boolean Watch_start(void) {
+   return TRUE;
+}
+
+/* see watch.h for specification */
+void Watch_flush(void) {
+   Watch_tell(&queued);
+   numTold = numQueued;
+}
+
+/* see above */
+static void Watch_stop(void) {
+   Watch_flush();
+}
+
+#endif
+
+/* see watch.h for specification */
+struct FT_Watch *Watch_add(const char *prefix, FT_WatchCallback callback,
+                           void *ctx) {
+   struct FT_Watch *watch;
+   struct node *node;
+
+   assert(prefix != NULL);
+   assert(callback != NULL);
+
+   watch = (struct FT_Watch *)calloc(1, sizeof(struct FT_Watch));
+   if (watch == NULL)
+      return NULL;
+
+   Watch_lock(&trieLock);
+
+   node = Watch_getNode(prefix);
+   if (node == NULL || !Watch_start()) {
+      if (node != NULL)
+         Watch_prune(node);
+      Watch_unlock(&trieLock);
+      free(watch);
+      return NULL;
+   }
+
+   watch->callback = callback;
+   watch->ctx = ctx;
+   watch->node = node;
+   watch->next = node->watches;
+   node->watches = watch;
+   numWatches++;
+
+   Watch_unlock(&trieLock);
+   return watch;
+}
+
+/* see watch.h for specification */
+void Watch_remove(struct FT_Watch *watch) {
+   struct FT_Watch **link;
+
+   assert(watch != NULL);
+
+   /* waits for the dispatcher to be done telling changes */
+   Watch_lock(&trieLock);
+
+   for (link = &watch->node->watches; *link != watch;
+        link = &(*link)->next)
+      ;
+   *link = watch->next;
+   numWatches--;
+   Watch_prune(watch->node);
+
+   Watch_unlock(&trieLock);
+
+   free(watch->batch);
+   free(watch);
+}
+
+/* see watch.h for specification */
+void Watch_publish(const char *path, boolean type, enum FT_Change change) {
+   struct change *new;
+   struct queue one;
+   size_t length;
+
+   assert(path != NULL);
+
+   if (numWatches == 0)
+      return;
+
+   /* the path is kept right after the change */
+   length = strlen(path) + 1;
+   new = (struct change *)malloc(sizeof(struct change) + length);
+   if (new == NULL)
+      return;
+
+   memcpy(new + 1, path, length);
+   new->event.path = (const char *)(new + 1);
+   new->event.type = type;
+   new->event.change = change;
+   new->next = NULL;
+
+   one.head = new;
+   one.tail = new;
+   one.length = 1;
+
+   Watch_lock(&queueLock);
+   if (isHeld)
+      Watch_append(&held, &one);
+   else {
+      Watch_append(&queued, &one);
+      numQueued++;
+      Watch_signal();
+   }
+   Watch_unlock(&queueLock);
+}
+
+/* see watch.h for specification */
+void Watch_hold(void) {
+   Watch_lock(&queueLock);
+   isHeld = TRUE;
+   Watch_unlock(&queueLock);
+}
+
+/* see watch.h for specification */
+void Watch_release(boolean deliver) {
+   struct change *change;
+   struct change *next;
+
+   Watch_lock(&queueLock);
+
+   isHeld = FALSE;
+   if (deliver && held.head != NULL) {
+      numQueued += held.length;
+      Watch_append(&queued, &held);
+      Watch_signal();
+   }
+
+   change = held.head;
+   held.head = NULL;
+   held.tail = NULL;
+   held.length = 0;
+
+   Watch_unlock(&queueLock);
+
+   for (; change != NULL; change = next) {
+      next = change->next;
+      free(change);
+   }
+}
+
+/* Removes the watches of node and of the nodes below it, and frees
+   those nodes, other than the root of the trie */
+static void Watch_clear(struct node *node) {
+   struct FT_Watch *watch;
+   struct node *child;
+
+   while (node->watches != NULL) {
+      watch = node->watches;
+      node->watches = watch->next;
+      free(watch->batch);
+      free(watch);
+   }
+
+   while (node->child != NULL) {
+      child = node->child;
+      node->child = child->sibling;
+      Watch_clear(child);
+      free(child->name);
+      free(child);
+   }
+}
+
+/* see watch.h for specification */
+void Watch_destroy(void) {
+   Watch_release(FALSE);
+   Watch_stop();
+
+   Watch_clear(&trieRoot);
+   numWatches = 0;
+}
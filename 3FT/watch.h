@@ -0,0 +1,69 @@
+/*--------------------------------------------------------------------*/
+/* watch.h                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef WATCH_INCLUDED
+#define WATCH_INCLUDED
+
+#include "ft.h"
+
+/*
+   Watch is an AO that tells the clients watching prefixes of paths
+   (see FT_watch) about the changes made to the tree at or below them.
+   The watches are kept in a trie keyed by the components of their
+   prefixes, so that the watches of a change are found by following
+   its path down the trie once.
+
+   Writers only queue their changes: a dispatcher thread finds their
+   watches and calls each one's callback with all its changes queued
+   since the last call, so that a slow callback delays other callbacks
+   but never a writer.
+*/
+
+/*
+   Returns a new watch that has callback called with ctx for the
+   changes at or below prefix (see FT_watch), or NULL if unable to
+   allocate sufficient memory.
+*/
+struct FT_Watch *Watch_add(const char *prefix, FT_WatchCallback callback,
+                           void *ctx);
+
+/*
+   Removes watch, waiting for a call to its callback in progress to
+   return.
+*/
+void Watch_remove(struct FT_Watch *watch);
+
+/*
+   Queues the change of path, a directory if type is FALSE and a file
+   if it is TRUE, for the watches at or above path, and, if path is a
+   directory that was removed, those below it. Costs nothing if there
+   are no watches. The change is lost if unable to allocate
+   sufficient memory for it.
+*/
+void Watch_publish(const char *path, boolean type, enum FT_Change change);
+
+/*
+   Holds the changes published from now on until Watch_release.
+*/
+void Watch_hold(void);
+
+/*
+   Queues the changes held since Watch_hold if deliver is TRUE, and
+   discards them otherwise.
+*/
+void Watch_release(boolean deliver);
+
+/*
+   Waits until every change queued so far has been told to its watches.
+*/
+void Watch_flush(void);
+
+/*
+   Tells the changes queued so far to their watches, removes every
+   watch, and stops the dispatcher thread.
+*/
+void Watch_destroy(void);
+
+#endif
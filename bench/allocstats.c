@@ -0,0 +1,96 @@
+/*--------------------------------------------------------------------*/
+/* allocstats.c                                                       */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "allocstats.h"
+
+/* The AllocStats AO has 1 state variable: */
+
+/* the counts so far */
+static struct AllocStats counts;
+
+#if defined(__GLIBC__)
+
+#include <malloc.h>
+
+/* The allocator's own functions, which the linker gives these names
+   when told to wrap them */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *block, size_t size);
+void __real_free(void *block);
+
+/* Counts block, just allocated, if not NULL */
+static void AllocStats_add(void *block) {
+   if (block == NULL)
+      return;
+
+   counts.liveBlocks++;
+   counts.liveBytes += (long)malloc_usable_size(block);
+}
+
+/* Stops counting block, about to be freed, if not NULL */
+static void AllocStats_remove(void *block) {
+   if (block == NULL)
+      return;
+
+   counts.liveBlocks--;
+   counts.liveBytes -= (long)malloc_usable_size(block);
+}
+
+/* Counts a call to malloc, in its stead */
+void *__wrap_malloc(size_t size) {
+   void *block = __real_malloc(size);
+
+   counts.numAllocs++;
+   AllocStats_add(block);
+   return block;
+}
+
+/* Counts a call to calloc, in its stead */
+void *__wrap_calloc(size_t count, size_t size) {
+   void *block = __real_calloc(count, size);
+
+   counts.numAllocs++;
+   AllocStats_add(block);
+   return block;
+}
+
+/* Counts a call to realloc, in its stead; the block is left as it was
+   if realloc fails */
+void *__wrap_realloc(void *block, size_t size) {
+   size_t oldSize = block != NULL ? malloc_usable_size(block) : 0;
+   void *newBlock = __real_realloc(block, size);
+
+   counts.numAllocs++;
+   if (newBlock == NULL)
+      return NULL;
+
+   if (block != NULL) {
+      counts.liveBlocks--;
+      counts.liveBytes -= (long)oldSize;
+   }
+   AllocStats_add(newBlock);
+   return newBlock;
+}
+
+/* Counts a call to free, in its stead */
+void __wrap_free(void *block) {
+   if (block != NULL)
+      counts.numFrees++;
+   AllocStats_remove(block);
+   __real_free(block);
+}
+
+#endif
+
+/* see allocstats.h for specification */
+void AllocStats_get(struct AllocStats *stats) {
+   assert(stats != NULL);
+
+   *stats = counts;
+}
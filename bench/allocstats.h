@@ -0,0 +1,34 @@
+/*--------------------------------------------------------------------*/
+/* allocstats.h                                                       */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef ALLOCSTATS_INCLUDED
+#define ALLOCSTATS_INCLUDED
+
+/*
+   AllocStats is an AO that counts the calls to malloc, calloc,
+   realloc and free made by the modules linked with it, and the heap
+   memory they hold, so that bench can compare engines, none of which
+   counts its own allocations the same way. It wraps the allocator at
+   link time (with the GNU linker's --wrap=malloc, --wrap=calloc,
+   --wrap=realloc and --wrap=free), so the engines need no change.
+   Memory is measured as the usable size of each block, which glibc
+   reports; without glibc, everything stays 0.
+*/
+
+struct AllocStats {
+   /* the calls that allocated or resized a block, and that freed one */
+   unsigned long numAllocs;
+   unsigned long numFrees;
+   /* the blocks held, and their usable bytes */
+   long liveBlocks;
+   long liveBytes;
+};
+
+/*
+   Fills *stats with the counts since the program started.
+*/
+void AllocStats_get(struct AllocStats *stats);
+
+#endif
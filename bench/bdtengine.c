@@ -0,0 +1,18 @@
+/*--------------------------------------------------------------------*/
+/* bdtengine.c                                                        */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "bdt.h"
+#include "engine.h"
+
+/* Returns whether the tree contains the directory at path */
+static int BDTEngine_contains(char *path) {
+   return BDT_containsPath(path) == TRUE;
+}
+
+/* see engine.h for specification */
+const struct Engine Engine_bdt = {
+   "BDT", BDT_init, BDT_destroy, BDT_insertPath, BDTEngine_contains,
+   BDT_rmPath
+};
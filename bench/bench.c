@@ -0,0 +1,610 @@
+/*--------------------------------------------------------------------*/
+/* bench.c                                                            */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not ANSI C */
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "engine.h"
+#include "allocstats.h"
+#include "ft.h"
+
+/*
+   bench replays the same directory-only workloads against every
+   engine (see engine.h) and reports, side by side, the latency and
+   allocations per operation of each phase, the operations that
+   failed, the heap held once every path is inserted, and the heap
+   still held once the tree is destroyed. It then replays a workload
+   of files against FT alone, with compression off and on.
+
+   Usage: bench [size [runs]]
+
+   Each workload inserts its paths in order, looks them up in order,
+   then removes them in reverse order:
+      binary   the leaves of a complete binary tree of at most size
+               leaves, whose directories are made as their leaves
+               are inserted
+      chain    a single path size/16 directories deep, inserted one
+               directory at a time
+      wide     size directories in one, past the 2 children that a
+               BDT allows, so that its failures show the cost of
+               bounding the fan-out
+      files    size/16 files of 4096 bytes of text each, inserted
+               then read with FT_getFileContents in order, so that
+               FT's cache of unpacked contents misses on every read
+               and what is measured is the cost of unpacking; with
+               compression on, FT keeps its own copy of every file
+               and the client frees its buffers, while with it off
+               FT holds the client's buffers, so the memory to
+               compare is that of the client and FT together
+   Latencies are those of the fastest of runs runs (5 by default).
+*/
+
+/* The default size of the workloads, and number of runs of each */
+enum {DEFAULT_SIZE = 4096, DEFAULT_RUNS = 5};
+
+/* The depth of a chain, per unit of size */
+enum {CHAIN_DIVISOR = 16};
+
+/* The number of files, per unit of size, the length of the contents
+   of each, and the threshold from which FT packs contents while
+   compression is on */
+enum {FILE_DIVISOR = 16, FILE_LENGTH = 4096, FILE_THRESHOLD = 256};
+
+/* The width of the labels of the rows of the report */
+enum {LABEL_WIDTH = 24};
+
+/* The engines, in the order of the columns of the report */
+static const struct Engine *const engines[] = {
+   &Engine_bdt, &Engine_dt, &Engine_ft
+};
+enum {NUM_ENGINES = sizeof(engines) / sizeof(engines[0])};
+
+/* The phases of a workload, and their names */
+enum Phase {PHASE_INSERT, PHASE_CONTAINS, PHASE_RM, NUM_PHASES};
+static const char *const phaseNames[NUM_PHASES] = {
+   "insert", "contains", "rm"
+};
+
+/* A workload: its paths, in the order they are inserted, and the
+   contents of the file at each path, NULL for directory workloads */
+struct Workload {
+   const char *name;
+   char **paths;
+   char **contents;
+   size_t numPaths;
+};
+
+/* The results of an engine on a workload */
+struct Result {
+   /* of each phase, the nanoseconds per operation of the fastest run,
+      and the allocations per operation and failed operations */
+   double nanos[NUM_PHASES];
+   double allocs[NUM_PHASES];
+   unsigned long numFailed[NUM_PHASES];
+   /* the heap held once every path is inserted, and still held once
+      the tree is destroyed */
+   long bytes;
+   long blocks;
+   long leakedBytes;
+};
+
+/* The results of FT on the files workload, with compression off or
+   on */
+struct FileResult {
+   /* the nanoseconds per insertion and per read of the fastest run,
+      and the failed operations, wrong contents included */
+   double insertNanos;
+   double getNanos;
+   unsigned long numFailed;
+   /* the bytes compression saves, and the reads not served from the
+      cache */
+   size_t savedBytes;
+   size_t numMisses;
+   /* once every file is inserted, the heap FT holds, and the heap FT
+      and the client hold together, the client keeping its buffers of
+      contents only if FT does not copy them */
+   long ftBytes;
+   long bytes;
+};
+
+
+/* Returns the time, in nanoseconds of a monotonic clock */
+static double Bench_now(void) {
+   struct timespec now;
+
+   if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+      return 0;
+
+   return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+/* Returns a new string of length bytes, which the caller fills, or
+   exits if unable to allocate it */
+static char *Bench_newPath(size_t length) {
+   char *path = (char *)malloc(length + 1);
+
+   if (path == NULL) {
+      fprintf(stderr, "bench: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   path[length] = '\0';
+   return path;
+}
+
+/* Makes workload hold room for numPaths paths, named name, or exits
+   if unable to allocate it */
+static void Bench_initWorkload(struct Workload *workload,
+                               const char *name, size_t numPaths) {
+   assert(workload != NULL);
+
+   workload->name = name;
+   workload->contents = NULL;
+   workload->numPaths = numPaths;
+   workload->paths = (char **)calloc(numPaths, sizeof(char *));
+   if (workload->paths == NULL) {
+      fprintf(stderr, "bench: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+}
+
+/* Fills workload with the leaves of a complete binary tree of at most
+   size leaves */
+static void Bench_makeBinary(struct Workload *workload, size_t size) {
+   size_t depth = 0;
+   size_t i;
+   size_t d;
+   char *path;
+
+   while (((size_t)2 << depth) <= size)
+      depth++;
+
+   Bench_initWorkload(workload, "binary", (size_t)1 << depth);
+
+   for (i = 0; i < workload->numPaths; i++) {
+      path = Bench_newPath(1 + 2 * depth);
+      path[0] = 't';
+      for (d = 0; d < depth; d++) {
+         path[1 + 2 * d] = '/';
+         path[2 + 2 * d] = (char)('0' + ((i >> (depth - 1 - d)) & 1));
+      }
+      workload->paths[i] = path;
+   }
+}
+
+/* Fills workload with the directories of a single path size/16
+   directories deep, each one directory below the one before it */
+static void Bench_makeChain(struct Workload *workload, size_t size) {
+   size_t numPaths = size / CHAIN_DIVISOR;
+   char component[32];
+   char *path;
+   size_t length;
+   size_t i;
+
+   if (numPaths == 0)
+      numPaths = 1;
+
+   Bench_initWorkload(workload, "chain", numPaths);
+
+   workload->paths[0] = Bench_newPath(1);
+   workload->paths[0][0] = 't';
+   for (i = 1; i < numPaths; i++) {
+      sprintf(component, "/d%lu", (unsigned long)i);
+      length = strlen(workload->paths[i - 1]);
+      path = Bench_newPath(length + strlen(component));
+      memcpy(path, workload->paths[i - 1], length);
+      strcpy(path + length, component);
+      workload->paths[i] = path;
+   }
+}
+
+/* Fills workload with size directories of one directory, named with
+   as many digits each, since DT takes a directory for the parent of
+   any path that starts with its path, even without a '/' after it */
+static void Bench_makeWide(struct Workload *workload, size_t size) {
+   char path[32];
+   size_t i;
+
+   Bench_initWorkload(workload, "wide", size);
+
+   for (i = 0; i < size; i++) {
+      sprintf(path, "t/c%010lu", (unsigned long)i);
+      workload->paths[i] = strcpy(Bench_newPath(strlen(path)), path);
+   }
+}
+
+/* Fills workload with size/16 files of one directory, each holding
+   FILE_LENGTH bytes of lines of text that differ from file to file
+   and from line to line, as a log's do */
+static void Bench_makeFiles(struct Workload *workload, size_t size) {
+   size_t numPaths = size / FILE_DIVISOR;
+   char line[128];
+   char path[32];
+   char *contents;
+   size_t length;
+   size_t n;
+   size_t i;
+
+   if (numPaths == 0)
+      numPaths = 1;
+
+   Bench_initWorkload(workload, "files", numPaths);
+   workload->contents = (char **)calloc(numPaths, sizeof(char *));
+   if (workload->contents == NULL) {
+      fprintf(stderr, "bench: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (i = 0; i < numPaths; i++) {
+      sprintf(path, "f/file%010lu", (unsigned long)i);
+      workload->paths[i] = strcpy(Bench_newPath(strlen(path)), path);
+
+      contents = Bench_newPath(FILE_LENGTH);
+      for (length = 0, n = 0; length < FILE_LENGTH; length += n) {
+         sprintf(line, "%08lu file %lu: request served in %lu us\n",
+                 (unsigned long)(length * 7 + i),
+                 (unsigned long)i, (unsigned long)(length % 97));
+         n = strlen(line);
+         if (n > FILE_LENGTH - length)
+            n = FILE_LENGTH - length;
+         memcpy(contents + length, line, n);
+      }
+      workload->contents[i] = contents;
+   }
+}
+
+/* Frees the paths of workload, and their contents */
+static void Bench_freeWorkload(struct Workload *workload) {
+   size_t i;
+
+   assert(workload != NULL);
+
+   for (i = 0; i < workload->numPaths; i++) {
+      free(workload->paths[i]);
+      if (workload->contents != NULL)
+         free(workload->contents[i]);
+   }
+   free(workload->paths);
+   free(workload->contents);
+}
+
+/* Runs phase of workload on engine, and stores in *pNanos the time it
+   took, in nanoseconds, in *pAllocs its allocations, and in
+   *pNumFailed its failed operations */
+static void Bench_runPhase(const struct Engine *engine,
+                           const struct Workload *workload,
+                           enum Phase phase, double *pNanos,
+                           unsigned long *pAllocs,
+                           unsigned long *pNumFailed) {
+   struct AllocStats before;
+   struct AllocStats after;
+   unsigned long numFailed = 0;
+   double start;
+   size_t n = workload->numPaths;
+   size_t i;
+
+   AllocStats_get(&before);
+   start = Bench_now();
+
+   switch (phase) {
+   case PHASE_INSERT:
+      for (i = 0; i < n; i++) {
+         if (engine->insert(workload->paths[i]) != 0)
+            numFailed++;
+      }
+      break;
+   case PHASE_CONTAINS:
+      for (i = 0; i < n; i++) {
+         if (!engine->contains(workload->paths[i]))
+            numFailed++;
+      }
+      break;
+   case PHASE_RM:
+      for (i = n; i > 0; i--) {
+         if (engine->rm(workload->paths[i - 1]) != 0)
+            numFailed++;
+      }
+      break;
+   default:
+      assert(0);
+   }
+
+   *pNanos = Bench_now() - start;
+   AllocStats_get(&after);
+   *pAllocs = after.numAllocs - before.numAllocs;
+   *pNumFailed = numFailed;
+}
+
+/* Runs workload runs times on engine, and stores its results in
+   *result */
+static void Bench_runEngine(const struct Engine *engine,
+                            const struct Workload *workload,
+                            size_t runs, struct Result *result) {
+   struct AllocStats base;
+   struct AllocStats stats;
+   unsigned long allocs;
+   double nanos;
+   size_t run;
+   int phase;
+
+   assert(runs > 0);
+
+   for (run = 0; run < runs; run++) {
+      AllocStats_get(&base);
+      if (engine->init() != 0) {
+         fprintf(stderr, "bench: unable to initialize %s\n",
+                 engine->name);
+         exit(EXIT_FAILURE);
+      }
+
+      for (phase = 0; phase < NUM_PHASES; phase++) {
+         Bench_runPhase(engine, workload, (enum Phase)phase, &nanos,
+                        &allocs, &result->numFailed[phase]);
+         nanos /= (double)workload->numPaths;
+         if (run == 0 || nanos < result->nanos[phase])
+            result->nanos[phase] = nanos;
+         result->allocs[phase] =
+            (double)allocs / (double)workload->numPaths;
+
+         if (phase == PHASE_INSERT) {
+            AllocStats_get(&stats);
+            result->bytes = stats.liveBytes - base.liveBytes;
+            result->blocks = stats.liveBlocks - base.liveBlocks;
+         }
+      }
+
+      (void) engine->destroy();
+      AllocStats_get(&stats);
+      result->leakedBytes = stats.liveBytes - base.liveBytes;
+   }
+}
+
+/* Runs the files workload runs times on FT, packing contents of at
+   least threshold bytes (none if it is 0), and stores its results in
+   *result */
+static void Bench_runFiles(const struct Workload *workload,
+                           size_t threshold, size_t runs,
+                           struct FileResult *result) {
+   struct FT_CompressionStats stats;
+   struct AllocStats base;
+   struct AllocStats copied;
+   struct AllocStats after;
+   char **buffers;
+   unsigned long numFailed;
+   size_t n = workload->numPaths;
+   double start;
+   double nanos;
+   void *contents;
+   size_t run;
+   size_t i;
+
+   assert(workload->contents != NULL);
+   assert(runs > 0);
+
+   buffers = (char **)calloc(n, sizeof(char *));
+   if (buffers == NULL) {
+      fprintf(stderr, "bench: out of memory\n");
+      exit(EXIT_FAILURE);
+   }
+
+   for (run = 0; run < runs; run++) {
+      numFailed = 0;
+      if (FT_useCompression(threshold) != SUCCESS ||
+          FT_init() != SUCCESS) {
+         fprintf(stderr, "bench: unable to initialize FT\n");
+         exit(EXIT_FAILURE);
+      }
+
+      /* a file cannot be the root, so the files share a directory */
+      if (FT_insertDir("f") != SUCCESS)
+         numFailed++;
+
+      /* the client reads each file into a buffer of its own */
+      AllocStats_get(&base);
+      for (i = 0; i < n; i++) {
+         buffers[i] = Bench_newPath(FILE_LENGTH);
+         memcpy(buffers[i], workload->contents[i], FILE_LENGTH);
+      }
+      AllocStats_get(&copied);
+
+      start = Bench_now();
+      for (i = 0; i < n; i++) {
+         if (FT_insertFile(workload->paths[i], buffers[i],
+                           FILE_LENGTH) != SUCCESS)
+            numFailed++;
+      }
+      nanos = (Bench_now() - start) / (double)n;
+      if (run == 0 || nanos < result->insertNanos)
+         result->insertNanos = nanos;
+
+      /* FT keeps its own copies while compression is on, so the
+         client frees its buffers; otherwise FT holds the client's */
+      if (threshold != 0) {
+         for (i = 0; i < n; i++) {
+            free(buffers[i]);
+            buffers[i] = NULL;
+         }
+      }
+      AllocStats_get(&after);
+      result->bytes = after.liveBytes - base.liveBytes;
+      result->ftBytes = after.liveBytes - copied.liveBytes;
+      if (threshold != 0)
+         result->ftBytes += copied.liveBytes - base.liveBytes;
+
+      start = Bench_now();
+      for (i = 0; i < n; i++) {
+         if (FT_getFileContents(workload->paths[i]) == NULL)
+            numFailed++;
+      }
+      nanos = (Bench_now() - start) / (double)n;
+      if (run == 0 || nanos < result->getNanos)
+         result->getNanos = nanos;
+
+      (void) FT_getCompressionStats(&stats);
+      result->savedBytes = stats.savedBytes;
+      result->numMisses = stats.numMisses;
+
+      /* checks the contents apart, so as not to time the checks */
+      for (i = 0; i < n; i++) {
+         contents = FT_getFileContents(workload->paths[i]);
+         if (contents == NULL ||
+             memcmp(contents, workload->contents[i], FILE_LENGTH) != 0)
+            numFailed++;
+      }
+      result->numFailed = numFailed;
+
+      (void) FT_destroy();
+      for (i = 0; i < n; i++) {
+         free(buffers[i]);
+         buffers[i] = NULL;
+      }
+   }
+
+   free(buffers);
+   (void) FT_useCompression(0);
+}
+
+/* Prints the label of a row of the report, for phase if it is not
+   NUM_PHASES */
+static void Bench_printLabel(int phase, const char *label) {
+   char row[64];
+
+   if (phase == NUM_PHASES)
+      sprintf(row, "%s", label);
+   else
+      sprintf(row, "%s %s", phaseNames[phase], label);
+   printf("%-*s", (int)LABEL_WIDTH, row);
+}
+
+/* Prints the results of every engine on workload, run runs times */
+static void Bench_report(const struct Workload *workload, size_t runs,
+                         const struct Result *results) {
+   size_t e;
+   int phase;
+
+   printf("%s: %lu paths, fastest of %lu runs\n", workload->name,
+          (unsigned long)workload->numPaths, (unsigned long)runs);
+
+   Bench_printLabel(NUM_PHASES, "");
+   for (e = 0; e < NUM_ENGINES; e++)
+      printf("%14s", engines[e]->name);
+   printf("\n");
+
+   for (phase = 0; phase < NUM_PHASES; phase++) {
+      Bench_printLabel(phase, "ns/op");
+      for (e = 0; e < NUM_ENGINES; e++)
+         printf("%14.1f", results[e].nanos[phase]);
+      printf("\n");
+
+      Bench_printLabel(phase, "allocs/op");
+      for (e = 0; e < NUM_ENGINES; e++)
+         printf("%14.2f", results[e].allocs[phase]);
+      printf("\n");
+
+      Bench_printLabel(phase, "failed");
+      for (e = 0; e < NUM_ENGINES; e++)
+         printf("%14lu", results[e].numFailed[phase]);
+      printf("\n");
+   }
+
+   Bench_printLabel(NUM_PHASES, "heap bytes");
+   for (e = 0; e < NUM_ENGINES; e++)
+      printf("%14ld", results[e].bytes);
+   printf("\n");
+
+   Bench_printLabel(NUM_PHASES, "heap blocks");
+   for (e = 0; e < NUM_ENGINES; e++)
+      printf("%14ld", results[e].blocks);
+   printf("\n");
+
+   Bench_printLabel(NUM_PHASES, "leaked bytes");
+   for (e = 0; e < NUM_ENGINES; e++)
+      printf("%14ld", results[e].leakedBytes);
+   printf("\n\n");
+}
+
+/* Prints the results of FT on the files workload, run runs times,
+   with compression off (off) and on (on) */
+static void Bench_reportFiles(const struct Workload *workload,
+                              size_t runs,
+                              const struct FileResult *off,
+                              const struct FileResult *on) {
+   printf("%s: %lu files of %lu bytes, FT only, fastest of %lu runs\n",
+          workload->name, (unsigned long)workload->numPaths,
+          (unsigned long)FILE_LENGTH, (unsigned long)runs);
+
+   Bench_printLabel(NUM_PHASES, "compression");
+   printf("%14s%14s\n", "off", "on");
+
+   Bench_printLabel(NUM_PHASES, "insertFile ns/op");
+   printf("%14.1f%14.1f\n", off->insertNanos, on->insertNanos);
+
+   Bench_printLabel(NUM_PHASES, "getFileContents ns/op");
+   printf("%14.1f%14.1f\n", off->getNanos, on->getNanos);
+
+   Bench_printLabel(NUM_PHASES, "saved bytes");
+   printf("%14lu%14lu\n", (unsigned long)off->savedBytes,
+          (unsigned long)on->savedBytes);
+
+   Bench_printLabel(NUM_PHASES, "cache misses");
+   printf("%14lu%14lu\n", (unsigned long)off->numMisses,
+          (unsigned long)on->numMisses);
+
+   Bench_printLabel(NUM_PHASES, "failed");
+   printf("%14lu%14lu\n", off->numFailed, on->numFailed);
+
+   Bench_printLabel(NUM_PHASES, "FT heap bytes");
+   printf("%14ld%14ld\n", off->ftBytes, on->ftBytes);
+
+   Bench_printLabel(NUM_PHASES, "client + FT heap bytes");
+   printf("%14ld%14ld\n\n", off->bytes, on->bytes);
+}
+
+/* Runs every workload on every engine, and reports the results. */
+int main(int argc, char *argv[]) {
+   struct Workload workloads[3];
+   struct Workload files;
+   struct Result results[NUM_ENGINES];
+   struct FileResult off;
+   struct FileResult on;
+   size_t numWorkloads = sizeof(workloads) / sizeof(workloads[0]);
+   size_t size = DEFAULT_SIZE;
+   size_t runs = DEFAULT_RUNS;
+   size_t w;
+   size_t e;
+
+   if (argc > 1)
+      size = (size_t)strtoul(argv[1], NULL, 10);
+   if (argc > 2)
+      runs = (size_t)strtoul(argv[2], NULL, 10);
+   if (argc > 3 || size == 0 || runs == 0) {
+      fprintf(stderr, "usage: %s [size [runs]]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   Bench_makeBinary(&workloads[0], size);
+   Bench_makeChain(&workloads[1], size);
+   Bench_makeWide(&workloads[2], size);
+
+   for (w = 0; w < numWorkloads; w++) {
+      for (e = 0; e < NUM_ENGINES; e++)
+         Bench_runEngine(engines[e], &workloads[w], runs, &results[e]);
+      Bench_report(&workloads[w], runs, results);
+      Bench_freeWorkload(&workloads[w]);
+   }
+
+   Bench_makeFiles(&files, size);
+   Bench_runFiles(&files, 0, runs, &off);
+   Bench_runFiles(&files, FILE_THRESHOLD, runs, &on);
+   Bench_reportFiles(&files, runs, &off, &on);
+   Bench_freeWorkload(&files);
+
+   return 0;
+}
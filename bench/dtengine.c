@@ -0,0 +1,18 @@
+/*--------------------------------------------------------------------*/
+/* dtengine.c                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "dt.h"
+#include "engine.h"
+
+/* Returns whether the tree contains the directory at path */
+static int DTEngine_contains(char *path) {
+   return DT_containsPath(path) == TRUE;
+}
+
+/* see engine.h for specification */
+const struct Engine Engine_dt = {
+   "DT", DT_init, DT_destroy, DT_insertPath, DTEngine_contains,
+   DT_rmPath
+};
@@ -0,0 +1,38 @@
+/*--------------------------------------------------------------------*/
+/* engine.h                                                           */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#ifndef ENGINE_INCLUDED
+#define ENGINE_INCLUDED
+
+/*
+   An engine is one of the directory tree implementations that bench
+   compares: the Binary Directory Tree (1BDT), the Directory Tree
+   (2DT) and the File Tree (3FT), restricted to directories. Each is
+   wrapped by a module of its own, which alone includes its header,
+   since their headers define the same statuses and boolean type.
+
+   Every engine returns 0 for success, as SUCCESS is 0 in each of
+   them.
+*/
+
+struct Engine {
+   /* the name of the engine in reports */
+   const char *name;
+   /* initializes, and destroys, the tree */
+   int (*init)(void);
+   int (*destroy)(void);
+   /* inserts the directory at path, returns whether the tree contains
+      it (nonzero if so), and removes the hierarchy rooted at it */
+   int (*insert)(char *path);
+   int (*contains)(char *path);
+   int (*rm)(char *path);
+};
+
+/* the engines, on the BDT_*, DT_* and FT_*Dir functions */
+extern const struct Engine Engine_bdt;
+extern const struct Engine Engine_dt;
+extern const struct Engine Engine_ft;
+
+#endif
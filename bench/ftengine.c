@@ -0,0 +1,18 @@
+/*--------------------------------------------------------------------*/
+/* ftengine.c                                                         */
+/* Authors: Julio Lins and Rishabh Rout                               */
+/*--------------------------------------------------------------------*/
+
+#include "ft.h"
+#include "engine.h"
+
+/* Returns whether the tree contains the directory at path */
+static int FTEngine_contains(char *path) {
+   return FT_containsDir(path) == TRUE;
+}
+
+/* see engine.h for specification */
+const struct Engine Engine_ft = {
+   "FT", FT_init, FT_destroy, FT_insertDir, FTEngine_contains,
+   FT_rmDir
+};